@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compare the Scheduler implementations with the classic "hold" model:
+// the queue is filled with a fixed population of events and each
+// subsequent operation removes the earliest event and inserts a new one
+// at a random offset in the future.
+//
+// ./waf --run "bench-scheduler --population=1000000 --holds=10000000"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include "ns3/command-line.h"
+#include "ns3/object-factory.h"
+#include "ns3/scheduler.h"
+#include "ns3/list-scheduler.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/heap-scheduler.h"
+#include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/double.h"
+#include "ns3/system-wall-clock-ms.h"
+
+using namespace ns3;
+
+static void
+Bench (TypeId tid, const std::vector<uint64_t> &delays,
+       uint32_t population, uint32_t holds)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+  uint32_t uid = 0;
+  uint32_t d = 0;
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < population; i++)
+    {
+      Scheduler::Event ev = { 0, { delays[d++ % delays.size ()], uid++, 0}};
+      scheduler->Insert (ev);
+    }
+  int64_t fill = clock.End ();
+
+  clock.Start ();
+  for (uint32_t i = 0; i < holds; i++)
+    {
+      Scheduler::Event next = scheduler->RemoveNext ();
+      next.key.m_ts += delays[d++ % delays.size ()];
+      next.key.m_uid = uid++;
+      scheduler->Insert (next);
+    }
+  int64_t hold = clock.End ();
+
+  clock.Start ();
+  while (!scheduler->IsEmpty ())
+    {
+      scheduler->RemoveNext ();
+    }
+  int64_t drain = clock.End ();
+
+  std::cout << std::left << std::setw (24) << tid.GetName ()
+            << std::right
+            << std::setw (10) << fill
+            << std::setw (10) << hold
+            << std::setw (10) << drain;
+  if (holds > 0)
+    {
+      std::cout << std::setw (12) << std::fixed << std::setprecision (1)
+                << (hold * 1000000.0) / holds;
+    }
+  std::cout << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t population = 100000;
+  uint32_t holds = 1000000;
+  double meanDelay = 1000000;
+  bool list = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("population", "Number of pending events", population);
+  cmd.AddValue ("holds", "Number of remove/insert operations", holds);
+  cmd.AddValue ("delay", "Mean delay of the inserted events in time steps", meanDelay);
+  cmd.AddValue ("list", "Also run the (quadratic) ListScheduler", list);
+  cmd.Parse (argc, argv);
+
+  // draw all the delays up front so that the random number generator
+  // does not show up in the measurements.
+  Ptr<ExponentialRandomVariable> rng = CreateObject<ExponentialRandomVariable> ();
+  rng->SetAttribute ("Mean", DoubleValue (meanDelay));
+  std::vector<uint64_t> delays (1 << 20);
+  for (uint32_t i = 0; i < delays.size (); i++)
+    {
+      delays[i] = static_cast<uint64_t> (rng->GetValue ());
+    }
+
+  std::cout << "population=" << population << " holds=" << holds
+            << " mean delay=" << meanDelay << std::endl;
+  std::cout << std::left << std::setw (24) << "scheduler"
+            << std::right
+            << std::setw (10) << "fill(ms)"
+            << std::setw (10) << "hold(ms)"
+            << std::setw (10) << "drain(ms)"
+            << std::setw (12) << "ns/hold" << std::endl;
+
+  if (list)
+    {
+      Bench (ListScheduler::GetTypeId (), delays, population, holds);
+    }
+  Bench (MapScheduler::GetTypeId (), delays, population, holds);
+  Bench (HeapScheduler::GetTypeId (), delays, population, holds);
+  Bench (CalendarScheduler::GetTypeId (), delays, population, holds);
+  Bench (LadderScheduler::GetTypeId (), delays, population, holds);
+
+  return 0;
+}
@@ -29,6 +29,7 @@
 #include "attribute-helper.h"
 #include "simple-ref-count.h"
 #include <typeinfo>
+#include <new>
 
 namespace ns3 {
 
@@ -87,6 +88,21 @@ public:
    * \return true if we are equal
    */
   virtual bool IsEqual (Ptr<const CallbackImplBase> other) const = 0;
+  /**
+   * Copy this CallbackImpl.
+   *
+   * A Callback stores small CallbackImpl objects in its own buffer
+   * rather than on the heap, and copies them with this method whenever
+   * the Callback is copied.  CallbackImpl classes which do not override
+   * it can only be handed to a Callback by Ptr.
+   *
+   * \param buffer storage for the copy, or 0 to allocate it on the heap
+   * \return a copy of this CallbackImpl, with a reference count of one
+   */
+  virtual CallbackImplBase *Clone (void *buffer) const {
+    NS_FATAL_ERROR ("This CallbackImpl cannot be copied");
+    return 0;
+  }
 };
 
 /**
@@ -189,6 +205,17 @@ public:
   FunctorCallbackImpl (T const &functor)
     : m_functor (functor) {}
   virtual ~FunctorCallbackImpl () {}
+  /**
+   * \param buffer storage for the copy, or 0 to allocate it on the heap
+   * \return a copy of this CallbackImpl
+   */
+  virtual CallbackImplBase *Clone (void *buffer) const {
+    if (buffer == 0)
+      {
+        return new FunctorCallbackImpl (*this);
+      }
+    return new (buffer) FunctorCallbackImpl (*this);
+  }
   /**
    * Functor with varying numbers of arguments
    * @{
@@ -336,6 +363,17 @@ public:
   MemPtrCallbackImpl (OBJ_PTR const&objPtr, MEM_PTR memPtr)
     : m_objPtr (objPtr), m_memPtr (memPtr) {}
   virtual ~MemPtrCallbackImpl () {}
+  /**
+   * \param buffer storage for the copy, or 0 to allocate it on the heap
+   * \return a copy of this CallbackImpl
+   */
+  virtual CallbackImplBase *Clone (void *buffer) const {
+    if (buffer == 0)
+      {
+        return new MemPtrCallbackImpl (*this);
+      }
+    return new (buffer) MemPtrCallbackImpl (*this);
+  }
   /**
    * Functor with varying numbers of arguments
    * @{
@@ -485,6 +523,17 @@ public:
   BoundFunctorCallbackImpl (FUNCTOR functor, ARG a)
     : m_functor (functor), m_a (a) {}
   virtual ~BoundFunctorCallbackImpl () {}
+  /**
+   * \param buffer storage for the copy, or 0 to allocate it on the heap
+   * \return a copy of this CallbackImpl
+   */
+  virtual CallbackImplBase *Clone (void *buffer) const {
+    if (buffer == 0)
+      {
+        return new BoundFunctorCallbackImpl (*this);
+      }
+    return new (buffer) BoundFunctorCallbackImpl (*this);
+  }
   /**
    * Functor with varying numbers of arguments
    * @{
@@ -620,6 +669,17 @@ public:
   TwoBoundFunctorCallbackImpl (FUNCTOR functor, ARG1 arg1, ARG2 arg2)
     : m_functor (functor), m_a1 (arg1), m_a2 (arg2) {}
   virtual ~TwoBoundFunctorCallbackImpl () {}
+  /**
+   * \param buffer storage for the copy, or 0 to allocate it on the heap
+   * \return a copy of this CallbackImpl
+   */
+  virtual CallbackImplBase *Clone (void *buffer) const {
+    if (buffer == 0)
+      {
+        return new TwoBoundFunctorCallbackImpl (*this);
+      }
+    return new (buffer) TwoBoundFunctorCallbackImpl (*this);
+  }
   /**
    * Functor with varying numbers of arguments
    * @{
@@ -743,6 +803,17 @@ public:
   ThreeBoundFunctorCallbackImpl (FUNCTOR functor, ARG1 arg1, ARG2 arg2, ARG3 arg3)
     : m_functor (functor), m_a1 (arg1), m_a2 (arg2), m_a3 (arg3) {}
   virtual ~ThreeBoundFunctorCallbackImpl () {}
+  /**
+   * \param buffer storage for the copy, or 0 to allocate it on the heap
+   * \return a copy of this CallbackImpl
+   */
+  virtual CallbackImplBase *Clone (void *buffer) const {
+    if (buffer == 0)
+      {
+        return new ThreeBoundFunctorCallbackImpl (*this);
+      }
+    return new (buffer) ThreeBoundFunctorCallbackImpl (*this);
+  }
   /**
    * Functor with varying numbers of arguments
    * @{
@@ -836,23 +907,178 @@ private:
   typename TypeTraits<TX3>::ReferencedType m_a3;  //!< third bound argument
 };
 
+/**
+ * \ingroup callback
+ * Tag which selects the Callback constructor copying a CallbackImpl
+ * object, used by MakeBoundCallback.
+ */
+struct CallbackImplCopy {};
+
 /**
  * \ingroup callback
  * Base class for Callback class.
  * Provides pimpl abstraction.
+ *
+ * The pimpl is either held by reference on the heap, or, if it is small
+ * enough, stored by value in a buffer inside the CallbackBase, which
+ * saves the allocation and reference counting of the common object and
+ * member function pointer callbacks.  Copying a CallbackBase copies an
+ * inline pimpl.  The buffer is just large enough for an object and
+ * member function pointer, which makes a CallbackBase 56 bytes long on
+ * 64-bit platforms.
  */
 class CallbackBase {
 public:
-  CallbackBase () : m_impl () {}
-  /** \return the impl pointer */
-  Ptr<CallbackImplBase> GetImpl (void) const { return m_impl; }
+  CallbackBase () : m_impl (), m_inline (0) {}
+  /**
+   * Copy constructor
+   * \param o the CallbackBase to copy
+   */
+  CallbackBase (const CallbackBase &o)
+    : m_impl (o.m_impl),
+      m_inline (0)
+  {
+    if (o.m_inline != 0)
+      {
+        m_inline = o.m_inline->Clone (&m_buffer);
+      }
+  }
+  /**
+   * Assignment operator
+   * \param o the CallbackBase to copy
+   * \return this CallbackBase
+   */
+  CallbackBase &operator = (const CallbackBase &o)
+  {
+    if (this != &o)
+      {
+        DoReset ();
+        m_impl = o.m_impl;
+        if (o.m_inline != 0)
+          {
+            m_inline = o.m_inline->Clone (&m_buffer);
+          }
+      }
+    return *this;
+  }
+  ~CallbackBase ()
+  {
+    DoReset ();
+  }
+  /**
+   * \return the impl pointer.  An inline pimpl is copied to a new heap
+   * pimpl on each call, so this is best avoided on the fast path: see
+   * PeekImpl.
+   */
+  Ptr<CallbackImplBase> GetImpl (void) const
+  {
+    if (m_inline != 0)
+      {
+        return Ptr<CallbackImplBase> (m_inline->Clone (0), false);
+      }
+    return m_impl;
+  }
+  /** \return the impl pointer, which remains owned by this CallbackBase */
+  CallbackImplBase *PeekImpl (void) const
+  {
+    return m_inline != 0 ? m_inline : PeekPointer (m_impl);
+  }
 protected:
+  template <typename T1, typename T2, typename T3, typename T4,
+            typename T5, typename T6, typename T7, typename T8>
+  friend class TracedCallback;
+
+  /**
+   * Move an inline pimpl to the heap, where it is shared by the copies
+   * of this CallbackBase rather than copied: a copy then keeps the
+   * pimpl alive, and copying is cheaper.  TracedCallback does this
+   * when a sink is connected, before the sink is shared.
+   */
+  void MoveImplToHeap (void)
+  {
+    if (m_inline != 0)
+      {
+        m_impl = Ptr<CallbackImplBase> (m_inline->Clone (0), false);
+        m_inline->~CallbackImplBase ();
+        m_inline = 0;
+      }
+  }
   /**
    * Construct from a pimpl
    * \param impl the CallbackImplBase Ptr
    */
-  CallbackBase (Ptr<CallbackImplBase> impl) : m_impl (impl) {}
-  Ptr<CallbackImplBase> m_impl;         //!< the pimpl
+  CallbackBase (Ptr<CallbackImplBase> impl) : m_impl (impl), m_inline (0) {}
+
+  /** Storage for an inline pimpl, aligned for pointers and doubles */
+  union Buffer
+  {
+    char bytes[40];                     //!< the storage
+    void *pointer;                      //!< pointer alignment
+    double number;                      //!< double alignment
+    uint64_t integer;                   //!< 64-bit integer alignment
+  };
+
+  /**
+   * Whether a CallbackImpl type is stored inline.
+   */
+  template <typename IMPL>
+  struct IsInline
+  {
+    /** Helper to compute the alignment of IMPL */
+    struct Alignment
+    {
+      char c;                           //!< padding
+      IMPL impl;                        //!< aligned member
+    };
+    /** true if IMPL fits in the buffer */
+    enum { value = sizeof (IMPL) <= sizeof (Buffer)
+                   && sizeof (Alignment) - sizeof (IMPL) <= sizeof (void *) };
+  };
+  /** Tag selecting the inline or heap storage of a CallbackImpl */
+  template <bool INLINE>
+  struct StorageTag {};
+  /**
+   * Construct a copy of a CallbackImpl inline if it fits,
+   * on the heap otherwise.
+   * \param impl the CallbackImpl to copy
+   */
+  template <typename IMPL>
+  void DoCreate (IMPL const &impl)
+  {
+    DoCreate (impl, StorageTag<IsInline<IMPL>::value> ());
+  }
+  /**
+   * Construct a copy of a CallbackImpl inline.
+   * \param impl the CallbackImpl to copy
+   */
+  template <typename IMPL>
+  void DoCreate (IMPL const &impl, StorageTag<true>)
+  {
+    m_inline = new (&m_buffer) IMPL (impl);
+  }
+  /**
+   * Construct a copy of a CallbackImpl on the heap.
+   * \param impl the CallbackImpl to copy
+   */
+  template <typename IMPL>
+  void DoCreate (IMPL const &impl, StorageTag<false>)
+  {
+    m_impl = Create<IMPL> (impl);
+  }
+  /** Release the pimpl */
+  void DoReset (void)
+  {
+    if (m_inline != 0)
+      {
+        m_inline->~CallbackImplBase ();
+        m_inline = 0;
+      }
+    m_impl = 0;
+  }
+
+  Ptr<CallbackImplBase> m_impl;         //!< the pimpl, if held on the heap
+  CallbackImplBase *m_inline;           //!< the pimpl, if held in m_buffer
+  Buffer m_buffer;                      //!< the inline pimpl storage
 
   /**
    * \param mangled the mangled string
@@ -903,6 +1129,10 @@ protected:
  *     member functions.
  *   - a reference list implementation to implement the Callback's
  *     value semantics.
+ *   - a small buffer inside the Callback which stores the pimpl of
+ *     object and member function pointer callbacks, as well as
+ *     functions with a few small bound arguments, without a heap
+ *     allocation.
  *
  * This code most notably departs from the alexandrescu 
  * implementation in that it does not use type lists to specify
@@ -932,8 +1162,9 @@ public:
    */
   template <typename FUNCTOR>
   Callback (FUNCTOR const &functor, bool, bool) 
-    : CallbackBase (Create<FunctorCallbackImpl<FUNCTOR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (functor))
-  {}
+  {
+    DoCreate (FunctorCallbackImpl<FUNCTOR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> (functor));
+  }
 
   /**
    * Construct a member function pointer call back.
@@ -943,8 +1174,21 @@ public:
    */
   template <typename OBJ_PTR, typename MEM_PTR>
   Callback (OBJ_PTR const &objPtr, MEM_PTR memPtr)
-    : CallbackBase (Create<MemPtrCallbackImpl<OBJ_PTR,MEM_PTR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (objPtr, memPtr))
-  {}
+  {
+    DoCreate (MemPtrCallbackImpl<OBJ_PTR,MEM_PTR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> (objPtr, memPtr));
+  }
+
+  /**
+   * Construct from a CallbackImpl object, which is copied inline
+   * when it is small enough.
+   *
+   * \param impl the CallbackImpl
+   */
+  template <typename IMPL>
+  Callback (IMPL const &impl, CallbackImplCopy)
+  {
+    DoCreate (impl);
+  }
 
   /**
    * Construct from a CallbackImpl pointer
@@ -1016,7 +1260,7 @@ public:
   }
   /** Discard the implementation, set it to null */
   void Nullify (void) {
-    m_impl = 0;
+    DoReset ();
   }
 
   /**
@@ -1135,7 +1379,7 @@ public:
    * \return true if we are equal
    */
   bool IsEqual (const CallbackBase &other) const {
-    return m_impl->IsEqual (other.GetImpl ());
+    return DoPeekImpl ()->IsEqual (Ptr<const CallbackImplBase> (other.PeekImpl ()));
   }
 
   /**
@@ -1145,7 +1389,7 @@ public:
    * \return true if other can be dynamic_cast to my type
    */
   bool CheckType (const CallbackBase & other) const {
-    return DoCheckType (other.GetImpl ());
+    return DoCheckType (other.PeekImpl ());
   }
   /**
    * Adopt the other's implementation, if type compatible
@@ -1153,21 +1397,21 @@ public:
    * \param other Callback
    */
   void Assign (const CallbackBase &other) {
-    DoAssign (other.GetImpl ());
+    DoAssign (other);
   }
 private:
   /** \return the pimpl pointer */
   CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *DoPeekImpl (void) const {
-    return static_cast<CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *> (PeekPointer (m_impl));
+    return static_cast<CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *> (PeekImpl ());
   }
   /**
    * Check for compatible types
    *
-   * \param other Callback Ptr
+   * \param other CallbackImpl pointer
    * \return true if other can be dynamic_cast to my type
    */
-  bool DoCheckType (Ptr<const CallbackImplBase> other) const {
-    if (other != 0 && dynamic_cast<const CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *> (PeekPointer (other)) != 0)
+  bool DoCheckType (const CallbackImplBase *other) const {
+    if (other != 0 && dynamic_cast<const CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *> (other) != 0)
       {
         return true;
       }
@@ -1183,16 +1427,16 @@ private:
   /**
    * Adopt the other's implementation, if type compatible
    *
-   * \param other Callback Ptr to adopt from
+   * \param other Callback to adopt from
    */
-  void DoAssign (Ptr<const CallbackImplBase> other) {
-    if (!DoCheckType (other))
+  void DoAssign (const CallbackBase &other) {
+    if (!DoCheckType (other.PeekImpl ()))
       {
         NS_FATAL_ERROR ("Incompatible types. (feed to \"c++filt -t\" if needed)" << std::endl <<
-                        "got=" << Demangle ( typeid (*other).name () ) << std::endl <<
+                        "got=" << Demangle ( typeid (*other.PeekImpl ()).name () ) << std::endl <<
                         "expected=" << Demangle ( typeid (CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *).name () ));
       }
-    m_impl = const_cast<CallbackImplBase *> (PeekPointer (other));
+    CallbackBase::operator = (other);
   }
 };
 
@@ -1461,65 +1705,47 @@ Callback<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> MakeNullCallback (void) {
  */   
 template <typename R, typename TX, typename ARG>
 Callback<R> MakeBoundCallback (R (*fnPtr)(TX), ARG a1) {
-  Ptr<CallbackImpl<R,empty,empty,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX),R,TX,empty,empty,empty,empty,empty,empty,empty,empty> >(fnPtr, a1);
-  return Callback<R> (impl);
+  return Callback<R> (BoundFunctorCallbackImpl<R (*)(TX),R,TX,empty,empty,empty,empty,empty,empty,empty,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG, 
           typename T1>
 Callback<R,T1> MakeBoundCallback (R (*fnPtr)(TX,T1), ARG a1) {
-  Ptr<CallbackImpl<R,T1,empty,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1),R,TX,T1,empty,empty,empty,empty,empty,empty,empty> > (fnPtr, a1);
-  return Callback<R,T1> (impl);
+  return Callback<R,T1> (BoundFunctorCallbackImpl<R (*)(TX,T1),R,TX,T1,empty,empty,empty,empty,empty,empty,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG, 
           typename T1, typename T2>
 Callback<R,T1,T2> MakeBoundCallback (R (*fnPtr)(TX,T1,T2), ARG a1) {
-  Ptr<CallbackImpl<R,T1,T2,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1,T2),R,TX,T1,T2,empty,empty,empty,empty,empty,empty> > (fnPtr, a1);
-  return Callback<R,T1,T2> (impl);
+  return Callback<R,T1,T2> (BoundFunctorCallbackImpl<R (*)(TX,T1,T2),R,TX,T1,T2,empty,empty,empty,empty,empty,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG,
           typename T1, typename T2,typename T3>
 Callback<R,T1,T2,T3> MakeBoundCallback (R (*fnPtr)(TX,T1,T2,T3), ARG a1) {
-  Ptr<CallbackImpl<R,T1,T2,T3,empty,empty,empty,empty,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3),R,TX,T1,T2,T3,empty,empty,empty,empty,empty> > (fnPtr, a1);
-  return Callback<R,T1,T2,T3> (impl);
+  return Callback<R,T1,T2,T3> (BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3),R,TX,T1,T2,T3,empty,empty,empty,empty,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG,
           typename T1, typename T2,typename T3,typename T4>
 Callback<R,T1,T2,T3,T4> MakeBoundCallback (R (*fnPtr)(TX,T1,T2,T3,T4), ARG a1) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,empty,empty,empty,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4),R,TX,T1,T2,T3,T4,empty,empty,empty,empty> > (fnPtr, a1);
-  return Callback<R,T1,T2,T3,T4> (impl);
+  return Callback<R,T1,T2,T3,T4> (BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4),R,TX,T1,T2,T3,T4,empty,empty,empty,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG,
           typename T1, typename T2,typename T3,typename T4,typename T5>
 Callback<R,T1,T2,T3,T4,T5> MakeBoundCallback (R (*fnPtr)(TX,T1,T2,T3,T4,T5), ARG a1) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,empty,empty,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5),R,TX,T1,T2,T3,T4,T5,empty,empty,empty> > (fnPtr, a1);
-  return Callback<R,T1,T2,T3,T4,T5> (impl);
+  return Callback<R,T1,T2,T3,T4,T5> (BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5),R,TX,T1,T2,T3,T4,T5,empty,empty,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG,
           typename T1, typename T2,typename T3,typename T4,typename T5, typename T6>
 Callback<R,T1,T2,T3,T4,T5,T6> MakeBoundCallback (R (*fnPtr)(TX,T1,T2,T3,T4,T5,T6), ARG a1) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,T6,empty,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5,T6),R,TX,T1,T2,T3,T4,T5,T6,empty,empty> > (fnPtr, a1);
-  return Callback<R,T1,T2,T3,T4,T5,T6> (impl);
+  return Callback<R,T1,T2,T3,T4,T5,T6> (BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5,T6),R,TX,T1,T2,T3,T4,T5,T6,empty,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG,
           typename T1, typename T2,typename T3,typename T4,typename T5, typename T6, typename T7>
 Callback<R,T1,T2,T3,T4,T5,T6,T7> MakeBoundCallback (R (*fnPtr)(TX,T1,T2,T3,T4,T5,T6,T7), ARG a1) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,empty,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5,T6,T7),R,TX,T1,T2,T3,T4,T5,T6,T7,empty> > (fnPtr, a1);
-  return Callback<R,T1,T2,T3,T4,T5,T6,T7> (impl);
+  return Callback<R,T1,T2,T3,T4,T5,T6,T7> (BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5,T6,T7),R,TX,T1,T2,T3,T4,T5,T6,T7,empty> (fnPtr, a1), CallbackImplCopy ());
 }
 template <typename R, typename TX, typename ARG,
           typename T1, typename T2,typename T3,typename T4,typename T5, typename T6, typename T7, typename T8>
 Callback<R,T1,T2,T3,T4,T5,T6,T7,T8> MakeBoundCallback (R (*fnPtr)(TX,T1,T2,T3,T4,T5,T6,T7,T8), ARG a1) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,empty> > impl =
-    Create<BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5,T6,T7,T8),R,TX,T1,T2,T3,T4,T5,T6,T7,T8> > (fnPtr, a1);
-  return Callback<R,T1,T2,T3,T4,T5,T6,T7,T8> (impl);
+  return Callback<R,T1,T2,T3,T4,T5,T6,T7,T8> (BoundFunctorCallbackImpl<R (*)(TX,T1,T2,T3,T4,T5,T6,T7,T8),R,TX,T1,T2,T3,T4,T5,T6,T7,T8> (fnPtr, a1), CallbackImplCopy ());
 }
 /**@}*/
 
@@ -1532,58 +1758,42 @@ Callback<R,T1,T2,T3,T4,T5,T6,T7,T8> MakeBoundCallback (R (*fnPtr)(TX,T1,T2,T3,T4
  */
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2>
 Callback<R> MakeBoundCallback (R (*fnPtr)(TX1,TX2), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,empty,empty,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2),R,TX1,TX2,empty,empty,empty,empty,empty,empty,empty> >(fnPtr, a1, a2);
-  return Callback<R> (impl);
+  return Callback<R> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2),R,TX1,TX2,empty,empty,empty,empty,empty,empty,empty> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2,
           typename T1>
 Callback<R,T1> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,T1,empty,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1),R,TX1,TX2,T1,empty,empty,empty,empty,empty,empty> > (fnPtr, a1, a2);
-  return Callback<R,T1> (impl);
+  return Callback<R,T1> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1),R,TX1,TX2,T1,empty,empty,empty,empty,empty,empty> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2,
           typename T1, typename T2>
 Callback<R,T1,T2> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1,T2), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,T1,T2,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2),R,TX1,TX2,T1,T2,empty,empty,empty,empty,empty> > (fnPtr, a1, a2);
-  return Callback<R,T1,T2> (impl);
+  return Callback<R,T1,T2> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2),R,TX1,TX2,T1,T2,empty,empty,empty,empty,empty> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2,
           typename T1, typename T2,typename T3>
 Callback<R,T1,T2,T3> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1,T2,T3), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,T1,T2,T3,empty,empty,empty,empty,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3),R,TX1,TX2,T1,T2,T3,empty,empty,empty,empty> > (fnPtr, a1, a2);
-  return Callback<R,T1,T2,T3> (impl);
+  return Callback<R,T1,T2,T3> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3),R,TX1,TX2,T1,T2,T3,empty,empty,empty,empty> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2,
           typename T1, typename T2,typename T3,typename T4>
 Callback<R,T1,T2,T3,T4> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1,T2,T3,T4), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,empty,empty,empty,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4),R,TX1,TX2,T1,T2,T3,T4,empty,empty,empty> > (fnPtr, a1, a2);
-  return Callback<R,T1,T2,T3,T4> (impl);
+  return Callback<R,T1,T2,T3,T4> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4),R,TX1,TX2,T1,T2,T3,T4,empty,empty,empty> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2,
           typename T1, typename T2,typename T3,typename T4,typename T5>
 Callback<R,T1,T2,T3,T4,T5> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1,T2,T3,T4,T5), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,empty,empty,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4,T5),R,TX1,TX2,T1,T2,T3,T4,T5,empty,empty> > (fnPtr, a1, a2);
-  return Callback<R,T1,T2,T3,T4,T5> (impl);
+  return Callback<R,T1,T2,T3,T4,T5> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4,T5),R,TX1,TX2,T1,T2,T3,T4,T5,empty,empty> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2,
           typename T1, typename T2,typename T3,typename T4,typename T5, typename T6>
 Callback<R,T1,T2,T3,T4,T5,T6> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1,T2,T3,T4,T5,T6), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,T6,empty,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4,T5,T6),R,TX1,TX2,T1,T2,T3,T4,T5,T6,empty> > (fnPtr, a1, a2);
-  return Callback<R,T1,T2,T3,T4,T5,T6> (impl);
+  return Callback<R,T1,T2,T3,T4,T5,T6> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4,T5,T6),R,TX1,TX2,T1,T2,T3,T4,T5,T6,empty> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename ARG1, typename ARG2,
           typename T1, typename T2,typename T3,typename T4,typename T5, typename T6, typename T7>
 Callback<R,T1,T2,T3,T4,T5,T6,T7> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1,T2,T3,T4,T5,T6,T7), ARG1 a1, ARG2 a2) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,empty,empty> > impl =
-    Create<TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4,T5,T6,T7),R,TX1,TX2,T1,T2,T3,T4,T5,T6,T7> > (fnPtr, a1, a2);
-  return Callback<R,T1,T2,T3,T4,T5,T6,T7> (impl);
+  return Callback<R,T1,T2,T3,T4,T5,T6,T7> (TwoBoundFunctorCallbackImpl<R (*)(TX1,TX2,T1,T2,T3,T4,T5,T6,T7),R,TX1,TX2,T1,T2,T3,T4,T5,T6,T7> (fnPtr, a1, a2), CallbackImplCopy ());
 }
 /**@}*/
 
@@ -1597,51 +1807,37 @@ Callback<R,T1,T2,T3,T4,T5,T6,T7> MakeBoundCallback (R (*fnPtr)(TX1,TX2,T1,T2,T3,
  */
 template <typename R, typename TX1, typename TX2, typename TX3, typename ARG1, typename ARG2, typename ARG3>
 Callback<R> MakeBoundCallback (R (*fnPtr)(TX1,TX2,TX3), ARG1 a1, ARG2 a2, ARG3 a3) {
-  Ptr<CallbackImpl<R,empty,empty,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3),R,TX1,TX2,TX3,empty,empty,empty,empty,empty,empty> >(fnPtr, a1, a2, a3);
-  return Callback<R> (impl);
+  return Callback<R> (ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3),R,TX1,TX2,TX3,empty,empty,empty,empty,empty,empty> (fnPtr, a1, a2, a3), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename TX3, typename ARG1, typename ARG2, typename ARG3,
           typename T1>
 Callback<R,T1> MakeBoundCallback (R (*fnPtr)(TX1,TX2,TX3,T1), ARG1 a1, ARG2 a2, ARG3 a3) {
-  Ptr<CallbackImpl<R,T1,empty,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1),R,TX1,TX2,TX3,T1,empty,empty,empty,empty,empty> > (fnPtr, a1, a2, a3);
-  return Callback<R,T1> (impl);
+  return Callback<R,T1> (ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1),R,TX1,TX2,TX3,T1,empty,empty,empty,empty,empty> (fnPtr, a1, a2, a3), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename TX3, typename ARG1, typename ARG2, typename ARG3,
           typename T1, typename T2>
 Callback<R,T1,T2> MakeBoundCallback (R (*fnPtr)(TX1,TX2,TX3,T1,T2), ARG1 a1, ARG2 a2, ARG3 a3) {
-  Ptr<CallbackImpl<R,T1,T2,empty,empty,empty,empty,empty,empty,empty> > impl =
-    Create<ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2),R,TX1,TX2,TX3,T1,T2,empty,empty,empty,empty> > (fnPtr, a1, a2, a3);
-  return Callback<R,T1,T2> (impl);
+  return Callback<R,T1,T2> (ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2),R,TX1,TX2,TX3,T1,T2,empty,empty,empty,empty> (fnPtr, a1, a2, a3), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename TX3, typename ARG1, typename ARG2, typename ARG3,
           typename T1, typename T2,typename T3>
 Callback<R,T1,T2,T3> MakeBoundCallback (R (*fnPtr)(TX1,TX2,TX3,T1,T2,T3), ARG1 a1, ARG2 a2, ARG3 a3) {
-  Ptr<CallbackImpl<R,T1,T2,T3,empty,empty,empty,empty,empty,empty> > impl =
-    Create<ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3),R,TX1,TX2,TX3,T1,T2,T3,empty,empty,empty> > (fnPtr, a1, a2, a3);
-  return Callback<R,T1,T2,T3> (impl);
+  return Callback<R,T1,T2,T3> (ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3),R,TX1,TX2,TX3,T1,T2,T3,empty,empty,empty> (fnPtr, a1, a2, a3), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename TX3, typename ARG1, typename ARG2, typename ARG3,
           typename T1, typename T2,typename T3,typename T4>
 Callback<R,T1,T2,T3,T4> MakeBoundCallback (R (*fnPtr)(TX1,TX2,TX3,T1,T2,T3,T4), ARG1 a1, ARG2 a2, ARG3 a3) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,empty,empty,empty,empty,empty> > impl =
-    Create<ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3,T4),R,TX1,TX2,TX3,T1,T2,T3,T4,empty,empty> > (fnPtr, a1, a2, a3);
-  return Callback<R,T1,T2,T3,T4> (impl);
+  return Callback<R,T1,T2,T3,T4> (ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3,T4),R,TX1,TX2,TX3,T1,T2,T3,T4,empty,empty> (fnPtr, a1, a2, a3), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename TX3, typename ARG1, typename ARG2, typename ARG3,
           typename T1, typename T2,typename T3,typename T4,typename T5>
 Callback<R,T1,T2,T3,T4,T5> MakeBoundCallback (R (*fnPtr)(TX1,TX2,TX3,T1,T2,T3,T4,T5), ARG1 a1, ARG2 a2, ARG3 a3) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,empty,empty,empty,empty> > impl =
-    Create<ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3,T4,T5),R,TX1,TX2,TX3,T1,T2,T3,T4,T5,empty> > (fnPtr, a1, a2, a3);
-  return Callback<R,T1,T2,T3,T4,T5> (impl);
+  return Callback<R,T1,T2,T3,T4,T5> (ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3,T4,T5),R,TX1,TX2,TX3,T1,T2,T3,T4,T5,empty> (fnPtr, a1, a2, a3), CallbackImplCopy ());
 }
 template <typename R, typename TX1, typename TX2, typename TX3, typename ARG1, typename ARG2, typename ARG3,
           typename T1, typename T2,typename T3,typename T4,typename T5, typename T6>
 Callback<R,T1,T2,T3,T4,T5,T6> MakeBoundCallback (R (*fnPtr)(TX1,TX2,TX3,T1,T2,T3,T4,T5,T6), ARG1 a1, ARG2 a2, ARG3 a3) {
-  Ptr<CallbackImpl<R,T1,T2,T3,T4,T5,T6,empty,empty,empty> > impl =
-    Create<ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3,T4,T5,T6),R,TX1,TX2,TX3,T1,T2,T3,T4,T5,T6> > (fnPtr, a1, a2, a3);
-  return Callback<R,T1,T2,T3,T4,T5,T6> (impl);
+  return Callback<R,T1,T2,T3,T4,T5,T6> (ThreeBoundFunctorCallbackImpl<R (*)(TX1,TX2,TX3,T1,T2,T3,T4,T5,T6),R,TX1,TX2,TX3,T1,T2,T3,T4,T5,T6> (fnPtr, a1, a2, a3), CallbackImplCopy ());
 }
 /**@}*/
 
@@ -24,14 +24,23 @@
 #include "object-ptr-container.h"
 #include "names.h"
 #include "pointer.h"
+#include "boolean.h"
 #include "log.h"
 
 #include <sstream>
+#include <limits>
+#include <map>
 
 NS_LOG_COMPONENT_DEFINE ("Config");
 
 namespace ns3 {
 
+static GlobalValue g_configMatchCache ("ConfigMatchCache",
+                                      "Cache the objects matched by the paths of the Config functions "
+                                      "until the object graph changes (see Config::InvalidateMatchCache)",
+                                      BooleanValue (false),
+                                      MakeBooleanChecker ());
+
 namespace Config {
 
 MatchContainer::MatchContainer ()
@@ -142,14 +151,21 @@ MatchContainer::DisconnectWithoutContext (std::string name, const CallbackBase &
 
 } // namespace Config
 
+/**
+ * Matches the indexes of a container against an element of a path: "*",
+ * a number, a range "[min-max]", or several of those separated by "|".
+ * The element is compiled into a list of ranges once.
+ */
 class ArrayMatcher
 {
 public:
   ArrayMatcher (std::string element);
   bool Matches (uint32_t i) const;
 private:
+  void Compile (std::string element);
   bool StringToUint32 (std::string str, uint32_t *value) const;
   std::string m_element;
+  std::vector<std::pair<uint32_t, uint32_t> > m_ranges;
 };
 
 
@@ -157,66 +173,60 @@ ArrayMatcher::ArrayMatcher (std::string element)
   : m_element (element)
 {
   NS_LOG_FUNCTION (this << element);
+  Compile (element);
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Compile (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_ranges.push_back (std::make_pair (0, std::numeric_limits<uint32_t>::max ()));
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      Compile (element.substr (0, tmp-0));
+      Compile (element.substr (tmp+1, element.size () - (tmp + 1)));
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
       if (StringToUint32 (lowerBound, &min) && 
           StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
+          min <= max)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          m_ranges.push_back (std::make_pair (min, max));
         }
+      return;
     }
   uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  if (StringToUint32 (element, &value))
+    {
+      m_ranges.push_back (std::make_pair (value, value));
+    }
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  for (uint32_t j = 0; j < m_ranges.size (); j++)
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-      return true;
+      if (i >= m_ranges[j].first && i <= m_ranges[j].second)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
     }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
@@ -233,6 +243,95 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
 }
 
 
+/**
+ * An element of a path, parsed once by the Resolver and matched against
+ * every object the path goes through. The TypeId of a "$" element and
+ * the attributes an element matches on each TypeId are looked up the
+ * first time they are needed only.
+ */
+class PathSegment
+{
+public:
+  PathSegment (std::string item);
+
+  /**
+   * An attribute matched by the element: the attributes of other
+   * kinds cannot be followed by a path.
+   */
+  struct Attribute
+  {
+    std::string name;
+    bool isPointer;     //!< a PointerValue, or else an ObjectPtrContainerValue
+  };
+  typedef std::vector<struct Attribute> Attributes;
+
+  std::string item;
+  ArrayMatcher matcher;
+  bool isGetObject;
+
+  TypeId GetObjectTypeId (void);
+  const Attributes &GetAttributes (TypeId tid);
+private:
+  bool m_hasTypeId;
+  TypeId m_tid;
+  std::map<TypeId, Attributes> m_attributes;
+};
+
+PathSegment::PathSegment (std::string _item)
+  : item (_item),
+    matcher (_item),
+    isGetObject (_item.find ("$") == 0),
+    m_hasTypeId (false)
+{
+  NS_LOG_FUNCTION (this << _item);
+}
+TypeId
+PathSegment::GetObjectTypeId (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_hasTypeId)
+    {
+      m_tid = TypeId::LookupByName (item.substr (1, item.size () - 1));
+      m_hasTypeId = true;
+    }
+  return m_tid;
+}
+const PathSegment::Attributes &
+PathSegment::GetAttributes (TypeId tid)
+{
+  NS_LOG_FUNCTION (this << tid);
+  std::map<TypeId, Attributes>::iterator found = m_attributes.find (tid);
+  if (found != m_attributes.end ())
+    {
+      return found->second;
+    }
+  Attributes &attributes = m_attributes[tid];
+  for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+    {
+      struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+      if (info.name != item && item != "*")
+        {
+          continue;
+        }
+      struct Attribute attribute;
+      attribute.name = info.name;
+      if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+        {
+          attribute.isPointer = true;
+          attributes.push_back (attribute);
+        }
+      else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+        {
+          attribute.isPointer = false;
+          attributes.push_back (attribute);
+        }
+      // this could be anything else and we don't know what to do with it.
+      // So, we just ignore it.
+    }
+  return attributes;
+}
+
+
 class Resolver
 {
 public:
@@ -242,12 +341,14 @@ public:
   void Resolve (Ptr<Object> root);
 private:
   void Canonicalize (void);
-  void DoResolve (std::string path, Ptr<Object> root);
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void Compile (void);
+  void DoResolve (uint32_t segment, Ptr<Object> root);
+  void DoArrayResolve (uint32_t segment, const ObjectPtrContainerValue &vector);
   void DoResolveOne (Ptr<Object> object);
   std::string GetResolvedPath (void) const;
   virtual void DoOne (Ptr<Object> object, std::string path) = 0;
   std::vector<std::string> m_workStack;
+  std::vector<PathSegment> m_segments;
   std::string m_path;
 };
 
@@ -256,6 +357,7 @@ Resolver::Resolver (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
   Canonicalize ();
+  Compile ();
 }
 Resolver::~Resolver ()
 {
@@ -281,12 +383,28 @@ Resolver::Canonicalize (void)
     }
 }
 
+void
+Resolver::Compile (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // split the path into the items found between its slashes.
+  std::string::size_type start = 0;
+  std::string::size_type next = m_path.find ("/", 1);
+  while (next != std::string::npos)
+    {
+      m_segments.push_back (PathSegment (m_path.substr (start + 1, next - (start + 1))));
+      start = next;
+      next = m_path.find ("/", start + 1);
+    }
+}
+
 void 
 Resolver::Resolve (Ptr<Object> root)
 {
   NS_LOG_FUNCTION (this << root);
 
-  DoResolve (m_path, root);
+  DoResolve (0, root);
 }
 
 std::string
@@ -312,13 +430,11 @@ Resolver::DoResolveOne (Ptr<Object> object)
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+Resolver::DoResolve (uint32_t segment, Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << segment << root);
 
-  if (next == std::string::npos)
+  if (segment == m_segments.size ())
     {
       //
       // If root is zero, we're beginning to see if we can use the object name 
@@ -334,8 +450,8 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
         }
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  PathSegment &current = m_segments[segment];
+  const std::string &item = current.item;
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -346,11 +462,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   //
   if (root == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
+      if (item.compare (0, 5, "Names") == 0)
         {
           m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
+          DoResolve (segment + 1, root);
           m_workStack.pop_back ();
           return;
         }
@@ -367,7 +482,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
       m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      DoResolve (segment + 1, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -383,43 +498,33 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       return;
     }
-  std::string::size_type dollarPos = item.find ("$");
-  if (dollarPos == 0)
+  if (current.isGetObject)
     {
       // This is a call to GetObject
-      std::string tidString = item.substr (1, item.size () - 1);
-      NS_LOG_DEBUG ("GetObject="<<tidString<<" on path="<<GetResolvedPath ());
-      TypeId tid = TypeId::LookupByName (tidString);
-      Ptr<Object> object = root->GetObject<Object> (tid);
+      NS_LOG_DEBUG ("GetObject="<<item<<" on path="<<GetResolvedPath ());
+      Ptr<Object> object = root->GetObject<Object> (current.GetObjectTypeId ());
       if (object == 0)
         {
-          NS_LOG_DEBUG ("GetObject ("<<tidString<<") failed on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("GetObject ("<<item<<") failed on path="<<GetResolvedPath ());
           return;
         }
       m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      DoResolve (segment + 1, object);
       m_workStack.pop_back ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid = root->GetInstanceTypeId ();
+      const PathSegment::Attributes &attributes = current.GetAttributes (root->GetInstanceTypeId ());
       bool foundMatch = false;
-      for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+      for (uint32_t i = 0; i < attributes.size (); i++)
         {
-          struct TypeId::AttributeInformation info;
-          info = tid.GetAttribute(i);
-          if (info.name != item && item != "*")
-            {
-              continue;
-            }
-          // attempt to cast to a pointer checker.
-          const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-          if (ptr != 0)
+          const struct PathSegment::Attribute &attribute = attributes[i];
+          if (attribute.isPointer)
             {
-              NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<attribute.name<<" on path="<<GetResolvedPath ());
               PointerValue ptr;
-              root->GetAttribute (info.name, ptr);
+              root->GetAttribute (attribute.name, ptr);
               Ptr<Object> object = ptr.Get<Object> ();
               if (object == 0)
                 {
@@ -429,25 +534,20 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
                   continue;
                 }
               foundMatch = true;
-              m_workStack.push_back (info.name);
-              DoResolve (pathLeft, object);
+              m_workStack.push_back (attribute.name);
+              DoResolve (segment + 1, object);
               m_workStack.pop_back ();
             }
-          // attempt to cast to an object vector.
-          const ObjectPtrContainerChecker *vectorChecker = 
-            dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-          if (vectorChecker != 0)
+          else
             {
-              NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<attribute.name<<" on path="<<GetResolvedPath ());
               foundMatch = true;
               ObjectPtrContainerValue vector;
-              root->GetAttribute (info.name, vector);
-              m_workStack.push_back (info.name);
-              DoArrayResolve (pathLeft, vector);
+              root->GetAttribute (attribute.name, vector);
+              m_workStack.push_back (attribute.name);
+              DoArrayResolve (segment + 1, vector);
               m_workStack.pop_back ();
             }
-          // this could be anything else and we don't know what to do with it.
-          // So, we just ignore it.
         }
       if (!foundMatch)
         {
@@ -458,20 +558,15 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (uint32_t segment, const ObjectPtrContainerValue &container)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION(this << segment << &container);
+  if (segment == m_segments.size ())
     {
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
 
-  ArrayMatcher matcher = ArrayMatcher (item);
+  const ArrayMatcher &matcher = m_segments[segment].matcher;
   ObjectPtrContainerValue::Iterator it;
   for (it = container.Begin (); it != container.End (); ++it)
     {
@@ -480,13 +575,12 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
           std::ostringstream oss;
           oss << (*it).first;
           m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
+          DoResolve (segment + 1, (*it).second);
           m_workStack.pop_back ();
         }
     }
 }
 
-
 class ConfigImpl 
 {
 public:
@@ -496,6 +590,7 @@ public:
   void DisconnectWithoutContext (std::string path, const CallbackBase &cb);
   void Disconnect (std::string path, const CallbackBase &cb);
   Config::MatchContainer LookupMatches (std::string path);
+  void InvalidateMatchCache (void);
 
   void RegisterRootNamespaceObject (Ptr<Object> obj);
   void UnregisterRootNamespaceObject (Ptr<Object> obj);
@@ -507,6 +602,7 @@ private:
   void ParsePath (std::string path, std::string *root, std::string *leaf) const;
   typedef std::vector<Ptr<Object> > Roots;
   Roots m_roots;
+  std::map<std::string, Config::MatchContainer> m_matches;
 };
 
 void 
@@ -530,6 +626,11 @@ ConfigImpl::Set (std::string path, const AttributeValue &value)
   ParsePath (path, &root, &leaf);
   Config::MatchContainer container = LookupMatches (root);
   container.Set (leaf, value);
+  if (dynamic_cast<const PointerValue *> (&value) != 0)
+    {
+      // the objects referenced by the matched objects changed.
+      InvalidateMatchCache ();
+    }
 }
 void 
 ConfigImpl::ConnectWithoutContext (std::string path, const CallbackBase &cb)
@@ -574,6 +675,17 @@ Config::MatchContainer
 ConfigImpl::LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
+  BooleanValue cache;
+  g_configMatchCache.GetValue (cache);
+  if (cache.Get ())
+    {
+      std::map<std::string, Config::MatchContainer>::const_iterator found = m_matches.find (path);
+      if (found != m_matches.end ())
+        {
+          NS_LOG_DEBUG ("cached matches for path=" << path);
+          return found->second;
+        }
+    }
   class LookupMatchesResolver : public Resolver 
   {
   public:
@@ -599,7 +711,19 @@ ConfigImpl::LookupMatches (std::string path)
   //
   resolver.Resolve (0);
 
-  return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
+  Config::MatchContainer matches (resolver.m_objects, resolver.m_contexts, path);
+  if (cache.Get ())
+    {
+      m_matches[path] = matches;
+    }
+  return matches;
+}
+
+void
+ConfigImpl::InvalidateMatchCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_matches.clear ();
 }
 
 void 
@@ -607,6 +731,7 @@ ConfigImpl::RegisterRootNamespaceObject (Ptr<Object> obj)
 {
   NS_LOG_FUNCTION (this << obj);
   m_roots.push_back (obj);
+  InvalidateMatchCache ();
 }
 
 void 
@@ -619,6 +744,7 @@ ConfigImpl::UnregisterRootNamespaceObject (Ptr<Object> obj)
       if (*i == obj)
         {
           m_roots.erase (i);
+          InvalidateMatchCache ();
           return;
         }
     }
@@ -742,6 +868,12 @@ Config::MatchContainer LookupMatches (std::string path)
   return Singleton<ConfigImpl>::Get ()->LookupMatches (path);
 }
 
+void InvalidateMatchCache (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Singleton<ConfigImpl>::Get ()->InvalidateMatchCache ();
+}
+
 void RegisterRootNamespaceObject (Ptr<Object> obj)
 {
   NS_LOG_FUNCTION (obj);
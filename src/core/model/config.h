@@ -222,6 +222,23 @@ private:
  */
 MatchContainer LookupMatches (std::string path);
 
+/**
+ * Discard the results of LookupMatches cached so far.
+ *
+ * When the global value ConfigMatchCache is true, the objects matched by
+ * a path are cached until the object graph changes, so that the
+ * functions of this namespace called on the same path, such as several
+ * Config::Connect calls on the trace sources of the same objects, walk
+ * the object graph only once. The cache is discarded automatically when
+ * a root namespace object is registered or unregistered, when an object
+ * is named or aggregated to another, when a node, a device or an
+ * application is added to the simulation, and when the node list or the
+ * simulation is destroyed. Any other change to the
+ * objects referenced by the attributes of the objects of the graph must
+ * be followed by a call to this function.
+ */
+void InvalidateMatchCache (void);
+
 /**
  * \param obj a new root object
  *
@@ -25,10 +25,14 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "double.h"
+#include "uinteger.h"
 #include "assert.h"
 #include "log.h"
 
 #include <cmath>
+#include <algorithm>
+#include <vector>
 
 // Note:  Logging in this file is largely avoided due to the
 // number of calls that are made to these functions and the possibility
@@ -46,6 +50,17 @@ DefaultSimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::DefaultSimulatorImpl")
     .SetParent<SimulatorImpl> ()
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CancelledPurgeRatio",
+                   "Remove the cancelled events from the scheduler once there are more than "
+                   "this many times as many of them as live events. Zero disables purging.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&DefaultSimulatorImpl::m_purgeRatio),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("CancelledPurgeMinimum",
+                   "The number of cancelled events below which they are never purged.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::m_purgeMinimum),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -64,6 +79,8 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
+  m_peakEvents = 0;
   m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
 }
@@ -132,6 +149,11 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
+  if (next.impl->IsCancelCounted ())
+    {
+      // events cancelled without Simulator::Cancel are not counted.
+      m_cancelledEvents--;
+    }
 
   NS_LOG_LOGIC ("handle " << next.key.m_ts);
   m_currentTs = next.key.m_ts;
@@ -175,6 +197,7 @@ DefaultSimulatorImpl::ProcessEventsWithContext (void)
        ev.key.m_uid = m_uid;
        m_uid++;
        m_unscheduledEvents++;
+       m_peakEvents = std::max (m_peakEvents, m_unscheduledEvents);
        m_events->Insert (ev);
     }
 }
@@ -232,6 +255,7 @@ DefaultSimulatorImpl::Schedule (Time const &time, EventImpl *event)
   ev.key.m_uid = m_uid;
   m_uid++;
   m_unscheduledEvents++;
+  m_peakEvents = std::max (m_peakEvents, m_unscheduledEvents);
   m_events->Insert (ev);
   return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
 }
@@ -251,6 +275,7 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, E
       ev.key.m_uid = m_uid;
       m_uid++;
       m_unscheduledEvents++;
+      m_peakEvents = std::max (m_peakEvents, m_unscheduledEvents);
       m_events->Insert (ev);
     }
   else
@@ -279,6 +304,7 @@ DefaultSimulatorImpl::ScheduleNow (EventImpl *event)
   ev.key.m_uid = m_uid;
   m_uid++;
   m_unscheduledEvents++;
+  m_peakEvents = std::max (m_peakEvents, m_unscheduledEvents);
   m_events->Insert (ev);
   return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
 }
@@ -353,7 +379,33 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          id.PeekEventImpl ()->SetCancelCounted ();
+          m_cancelledEvents++;
+          if (m_purgeRatio > 0
+              && (uint32_t)m_cancelledEvents >= m_purgeMinimum
+              && m_cancelledEvents > m_purgeRatio * (m_unscheduledEvents - m_cancelledEvents))
+            {
+              PurgeCancelled ();
+            }
+        }
+    }
+}
+
+void
+DefaultSimulatorImpl::PurgeCancelled (void)
+{
+  NS_LOG_FUNCTION (this << m_cancelledEvents << m_unscheduledEvents);
+  std::vector<Scheduler::Event> removed;
+  m_events->RemoveCancelled (removed);
+  for (std::vector<Scheduler::Event>::const_iterator i = removed.begin (); i != removed.end (); ++i)
+    {
+      // whenever we remove an event from the event list, we have to unref it.
+      i->impl->Unref ();
     }
+  m_unscheduledEvents -= removed.size ();
+  m_cancelledEvents = 0;
 }
 
 bool
@@ -404,4 +456,22 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint32_t
+DefaultSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_cancelledEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_cancelledEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetPeakEventCount (void) const
+{
+  return m_peakEvents;
+}
+
 } // namespace ns3
@@ -62,10 +62,14 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
+  virtual uint32_t GetPeakEventCount (void) const;
 
 private:
   virtual void DoDispose (void);
   void ProcessOneEvent (void);
+  void PurgeCancelled (void);
   void ProcessEventsWithContext (void);
  
   struct EventWithContext {
@@ -90,6 +94,13 @@ private:
   // number of events that have been inserted but not yet scheduled,
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
+  // number of events of m_unscheduledEvents cancelled with Cancel
+  int m_cancelledEvents;
+  int m_peakEvents;
+  // purge the cancelled events once there are more than m_purgeRatio
+  // times as many as the live events, and at least m_purgeMinimum
+  double m_purgeRatio;
+  uint32_t m_purgeMinimum;
 
   SystemThread::ThreadId m_main;
 };
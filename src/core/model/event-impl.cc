@@ -20,18 +20,420 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include "ns3/core-config.h"
+#include <new>
+#include <cstring>
+#include <cstdlib>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
 namespace ns3 {
 
+#if defined (__GNUC__)
+// the pool relies on thread-local storage and on the atomic builtins.
+#define EVENT_POOL_ENABLED 1
+#endif
+
+// block sizes are multiples of this, which also preserves the alignment
+// of the slabs.
+static const std::size_t EVENT_POOL_GRANULARITY = 16;
+static const std::size_t EVENT_POOL_MAX_SIZE = 256;
+// slabs are aligned on their size, so that the slab of a block is found
+// by masking its address.
+static const std::size_t EVENT_POOL_SLAB_SIZE = 16384;
+static const uint32_t EVENT_POOL_N_CLASSES = EVENT_POOL_MAX_SIZE / EVENT_POOL_GRANULARITY;
+
+struct EventPoolBlock
+{
+  EventPoolBlock *m_next;
+};
+
+#ifdef EVENT_POOL_ENABLED
+struct EventPoolThread;
+
+// The header at the start of each slab. A slab is carved into blocks of
+// a single size class, and belongs to the thread state which allocated
+// it: only that thread allocates from it and links its blocks back into
+// it.
+struct EventPoolSlab
+{
+  EventPoolThread *m_owner;
+  // the slab is in the list of the slabs of its class which have free
+  // blocks in its owner if m_free is not zero, and in the list of its
+  // full slabs otherwise, so that all the slabs remain reachable for
+  // leak checkers.
+  EventPoolSlab *m_prev;
+  EventPoolSlab *m_next;
+  EventPoolBlock *m_free;
+  uint32_t m_sizeClass;
+  // the number of blocks allocated and not yet returned to the slab
+  uint32_t m_used;
+};
+
+static const std::size_t EVENT_POOL_HEADER_SIZE =
+  (sizeof (EventPoolSlab) + EVENT_POOL_GRANULARITY - 1) / EVENT_POOL_GRANULARITY * EVENT_POOL_GRANULARITY;
+
+// The slabs and the memory statistics of a thread. A block released by
+// its owner thread is linked back into its slab, and a block released
+// by another thread is pushed on the remote list of the owner, which
+// takes the remote blocks back when it runs out of free blocks of a
+// class. The statistics are only written by their thread, so that
+// allocating and releasing an event in the same thread needs no atomic
+// operation. A slab is returned to the system when all its blocks are
+// free, unless it is the last slab of its class in its owner.
+//
+// The state of a thread which exits is retired, with its slabs and
+// its statistics, and adopted by the next thread which allocates an
+// event: threads which come and go, like the workers of the
+// MultithreadedSimulatorImpl, reuse the same blocks.
+struct EventPoolThread
+{
+  EventPoolSlab *m_slabs[EVENT_POOL_N_CLASSES];
+  EventPoolSlab *m_fullSlabs;
+  // pushed by the other threads, with an atomic compare and swap
+  EventPoolBlock *volatile m_remote;
+  // these may be read by other threads
+  volatile int64_t m_live;
+  volatile int64_t m_peak;
+  EventPoolThread *m_next;        //!< the next state of g_eventPoolThreads
+  EventPoolThread *m_nextRetired; //!< the next state of g_eventPoolRetired
+};
+
+static __thread EventPoolThread *g_eventPoolThread = 0;
+// these are protected by g_eventPoolLock
+static EventPoolThread *g_eventPoolThreads = 0;
+static EventPoolThread *g_eventPoolRetired = 0;
+static volatile int g_eventPoolLock = 0;
+
+static void
+EventPoolLock (void)
+{
+  while (__sync_lock_test_and_set (&g_eventPoolLock, 1))
+    {
+    }
+}
+
+static void
+EventPoolUnlock (void)
+{
+  __sync_lock_release (&g_eventPoolLock);
+}
+
+#ifdef HAVE_PTHREAD_H
+static pthread_key_t g_eventPoolKey;
+static pthread_once_t g_eventPoolKeyOnce = PTHREAD_ONCE_INIT;
+
+static void
+EventPoolRetire (void *p)
+{
+  EventPoolThread *state = static_cast<EventPoolThread *> (p);
+  EventPoolLock ();
+  state->m_nextRetired = g_eventPoolRetired;
+  g_eventPoolRetired = state;
+  EventPoolUnlock ();
+}
+
+static void
+EventPoolCreateKey (void)
+{
+  pthread_key_create (&g_eventPoolKey, &EventPoolRetire);
+}
+#endif /* HAVE_PTHREAD_H */
+
+static EventPoolThread *
+EventPoolAttach (void)
+{
+  EventPoolLock ();
+  EventPoolThread *state = g_eventPoolRetired;
+  if (state != 0)
+    {
+      g_eventPoolRetired = state->m_nextRetired;
+    }
+  else
+    {
+      state = new EventPoolThread ();
+      std::memset (state, 0, sizeof (*state));
+      state->m_next = g_eventPoolThreads;
+      g_eventPoolThreads = state;
+    }
+  EventPoolUnlock ();
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_eventPoolKeyOnce, &EventPoolCreateKey);
+  pthread_setspecific (g_eventPoolKey, state);
+#endif /* HAVE_PTHREAD_H */
+  g_eventPoolThread = state;
+  return state;
+}
+
+static inline EventPoolThread *
+EventPoolGetThread (void)
+{
+  EventPoolThread *state = g_eventPoolThread;
+  if (state == 0)
+    {
+      state = EventPoolAttach ();
+    }
+  return state;
+}
+
+static inline EventPoolSlab *
+EventPoolGetSlab (void *block)
+{
+  return reinterpret_cast<EventPoolSlab *> (reinterpret_cast<uintptr_t> (block)
+                                            & ~static_cast<uintptr_t> (EVENT_POOL_SLAB_SIZE - 1));
+}
+
+static void
+EventPoolLink (EventPoolSlab **list, EventPoolSlab *slab)
+{
+  slab->m_prev = 0;
+  slab->m_next = *list;
+  if (slab->m_next != 0)
+    {
+      slab->m_next->m_prev = slab;
+    }
+  *list = slab;
+}
+
+static void
+EventPoolUnlink (EventPoolSlab **list, EventPoolSlab *slab)
+{
+  if (slab->m_prev != 0)
+    {
+      slab->m_prev->m_next = slab->m_next;
+    }
+  else
+    {
+      *list = slab->m_next;
+    }
+  if (slab->m_next != 0)
+    {
+      slab->m_next->m_prev = slab->m_prev;
+    }
+}
+
+static EventPoolSlab *
+EventPoolCreateSlab (EventPoolThread *state, uint32_t sizeClass)
+{
+  void *memory;
+  if (posix_memalign (&memory, EVENT_POOL_SLAB_SIZE, EVENT_POOL_SLAB_SIZE) != 0)
+    {
+      throw std::bad_alloc ();
+    }
+  uint8_t *start = static_cast<uint8_t *> (memory);
+  EventPoolSlab *slab = static_cast<EventPoolSlab *> (memory);
+  slab->m_owner = state;
+  slab->m_free = 0;
+  slab->m_sizeClass = sizeClass;
+  slab->m_used = 0;
+  std::size_t blockSize = (sizeClass + 1) * EVENT_POOL_GRANULARITY;
+  for (std::size_t offset = EVENT_POOL_HEADER_SIZE;
+       offset + blockSize <= EVENT_POOL_SLAB_SIZE;
+       offset += blockSize)
+    {
+      EventPoolBlock *block = reinterpret_cast<EventPoolBlock *> (start + offset);
+      block->m_next = slab->m_free;
+      slab->m_free = block;
+    }
+  EventPoolLink (&state->m_slabs[sizeClass], slab);
+  return slab;
+}
+
+// link a block back into its slab, which belongs to state.
+static void
+EventPoolRelease (EventPoolThread *state, EventPoolSlab *slab, EventPoolBlock *block)
+{
+  if (slab->m_free == 0)
+    {
+      EventPoolUnlink (&state->m_fullSlabs, slab);
+      EventPoolLink (&state->m_slabs[slab->m_sizeClass], slab);
+    }
+  block->m_next = slab->m_free;
+  slab->m_free = block;
+  slab->m_used--;
+  if (slab->m_used == 0 && (slab->m_prev != 0 || slab->m_next != 0))
+    {
+      EventPoolUnlink (&state->m_slabs[slab->m_sizeClass], slab);
+      std::free (slab);
+    }
+}
+
+// take back the blocks released by the other threads.
+static void
+EventPoolDrain (EventPoolThread *state)
+{
+  EventPoolBlock *block;
+  do
+    {
+      block = state->m_remote;
+    }
+  while (!__sync_bool_compare_and_swap (&state->m_remote, block, 0));
+  while (block != 0)
+    {
+      EventPoolBlock *next = block->m_next;
+      EventPoolRelease (state, EventPoolGetSlab (block), block);
+      block = next;
+    }
+}
+
+static inline void *
+EventPoolAllocate (EventPoolThread *state, uint32_t sizeClass)
+{
+  EventPoolSlab *slab = state->m_slabs[sizeClass];
+  if (slab == 0)
+    {
+      if (state->m_remote != 0)
+        {
+          EventPoolDrain (state);
+          slab = state->m_slabs[sizeClass];
+        }
+      if (slab == 0)
+        {
+          slab = EventPoolCreateSlab (state, sizeClass);
+        }
+    }
+  EventPoolBlock *block = slab->m_free;
+  slab->m_free = block->m_next;
+  slab->m_used++;
+  if (slab->m_free == 0)
+    {
+      EventPoolUnlink (&state->m_slabs[sizeClass], slab);
+      EventPoolLink (&state->m_fullSlabs, slab);
+    }
+  return block;
+}
+
+static inline void
+EventPoolFree (EventPoolThread *state, void *p)
+{
+  EventPoolBlock *block = static_cast<EventPoolBlock *> (p);
+  EventPoolSlab *slab = EventPoolGetSlab (block);
+  EventPoolThread *owner = slab->m_owner;
+  if (owner == state)
+    {
+      EventPoolRelease (state, slab, block);
+      return;
+    }
+  EventPoolBlock *head;
+  do
+    {
+      head = owner->m_remote;
+      block->m_next = head;
+    }
+  while (!__sync_bool_compare_and_swap (&owner->m_remote, head, block));
+}
+
+static inline void
+EventPoolCount (EventPoolThread *state, int64_t delta)
+{
+  int64_t live = state->m_live + delta;
+  state->m_live = live;
+  if (live > state->m_peak)
+    {
+      state->m_peak = live;
+    }
+}
+#else
+static int64_t g_eventLiveMemory = 0;
+static int64_t g_eventPeakMemory = 0;
+#endif
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+#ifdef EVENT_POOL_ENABLED
+  EventPoolThread *state = EventPoolGetThread ();
+  if (size <= EVENT_POOL_MAX_SIZE)
+    {
+      uint32_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+      void *block = EventPoolAllocate (state, sizeClass);
+      EventPoolCount (state, (sizeClass + 1) * EVENT_POOL_GRANULARITY);
+      return block;
+    }
+  EventPoolCount (state, size);
+  return ::operator new (size);
+#else
+  g_eventLiveMemory += size;
+  if (g_eventLiveMemory > g_eventPeakMemory)
+    {
+      g_eventPeakMemory = g_eventLiveMemory;
+    }
+  return ::operator new (size);
+#endif
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+#ifdef EVENT_POOL_ENABLED
+  EventPoolThread *state = EventPoolGetThread ();
+  if (size <= EVENT_POOL_MAX_SIZE)
+    {
+      uint32_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+      EventPoolCount (state, -static_cast<int64_t> ((sizeClass + 1) * EVENT_POOL_GRANULARITY));
+      EventPoolFree (state, p);
+      return;
+    }
+  EventPoolCount (state, -static_cast<int64_t> (size));
+#else
+  g_eventLiveMemory -= size;
+#endif
+  ::operator delete (p);
+}
+
+uint64_t
+EventImpl::GetLiveMemory (void)
+{
+#ifdef EVENT_POOL_ENABLED
+  // the statistics of the other threads may be slightly out of date.
+  int64_t live = 0;
+  EventPoolLock ();
+  for (EventPoolThread *state = g_eventPoolThreads; state != 0; state = state->m_next)
+    {
+      live += state->m_live;
+    }
+  EventPoolUnlock ();
+  return live;
+#else
+  return g_eventLiveMemory;
+#endif
+}
+
+uint64_t
+EventImpl::GetPeakMemory (void)
+{
+#ifdef EVENT_POOL_ENABLED
+  // the sum of the peaks of the threads, which is the actual peak when
+  // a single thread allocates and releases events, and an upper bound
+  // of it otherwise.
+  int64_t peak = 0;
+  EventPoolLock ();
+  for (EventPoolThread *state = g_eventPoolThreads; state != 0; state = state->m_next)
+    {
+      peak += state->m_peak;
+    }
+  EventPoolUnlock ();
+  return peak;
+#else
+  return g_eventPeakMemory;
+#endif
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
 }
 
 EventImpl::EventImpl ()
-  : m_cancel (false)
+  : m_cancel (false),
+    m_cancelCounted (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -60,4 +462,24 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void
+EventImpl::SetCancelCounted (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_cancelCounted = true;
+}
+
+bool
+EventImpl::IsCancelCounted (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_cancelCounted;
+}
+
+uintptr_t
+EventImpl::GetHandler (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 namespace ns3 {
@@ -35,6 +36,14 @@ namespace ns3 {
  * obviously (there are Ref and Unref methods) reference-counted and
  * most subclasses are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * The memory of all subclasses is allocated from fixed size blocks
+ * carved out of larger slabs owned by each thread, so that the arguments
+ * bound by MakeEvent are stored inline in a recycled block rather than
+ * in a fresh heap allocation. A block released by another thread is
+ * handed back to the thread which owns its slab, and the slabs whose
+ * blocks are all free are returned to the heap. Objects larger than the
+ * biggest block size are allocated from the heap.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -57,12 +66,55 @@ public:
    * Invoked by the simulation engine before calling Invoke.
    */
   bool IsCancelled (void);
+  /**
+   * Marks the event as counted by the simulation engine among its
+   * cancelled events, to tell it from the events cancelled directly
+   * with Cancel, which the engine does not see.
+   */
+  void SetCancelCounted (void);
+  /**
+   * \returns true if SetCancelCounted was invoked.
+   */
+  bool IsCancelCounted (void) const;
+  /**
+   * \returns an identifier of the function or method invoked by this
+   *          event, which tells apart the events of the same type
+   *          invoking different functions or methods with the same
+   *          signature, or zero if the subclass provides none.
+   *
+   * The events created by MakeEvent return GetEventHandler of the
+   * function or method they invoke.
+   */
+  virtual uintptr_t GetHandler (void) const;
+
+  /**
+   * \param size the size of the subclass being allocated
+   * \returns a block of at least size bytes
+   */
+  static void *operator new (std::size_t size);
+  /**
+   * \param p the block to release
+   * \param size the size of the subclass being released
+   */
+  static void operator delete (void *p, std::size_t size);
+  /**
+   * \returns the number of bytes currently allocated to events,
+   *          including the rounding to the pool block sizes.
+   */
+  static uint64_t GetLiveMemory (void);
+  /**
+   * \returns the largest value ever returned by GetLiveMemory, or an
+   *          upper bound of it if events were allocated or released by
+   *          several threads.
+   */
+  static uint64_t GetPeakMemory (void);
 
 protected:
   virtual void Notify (void) = 0;
 
 private:
   bool m_cancel;
+  bool m_cancelCounted;
 };
 
 } // namespace ns3
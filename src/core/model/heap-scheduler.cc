@@ -143,10 +143,10 @@ HeapScheduler::IsEmpty (void) const
 }
 
 void
-HeapScheduler::BottomUp (void)
+HeapScheduler::BottomUp (uint32_t start)
 {
-  NS_LOG_FUNCTION (this);
-  uint32_t index = Last ();
+  NS_LOG_FUNCTION (this << start);
+  uint32_t index = start;
   while (!IsRoot (index)
          && IsLessStrictly (index, Parent (index)))
     {
@@ -196,7 +196,7 @@ HeapScheduler::Insert (const Event &ev)
 {
   NS_LOG_FUNCTION (this << &ev);
   m_heap.push_back (ev);
-  BottomUp ();
+  BottomUp (Last ());
 }
 
 Scheduler::Event
@@ -229,12 +229,44 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
+          if (IsBottom (i))
+            {
+              return;
+            }
+          // the element moved into the hole may belong either
+          // below or above it.
           TopDown (i);
+          BottomUp (i);
           return;
         }
     }
   NS_ASSERT (false);
 }
 
+void
+HeapScheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t n = 1;
+  for (uint32_t i = 1; i < m_heap.size (); i++)
+    {
+      if (m_heap[i].impl->IsCancelled ())
+        {
+          removed.push_back (m_heap[i]);
+        }
+      else
+        {
+          m_heap[n] = m_heap[i];
+          n++;
+        }
+    }
+  m_heap.resize (n);
+  // rebuild the heap from the bottom up.
+  for (uint32_t i = Last () / 2; i >= Root (); i--)
+    {
+      TopDown (i);
+    }
+}
+
 } // namespace ns3
 
@@ -57,6 +57,7 @@ public:
   virtual Event PeekNext (void) const;
   virtual Event RemoveNext (void);
   virtual void Remove (const Event &ev);
+  virtual void RemoveCancelled (std::vector<Event> &removed);
 
 private:
   typedef std::vector<Event> BinaryHeap;
@@ -74,7 +75,7 @@ private:
   inline uint32_t Smallest (uint32_t a, uint32_t b) const;
 
   inline void Exch (uint32_t a, uint32_t b);
-  void BottomUp (void);
+  void BottomUp (uint32_t start);
   void TopDown (uint32_t start);
 
   BinaryHeap m_heap;
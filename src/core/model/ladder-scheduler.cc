@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+// a bucket holding more events than this is split into a new rung
+// rather than being sorted into the bottom.
+static const uint32_t LADDER_THRESHOLD = 50;
+// the bottom is converted into a rung when it grows beyond this size.
+static const uint32_t LADDER_BOTTOM_MAX = 4 * LADDER_THRESHOLD;
+static const uint32_t LADDER_MAX_RUNGS = 8;
+static const uint32_t LADDER_MAX_BUCKETS = 65536;
+
+static bool
+IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (0),
+    m_topMax (0),
+    m_rungs (LADDER_MAX_RUNGS),
+    m_nRungs (0),
+    m_qSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.m_start + rung.m_current * rung.m_width;
+}
+
+void
+LadderScheduler::InitRung (uint32_t index, uint64_t start, uint64_t width, uint32_t nBuckets)
+{
+  NS_LOG_FUNCTION (this << index << start << width << nBuckets);
+  NS_ASSERT (index < LADDER_MAX_RUNGS);
+  Rung &rung = m_rungs[index];
+  NS_ASSERT (rung.m_count == 0);
+  rung.m_start = start;
+  rung.m_width = width;
+  rung.m_nBuckets = nBuckets;
+  rung.m_current = 0;
+  rung.m_count = 0;
+  if (rung.m_buckets.size () < nBuckets)
+    {
+      // buckets released by a previous rung are empty but keep
+      // their capacity, so only the missing ones are created.
+      rung.m_buckets.resize (nBuckets);
+    }
+}
+
+void
+LadderScheduler::InsertInRung (Rung &rung, const Event &ev)
+{
+  uint64_t bucket = (ev.key.m_ts - rung.m_start) / rung.m_width;
+  NS_ASSERT (bucket >= rung.m_current && bucket < rung.m_nBuckets);
+  rung.m_buckets[bucket].push_back (ev);
+  rung.m_count++;
+}
+
+void
+LadderScheduler::InsertInBottom (const Event &ev)
+{
+  Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+  m_bottom.insert (i, ev);
+  if (m_bottom.size () > LADDER_BOTTOM_MAX
+      && m_nRungs < LADDER_MAX_RUNGS
+      && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+    {
+      SpawnRungFromBottom ();
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  if (ev.key.m_ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ev.key.m_ts;
+          m_topMax = ev.key.m_ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ev.key.m_ts);
+          m_topMax = std::max (m_topMax, ev.key.m_ts);
+        }
+      m_top.push_back (ev);
+    }
+  else
+    {
+      uint32_t i;
+      for (i = 0; i < m_nRungs; i++)
+        {
+          if (ev.key.m_ts >= CurrentStart (m_rungs[i]))
+            {
+              InsertInRung (m_rungs[i], ev);
+              break;
+            }
+        }
+      if (i == m_nRungs)
+        {
+          InsertInBottom (ev);
+        }
+    }
+  m_qSize++;
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_qSize == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  // Refill is always invoked eagerly so the bottom is never empty
+  // while the queue is not.
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_qSize--;
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  NS_LOG_LOGIC ("remove ts=" << ev.key.m_ts << ", key=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  Bucket *bucket = 0;
+  uint32_t rung = m_nRungs;
+  if (ev.key.m_ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      for (rung = 0; rung < m_nRungs; rung++)
+        {
+          const Rung &r = m_rungs[rung];
+          if (ev.key.m_ts >= CurrentStart (r))
+            {
+              bucket = &m_rungs[rung].m_buckets[(ev.key.m_ts - r.m_start) / r.m_width];
+              break;
+            }
+        }
+    }
+  if (bucket != 0)
+    {
+      // the top and the rung buckets are unsorted: swap with the last
+      // element to avoid shifting the rest of the array.
+      Bucket::iterator end = bucket->end ();
+      for (Bucket::iterator i = bucket->begin (); i != end; ++i)
+        {
+          if (i->key.m_uid == ev.key.m_uid)
+            {
+              NS_ASSERT (ev.impl == i->impl);
+              *i = bucket->back ();
+              bucket->pop_back ();
+              if (rung < m_nRungs)
+                {
+                  m_rungs[rung].m_count--;
+                }
+              m_qSize--;
+              return;
+            }
+        }
+      NS_ASSERT (false);
+    }
+  Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+  NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+  NS_ASSERT (ev.impl == i->impl);
+  m_bottom.erase (i);
+  m_qSize--;
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+uint32_t
+LadderScheduler::RemoveCancelledFrom (Bucket &bucket, std::vector<Event> &removed)
+{
+  NS_LOG_FUNCTION (&bucket << bucket.size ());
+  // preserve the order of the remaining events: the bottom is sorted.
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < bucket.size (); i++)
+    {
+      if (bucket[i].impl->IsCancelled ())
+        {
+          removed.push_back (bucket[i]);
+        }
+      else
+        {
+          bucket[n] = bucket[i];
+          n++;
+        }
+    }
+  uint32_t nRemoved = bucket.size () - n;
+  bucket.resize (n);
+  return nRemoved;
+}
+
+void
+LadderScheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  m_qSize -= RemoveCancelledFrom (m_top, removed);
+  Bucket::const_iterator end = m_top.end ();
+  for (Bucket::const_iterator i = m_top.begin (); i != end; ++i)
+    {
+      if (i == m_top.begin ())
+        {
+          m_topMin = i->key.m_ts;
+          m_topMax = i->key.m_ts;
+        }
+      m_topMin = std::min (m_topMin, i->key.m_ts);
+      m_topMax = std::max (m_topMax, i->key.m_ts);
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      for (uint32_t j = rung.m_current; j < rung.m_nBuckets; j++)
+        {
+          uint32_t n = RemoveCancelledFrom (rung.m_buckets[j], removed);
+          rung.m_count -= n;
+          m_qSize -= n;
+        }
+    }
+  m_qSize -= RemoveCancelledFrom (m_bottom, removed);
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+void
+LadderScheduler::FillBottom (const Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  m_bottom.assign (events.begin (), events.end ());
+  std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size () << m_topMin << m_topMax);
+  NS_ASSERT (!m_top.empty () && m_nRungs == 0);
+  if (m_top.size () <= LADDER_THRESHOLD || m_topMin == m_topMax)
+    {
+      FillBottom (m_top);
+      m_topStart = m_topMax + 1;
+    }
+  else
+    {
+      uint32_t nBuckets = std::min<uint32_t> (m_top.size (), LADDER_MAX_BUCKETS);
+      uint64_t width = (m_topMax - m_topMin) / nBuckets + 1;
+      InitRung (0, m_topMin, width, nBuckets);
+      m_nRungs = 1;
+      Bucket::const_iterator end = m_top.end ();
+      for (Bucket::const_iterator i = m_top.begin (); i != end; ++i)
+        {
+          InsertInRung (m_rungs[0], *i);
+        }
+      m_topStart = m_topMin + nBuckets * width;
+    }
+  m_top.clear ();
+}
+
+void
+LadderScheduler::SpawnRung (Rung &parent)
+{
+  Bucket &bucket = parent.m_buckets[parent.m_current];
+  NS_LOG_FUNCTION (this << m_nRungs << bucket.size ());
+  uint32_t nBuckets = std::min<uint32_t> (bucket.size (), LADDER_MAX_BUCKETS);
+  uint64_t width = (parent.m_width + nBuckets - 1) / nBuckets;
+  InitRung (m_nRungs, CurrentStart (parent), width, nBuckets);
+  Rung &child = m_rungs[m_nRungs];
+  m_nRungs++;
+  Bucket::const_iterator end = bucket.end ();
+  for (Bucket::const_iterator i = bucket.begin (); i != end; ++i)
+    {
+      InsertInRung (child, *i);
+    }
+  parent.m_count -= bucket.size ();
+  bucket.clear ();
+  parent.m_current++;
+}
+
+void
+LadderScheduler::SpawnRungFromBottom (void)
+{
+  NS_LOG_FUNCTION (this << m_nRungs << m_bottom.size ());
+  // the new rung must cover everything up to the first event which
+  // would not be inserted in the bottom.
+  uint64_t limit = m_topStart;
+  if (m_nRungs > 0)
+    {
+      limit = CurrentStart (m_rungs[m_nRungs - 1]);
+    }
+  uint64_t start = m_bottom.back ().key.m_ts;
+  uint32_t nBuckets = std::min<uint32_t> (m_bottom.size (), LADDER_MAX_BUCKETS);
+  uint64_t width = (limit - start) / nBuckets + 1;
+  InitRung (m_nRungs, start, width, nBuckets);
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  Bucket::const_iterator end = m_bottom.end ();
+  for (Bucket::const_iterator i = m_bottom.begin (); i != end; ++i)
+    {
+      InsertInRung (rung, *i);
+    }
+  m_bottom.clear ();
+  Refill ();
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty () && m_qSize > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          TransferTop ();
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.m_count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      NS_ASSERT (rung.m_current < rung.m_nBuckets);
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      if (bucket.size () > LADDER_THRESHOLD
+          && rung.m_width > 1
+          && m_nRungs < LADDER_MAX_RUNGS)
+        {
+          SpawnRung (rung);
+        }
+      else
+        {
+          FillBottom (bucket);
+          rung.m_count -= bucket.size ();
+          bucket.clear ();
+          rung.m_current++;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the algorithm described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Tang, Goh and Thng (2005). Events are
+ * kept in three tiers:
+ *  - Top: an unsorted array of all events later than m_topStart.
+ *  - Ladder: up to a fixed number of rungs of buckets. Each rung
+ *    subdivides one bucket of the rung above it and events are merely
+ *    appended to their bucket.
+ *  - Bottom: a small sorted array holding the earliest events.
+ *
+ * Events are only ever sorted once they reach the bottom, which is
+ * refilled lazily from the last rung (or from the top when the ladder
+ * is empty). Unlike the CalendarScheduler, bucket widths are derived
+ * from the events actually being transferred, so no sampling or
+ * global resize is ever needed and the amortized cost of insertion and
+ * removal is O(1).
+ *
+ * All tiers use contiguous std::vector storage, and the buckets of a
+ * rung are recycled (without releasing their capacity) when the rung
+ * is re-spawned, so steady-state operation does not allocate.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+  virtual void RemoveCancelled (std::vector<Event> &removed);
+
+private:
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  struct Rung
+  {
+    Rung ()
+      : m_start (0), m_width (1), m_nBuckets (0), m_current (0), m_count (0)
+    {
+    }
+    // timestamp of the start of the first bucket
+    uint64_t m_start;
+    // duration of a bucket
+    uint64_t m_width;
+    // number of buckets in use (m_buckets may be larger)
+    uint32_t m_nBuckets;
+    // index of the first bucket not yet transferred downwards
+    uint32_t m_current;
+    // number of events stored in this rung
+    uint32_t m_count;
+    std::vector<Bucket> m_buckets;
+  };
+
+  inline uint64_t CurrentStart (const Rung &rung) const;
+  void InitRung (uint32_t index, uint64_t start, uint64_t width, uint32_t nBuckets);
+  void InsertInRung (Rung &rung, const Event &ev);
+  void InsertInBottom (const Event &ev);
+  void TransferTop (void);
+  void SpawnRung (Rung &parent);
+  void SpawnRungFromBottom (void);
+  void FillBottom (const Bucket &events);
+  void Refill (void);
+  static uint32_t RemoveCancelledFrom (Bucket &bucket, std::vector<Event> &removed);
+
+  // events with a timestamp equal or later than this are stored in m_top
+  uint64_t m_topStart;
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  Bucket m_top;
+  // rungs [0, m_nRungs) are in use; higher rungs are kept for reuse
+  std::vector<Rung> m_rungs;
+  uint32_t m_nRungs;
+  // sorted in decreasing order so that the earliest event is at the back
+  Bucket m_bottom;
+  // number of events in queue
+  uint32_t m_qSize;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -22,9 +22,14 @@
 #include <list>
 #include <utility>
 #include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
 #include "assert.h"
 #include "ns3/core-config.h"
 #include "fatal-error.h"
+#include "fatal-impl.h"
 
 #ifdef HAVE_GETENV
 #include <cstring>
@@ -34,10 +39,16 @@
 #include <cstdlib>
 #endif
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
 namespace ns3 {
 
 LogTimePrinter g_logTimePrinter = 0;
 LogNodePrinter g_logNodePrinter = 0;
+LogTimeSource g_logTimeSource = 0;
+LogNodeSource g_logNodeSource = 0;
 
 typedef std::list<std::pair <std::string, LogComponent *> > ComponentList;
 typedef std::list<std::pair <std::string, LogComponent *> >::iterator ComponentListI;
@@ -272,8 +283,8 @@ LogComponent::Name (void) const
   return m_name;
 }
 
-std::string
-LogComponent::GetLevelLabel(const enum LogLevel level) const
+static std::string
+GetLevelLabel (uint32_t level)
 {
   if (level == LOG_ERROR)
     {
@@ -307,6 +318,12 @@ LogComponent::GetLevelLabel(const enum LogLevel level) const
     }
 }
 
+std::string
+LogComponent::GetLevelLabel(const enum LogLevel level) const
+{
+  return ns3::GetLevelLabel (level);
+}
+
 void 
 LogComponentEnable (char const *name, enum LogLevel level)
 {
@@ -578,6 +595,24 @@ LogNodePrinter LogGetNodePrinter (void)
   return g_logNodePrinter;
 }
 
+void LogSetTimeSource (LogTimeSource source)
+{
+  g_logTimeSource = source;
+}
+LogTimeSource LogGetTimeSource (void)
+{
+  return g_logTimeSource;
+}
+
+void LogSetNodeSource (LogNodeSource source)
+{
+  g_logNodeSource = source;
+}
+LogNodeSource LogGetNodeSource (void)
+{
+  return g_logNodeSource;
+}
+
 
 ParameterLogger::ParameterLogger (std::ostream &os)
   : m_itemNumber (0),
@@ -585,4 +620,1000 @@ ParameterLogger::ParameterLogger (std::ostream &os)
 {
 }
 
+/*
+ * The binary log is a header followed by a sequence of entries, each
+ * starting with a tag byte:
+ *  - TAG_SITE: the site identifier, the kind of macro, the level, the
+ *    component name and the function name of a logging statement;
+ *  - TAG_MESSAGE: the site identifier, the flags, the time in seconds
+ *    and the context if their flags are set, then the arguments of the
+ *    message up to TAG_END.
+ * An argument is a tag followed by its value; strings are stored as
+ * their size followed by their characters.  In a file written as the
+ * messages are logged, a site is written before its first message.
+ */
+namespace {
+
+const char g_logBinaryMagic[8] = { 'n', 's', '3', 'b', 'l', 'o', 'g', '1' };
+
+enum LogBinaryTag
+{
+  TAG_END = 0,
+  TAG_SITE,
+  TAG_MESSAGE,
+  TAG_CONTEXT,
+  TAG_SEPARATOR,
+  TAG_INT,
+  TAG_UINT,
+  TAG_DOUBLE,
+  TAG_CHAR,
+  TAG_STRING,
+  TAG_POINTER
+};
+
+enum LogBinaryFlag
+{
+  FLAG_PREFIX_FUNC = 0x01,
+  FLAG_PREFIX_TIME = 0x02,
+  FLAG_PREFIX_NODE = 0x04,
+  FLAG_PREFIX_LEVEL = 0x08,
+  FLAG_TIME = 0x10,
+  FLAG_NODE = 0x20
+};
+
+struct LogBinarySite
+{
+  char const *component;
+  char const *function;
+  uint32_t level;
+  uint8_t kind;
+};
+
+std::vector<LogBinarySite> &
+GetLogBinarySites (void)
+{
+  static std::vector<LogBinarySite> sites;
+  return sites;
+}
+
+void
+AppendSite (std::string &data, uint32_t id)
+{
+  const LogBinarySite &site = GetLogBinarySites ()[id - 1];
+  uint32_t component = std::strlen (site.component);
+  uint32_t function = std::strlen (site.function);
+  data.push_back (TAG_SITE);
+  data.append (reinterpret_cast<const char *> (&id), sizeof (id));
+  data.push_back (site.kind);
+  data.append (reinterpret_cast<const char *> (&site.level), sizeof (site.level));
+  data.append (reinterpret_cast<const char *> (&component), sizeof (component));
+  data.append (site.component, component);
+  data.append (reinterpret_cast<const char *> (&function), sizeof (function));
+  data.append (site.function, function);
+}
+
+// the buffers of the records being built by a thread: a record can
+// be built while another one formats its arguments.
+struct LogBinaryBuffer
+{
+  std::string data;
+  std::ostringstream text;
+};
+
+struct LogBinaryBuffers
+{
+  std::vector<LogBinaryBuffer *> buffers;
+  uint32_t depth;
+  // the buffer of the record whose context is being captured, if any
+  std::streambuf *capture;
+};
+
+void
+DestroyLogBinaryBuffers (void *p)
+{
+  LogBinaryBuffers *buffers = static_cast<LogBinaryBuffers *> (p);
+  if (buffers == 0)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < buffers->buffers.size (); i++)
+    {
+      delete buffers->buffers[i];
+    }
+  delete buffers;
+}
+
+// The lock protects the sites, the writer and its file or ring buffer.
+// It is recursive because the ring buffer is written to the file, with
+// the lock held, when a fatal signal interrupts a thread which holds it.
+#ifdef HAVE_PTHREAD_H
+pthread_once_t g_logBinaryOnce = PTHREAD_ONCE_INIT;
+pthread_key_t g_logBinaryKey;
+pthread_mutex_t g_logBinaryMutex;
+
+void
+InitLogBinary (void)
+{
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init (&attr);
+  pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init (&g_logBinaryMutex, &attr);
+  pthread_mutexattr_destroy (&attr);
+  pthread_key_create (&g_logBinaryKey, &DestroyLogBinaryBuffers);
+}
+#else
+LogBinaryBuffers *g_logBinaryBuffers = 0;
+#endif /* HAVE_PTHREAD_H */
+
+void
+LockLogBinary (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_logBinaryOnce, &InitLogBinary);
+  pthread_mutex_lock (&g_logBinaryMutex);
+#endif
+}
+
+void
+UnlockLogBinary (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock (&g_logBinaryMutex);
+#endif
+}
+
+LogBinaryBuffers *
+PeekLogBinaryBuffers (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_logBinaryOnce, &InitLogBinary);
+  return static_cast<LogBinaryBuffers *> (pthread_getspecific (g_logBinaryKey));
+#else
+  return g_logBinaryBuffers;
+#endif
+}
+
+LogBinaryBuffers *
+GetLogBinaryBuffers (void)
+{
+  LogBinaryBuffers *buffers = PeekLogBinaryBuffers ();
+  if (buffers == 0)
+    {
+      buffers = new LogBinaryBuffers ();
+      buffers->depth = 0;
+      buffers->capture = 0;
+#ifdef HAVE_PTHREAD_H
+      pthread_setspecific (g_logBinaryKey, buffers);
+#else
+      g_logBinaryBuffers = buffers;
+#endif
+    }
+  return buffers;
+}
+
+// Installed in std::clog while the binary log is enabled, to route the
+// text a thread writes to std::clog to the record whose context it is
+// capturing, and to the original buffer of std::clog otherwise: the
+// other threads keep writing to std::clog meanwhile.
+class LogBinaryClogStreambuf : public std::streambuf
+{
+public:
+  LogBinaryClogStreambuf (std::streambuf *original)
+    : m_original (original)
+  {
+  }
+  std::streambuf *GetOriginal (void) const
+  {
+    return m_original;
+  }
+protected:
+  virtual int_type overflow (int_type c)
+  {
+    if (traits_type::eq_int_type (c, traits_type::eof ()))
+      {
+        return traits_type::not_eof (c);
+      }
+    return GetTarget ()->sputc (traits_type::to_char_type (c));
+  }
+  virtual std::streamsize xsputn (const char *s, std::streamsize n)
+  {
+    return GetTarget ()->sputn (s, n);
+  }
+  virtual int sync (void)
+  {
+    return GetTarget ()->pubsync ();
+  }
+private:
+  std::streambuf *GetTarget (void) const
+  {
+    LogBinaryBuffers *buffers = PeekLogBinaryBuffers ();
+    if (buffers != 0 && buffers->capture != 0)
+      {
+        return buffers->capture;
+      }
+    return m_original;
+  }
+  std::streambuf *m_original;
+};
+
+// the buffer installed in std::clog, if any. It is never deleted,
+// because the other threads may still be writing to it when the
+// binary log is disabled.
+LogBinaryClogStreambuf *g_logBinaryClog = 0;
+
+} // anonymous namespace
+
+/**
+ * \internal
+ *
+ * Write the binary log records to a file, or to a ring buffer.  The
+ * writer is only used with the lock held.
+ */
+class LogBinaryWriter
+{
+public:
+  LogBinaryWriter (std::string filename, uint32_t ringSize);
+  ~LogBinaryWriter ();
+  void Write (uint32_t site, const std::string &data);
+  void FlushRing (void);
+private:
+  // registered with FatalImpl, so that the ring buffer is written to
+  // the file when the program terminates on a fatal error.
+  class RingStreambuf : public std::streambuf
+  {
+  public:
+    RingStreambuf (LogBinaryWriter *writer);
+  protected:
+    virtual int sync (void);
+  private:
+    LogBinaryWriter *m_writer;
+  };
+
+  void Push (const std::string &data);
+  void CopyIn (uint32_t offset, const char *buffer, uint32_t size);
+  void Copy (uint32_t offset, char *buffer, uint32_t size) const;
+
+  std::ofstream m_file;
+  std::vector<bool> m_written;  //!< the sites written to the file
+  // the sites are kept with the ring buffer, rather than looked up
+  // when the log is written, because their component names may be
+  // gone by then.
+  std::string m_sites;
+  std::vector<char> m_ring;
+  uint32_t m_head;              //!< the offset of the oldest record
+  uint32_t m_used;
+  RingStreambuf m_ringStreambuf;
+  std::ostream m_ringStream;
+};
+
+LogBinaryWriter *volatile LogBinaryRecord::m_writer = 0;
+
+LogBinaryWriter::RingStreambuf::RingStreambuf (LogBinaryWriter *writer)
+  : m_writer (writer)
+{
+}
+
+int
+LogBinaryWriter::RingStreambuf::sync (void)
+{
+  m_writer->FlushRing ();
+  return 0;
+}
+
+LogBinaryWriter::LogBinaryWriter (std::string filename, uint32_t ringSize)
+  : m_ring (ringSize),
+    m_head (0),
+    m_used (0),
+    m_ringStreambuf (this),
+    m_ringStream (&m_ringStreambuf)
+{
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file)
+    {
+      NS_FATAL_ERROR ("Could not open binary log file " << filename);
+    }
+  m_file.write (g_logBinaryMagic, sizeof (g_logBinaryMagic));
+  FatalImpl::RegisterStream (&m_file);
+  if (!m_ring.empty ())
+    {
+      FatalImpl::RegisterStream (&m_ringStream);
+    }
+}
+
+LogBinaryWriter::~LogBinaryWriter ()
+{
+  FatalImpl::UnregisterStream (&m_ringStream);
+  FlushRing ();
+  FatalImpl::UnregisterStream (&m_file);
+  m_file.close ();
+}
+
+void
+LogBinaryWriter::FlushRing (void)
+{
+  if (m_ring.empty ())
+    {
+      return;
+    }
+  LockLogBinary ();
+  // the sites are written once: the records which are added to the
+  // ring buffer later may refer to them.
+  m_file.write (m_sites.data (), m_sites.size ());
+  m_sites.clear ();
+  std::string data;
+  while (m_used > 0)
+    {
+      uint32_t size;
+      Copy (m_head, reinterpret_cast<char *> (&size), sizeof (size));
+      data.resize (size);
+      Copy (m_head + sizeof (size), &data[0], size);
+      m_file.write (data.data (), size);
+      m_head = (m_head + sizeof (size) + size) % m_ring.size ();
+      m_used -= sizeof (size) + size;
+    }
+  m_file.flush ();
+  UnlockLogBinary ();
+}
+
+void
+LogBinaryWriter::Write (uint32_t site, const std::string &data)
+{
+  if (m_written.size () <= site)
+    {
+      m_written.resize (site + 1, false);
+    }
+  if (!m_written[site])
+    {
+      if (m_ring.empty ())
+        {
+          std::string data;
+          AppendSite (data, site);
+          m_file.write (data.data (), data.size ());
+        }
+      else
+        {
+          AppendSite (m_sites, site);
+        }
+      m_written[site] = true;
+    }
+  if (m_ring.empty ())
+    {
+      m_file.write (data.data (), data.size ());
+    }
+  else
+    {
+      Push (data);
+    }
+}
+
+void
+LogBinaryWriter::Push (const std::string &data)
+{
+  // each record is preceded by its size, to find the next record
+  // when the oldest one is overwritten.
+  uint32_t size = data.size ();
+  uint32_t total = sizeof (size) + size;
+  if (total > m_ring.size ())
+    {
+      return;
+    }
+  while (m_ring.size () - m_used < total)
+    {
+      uint32_t oldest;
+      Copy (m_head, reinterpret_cast<char *> (&oldest), sizeof (oldest));
+      m_head = (m_head + sizeof (oldest) + oldest) % m_ring.size ();
+      m_used -= sizeof (oldest) + oldest;
+    }
+  uint32_t tail = m_head + m_used;
+  CopyIn (tail, reinterpret_cast<const char *> (&size), sizeof (size));
+  CopyIn (tail + sizeof (size), data.data (), size);
+  m_used += total;
+}
+
+void
+LogBinaryWriter::CopyIn (uint32_t offset, const char *buffer, uint32_t size)
+{
+  offset %= m_ring.size ();
+  uint32_t first = std::min<uint32_t> (size, m_ring.size () - offset);
+  std::memcpy (&m_ring[offset], buffer, first);
+  std::memcpy (&m_ring[0], buffer + first, size - first);
+}
+
+void
+LogBinaryWriter::Copy (uint32_t offset, char *buffer, uint32_t size) const
+{
+  offset %= m_ring.size ();
+  uint32_t first = std::min<uint32_t> (size, m_ring.size () - offset);
+  std::memcpy (buffer, &m_ring[offset], first);
+  std::memcpy (buffer + first, &m_ring[0], size - first);
+}
+
+LogBinaryRecord::LogBinaryRecord (const LogComponent &component, enum LogLevel level,
+                                  char const *function, enum Kind kind, uint32_t *site)
+  : m_capture (0),
+    m_formatted (false),
+    m_parameters (false),
+    m_textPending (false),
+    m_items (0)
+{
+  if (*site == 0)
+    {
+      // another thread may be registering the same site.
+      LockLogBinary ();
+      if (*site == 0)
+        {
+          LogBinarySite s;
+          s.component = component.Name ();
+          s.function = function;
+          s.level = level;
+          s.kind = kind;
+          GetLogBinarySites ().push_back (s);
+          *site = GetLogBinarySites ().size ();
+        }
+      UnlockLogBinary ();
+    }
+  m_site = *site;
+
+  LogBinaryBuffers *buffers = GetLogBinaryBuffers ();
+  if (buffers->depth == buffers->buffers.size ())
+    {
+      buffers->buffers.push_back (new LogBinaryBuffer ());
+    }
+  LogBinaryBuffer *buffer = buffers->buffers[buffers->depth++];
+  buffer->data.clear ();
+  buffer->text.str ("");
+  buffer->text.clear ();
+  buffer->text.flags (std::ios_base::skipws | std::ios_base::dec);
+  buffer->text.width (0);
+  buffer->text.precision (6);
+  buffer->text.fill (' ');
+  m_data = &buffer->data;
+  m_text = &buffer->text;
+
+  uint8_t flags = 0;
+  flags |= component.IsEnabled (LOG_PREFIX_FUNC) ? FLAG_PREFIX_FUNC : 0;
+  flags |= component.IsEnabled (LOG_PREFIX_TIME) ? FLAG_PREFIX_TIME : 0;
+  flags |= component.IsEnabled (LOG_PREFIX_NODE) ? FLAG_PREFIX_NODE : 0;
+  flags |= component.IsEnabled (LOG_PREFIX_LEVEL) ? FLAG_PREFIX_LEVEL : 0;
+  flags |= g_logTimeSource != 0 ? FLAG_TIME : 0;
+  flags |= g_logNodeSource != 0 ? FLAG_NODE : 0;
+  m_data->push_back (TAG_MESSAGE);
+  m_data->append (reinterpret_cast<const char *> (&m_site), sizeof (m_site));
+  m_data->push_back (flags);
+  if (g_logTimeSource != 0)
+    {
+      double time = (*g_logTimeSource)();
+      m_data->append (reinterpret_cast<const char *> (&time), sizeof (time));
+    }
+  if (g_logNodeSource != 0)
+    {
+      uint32_t node = (*g_logNodeSource)();
+      m_data->append (reinterpret_cast<const char *> (&node), sizeof (node));
+    }
+}
+
+LogBinaryRecord::~LogBinaryRecord ()
+{
+  FlushText ();
+  m_data->push_back (TAG_END);
+  GetLogBinaryBuffers ()->depth--;
+  LockLogBinary ();
+  // the log may have been disabled since the record was started.
+  if (m_writer != 0)
+    {
+      m_writer->Write (m_site, *m_data);
+    }
+  UnlockLogBinary ();
+}
+
+void
+LogBinaryRecord::BeginContext (void)
+{
+  // std::clog is shared by all the threads: its buffer routes the text
+  // of this thread only to the record.
+  LogBinaryBuffers *buffers = GetLogBinaryBuffers ();
+  m_capture = buffers->capture;
+  buffers->capture = m_text->rdbuf ();
+}
+
+void
+LogBinaryRecord::EndContext (void)
+{
+  GetLogBinaryBuffers ()->capture = m_capture;
+  if (m_text->tellp () > 0)
+    {
+      std::string context = m_text->str ();
+      AppendString (TAG_CONTEXT, context.data (), context.size ());
+      m_text->str ("");
+    }
+}
+
+void
+LogBinaryRecord::BeginParameters (void)
+{
+  m_parameters = true;
+}
+
+void
+LogBinaryRecord::BeginItem (void)
+{
+  if (!m_parameters)
+    {
+      return;
+    }
+  if (m_items > 0)
+    {
+      FlushText ();
+      m_data->push_back (TAG_SEPARATOR);
+    }
+  m_items++;
+}
+
+void
+LogBinaryRecord::EndText (void)
+{
+  // once the format of the text changes, it applies to all the
+  // following arguments, which are then formatted too.
+  if (!m_formatted
+      && (m_text->flags () != (std::ios_base::skipws | std::ios_base::dec)
+          || m_text->width () != 0 || m_text->precision () != 6 || m_text->fill () != ' '))
+    {
+      m_formatted = true;
+    }
+}
+
+void
+LogBinaryRecord::FlushText (void)
+{
+  if (m_textPending)
+    {
+      std::string text = m_text->str ();
+      if (!text.empty ())
+        {
+          AppendString (TAG_STRING, text.data (), text.size ());
+          m_text->str ("");
+        }
+      m_textPending = false;
+    }
+}
+
+void
+LogBinaryRecord::Append (uint8_t tag, const void *data, uint32_t size)
+{
+  FlushText ();
+  m_data->push_back (tag);
+  m_data->append (static_cast<const char *> (data), size);
+}
+
+void
+LogBinaryRecord::AppendString (uint8_t tag, const char *data, uint32_t size)
+{
+  m_data->push_back (tag);
+  m_data->append (reinterpret_cast<const char *> (&size), sizeof (size));
+  m_data->append (data, size);
+}
+
+void
+LogBinaryRecord::AppendInt (int64_t v)
+{
+  Append (TAG_INT, &v, sizeof (v));
+}
+
+void
+LogBinaryRecord::AppendUint (uint64_t v)
+{
+  Append (TAG_UINT, &v, sizeof (v));
+}
+
+void
+LogBinaryRecord::AppendDouble (double v)
+{
+  Append (TAG_DOUBLE, &v, sizeof (v));
+}
+
+#define LOG_BINARY_OPERATOR(type, append)       \
+  LogBinaryRecord &                             \
+  LogBinaryRecord::operator<< (type v)          \
+  {                                             \
+    BeginItem ();                               \
+    if (m_formatted)                            \
+      {                                         \
+        *m_text << v;                           \
+        m_textPending = true;                   \
+      }                                         \
+    else                                        \
+      {                                         \
+        append;                                 \
+      }                                         \
+    return *this;                               \
+  }
+
+LOG_BINARY_OPERATOR (bool, AppendInt (v))
+LOG_BINARY_OPERATOR (char, Append (TAG_CHAR, &v, 1))
+LOG_BINARY_OPERATOR (signed char, Append (TAG_CHAR, &v, 1))
+LOG_BINARY_OPERATOR (unsigned char, Append (TAG_CHAR, &v, 1))
+LOG_BINARY_OPERATOR (short, AppendInt (v))
+LOG_BINARY_OPERATOR (unsigned short, AppendUint (v))
+LOG_BINARY_OPERATOR (int, AppendInt (v))
+LOG_BINARY_OPERATOR (unsigned int, AppendUint (v))
+LOG_BINARY_OPERATOR (long, AppendInt (v))
+LOG_BINARY_OPERATOR (unsigned long, AppendUint (v))
+LOG_BINARY_OPERATOR (long long, AppendInt (v))
+LOG_BINARY_OPERATOR (unsigned long long, AppendUint (v))
+LOG_BINARY_OPERATOR (float, AppendDouble (v))
+LOG_BINARY_OPERATOR (double, AppendDouble (v))
+
+#undef LOG_BINARY_OPERATOR
+
+LogBinaryRecord &
+LogBinaryRecord::operator<< (char const *v)
+{
+  BeginItem ();
+  if (m_formatted)
+    {
+      *m_text << v;
+      m_textPending = true;
+    }
+  else
+    {
+      FlushText ();
+      AppendString (TAG_STRING, v, std::strlen (v));
+    }
+  return *this;
+}
+
+LogBinaryRecord &
+LogBinaryRecord::operator<< (char *v)
+{
+  return *this << const_cast<char const *> (v);
+}
+
+LogBinaryRecord &
+LogBinaryRecord::operator<< (const std::string &v)
+{
+  BeginItem ();
+  if (m_formatted)
+    {
+      *m_text << v;
+      m_textPending = true;
+    }
+  else
+    {
+      FlushText ();
+      AppendString (TAG_STRING, v.data (), v.size ());
+    }
+  return *this;
+}
+
+LogBinaryRecord &
+LogBinaryRecord::operator<< (const void *v)
+{
+  BeginItem ();
+  if (m_formatted)
+    {
+      *m_text << v;
+      m_textPending = true;
+    }
+  else
+    {
+      uint64_t pointer = reinterpret_cast<uintptr_t> (v);
+      Append (TAG_POINTER, &pointer, sizeof (pointer));
+    }
+  return *this;
+}
+
+LogBinaryRecord &
+LogBinaryRecord::operator<< (std::ostream& (*manipulator)(std::ostream &))
+{
+  BeginItem ();
+  *m_text << manipulator;
+  m_textPending = true;
+  EndText ();
+  return *this;
+}
+
+LogBinaryRecord &
+LogBinaryRecord::operator<< (std::ios_base& (*manipulator)(std::ios_base &))
+{
+  BeginItem ();
+  *m_text << manipulator;
+  m_textPending = true;
+  EndText ();
+  return *this;
+}
+
+void
+LogEnableBinary (std::string filename, uint32_t ringSize)
+{
+  LogDisableBinary ();
+  LogBinaryWriter *writer = new LogBinaryWriter (filename, ringSize);
+  LockLogBinary ();
+  if (g_logBinaryClog == 0 || g_logBinaryClog->GetOriginal () != std::clog.rdbuf ())
+    {
+      g_logBinaryClog = new LogBinaryClogStreambuf (std::clog.rdbuf ());
+    }
+  std::clog.rdbuf (g_logBinaryClog);
+  LogBinaryRecord::m_writer = writer;
+  UnlockLogBinary ();
+}
+
+void
+LogDisableBinary (void)
+{
+  // once the lock is released, no other thread uses the writer.
+  LockLogBinary ();
+  LogBinaryWriter *writer = LogBinaryRecord::m_writer;
+  LogBinaryRecord::m_writer = 0;
+  if (g_logBinaryClog != 0 && std::clog.rdbuf () == g_logBinaryClog)
+    {
+      std::clog.rdbuf (g_logBinaryClog->GetOriginal ());
+    }
+  UnlockLogBinary ();
+  delete writer;
+}
+
+namespace {
+
+struct DecodedSite
+{
+  std::string component;
+  std::string function;
+  uint32_t level;
+  uint8_t kind;
+};
+
+template <typename T>
+bool
+Read (std::istream &is, T &v)
+{
+  is.read (reinterpret_cast<char *> (&v), sizeof (v));
+  return is.gcount () == sizeof (v);
+}
+
+bool
+ReadString (std::istream &is, std::string &v)
+{
+  uint32_t size;
+  if (!Read (is, size))
+    {
+      return false;
+    }
+  v.resize (size);
+  if (size > 0)
+    {
+      is.read (&v[0], size);
+    }
+  return is.gcount () == size;
+}
+
+// Print the arguments of a message up to TAG_END.
+bool
+DecodeArguments (std::istream &is, uint8_t tag, std::ostream &os)
+{
+  while (tag != TAG_END)
+    {
+      switch (tag)
+        {
+        case TAG_SEPARATOR:
+          os << ", ";
+          break;
+        case TAG_INT:
+          {
+            int64_t v;
+            if (!Read (is, v))
+              {
+                return false;
+              }
+            os << v;
+          }
+          break;
+        case TAG_UINT:
+          {
+            uint64_t v;
+            if (!Read (is, v))
+              {
+                return false;
+              }
+            os << v;
+          }
+          break;
+        case TAG_DOUBLE:
+          {
+            double v;
+            if (!Read (is, v))
+              {
+                return false;
+              }
+            os << v;
+          }
+          break;
+        case TAG_CHAR:
+          {
+            char v;
+            if (!Read (is, v))
+              {
+                return false;
+              }
+            os << v;
+          }
+          break;
+        case TAG_STRING:
+          {
+            std::string v;
+            if (!ReadString (is, v))
+              {
+                return false;
+              }
+            os << v;
+          }
+          break;
+        case TAG_POINTER:
+          {
+            uint64_t v;
+            if (!Read (is, v))
+              {
+                return false;
+              }
+            os << reinterpret_cast<const void *> (static_cast<uintptr_t> (v));
+          }
+          break;
+        default:
+          return false;
+        }
+      if (!Read (is, tag))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // anonymous namespace
+
+bool
+LogDecodeBinary (std::istream &is, std::ostream &os)
+{
+  std::map<uint32_t, DecodedSite> sites;
+
+  char magic[sizeof (g_logBinaryMagic)];
+  is.read (magic, sizeof (magic));
+  if (is.gcount () != sizeof (magic)
+      || std::memcmp (magic, g_logBinaryMagic, sizeof (magic)) != 0)
+    {
+      return false;
+    }
+
+  std::ostringstream line;
+  uint8_t tag;
+  while (Read (is, tag))
+    {
+      if (tag == TAG_SITE)
+        {
+          uint32_t id;
+          DecodedSite site;
+          if (!Read (is, id) || !Read (is, site.kind) || !Read (is, site.level)
+              || !ReadString (is, site.component) || !ReadString (is, site.function))
+            {
+              return false;
+            }
+          sites[id] = site;
+          continue;
+        }
+      uint32_t id;
+      uint8_t flags;
+      if (tag != TAG_MESSAGE || !Read (is, id) || !Read (is, flags)
+          || sites.find (id) == sites.end ())
+        {
+          return false;
+        }
+      const DecodedSite &site = sites[id];
+      double time = 0;
+      uint32_t node = 0;
+      if (((flags & FLAG_TIME) && !Read (is, time))
+          || ((flags & FLAG_NODE) && !Read (is, node))
+          || !Read (is, tag))
+        {
+          return false;
+        }
+
+      line.str ("");
+      // the prefixes of the default time and node printers.
+      if ((flags & FLAG_PREFIX_TIME) && (flags & FLAG_TIME))
+        {
+          line << time << "s ";
+        }
+      if ((flags & FLAG_PREFIX_NODE) && (flags & FLAG_NODE))
+        {
+          if (node == 0xffffffff)
+            {
+              line << "-1 ";
+            }
+          else
+            {
+              line << node << " ";
+            }
+        }
+      if (tag == TAG_CONTEXT)
+        {
+          std::string context;
+          if (!ReadString (is, context) || !Read (is, tag))
+            {
+              return false;
+            }
+          line << context;
+        }
+      switch (site.kind)
+        {
+        case LogBinaryRecord::MESSAGE:
+          if (flags & FLAG_PREFIX_FUNC)
+            {
+              line << site.component << ":" << site.function << "(): ";
+            }
+          if (flags & FLAG_PREFIX_LEVEL)
+            {
+              line << "[" << GetLevelLabel (site.level) << "] ";
+            }
+          if (!DecodeArguments (is, tag, line))
+            {
+              return false;
+            }
+          break;
+        case LogBinaryRecord::FUNCTION:
+          line << site.component << ":" << site.function << "(";
+          if (!DecodeArguments (is, tag, line))
+            {
+              return false;
+            }
+          line << ")";
+          break;
+        default:
+          line << site.component << ":" << site.function << "()";
+          if (!DecodeArguments (is, tag, line))
+            {
+              return false;
+            }
+          break;
+        }
+      os << line.str () << std::endl;
+    }
+  return is.eof ();
+}
+
+static class LogBinaryEnvironment
+{
+public:
+  LogBinaryEnvironment ();
+  ~LogBinaryEnvironment ();
+} g_logBinaryEnvironment;
+
+LogBinaryEnvironment::LogBinaryEnvironment ()
+{
+#ifdef HAVE_GETENV
+  char *filename = getenv ("NS_LOG_BINARY");
+  if (filename == 0 || std::strlen (filename) == 0)
+    {
+      return;
+    }
+  uint32_t ringSize = 0;
+  char *ring = getenv ("NS_LOG_BINARY_RING");
+  if (ring != 0)
+    {
+      ringSize = std::strtoul (ring, 0, 10);
+    }
+  LogEnableBinary (filename, ringSize);
+#endif
+}
+
+LogBinaryEnvironment::~LogBinaryEnvironment ()
+{
+  LogDisableBinary ();
+  // the thread-specific destructor is not invoked for the main thread
+  DestroyLogBinaryBuffers (PeekLogBinaryBuffers ());
+#ifdef HAVE_PTHREAD_H
+  pthread_setspecific (g_logBinaryKey, 0);
+#else
+  g_logBinaryBuffers = 0;
+#endif
+}
+
 } // namespace ns3
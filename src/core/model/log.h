@@ -23,8 +23,10 @@
 
 #include <string>
 #include <iostream>
+#include <sstream>
 #include <stdint.h>
 #include <map>
+#include <limits>
 
 namespace ns3 {
 
@@ -162,6 +164,16 @@ void LogComponentDisableAll (enum LogLevel level);
 #define NS_LOG_APPEND_CONTEXT
 #endif /* NS_LOG_APPEND_CONTEXT */
 
+// Start a binary record of the current message: the text which
+// NS_LOG_APPEND_CONTEXT writes to std::clog is captured into it.
+#define NS_LOG_BINARY_RECORD(level, kind)                       \
+  static uint32_t ns3LogSite = 0;                               \
+  ns3::LogBinaryRecord ns3LogRecord (g_log, level, __FUNCTION__, \
+                                     kind, &ns3LogSite);        \
+  ns3LogRecord.BeginContext ();                                 \
+  NS_LOG_APPEND_CONTEXT;                                        \
+  ns3LogRecord.EndContext ()
+
 
 
 #ifdef NS3_LOG_ENABLE
@@ -196,6 +208,13 @@ void LogComponentDisableAll (enum LogLevel level);
  * A note on NS_LOG_FUNCTION() and NS_LOG_FUNCTION_NOARGS():
  * generally, use of (at least) NS_LOG_FUNCTION(this) is preferred.
  * Use NS_LOG_FUNCTION_NOARGS() only in static functions.
+ *
+ * Formatting the messages is much slower than the code they trace.
+ * To log long simulations, the messages can instead be recorded in a
+ * binary file with ns3::LogEnableBinary or the NS_LOG_BINARY
+ * environment variable: NS_LOG_BINARY=trace.bin stores the messages
+ * of the enabled components into trace.bin, and the log-decode
+ * program prints them later in the text format.
  */
 
 
@@ -218,6 +237,13 @@ void LogComponentDisableAll (enum LogLevel level);
     {                                                           \
       if (g_log.IsEnabled (level))                              \
         {                                                       \
+          if (ns3::LogBinaryRecord::IsEnabled ())               \
+            {                                                   \
+              NS_LOG_BINARY_RECORD (level,                      \
+                                    ns3::LogBinaryRecord::MESSAGE); \
+              ns3LogRecord << msg;                              \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -277,6 +303,12 @@ void LogComponentDisableAll (enum LogLevel level);
     {                                                           \
       if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
         {                                                       \
+          if (ns3::LogBinaryRecord::IsEnabled ())               \
+            {                                                   \
+              NS_LOG_BINARY_RECORD (ns3::LOG_FUNCTION,          \
+                                    ns3::LogBinaryRecord::FUNCTION_NOARGS); \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -313,6 +345,14 @@ void LogComponentDisableAll (enum LogLevel level);
     {                                                           \
       if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
         {                                                       \
+          if (ns3::LogBinaryRecord::IsEnabled ())               \
+            {                                                   \
+              NS_LOG_BINARY_RECORD (ns3::LOG_FUNCTION,          \
+                                    ns3::LogBinaryRecord::FUNCTION); \
+              ns3LogRecord.BeginParameters ();                  \
+              ns3LogRecord << parameters;                       \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -338,7 +378,8 @@ void LogComponentDisableAll (enum LogLevel level);
  * \ingroup logging
  * \param msg the message to log
  *
- * Output the requested message unconditionaly.
+ * Output the requested message unconditionaly.  The message is always
+ * formatted to std::clog, even when the log is recorded in binary.
  */
 #define NS_LOG_UNCOND(msg)              \
   do                                    \
@@ -381,6 +422,68 @@ LogTimePrinter LogGetTimePrinter (void);
 void LogSetNodePrinter (LogNodePrinter);
 LogNodePrinter LogGetNodePrinter (void);
 
+/**
+ * The sources of the time, in seconds, and of the context of the
+ * binary log messages, which take the place of the time and node
+ * printers.
+ */
+typedef double (*LogTimeSource)(void);
+typedef uint32_t (*LogNodeSource)(void);
+
+void LogSetTimeSource (LogTimeSource);
+LogTimeSource LogGetTimeSource (void);
+
+void LogSetNodeSource (LogNodeSource);
+LogNodeSource LogGetNodeSource (void);
+
+/**
+ * \ingroup logging
+ * \param filename the file to record the log messages into
+ * \param ringSize the size of the ring buffer, in bytes, or zero
+ *
+ * Record the messages of the enabled log components in binary form
+ * instead of formatting them to std::clog.  A message is recorded as
+ * the identifier of the statement which logged it, followed by the
+ * simulation time, the context and the arguments of the message:
+ * integers, floating point numbers, pointers and strings are stored
+ * as they are, and only the other types are formatted.
+ *
+ * If \pname{ringSize} is zero, the messages are written to
+ * \pname{filename} as they are logged.  Otherwise, only the most recent
+ * messages which fit into \pname{ringSize} bytes are kept in memory,
+ * and they are written to \pname{filename} by LogDisableBinary, when
+ * the program exits, or on a fatal error.
+ *
+ * Messages may be logged by several threads at once.
+ *
+ * The file is read by LogDecodeBinary, or by the log-decode program,
+ * on a host of the same byte order.  Its messages are those the text
+ * log would contain, except that the time and node prefixes are
+ * always printed in the default format of the simulator.
+ *
+ * Same as running your program with the NS_LOG_BINARY environment
+ * variable set to \pname{filename}, and NS_LOG_BINARY_RING set to
+ * \pname{ringSize}.
+ */
+void LogEnableBinary (std::string filename, uint32_t ringSize = 0);
+
+/**
+ * \ingroup logging
+ *
+ * Stop recording the log messages in binary form, and close the file.
+ */
+void LogDisableBinary (void);
+
+/**
+ * \ingroup logging
+ * \param is the binary log to read
+ * \param os the stream to print the messages to
+ * \returns false if the binary log is truncated or corrupted
+ *
+ * Print the messages of a binary log in the text format.
+ */
+bool LogDecodeBinary (std::istream &is, std::ostream &os);
+
 
 class LogComponent {
 public:
@@ -397,6 +500,254 @@ private:
   char const *m_name;
 };
 
+/**
+ * \internal
+ *
+ * The detection of the enums which have no inserter.
+ */
+namespace LogBinaryDetail {
+
+template <typename T>
+struct RemoveConst
+{
+  typedef T Type;
+};
+template <typename T>
+struct RemoveConst<const T>
+{
+  typedef T Type;
+};
+
+template <typename T, bool candidate>
+struct ConvertsToInt
+{
+  enum { value = 0 };
+};
+template <typename T>
+struct ConvertsToInt<T, true>
+{
+  static char Test (int);
+  static long Test (...);
+  static T &MakeValue (void);
+  enum { value = sizeof (Test (MakeValue ())) == 1 };
+};
+
+/**
+ * T is an enum if it is neither a class nor an arithmetic type, but
+ * converts to an int.  The conversions of the classes are not tested,
+ * since they may be ambiguous.
+ */
+template <typename T>
+struct IsEnum
+{
+  typedef typename RemoveConst<T>::Type Type;
+  template <typename U> static char TestClass (int U::*);
+  template <typename U> static long TestClass (...);
+  enum { candidate = sizeof (TestClass<Type> (0)) != 1
+                     && !std::numeric_limits<Type>::is_specialized };
+  enum { value = ConvertsToInt<T, candidate>::value };
+};
+
+/**
+ * The inserter of last resort, which is selected for an enum instead of
+ * the inserter of its integral promotion, unless the enum has its own.
+ */
+struct NoInserter
+{
+  char c[2];
+};
+template <typename T>
+NoInserter operator<< (std::ostream &os, const T &v);
+char TestInserter (const std::ostream &os);
+NoInserter TestInserter (const NoInserter &v);
+
+template <typename T>
+struct HasInserter
+{
+  static std::ostream &MakeStream (void);
+  static T &MakeValue (void);
+  enum { value = sizeof (TestInserter (MakeStream () << MakeValue ())) == 1 };
+};
+
+} // namespace LogBinaryDetail
+
+/**
+ * \internal
+ *
+ * A message of the binary log, built by the logging macros: it
+ * records the arguments given to its operator<< and is written to the
+ * binary log when it is destroyed.
+ */
+class LogBinaryRecord
+{
+public:
+  /**
+   * The logging macro which records the message.
+   */
+  enum Kind
+  {
+    MESSAGE,                    //!< NS_LOG and its variants
+    FUNCTION,                   //!< NS_LOG_FUNCTION
+    FUNCTION_NOARGS             //!< NS_LOG_FUNCTION_NOARGS
+  };
+
+  /**
+   * \returns true if the log messages are recorded in binary form
+   */
+  static bool IsEnabled (void)
+  {
+    return m_writer != 0;
+  }
+
+  /**
+   * \param component the component of the message
+   * \param level the level of the message
+   * \param function the function which logs the message
+   * \param kind the macro which logs the message
+   * \param site the identifier of the logging statement, zero until
+   *        it is first recorded
+   */
+  LogBinaryRecord (const LogComponent &component, enum LogLevel level,
+                   char const *function, enum Kind kind, uint32_t *site);
+  ~LogBinaryRecord ();
+
+  /**
+   * Capture the text written to std::clog by this thread until
+   * EndContext, which is printed before the message.
+   */
+  void BeginContext (void);
+  void EndContext (void);
+  /**
+   * Separate the following arguments by ", ", as function parameters.
+   */
+  void BeginParameters (void);
+
+  LogBinaryRecord& operator<< (bool v);
+  LogBinaryRecord& operator<< (char v);
+  LogBinaryRecord& operator<< (signed char v);
+  LogBinaryRecord& operator<< (unsigned char v);
+  LogBinaryRecord& operator<< (short v);
+  LogBinaryRecord& operator<< (unsigned short v);
+  LogBinaryRecord& operator<< (int v);
+  LogBinaryRecord& operator<< (unsigned int v);
+  LogBinaryRecord& operator<< (long v);
+  LogBinaryRecord& operator<< (unsigned long v);
+  LogBinaryRecord& operator<< (long long v);
+  LogBinaryRecord& operator<< (unsigned long long v);
+  LogBinaryRecord& operator<< (float v);
+  LogBinaryRecord& operator<< (double v);
+  LogBinaryRecord& operator<< (char const *v);
+  LogBinaryRecord& operator<< (char *v);
+  LogBinaryRecord& operator<< (const std::string &v);
+  LogBinaryRecord& operator<< (std::string &v)
+  {
+    return *this << static_cast<const std::string &> (v);
+  }
+  LogBinaryRecord& operator<< (const void *v);
+  LogBinaryRecord& operator<< (std::ostream& (*manipulator)(std::ostream &));
+  LogBinaryRecord& operator<< (std::ios_base& (*manipulator)(std::ios_base &));
+
+  template <typename T>
+  LogBinaryRecord& operator<< (T *v)
+  {
+    return AppendPointer (v, Tag<IsFunction<T>::value> ());
+  }
+  /**
+   * Record the arguments of the other types as the text they format
+   * into, except for the enums without an inserter, which are recorded
+   * as the integers they are printed as.  Non-const arguments are
+   * formatted as such, since their inserters may take them by
+   * non-const reference.
+   */
+  template <typename T>
+  LogBinaryRecord& operator<< (T &v)
+  {
+    return AppendValue (v, Tag<LogBinaryDetail::IsEnum<T>::value> ());
+  }
+  template <typename T>
+  LogBinaryRecord& operator<< (const T &v)
+  {
+    return AppendValue (v, Tag<LogBinaryDetail::IsEnum<const T>::value> ());
+  }
+
+private:
+  template <bool> struct Tag {};
+  // there are no arrays of functions.
+  template <typename T>
+  struct IsFunction
+  {
+    template <typename U> static char Test (U (*)[1]);
+    template <typename U> static long Test (...);
+    enum { value = sizeof (Test<T> (0)) != 1 };
+  };
+  template <typename T>
+  LogBinaryRecord& AppendPointer (T *v, Tag<false>)
+  {
+    return *this << static_cast<const void *> (v);
+  }
+  template <typename T>
+  LogBinaryRecord& AppendPointer (T *v, Tag<true>)
+  {
+    return Format (v);
+  }
+  template <typename T>
+  LogBinaryRecord& AppendValue (T &v, Tag<false>)
+  {
+    return Format (v);
+  }
+  template <typename T>
+  LogBinaryRecord& AppendValue (T &v, Tag<true>)
+  {
+    return AppendEnum (v, Tag<LogBinaryDetail::HasInserter<T>::value> ());
+  }
+  template <typename T>
+  LogBinaryRecord& AppendEnum (T &v, Tag<false>)
+  {
+    // the integral promotion, as in the text log.
+    return *this << +v;
+  }
+  template <typename T>
+  LogBinaryRecord& AppendEnum (T &v, Tag<true>)
+  {
+    return Format (v);
+  }
+  template <typename T>
+  LogBinaryRecord& Format (T &v)
+  {
+    BeginItem ();
+    // through a std::ostream, as in the text log, so that the same
+    // inserter is selected.
+    std::ostream &os = *m_text;
+    os << v;
+    m_textPending = true;
+    EndText ();
+    return *this;
+  }
+
+  void BeginItem (void);
+  void EndText (void);
+  void FlushText (void);
+  void Append (uint8_t tag, const void *data, uint32_t size);
+  void AppendString (uint8_t tag, const char *data, uint32_t size);
+  void AppendInt (int64_t v);
+  void AppendUint (uint64_t v);
+  void AppendDouble (double v);
+
+  static class LogBinaryWriter *volatile m_writer;
+  friend class LogBinaryWriter;
+  friend void LogEnableBinary (std::string filename, uint32_t ringSize);
+  friend void LogDisableBinary (void);
+
+  uint32_t m_site;              //!< the identifier of the logging statement
+  std::string *m_data;          //!< the encoded message
+  std::ostringstream *m_text;   //!< the arguments formatted as text
+  std::streambuf *m_capture;    //!< the capture of the enclosing record, if any
+  bool m_formatted;             //!< whether the format of m_text changed
+  bool m_parameters;
+  bool m_textPending;           //!< whether m_text may hold text
+  uint32_t m_items;
+};
+
 class ParameterLogger : public std::ostream
 {
   int m_itemNumber;
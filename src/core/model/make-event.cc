@@ -27,6 +27,10 @@ protected:
       (*m_function)();
     }
 private:
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     F m_function;
   } *ev = new EventFunctionImpl0 (f);
   return ev;
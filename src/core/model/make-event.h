@@ -58,9 +58,24 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), T1 a1, T2 a2, T3 a3, T4 a4, T5
 
 #include "event-impl.h"
 #include "type-traits.h"
+#include <cstring>
 
 namespace ns3 {
 
+/**
+ * \param f a pointer to a function or method
+ * \returns the first word of the representation of f: with the common
+ *          ABIs, the address of the function or of the non-virtual
+ *          method, or the offset of a virtual method in the vtable.
+ */
+template <typename F>
+uintptr_t GetEventHandler (F f)
+{
+  uintptr_t handler = 0;
+  std::memcpy (&handler, &f, sizeof (f) < sizeof (handler) ? sizeof (f) : sizeof (handler));
+  return handler;
+}
+
 template <typename T>
 struct EventMemberImplObjTraits;
 
@@ -93,6 +108,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)();
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
   } *ev = new EventMemberImpl0 (obj, mem_ptr);
@@ -123,6 +142,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -154,6 +177,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -187,6 +214,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -222,6 +253,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -260,6 +295,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -294,6 +333,10 @@ private:
     {
       (*m_function)(m_a1);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
   } *ev = new EventFunctionImpl1 (f, a1);
@@ -324,6 +367,10 @@ private:
     {
       (*m_function)(m_a1, m_a2);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -357,6 +404,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -392,6 +443,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -429,6 +484,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual uintptr_t GetHandler (void) const
+    {
+      return GetEventHandler (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
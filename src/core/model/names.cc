@@ -22,6 +22,7 @@
 #include "assert.h"
 #include "abort.h"
 #include "names.h"
+#include "config.h"
 
 namespace ns3 {
 
@@ -156,6 +157,7 @@ NamesPriv::Clear (void)
   m_root.m_name = "Names";
   m_root.m_object = 0;
   m_root.m_nameMap.clear ();
+  Config::InvalidateMatchCache ();
 }
 
 bool
@@ -262,6 +264,7 @@ NamesPriv::Add (Ptr<Object> context, std::string name, Ptr<Object> object)
   NameNode *newNode = new NameNode (node, name, object);
   node->m_nameMap[name] = newNode;
   m_objectMap[object] = newNode;
+  Config::InvalidateMatchCache ();
 
   return true;
 }
@@ -384,6 +387,7 @@ NamesPriv::Rename (Ptr<Object> context, std::string oldname, std::string newname
       node->m_nameMap.erase (i);
       changeNode->m_name = newname;
       node->m_nameMap[newname] = changeNode;
+      Config::InvalidateMatchCache ();
       return true;
     }
 }
@@ -412,6 +412,17 @@ public:
    */
   inline static Time FromDouble (double value, enum Unit timeUnit)
   {
+    struct Information *info = PeekInformation (timeUnit);
+    // whole values in a unit coarser than the resolution, such as
+    // Seconds (1.0), convert exactly in integer arithmetic.
+    if (info->fromMul && value > -2147483648.0 && value < 2147483648.0)
+      {
+        int64_t integer = static_cast<int64_t> (value);
+        if (integer == value)
+          {
+            return Time (integer * info->factor);
+          }
+      }
     return From (int64x64_t (value), timeUnit);
   }
   /**
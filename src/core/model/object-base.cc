@@ -64,80 +64,87 @@ ObjectBase::NotifyConstructionCompleted (void)
 void
 ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
 {
-  // loop over the inheritance tree back to the Object base class.
+  // loop over the attributes of the inheritance tree back to the Object
+  // base class, as flattened by the TypeId.
   NS_LOG_FUNCTION (this << &attributes);
   TypeId tid = GetInstanceTypeId ();
-  do {
-      // loop over all attributes in object type
-      NS_LOG_DEBUG ("construct tid="<<tid.GetName ()<<", params="<<tid.GetAttributeN ());
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
+#endif /* HAVE_GETENV */
+  uint32_t n = tid.GetFlatAttributeN ();
+  NS_LOG_DEBUG ("construct tid="<<tid.GetName ()<<", params="<<n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      TypeId owner;
+      const struct TypeId::AttributeInformation &info = tid.GetFlatAttribute (i, &owner);
+      NS_LOG_DEBUG ("try to construct \""<< owner.GetName ()<<"::"<<
+                    info.name <<"\"");
+      if (!(info.flags & TypeId::ATTR_CONSTRUCT))
+        {
+          continue;
+        }
+      // setting an attribute may register new types, so do not keep
+      // a reference to the TypeId database across DoSet.
+      std::string name = info.name;
+      Ptr<const AttributeAccessor> accessor = info.accessor;
+      Ptr<const AttributeChecker> checker = info.checker;
+      Ptr<const AttributeValue> initialValue = info.initialValue;
+      bool found = false;
+      // is this attribute stored in this AttributeConstructionList instance ?
+      Ptr<AttributeValue> value = attributes.Find(checker);
+      if (value != 0)
         {
-          struct TypeId::AttributeInformation info = tid.GetAttribute(i);
-          NS_LOG_DEBUG ("try to construct \""<< tid.GetName ()<<"::"<<
-                        info.name <<"\"");
-          if (!(info.flags & TypeId::ATTR_CONSTRUCT))
+          // We have a matching attribute value.
+          if (DoSet (accessor, checker, *value))
             {
+              NS_LOG_DEBUG ("construct \""<< owner.GetName ()<<"::"<<
+                            name<<"\"");
+              found = true;
               continue;
             }
-          bool found = false;
-          // is this attribute stored in this AttributeConstructionList instance ?
-          Ptr<AttributeValue> value = attributes.Find(info.checker);
-          if (value != 0)
-            {
-              // We have a matching attribute value.
-              if (DoSet (info.accessor, info.checker, *value))
-                {
-                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                info.name<<"\"");
-                  found = true;
-                  continue;
-                }
-            }              
-          if (!found)
-            {
-              // No matching attribute value so we try to look at the env var.
+        }              
+      if (!found)
+        {
+          // No matching attribute value so we try to look at the env var.
 #ifdef HAVE_GETENV
-              char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
-              if (envVar != 0)
+          if (envVar != 0)
+            {
+              std::string fullName = owner.GetName () + "::" + name;
+              std::string env = std::string (envVar);
+              std::string::size_type cur = 0;
+              std::string::size_type next = 0;
+              while (next != std::string::npos)
                 {
-                  std::string env = std::string (envVar);
-                  std::string::size_type cur = 0;
-                  std::string::size_type next = 0;
-                  while (next != std::string::npos)
+                  next = env.find (";", cur);
+                  std::string tmp = std::string (env, cur, next-cur);
+                  std::string::size_type equal = tmp.find ("=");
+                  if (equal != std::string::npos)
                     {
-                      next = env.find (";", cur);
-                      std::string tmp = std::string (env, cur, next-cur);
-                      std::string::size_type equal = tmp.find ("=");
-                      if (equal != std::string::npos)
+                      std::string envName = tmp.substr (0, equal);
+                      std::string envValue = tmp.substr (equal+1, tmp.size () - equal - 1);
+                      if (envName == fullName)
                         {
-                          std::string name = tmp.substr (0, equal);
-                          std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
-                          if (name == tid.GetAttributeFullName (i))
+                          if (DoSet (accessor, checker, StringValue (envValue)))
                             {
-                              if (DoSet (info.accessor, info.checker, StringValue (value)))
-                                {
-                                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                                info.name <<"\" from env var");
-                                  found = true;
-                                  break;
-                                }
+                              NS_LOG_DEBUG ("construct \""<< fullName <<"\" from env var");
+                              found = true;
+                              break;
                             }
                         }
-                      cur = next + 1;
                     }
+                  cur = next + 1;
                 }
-#endif /* HAVE_GETENV */
-            }
-          if (!found)
-            {
-              // No matching attribute value so we try to set the default value.
-              DoSet (info.accessor, info.checker, *info.initialValue);
-              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                            info.name <<"\" from initial value.");
             }
+#endif /* HAVE_GETENV */
+        }
+      if (!found)
+        {
+          // No matching attribute value so we try to set the default value.
+          DoSet (accessor, checker, *initialValue);
+          NS_LOG_DEBUG ("construct \""<< owner.GetName ()<<"::"<<
+                        name <<"\" from initial value.");
         }
-      tid = tid.GetParent ();
-    } while (tid != ObjectBase::GetTypeId ());
+    }
   NotifyConstructionCompleted ();
 }
 
@@ -160,18 +167,18 @@ void
 ObjectBase::SetAttribute (std::string name, const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.FindAttribute (name);
+  if (info == 0)
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" does not exist for this object: tid="<<tid.GetName ());
     }
-  if (!(info.flags & TypeId::ATTR_SET) ||
-      !info.accessor->HasSetter ())
+  if (!(info->flags & TypeId::ATTR_SET) ||
+      !info->accessor->HasSetter ())
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" is not settable for this object: tid="<<tid.GetName ());
     }
-  if (!DoSet (info.accessor, info.checker, value))
+  if (!DoSet (info->accessor, info->checker, value))
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" could not be set for this object: tid="<<tid.GetName ());
     }
@@ -180,36 +187,38 @@ bool
 ObjectBase::SetAttributeFailSafe (std::string name, const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.FindAttribute (name);
+  if (info == 0)
     {
       return false;
     }
-  if (!(info.flags & TypeId::ATTR_SET) ||
-      !info.accessor->HasSetter ())
+  if (!(info->flags & TypeId::ATTR_SET) ||
+      !info->accessor->HasSetter ())
     {
       return false;
     }
-  return DoSet (info.accessor, info.checker, value);
+  return DoSet (info->accessor, info->checker, value);
 }
 
 void
 ObjectBase::GetAttribute (std::string name, AttributeValue &value) const
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.FindAttribute (name);
+  if (info == 0)
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" does not exist for this object: tid="<<tid.GetName ());
     }
-  if (!(info.flags & TypeId::ATTR_GET) || 
-      !info.accessor->HasGetter ())
+  if (!(info->flags & TypeId::ATTR_GET) || 
+      !info->accessor->HasGetter ())
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" is not gettable for this object: tid="<<tid.GetName ());
     }
-  bool ok = info.accessor->Get (this, value);
+  Ptr<const AttributeAccessor> accessor = info->accessor;
+  Ptr<const AttributeChecker> checker = info->checker;
+  bool ok = accessor->Get (this, value);
   if (ok)
     {
       return;
@@ -219,13 +228,13 @@ ObjectBase::GetAttribute (std::string name, AttributeValue &value) const
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" tid="<<tid.GetName () << ": input value is not a string");
     }
-  Ptr<AttributeValue> v = info.checker->Create ();
-  ok = info.accessor->Get (this, *PeekPointer (v));
+  Ptr<AttributeValue> v = checker->Create ();
+  ok = accessor->Get (this, *PeekPointer (v));
   if (!ok)
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" tid="<<tid.GetName () << ": could not get value");
     }
-  str->Set (v->SerializeToString (info.checker));
+  str->Set (v->SerializeToString (checker));
 }
 
 
@@ -233,18 +242,20 @@ bool
 ObjectBase::GetAttributeFailSafe (std::string name, AttributeValue &value) const
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.FindAttribute (name);
+  if (info == 0)
     {
       return false;
     }
-  if (!(info.flags & TypeId::ATTR_GET) ||
-      !info.accessor->HasGetter ())
+  if (!(info->flags & TypeId::ATTR_GET) ||
+      !info->accessor->HasGetter ())
     {
       return false;
     }
-  bool ok = info.accessor->Get (this, value);
+  Ptr<const AttributeAccessor> accessor = info->accessor;
+  Ptr<const AttributeChecker> checker = info->checker;
+  bool ok = accessor->Get (this, value);
   if (ok)
     {
       return true;
@@ -254,13 +265,13 @@ ObjectBase::GetAttributeFailSafe (std::string name, AttributeValue &value) const
     {
       return false;
     }
-  Ptr<AttributeValue> v = info.checker->Create ();
-  ok = info.accessor->Get (this, *PeekPointer (v));
+  Ptr<AttributeValue> v = checker->Create ();
+  ok = accessor->Get (this, *PeekPointer (v));
   if (!ok)
     {
       return false;
     }
-  str->Set (v->SerializeToString (info.checker));
+  str->Set (v->SerializeToString (checker));
   return true;
 }
 
@@ -63,19 +63,20 @@ ObjectFactory::Set (std::string name, const AttributeValue &value)
       return;
     }
   
-  struct TypeId::AttributeInformation info;
-  if (!m_tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = m_tid.FindAttribute (name);
+  if (info == 0)
     {
       NS_FATAL_ERROR ("Invalid attribute set (" << name << ") on " << m_tid.GetName ());
       return;
     }
-  Ptr<AttributeValue> v = info.checker->CreateValidValue (value);
+  Ptr<const AttributeChecker> checker = info->checker;
+  Ptr<AttributeValue> v = checker->CreateValidValue (value);
   if (v == 0)
     {
       NS_FATAL_ERROR ("Invalid value for attribute set (" << name << ") on " << m_tid.GetName ());
       return;
     }
-  m_parameters.Add (name, info.checker, value.Copy ());
+  m_parameters.Add (name, checker, value.Copy ());
 }
 
 TypeId 
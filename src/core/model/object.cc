@@ -26,6 +26,7 @@
 #include "attribute.h"
 #include "log.h"
 #include "string.h"
+#include "config.h"
 #include <vector>
 #include <sstream>
 #include <cstdlib>
@@ -99,6 +100,7 @@ Object::Object ()
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
+  ClearCache (m_aggregates);
 }
 Object::~Object () 
 {
@@ -116,6 +118,13 @@ Object::~Object ()
           m_aggregates->n--;
         }
     }
+  for (uint32_t i = 0; i < CACHE_SIZE; i++)
+    {
+      if (m_aggregates->cache[i].object == this)
+        {
+          m_aggregates->cache[i].tid = 0;
+        }
+    }
   // finally, if all objects have been removed from the list,
   // delete the aggregate list
   if (m_aggregates->n == 0)
@@ -133,6 +142,7 @@ Object::Object (const Object &o)
 {
   m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
+  ClearCache (m_aggregates);
 }
 void
 Object::Construct (const AttributeConstructionList &attributes)
@@ -147,6 +157,12 @@ Object::DoGetObject (TypeId tid) const
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
+  Object *cached = LookupCache (m_aggregates, tid.GetUid ());
+  if (cached != 0)
+    {
+      return cached;
+    }
+
   uint32_t n = m_aggregates->n;
   TypeId objectTid = Object::GetTypeId ();
   for (uint32_t i = 0; i < n; i++)
@@ -169,6 +185,9 @@ Object::DoGetObject (TypeId tid) const
           current->m_getObjectCount++;
           // then, update the sort
           UpdateSortedArray (m_aggregates, i);
+          // remember the match, so that the next lookup of this
+          // TypeId does not need to search the array.
+          UpdateCache (m_aggregates, tid.GetUid (), current);
           // finally, return the match
           return const_cast<Object *> (current);
         }
@@ -238,6 +257,38 @@ Object::UpdateSortedArray (struct Aggregates *aggregates, uint32_t j) const
       j--;
     }
 }
+void
+Object::ClearCache (struct Aggregates *aggregates)
+{
+  NS_LOG_FUNCTION (aggregates);
+  for (uint32_t i = 0; i < CACHE_SIZE; i++)
+    {
+      aggregates->cache[i].tid = 0;
+      aggregates->cache[i].object = 0;
+    }
+}
+void
+Object::UpdateCache (struct Aggregates *aggregates, uint16_t tid, Object *object)
+{
+  NS_LOG_FUNCTION (aggregates << tid << object);
+  struct Aggregates::CacheEntry &entry = aggregates->cache[tid % CACHE_SIZE];
+  uint16_t old = entry.tid;
+#if defined (__GNUC__)
+  // the object is written while the entry is marked busy, so that the
+  // readers never pair it with the tid of another object.
+  if (old == CACHE_BUSY || !__sync_bool_compare_and_swap (&entry.tid, old, CACHE_BUSY))
+    {
+      return;
+    }
+  entry.object = object;
+  __sync_synchronize ();
+  entry.tid = tid;
+#else
+  entry.tid = CACHE_BUSY;
+  entry.object = object;
+  entry.tid = tid;
+#endif
+}
 void 
 Object::AggregateObject (Ptr<Object> o)
 {
@@ -260,6 +311,7 @@ Object::AggregateObject (Ptr<Object> o)
   struct Aggregates *aggregates = 
     (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
   aggregates->n = total;
+  ClearCache (aggregates);
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -305,6 +357,9 @@ Object::AggregateObject (Ptr<Object> o)
   // Now that we are done with them, we can free our old aggregate buffers
   std::free (a);
   std::free (b);
+
+  // the objects found by the "$" elements of the config paths changed.
+  Config::InvalidateMatchCache ();
 }
 /**
  * This function must be implemented in the stack that needs to notify
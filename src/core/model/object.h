@@ -229,6 +229,10 @@ private:
   friend class AggregateIterator;
   friend struct ObjectDeleter;
 
+  /**
+   * The number of entries of the lookup cache of the aggregates.
+   */
+  enum { CACHE_SIZE = 8, CACHE_BUSY = 0xffff };
   /**
    * This data structure uses a classic C-style trick to 
    * hold an array of variable size without performing
@@ -241,6 +245,16 @@ private:
    */
   struct Aggregates {
     uint32_t n;
+    /**
+     * The results of the previous lookups in these aggregates, indexed
+     * by the uid of the requested TypeId modulo CACHE_SIZE. An entry
+     * whose tid is zero is empty, and an entry whose tid is CACHE_BUSY
+     * is being written.
+     */
+    struct CacheEntry {
+      volatile uint16_t tid;
+      Object * volatile object;
+    } cache[CACHE_SIZE];
     Object *buffer[1];
   };
 
@@ -291,6 +305,33 @@ private:
    * \param i the most recently used entry in the list
    */
   void UpdateSortedArray (struct Aggregates *aggregates, uint32_t i) const;
+  /**
+   * Empty the lookup cache of a list of aggregates
+   *
+   * \param aggregates the list of aggregated objects
+   */
+  static void ClearCache (struct Aggregates *aggregates);
+  /**
+   * Look up the result of a previous lookup in a list of aggregates
+   *
+   * The entries may be written by another thread which looks up the
+   * same aggregates: the object is only returned if the tid of its
+   * entry did not change while it was read, and the writers update the
+   * tid last.
+   *
+   * \param aggregates the list of aggregated objects
+   * \param tid the uid of the TypeId we're looking for
+   * \return the cached Object, or zero
+   */
+  static Object *LookupCache (const struct Aggregates *aggregates, uint16_t tid);
+  /**
+   * Remember the result of a lookup, unless another thread is doing so
+   *
+   * \param aggregates the list of aggregated objects
+   * \param tid the uid of the TypeId looked up
+   * \param object the Object found
+   */
+  static void UpdateCache (struct Aggregates *aggregates, uint16_t tid, Object *object);
   /**
    * Attempt to delete this object. This method iterates
    * over all aggregated objects to check if they all 
@@ -355,19 +396,49 @@ ObjectDeleter::Delete (Object *object)
  *   The Object implementation which depends on templates
  *************************************************************************/
 
+inline Object *
+Object::LookupCache (const struct Aggregates *aggregates, uint16_t tid)
+{
+  const struct Aggregates::CacheEntry &entry = aggregates->cache[tid % CACHE_SIZE];
+  if (entry.tid != tid)
+    {
+      return 0;
+    }
+  Object *object = entry.object;
+#if defined (__i386__) || defined (__x86_64__)
+  // loads are not reordered with other loads
+  __asm__ __volatile__ ("" : : : "memory");
+#elif defined (__GNUC__)
+  __sync_synchronize ();
+#endif
+  if (entry.tid != tid)
+    {
+      return 0;
+    }
+  return object;
+}
+
 template <typename T>
 Ptr<T> 
 Object::GetObject () const
 {
-  // This is an optimization: if the cast works (which is likely),
-  // things will be pretty fast.
+  // This is an optimization: if the same lookup was performed on these
+  // aggregates before, its result is in the cache.
+  TypeId tid = T::GetTypeId ();
+  Object *cached = LookupCache (m_aggregates, tid.GetUid ());
+  if (cached != 0)
+    {
+      return Ptr<T> (static_cast<T *> (cached));
+    }
+  // Otherwise, if the cast works (which is likely), things will be
+  // pretty fast.
   T *result = dynamic_cast<T *> (m_aggregates->buffer[0]);
   if (result != 0)
     {
       return Ptr<T> (result);
     }
   // if the cast does not work, we try to do a full type check.
-  Ptr<Object> found = DoGetObject (T::GetTypeId ());
+  Ptr<Object> found = DoGetObject (tid);
   if (found != 0)
     {
       return Ptr<T> (static_cast<T *> (PeekPointer (found)));
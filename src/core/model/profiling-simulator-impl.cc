@@ -0,0 +1,496 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "profiling-simulator-impl.h"
+#include "default-simulator-impl.h"
+#include "string.h"
+#include "log.h"
+
+#include <typeinfo>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("ProfilingSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (ProfilingSimulatorImpl);
+
+namespace {
+
+ObjectFactory
+GetDefaultSimulatorImplFactory ()
+{
+  ObjectFactory factory;
+  factory.SetTypeId (DefaultSimulatorImpl::GetTypeId ());
+  return factory;
+}
+
+uint64_t
+GetWallClockNs (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// sort the lines of a report by decreasing total time.
+struct ReportLine
+{
+  ReportLine ()
+    : count (0),
+      time (0)
+  {
+  }
+  std::string name;
+  uint64_t count;
+  uint64_t time;
+  bool operator < (const ReportLine &o) const
+  {
+    return time > o.time || (time == o.time && name < o.name);
+  }
+};
+
+void
+PrintLines (std::ostream &os, const std::map<std::string, ReportLine> &lines, uint64_t total)
+{
+  std::vector<ReportLine> sorted;
+  for (std::map<std::string, ReportLine>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      sorted.push_back (i->second);
+    }
+  std::sort (sorted.begin (), sorted.end ());
+  os << std::setw (12) << "time (ms)" << std::setw (8) << "%"
+     << std::setw (12) << "count" << std::setw (12) << "mean (us)" << "  name" << std::endl;
+  for (std::vector<ReportLine>::const_iterator i = sorted.begin (); i != sorted.end (); ++i)
+    {
+      os << std::fixed << std::setprecision (3)
+         << std::setw (12) << i->time / 1e6
+         << std::setprecision (2)
+         << std::setw (8) << (total == 0 ? 0.0 : 100.0 * i->time / total)
+         << std::setw (12) << i->count
+         << std::setprecision (3)
+         << std::setw (12) << (i->count == 0 ? 0.0 : i->time / 1e3 / i->count)
+         << "  " << i->name << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+/**
+ * Invoke the wrapped event and account for the wall-clock time it took.
+ */
+class ProfilingSimulatorImpl::ProfiledEvent : public EventImpl
+{
+public:
+  ProfiledEvent (ProfilingSimulatorImpl *profiler, EventImpl *event)
+    : m_profiler (profiler),
+      m_event (event)
+  {
+  }
+  virtual ~ProfiledEvent ()
+  {
+    m_event->Unref ();
+  }
+private:
+  virtual void Notify (void)
+  {
+    // the wrapped event may have been cancelled directly rather than
+    // through its EventId.
+    if (m_event->IsCancelled ())
+      {
+        return;
+      }
+    uint64_t start = GetWallClockNs ();
+    m_event->Invoke ();
+    uint64_t end = GetWallClockNs ();
+    m_profiler->Account (Key (typeid (*m_event).name (), m_event->GetHandler (),
+                              m_profiler->GetContext ()),
+                         end - start);
+  }
+  ProfilingSimulatorImpl *m_profiler;
+  EventImpl *m_event;
+};
+
+TypeId
+ProfilingSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ProfilingSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<ProfilingSimulatorImpl> ()
+    .AddAttribute ("SimulatorImplFactory",
+                   "Factory for the underlying simulator implementation which executes the events.",
+                   ObjectFactoryValue (GetDefaultSimulatorImplFactory ()),
+                   MakeObjectFactoryAccessor (&ProfilingSimulatorImpl::m_simulatorImplFactory),
+                   MakeObjectFactoryChecker ())
+    .AddAttribute ("ReportFile",
+                   "The file the event profile report is written to at Simulator::Destroy, "
+                   "or an empty string to write no report.",
+                   StringValue ("profile.txt"),
+                   MakeStringAccessor (&ProfilingSimulatorImpl::m_reportFile),
+                   MakeStringChecker ())
+    .AddAttribute ("FoldedFile",
+                   "The file the event profile is written to at Simulator::Destroy in the "
+                   "folded stack format of flame graph tools, or an empty string to write no file.",
+                   StringValue ("profile.folded"),
+                   MakeStringAccessor (&ProfilingSimulatorImpl::m_foldedFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+ProfilingSimulatorImpl::ProfilingSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ProfilingSimulatorImpl::~ProfilingSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ProfilingSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_simulator)
+    {
+      m_simulator->Dispose ();
+      m_simulator = 0;
+    }
+  m_records.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+ProfilingSimulatorImpl::NotifyConstructionCompleted (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator = m_simulatorImplFactory.Create<SimulatorImpl> ();
+  SimulatorImpl::NotifyConstructionCompleted ();
+}
+
+EventImpl *
+ProfilingSimulatorImpl::Wrap (EventImpl *event)
+{
+  return new ProfiledEvent (this, event);
+}
+
+ProfilingSimulatorImpl::Key::Key (const char *type, uintptr_t handler, uint32_t context)
+  : type (type),
+    handler (handler),
+    context (context)
+{
+}
+
+bool
+ProfilingSimulatorImpl::Key::operator < (const Key &o) const
+{
+  if (type != o.type)
+    {
+      return type < o.type;
+    }
+  if (handler != o.handler)
+    {
+      return handler < o.handler;
+    }
+  return context < o.context;
+}
+
+void
+ProfilingSimulatorImpl::Account (const Key &key, uint64_t time)
+{
+  struct Record &record = m_records[key];
+  record.count++;
+  record.time += time;
+}
+
+void
+ProfilingSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator->Destroy ();
+  WriteReports ();
+}
+
+void
+ProfilingSimulatorImpl::WriteReports (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_reportFile.empty ())
+    {
+      std::ofstream os (m_reportFile.c_str ());
+      if (!os.is_open ())
+        {
+          NS_LOG_WARN ("Cannot open " << m_reportFile);
+        }
+      PrintReport (os);
+    }
+  if (!m_foldedFile.empty ())
+    {
+      std::ofstream os (m_foldedFile.c_str ());
+      if (!os.is_open ())
+        {
+          NS_LOG_WARN ("Cannot open " << m_foldedFile);
+        }
+      PrintFolded (os);
+    }
+}
+
+void
+ProfilingSimulatorImpl::PrintReport (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  std::map<std::string, ReportLine> types;
+  std::map<std::string, ReportLine> contexts;
+  uint64_t count = 0;
+  uint64_t total = 0;
+  for (Records::const_iterator i = m_records.begin (); i != m_records.end (); ++i)
+    {
+      std::string type = GetEventName (i->first.type, i->first.handler);
+      std::string context = GetContextName (i->first.context);
+      ReportLine &t = types[type];
+      t.name = type;
+      t.count += i->second.count;
+      t.time += i->second.time;
+      ReportLine &c = contexts[context];
+      c.name = context;
+      c.count += i->second.count;
+      c.time += i->second.time;
+      count += i->second.count;
+      total += i->second.time;
+    }
+  os << "Event profile: " << count << " events in " << total / 1e9 << " s" << std::endl;
+  os << std::endl << "By event type:" << std::endl;
+  PrintLines (os, types, total);
+  os << std::endl << "By context:" << std::endl;
+  PrintLines (os, contexts, total);
+}
+
+void
+ProfilingSimulatorImpl::PrintFolded (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  std::map<std::string, uint64_t> stacks;
+  for (Records::const_iterator i = m_records.begin (); i != m_records.end (); ++i)
+    {
+      std::string stack = GetContextName (i->first.context) + ";" + GetEventName (i->first.type, i->first.handler);
+      stacks[stack] += i->second.time;
+    }
+  for (std::map<std::string, uint64_t>::const_iterator i = stacks.begin (); i != stacks.end (); ++i)
+    {
+      os << i->first << " " << i->second << std::endl;
+    }
+}
+
+std::string
+ProfilingSimulatorImpl::GetEventName (const char *type, uintptr_t handler)
+{
+  std::string name = GetSignature (type);
+  if (handler != 0)
+    {
+      std::ostringstream oss;
+      oss << name << " at 0x" << std::hex << handler;
+      name = oss.str ();
+    }
+  return name;
+}
+
+std::string
+ProfilingSimulatorImpl::GetSignature (const char *type)
+{
+  int status;
+  char *demangled = abi::__cxa_demangle (type, NULL, NULL, &status);
+  if (status != 0)
+    {
+      return type;
+    }
+  std::string name = demangled;
+  std::free (demangled);
+
+  // The events created by MakeEvent are local classes of the MakeEvent
+  // function templates: the first template argument, or the first
+  // argument of the non-template overloads, is the type of the function
+  // or method invoked.
+  std::string::size_type start = name.find ("MakeEvent<");
+  if (start == std::string::npos)
+    {
+      start = name.find ("MakeEvent(");
+    }
+  if (start == std::string::npos)
+    {
+      return name;
+    }
+  start += std::string ("MakeEvent<").size ();
+  int depth = 0;
+  for (std::string::size_type i = start; i < name.size (); i++)
+    {
+      char c = name[i];
+      if (c == '<' || c == '(')
+        {
+          depth++;
+        }
+      else if (depth > 0 && (c == '>' || c == ')'))
+        {
+          depth--;
+        }
+      else if (depth == 0 && (c == ',' || c == '>' || c == ')'))
+        {
+          return name.substr (start, i - start);
+        }
+    }
+  return name;
+}
+
+std::string
+ProfilingSimulatorImpl::GetContextName (uint32_t context)
+{
+  if (context == 0xffffffff)
+    {
+      return "no context";
+    }
+  std::ostringstream oss;
+  oss << "node " << context;
+  return oss.str ();
+}
+
+EventId
+ProfilingSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  return m_simulator->Schedule (time, Wrap (event));
+}
+
+void
+ProfilingSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  m_simulator->ScheduleWithContext (context, time, Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return m_simulator->ScheduleNow (Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  return m_simulator->ScheduleDestroy (event);
+}
+
+void
+ProfilingSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  m_simulator->SetScheduler (schedulerFactory);
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetSystemId (void) const
+{
+  return m_simulator->GetSystemId ();
+}
+
+bool
+ProfilingSimulatorImpl::IsFinished (void) const
+{
+  return m_simulator->IsFinished ();
+}
+
+void
+ProfilingSimulatorImpl::Run (void)
+{
+  m_simulator->Run ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (void)
+{
+  m_simulator->Stop ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (Time const &time)
+{
+  m_simulator->Stop (time);
+}
+
+void
+ProfilingSimulatorImpl::Remove (const EventId &id)
+{
+  m_simulator->Remove (id);
+}
+
+void
+ProfilingSimulatorImpl::Cancel (const EventId &id)
+{
+  m_simulator->Cancel (id);
+}
+
+bool
+ProfilingSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  return m_simulator->IsExpired (ev);
+}
+
+Time
+ProfilingSimulatorImpl::Now (void) const
+{
+  return m_simulator->Now ();
+}
+
+Time
+ProfilingSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  return m_simulator->GetDelayLeft (id);
+}
+
+Time
+ProfilingSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return m_simulator->GetMaximumSimulationTime ();
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetContext (void) const
+{
+  return m_simulator->GetContext ();
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_simulator->GetLiveEventCount ();
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_simulator->GetCancelledEventCount ();
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetPeakEventCount (void) const
+{
+  return m_simulator->GetPeakEventCount ();
+}
+
+} // namespace ns3
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PROFILING_SIMULATOR_IMPL_H
+#define PROFILING_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "object-factory.h"
+#include "event-impl.h"
+#include "ptr.h"
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <utility>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * \brief A simulator implementation which measures the wall-clock time
+ * spent in each event.
+ *
+ * To use this class, run any ns-3 simulation with the command-line
+ * argument --SimulatorImplementationType=ns3::ProfilingSimulatorImpl.
+ *
+ * The events are executed by an underlying simulator implementation,
+ * created from the SimulatorImplFactory attribute. Each event scheduled
+ * through this class is wrapped into an event which counts its
+ * invocations and measures their duration with the monotonic system
+ * clock. The measurements are attributed to the function or method
+ * the event invokes, and to the context (usually the node id) it is
+ * invoked in. Events scheduled with Simulator::ScheduleDestroy are not
+ * measured. The functions and methods are named by their signature
+ * followed by the identifier returned by EventImpl::GetHandler, with
+ * the common ABIs the address of the function or non-virtual method,
+ * so that the handlers which share a signature are reported apart.
+ *
+ * At Simulator::Destroy, a report of the events sorted by decreasing
+ * total time is written to the file named by the ReportFile attribute,
+ * and the same measurements are written to the file named by the
+ * FoldedFile attribute in the folded stack format read by flame graph
+ * tools: one line per context and event type, with the time spent in
+ * nanoseconds.
+ */
+class ProfilingSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  ProfilingSimulatorImpl ();
+  ~ProfilingSimulatorImpl ();
+
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
+  virtual uint32_t GetPeakEventCount (void) const;
+
+  /**
+   * \param os the stream to print to
+   *
+   * Print the number of invocations and the time spent in the events
+   * measured so far, by event type and by context, sorted by
+   * decreasing total time.
+   */
+  void PrintReport (std::ostream &os) const;
+  /**
+   * \param os the stream to print to
+   *
+   * Print the events measured so far in the folded stack format.
+   */
+  void PrintFolded (std::ostream &os) const;
+
+protected:
+  virtual void DoDispose (void);
+  virtual void NotifyConstructionCompleted (void);
+
+private:
+  class ProfiledEvent;
+
+  struct Record
+  {
+    uint64_t count;
+    // wall-clock time spent, in nanoseconds
+    uint64_t time;
+  };
+  // the events are identified by the std::type_info name of their type,
+  // which is unique and constant for each type, and by their handler.
+  struct Key
+  {
+    Key (const char *type, uintptr_t handler, uint32_t context);
+    bool operator < (const Key &o) const;
+    const char *type;
+    uintptr_t handler;
+    uint32_t context;
+  };
+  typedef std::map<Key, struct Record> Records;
+
+  EventImpl *Wrap (EventImpl *event);
+  void Account (const Key &key, uint64_t time);
+  void WriteReports (void) const;
+  static std::string GetEventName (const char *type, uintptr_t handler);
+  static std::string GetSignature (const char *type);
+  static std::string GetContextName (uint32_t context);
+
+  Ptr<SimulatorImpl> m_simulator;
+  ObjectFactory m_simulatorImplFactory;
+  std::string m_reportFile;
+  std::string m_foldedFile;
+  Records m_records;
+};
+
+} // namespace ns3
+
+#endif /* PROFILING_SIMULATOR_IMPL_H */
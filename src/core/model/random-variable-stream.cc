@@ -35,6 +35,7 @@
 #include "rng-seed-manager.h"
 #include <cmath>
 #include <iostream>
+#include <set>
 
 NS_LOG_COMPONENT_DEFINE ("RandomVariableStream");
 
@@ -42,6 +43,87 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (RandomVariableStream);
 
+namespace {
+// all the existing streams, for RandomVariableStream::ReseedAll.
+std::set<RandomVariableStream *> &
+GetStreams (void)
+{
+  static std::set<RandomVariableStream *> streams;
+  return streams;
+}
+
+// Build the alias table of a discrete distribution with Vose's
+// algorithm: entry i keeps i with probability prob[i], and otherwise
+// returns alias[i].
+void
+BuildAliasTable (const std::vector<double> &weights,
+                 std::vector<double> &prob, std::vector<uint32_t> &alias)
+{
+  uint32_t n = weights.size ();
+  double sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += weights[i];
+    }
+  NS_ASSERT (sum > 0);
+  prob.resize (n);
+  alias.resize (n);
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      prob[i] = weights[i] * n / sum;
+      alias[i] = i;
+      if (prob[i] < 1.0)
+        {
+          small.push_back (i);
+        }
+      else
+        {
+          large.push_back (i);
+        }
+    }
+  while (!small.empty () && !large.empty ())
+    {
+      uint32_t s = small.back ();
+      uint32_t l = large.back ();
+      small.pop_back ();
+      alias[s] = l;
+      prob[l] -= 1.0 - prob[s];
+      if (prob[l] < 1.0)
+        {
+          large.pop_back ();
+          small.push_back (l);
+        }
+    }
+  // the rounding errors leave entries whose probability is close to 1.
+  for (uint32_t i = 0; i < small.size (); i++)
+    {
+      prob[small[i]] = 1.0;
+    }
+  for (uint32_t i = 0; i < large.size (); i++)
+    {
+      prob[large[i]] = 1.0;
+    }
+}
+
+// Draw the index of an entry of an alias table with a single uniform
+// value: its integer part selects the entry and its fractional part
+// decides between the entry and its alias.
+inline uint32_t
+SampleAliasTable (double u, const std::vector<double> &prob,
+                  const std::vector<uint32_t> &alias)
+{
+  double x = u * prob.size ();
+  uint32_t i = static_cast<uint32_t> (x);
+  if (i >= prob.size ())
+    {
+      i = prob.size () - 1;
+    }
+  return (x - i < prob[i]) ? i : alias[i];
+}
+} // anonymous namespace
+
 TypeId 
 RandomVariableStream::GetTypeId (void)
 {
@@ -65,13 +147,16 @@ RandomVariableStream::GetTypeId (void)
 }
 
 RandomVariableStream::RandomVariableStream()
-  : m_rng (0)
+  : m_rng (0),
+    m_rngStream (0)
 {
   NS_LOG_FUNCTION (this);
+  GetStreams ().insert (this);
 }
 RandomVariableStream::~RandomVariableStream()
 {
   NS_LOG_FUNCTION (this);
+  GetStreams ().erase (this);
   delete m_rng;
 }
 
@@ -102,7 +187,9 @@ RandomVariableStream::SetStream (int64_t stream)
       NS_ASSERT(nextStream <= ((1ULL)<<63));
       m_rng = new RngStream (RngSeedManager::GetSeed (),
                              nextStream,
-                             RngSeedManager::GetRun ());
+                             RngSeedManager::GetRun (),
+                             RngSeedManager::GetGenerator ());
+      m_rngStream = nextStream;
     }
   else
     {
@@ -112,10 +199,32 @@ RandomVariableStream::SetStream (int64_t stream)
       uint64_t target = base + stream;
       m_rng = new RngStream (RngSeedManager::GetSeed (),
                              target,
-                             RngSeedManager::GetRun ());
+                             RngSeedManager::GetRun (),
+                             RngSeedManager::GetGenerator ());
+      m_rngStream = target;
     }
   m_stream = stream;
 }
+
+void
+RandomVariableStream::ReseedAll (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::set<RandomVariableStream *> &streams = GetStreams ();
+  for (std::set<RandomVariableStream *>::const_iterator i = streams.begin (); i != streams.end (); ++i)
+    {
+      RandomVariableStream *stream = *i;
+      if (stream->m_rng == 0)
+        {
+          continue;
+        }
+      delete stream->m_rng;
+      stream->m_rng = new RngStream (RngSeedManager::GetSeed (),
+                                     stream->m_rngStream,
+                                     RngSeedManager::GetRun (),
+                                     RngSeedManager::GetGenerator ());
+    }
+}
 int64_t
 RandomVariableStream::GetStream(void) const
 {
@@ -123,6 +232,16 @@ RandomVariableStream::GetStream(void) const
   return m_stream;
 }
 
+void
+RandomVariableStream::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      values[i] = GetValue ();
+    }
+}
+
 RngStream *
 RandomVariableStream::Peek(void) const
 {
@@ -199,6 +318,24 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  double min = m_min;
+  double max = m_max;
+  bool antithetic = IsAntithetic ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double v = min + values[i] * (max - min);
+      if (antithetic)
+        {
+          v = min + (max - v);
+        }
+      values[i] = v;
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
@@ -433,6 +570,29 @@ ExponentialRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_bound);
 }
+void
+ExponentialRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  bool antithetic = IsAntithetic ();
+  // a value above the bound is replaced by the next one, as in
+  // GetValue, so value i may use a uniform value of index j > i.
+  uint32_t i = 0;
+  for (uint32_t j = 0; j < n; j++)
+    {
+      double v = antithetic ? (1 - values[j]) : values[j];
+      double r = -m_mean * std::log (v);
+      if (m_bound == 0 || r <= m_bound)
+        {
+          values[i++] = r;
+        }
+    }
+  for (; i < n; i++)
+    {
+      values[i] = GetValue (m_mean, m_bound);
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ParetoRandomVariable);
 
@@ -1260,6 +1420,8 @@ ZipfRandomVariable::GetTypeId (void)
   return tid;
 }
 ZipfRandomVariable::ZipfRandomVariable ()
+  : m_tableN (0),
+    m_tableAlpha (0.0)
 {
   // m_n and m_alpha are initialized after constructor by attributes
   NS_LOG_FUNCTION (this);
@@ -1278,17 +1440,36 @@ ZipfRandomVariable::GetAlpha (void) const
   return m_alpha;
 }
 
+void
+ZipfRandomVariable::BuildTable (uint32_t n, double alpha)
+{
+  NS_LOG_FUNCTION (this << n << alpha);
+  std::vector<double> weights (n);
+  double sum = 0.0;
+  for (uint32_t i = 1; i <= n; i++)
+    {
+      weights[i - 1] = 1.0 / std::pow ((double)i, alpha);
+      sum += weights[i - 1];
+    }
+  // Calculate the normalization constant c.
+  m_c = 1.0 / sum;
+  BuildAliasTable (weights, m_prob, m_alias);
+  m_tableN = n;
+  m_tableAlpha = alpha;
+}
+
 double 
 ZipfRandomVariable::GetValue (uint32_t n, double alpha)
 {
   NS_LOG_FUNCTION (this << n << alpha);
-  // Calculate the normalization constant c.
-  m_c = 0.0;
-  for (uint32_t i = 1; i <= n; i++)
+  if (n == 0)
+    {
+      return 0;
+    }
+  if (n != m_tableN || alpha != m_tableAlpha)
     {
-      m_c += (1.0 / std::pow ((double)i,alpha));
+      BuildTable (n, alpha);
     }
-  m_c = 1.0 / m_c;
 
   // Get a uniform random variable in [0,1].
   double u = Peek ()->RandU01 ();
@@ -1297,17 +1478,7 @@ ZipfRandomVariable::GetValue (uint32_t n, double alpha)
       u = (1 - u);
     }
 
-  double sum_prob = 0,zipf_value = 0;
-  for (uint32_t i = 1; i <= m_n; i++)
-    {
-      sum_prob += m_c / std::pow ((double)i,m_alpha);
-      if (sum_prob > u)
-        {
-          zipf_value = i;
-          break;
-        }
-    }
-  return zipf_value;
+  return SampleAliasTable (u, m_prob, m_alias) + 1;
 }
 
 uint32_t 
@@ -1513,14 +1684,35 @@ EmpiricalRandomVariable::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::EmpiricalRandomVariable")
     .SetParent<RandomVariableStream>()
     .AddConstructor<EmpiricalRandomVariable> ()
+    .AddAttribute("Interpolate", "Whether the values are interpolated between the points of the CDF.",
+                  BooleanValue (true),
+                  MakeBooleanAccessor (&EmpiricalRandomVariable::SetInterpolate,
+                                       &EmpiricalRandomVariable::GetInterpolate),
+                  MakeBooleanChecker ())
     ;
   return tid;
 }
 EmpiricalRandomVariable::EmpiricalRandomVariable ()
   :
-  validated (false)
+  validated (false),
+  m_interpolate (true),
+  m_guideScale (0.0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+EmpiricalRandomVariable::SetInterpolate (bool interpolate)
+{
+  NS_LOG_FUNCTION (this << interpolate);
+  m_interpolate = interpolate;
+  validated = false;
+}
+bool
+EmpiricalRandomVariable::GetInterpolate (void) const
 {
   NS_LOG_FUNCTION (this);
+  return m_interpolate;
 }
 
 double 
@@ -1545,6 +1737,11 @@ EmpiricalRandomVariable::GetValue (void)
       r = (1 - r);
     }
 
+  if (!m_interpolate)
+    {
+      return emp[SampleAliasTable (r, m_prob, m_alias)].value;
+    }
+
   if (r <= emp.front ().cdf)
     {
       return emp.front ().value; // Less than first
@@ -1553,28 +1750,26 @@ EmpiricalRandomVariable::GetValue (void)
     {
       return emp.back ().value;  // Greater than last
     }
-  // Binary search
-  std::vector<ValueCDF>::size_type bottom = 0;
-  std::vector<ValueCDF>::size_type top = emp.size () - 1;
-  while (1)
+  // Look for the first point above r from the guide table entry of
+  // its interval: the loops only move by more than one point when
+  // several points fall into the same interval.
+  uint32_t k = static_cast<uint32_t> ((r - emp.front ().cdf) * m_guideScale);
+  if (k >= m_guide.size ())
     {
-      std::vector<ValueCDF>::size_type c = (top + bottom) / 2;
-      if (r >= emp[c].cdf && r < emp[c + 1].cdf)
-        { // Found it
-          return Interpolate (emp[c].cdf, emp[c + 1].cdf,
-                              emp[c].value, emp[c + 1].value,
-                              r);
-        }
-      // Not here, adjust bounds
-      if (r < emp[c].cdf)
-        {
-          top    = c - 1;
-        }
-      else
-        {
-          bottom = c + 1;
-        }
+      k = m_guide.size () - 1;
+    }
+  std::vector<ValueCDF>::size_type c = m_guide[k];
+  while (emp[c].cdf <= r)
+    {
+      c++;
     }
+  while (emp[c - 1].cdf > r)
+    {
+      c--;
+    }
+  return Interpolate (emp[c - 1].cdf, emp[c].cdf,
+                      emp[c - 1].value, emp[c].value,
+                      r);
 }
 
 uint32_t 
@@ -1589,6 +1784,7 @@ void EmpiricalRandomVariable::CDF (double v, double c)
   // NOTE.   These MUST be inserted in non-decreasing order
   NS_LOG_FUNCTION (this << v << c);
   emp.push_back (ValueCDF (v, c));
+  validated = false;
 }
 
 void EmpiricalRandomVariable::Validate ()
@@ -1609,6 +1805,42 @@ void EmpiricalRandomVariable::Validate ()
         }
       prior = current;
     }
+
+  if (m_interpolate)
+    {
+      // m_guide[k] is the first point above the start of interval k.
+      uint32_t n = emp.size ();
+      double width = (emp.back ().cdf - emp.front ().cdf) / n;
+      m_guideScale = width > 0 ? 1.0 / width : 0.0;
+      m_guide.resize (n);
+      std::vector<ValueCDF>::size_type c = 1;
+      for (uint32_t k = 0; k < n; k++)
+        {
+          double start = emp.front ().cdf + k * width;
+          while (c < n - 1 && emp[c].cdf <= start)
+            {
+              c++;
+            }
+          m_guide[k] = c;
+        }
+    }
+  else
+    {
+      // the probability of each point, the last one taking the
+      // probabilities above the end of the CDF.
+      std::vector<double> weights (emp.size ());
+      double below = 0.0;
+      for (std::vector<ValueCDF>::size_type i = 0; i < emp.size (); ++i)
+        {
+          weights[i] = emp[i].cdf - below;
+          below = emp[i].cdf;
+        }
+      if (below < 1.0)
+        {
+          weights.back () += 1.0 - below;
+        }
+      BuildAliasTable (weights, m_prob, m_alias);
+    }
   validated = true;
 }
 
@@ -117,6 +117,18 @@ public:
    */
   bool IsAntithetic(void) const;
 
+  /**
+   * \brief Re-create the underlying RNG stream of every existing
+   * RandomVariableStream.
+   *
+   * Each stream keeps its stream number, and restarts from the
+   * beginning of the substream selected by the current seed and run
+   * number, as if it had just been created. This is used to re-seed the
+   * random variables of a simulation forked after a warm-up with
+   * Simulator::ForkVariants.
+   */
+  static void ReseedAll (void);
+
   /**
    * \brief Returns a random double from the underlying distribution
    * \return A floating point random value.
@@ -129,6 +141,18 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Fill an array with random doubles from the underlying
+   * distribution
+   * \param values the array to fill
+   * \param n the number of values to generate
+   *
+   * The values are those which n calls to GetValue would return.
+   * Subclasses which can draw their uniform values in one batch
+   * override this method.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
 protected:
   /**
    * \brief Returns a pointer to the underlying RNG stream.
@@ -145,6 +169,9 @@ private:
   /// Pointer to the underlying RNG stream.
   RngStream *m_rng;
 
+  /// The index of the underlying RNG stream.
+  uint64_t m_rngStream;
+
   /// Indicates if antithetic values should be generated by this RNG stream.
   bool m_isAntithetic;
 
@@ -286,6 +313,14 @@ public:
    * upper bound.
    */
   virtual uint32_t GetInteger (void);
+
+  /**
+   * \brief Fill an array with random doubles, drawing the uniform
+   * values in one batch.
+   * \param values the array to fill
+   * \param n the number of values to generate
+   */
+  virtual void GetValues (double *values, uint32_t n);
 private:
   /// The lower bound on values that can be returned by this RNG stream.
   double m_min;
@@ -595,6 +630,14 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Fill an array with random doubles, drawing the uniform
+   * values in one batch.
+   * \param values the array to fill
+   * \param n the number of values to generate
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
 private:
   /// The mean value of the random variables returned by this RNG stream.
   double m_mean;
@@ -2036,6 +2079,10 @@ private:
  * Probability Mass Function is \f$ f(k; \alpha, N) = k^{-\alpha}/ H_{N,\alpha} \f$
  * where \f$ H_{N,\alpha} = \sum_{m=1}^N m^{-\alpha} \f$
  *
+ * Values are drawn in constant time with Walker's alias method, from
+ * a table of N entries which is built the first time a value is
+ * requested for a given N and alpha.
+ *
  * Here is an example of how to use this class:
  * \code
  *   uint32_t n = 1;
@@ -2161,6 +2208,13 @@ public:
   virtual uint32_t GetInteger (void);
 
 private:
+  /**
+   * \brief Build the alias table of a Zipf distribution.
+   * \param n N value for the Zipf distribution.
+   * \param alpha Alpha value for the Zipf distribution.
+   */
+  void BuildTable (uint32_t n, double alpha);
+
   /// The n value for the Zipf distribution returned by this RNG stream.
   uint32_t m_n;
 
@@ -2169,6 +2223,18 @@ private:
 
   /// The normalization constant.
   double m_c;
+
+  /// The n value of the alias table.
+  uint32_t m_tableN;
+
+  /// The alpha value of the alias table.
+  double m_tableAlpha;
+
+  /// The probability of keeping each entry of the alias table.
+  std::vector<double> m_prob;
+
+  /// The alias of each entry of the alias table.
+  std::vector<uint32_t> m_alias;
 };
 
 /**
@@ -2383,6 +2449,16 @@ private:
  * two appropriate points in the CDF.  The method is known
  * as inverse transform sampling:
  * (http://en.wikipedia.org/wiki/Inverse_transform_sampling).
+ * The point which follows the probability is found in a guide
+ * table, which divides the range of probabilities into as many
+ * intervals of equal size as there are points, so that it takes
+ * constant time on average.
+ *
+ * If the Interpolate attribute is false, the distribution is
+ * discrete instead: the value returned is the smallest value whose
+ * probability is greater than or equal to the uniform random
+ * variable.  These values are drawn in constant time with Walker's
+ * alias method.
  *
  * Here is an example of how to use this class:
  * \code
@@ -2444,6 +2520,19 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Select a continuous or discrete distribution
+   * \param interpolate true to interpolate the values between the
+   * points of the CDF, false to return only the values of the points
+   */
+  void SetInterpolate (bool interpolate);
+
+  /**
+   * \return true if the values are interpolated between the points of
+   * the CDF
+   */
+  bool GetInterpolate (void) const;
+
 private:
   class ValueCDF
   {
@@ -2458,6 +2547,11 @@ public:
   virtual double Interpolate (double, double, double, double, double);
   bool validated; // True if non-decreasing validated
   std::vector<ValueCDF> emp;       // Empicical CDF
+  bool m_interpolate;              // True for a continuous distribution
+  std::vector<uint32_t> m_guide;   // First point above each interval
+  double m_guideScale;             // Number of intervals per probability
+  std::vector<double> m_prob;      // Alias table of the discrete points
+  std::vector<uint32_t> m_alias;
 };
 
 } // namespace ns3
@@ -2,6 +2,7 @@
 #include "global-value.h"
 #include "attribute-helper.h"
 #include "integer.h"
+#include "enum.h"
 #include "config.h"
 #include "log.h"
 
@@ -19,6 +20,12 @@ static ns3::GlobalValue g_rngRun ("RngRun",
                                   ns3::IntegerValue (1),
                                   ns3::MakeIntegerChecker<int64_t> ());
 
+static ns3::GlobalValue g_rngGenerator ("RngGenerator",
+                                        "The generator of the rng streams",
+                                        ns3::EnumValue (RngStream::MRG32K3A),
+                                        ns3::MakeEnumChecker (RngStream::MRG32K3A, "MRG32k3a",
+                                                              RngStream::PHILOX, "Philox"));
+
 
 uint32_t RngSeedManager::GetSeed (void)
 {
@@ -49,6 +56,22 @@ uint64_t RngSeedManager::GetRun ()
   return run;
 }
 
+void
+RngSeedManager::SetGenerator (enum RngStream::Generator generator)
+{
+  NS_LOG_FUNCTION (generator);
+  Config::SetGlobal ("RngGenerator", EnumValue (generator));
+}
+
+enum RngStream::Generator
+RngSeedManager::GetGenerator (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  EnumValue value;
+  g_rngGenerator.GetValue (value);
+  return static_cast<enum RngStream::Generator> (value.Get ());
+}
+
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -2,6 +2,7 @@
 #define RNG_SEED_MANAGER_H
 
 #include <stdint.h>
+#include "rng-stream.h"
 
 namespace ns3 {
 
@@ -62,6 +63,24 @@ public:
 
   static uint64_t GetNextStreamIndex(void);
 
+  /**
+   * \brief Set the generator of the streams created from now on
+   *
+   * \param generator the generator, MRG32k3a by default
+   *
+   * This sets the ns3::GlobalValue \ref GlobalValueRngGenerator
+   * "RngGenerator", whose values are "MRG32k3a" and "Philox".  The
+   * streams of both generators depend in the same way on the seed, the
+   * run number and the stream numbers assigned to random variables,
+   * but they produce different values.
+   */
+  static void SetGenerator (enum RngStream::Generator generator);
+  /**
+   * \returns the current generator
+   * @sa SetGenerator
+   */
+  static enum RngStream::Generator GetGenerator (void);
+
 };
 
 // for compatibility
@@ -47,6 +47,12 @@ const double two17 =      131072.0;
 const double two53 =      9007199254740992.0;
 const double fact =       5.9604644775390625e-8;     /* 1 / 2^24  */
 
+const uint32_t philoxM0 = 0xD2511F53;
+const uint32_t philoxM1 = 0xCD9E8D57;
+const uint32_t philoxW0 = 0x9E3779B9;
+const uint32_t philoxW1 = 0xBB67AE85;
+const double two32inv =   2.3283064365386963e-10;    /* 1 / 2^32  */
+
 const Matrix InvA1 = {          // Inverse of A1p0
   { 184888585.0,   0.0,  1945170933.0 },
   {         1.0,   0.0,           0.0 },
@@ -264,6 +270,15 @@ double RngStream::RandU01 ()
   int32_t k;
   double p1, p2, u;
 
+  if (m_generator == PHILOX)
+    {
+      if (m_blockIndex == 4)
+        {
+          NextBlock ();
+        }
+      return m_block[m_blockIndex++];
+    }
+
   /* Component 1 */
   p1 = a12 * m_currentState[1] - a13n * m_currentState[0];
   k = static_cast<int32_t> (p1 / m1);
@@ -290,7 +305,92 @@ double RngStream::RandU01 ()
   return u;
 }
 
-RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
+void
+RngStream::RandU01 (double *values, uint32_t n)
+{
+  if (m_generator == PHILOX)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (m_blockIndex == 4)
+            {
+              NextBlock ();
+            }
+          values[i] = m_block[m_blockIndex++];
+        }
+      return;
+    }
+
+  // The recurrence is sequential: keep the state in local variables
+  // so that it stays in registers for the whole loop, and let the
+  // two independent components run in parallel.
+  double s0 = m_currentState[0], s1 = m_currentState[1], s2 = m_currentState[2];
+  double s3 = m_currentState[3], s4 = m_currentState[4], s5 = m_currentState[5];
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double p1 = a12 * s1 - a13n * s0;
+      p1 -= static_cast<int32_t> (p1 / m1) * m1;
+      if (p1 < 0.0)
+        {
+          p1 += m1;
+        }
+      s0 = s1; s1 = s2; s2 = p1;
+
+      double p2 = a21 * s5 - a23n * s3;
+      p2 -= static_cast<int32_t> (p2 / m2) * m2;
+      if (p2 < 0.0)
+        {
+          p2 += m2;
+        }
+      s3 = s4; s4 = s5; s5 = p2;
+
+      values[i] = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
+    }
+  m_currentState[0] = s0; m_currentState[1] = s1; m_currentState[2] = s2;
+  m_currentState[3] = s3; m_currentState[4] = s4; m_currentState[5] = s5;
+}
+
+void
+RngStream::Philox (uint32_t counter[4], const uint32_t key[2])
+{
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  for (int round = 0; round < 10; round++)
+    {
+      uint64_t product0 = static_cast<uint64_t> (philoxM0) * counter[0];
+      uint64_t product1 = static_cast<uint64_t> (philoxM1) * counter[2];
+      uint32_t c1 = counter[1];
+      uint32_t c3 = counter[3];
+      counter[0] = static_cast<uint32_t> (product1 >> 32) ^ c1 ^ k0;
+      counter[1] = static_cast<uint32_t> (product1);
+      counter[2] = static_cast<uint32_t> (product0 >> 32) ^ c3 ^ k1;
+      counter[3] = static_cast<uint32_t> (product0);
+      k0 += philoxW0;
+      k1 += philoxW1;
+    }
+}
+
+void
+RngStream::NextBlock (void)
+{
+  uint32_t block[4] = { m_counter[0], m_counter[1], m_counter[2], m_counter[3] };
+  Philox (block, m_key);
+  for (int i = 0; i < 4; i++)
+    {
+      // in (0,1), like MRG32k3a.
+      m_block[i] = (block[i] + 0.5) * two32inv;
+    }
+  m_blockIndex = 0;
+  if (++m_counter[0] == 0)
+    {
+      m_counter[1]++;
+    }
+}
+
+RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream,
+                      enum Generator generator)
+  : m_generator (generator),
+    m_blockIndex (4)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
     {
@@ -300,16 +400,39 @@ RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
     {
       m_currentState[i] = seedNumber;
     }
+  for (int i = 0; i < 4; ++i)
+    {
+      m_block[i] = 0.0;
+    }
+  m_counter[0] = 0;
+  m_counter[1] = 0;
+  m_counter[2] = static_cast<uint32_t> (stream);
+  m_counter[3] = static_cast<uint32_t> (stream >> 32);
+  m_key[0] = seedNumber;
+  m_key[1] = static_cast<uint32_t> (substream) ^ static_cast<uint32_t> (substream >> 32);
+  if (generator == PHILOX)
+    {
+      return;
+    }
   AdvanceNthBy (stream, 127, m_currentState);
   AdvanceNthBy (substream, 76, m_currentState);
 }
 
 RngStream::RngStream(const RngStream& r)
+  : m_generator (r.m_generator),
+    m_blockIndex (r.m_blockIndex)
 {
   for (int i = 0; i < 6; ++i)
     {
       m_currentState[i] = r.m_currentState[i];
     }
+  for (int i = 0; i < 4; ++i)
+    {
+      m_counter[i] = r.m_counter[i];
+      m_block[i] = r.m_block[i];
+    }
+  m_key[0] = r.m_key[0];
+  m_key[1] = r.m_key[1];
 }
 
 void 
@@ -34,22 +34,64 @@ namespace ns3 {
  * holds a static instance of this class.  The details of this
  * class are explained in:
  * http://www.iro.umontreal.ca/~lecuyer/myftp/papers/streams00.pdf
+ *
+ * A stream can instead use the Philox4x32-10 counter-based generator
+ * described in "Parallel random numbers: as easy as 1, 2, 3" (Salmon
+ * et al., SC11).  Its output block is the encryption of a counter made
+ * of the stream number and of the index of the block, with a key made
+ * of the seed and of the substream number, so that streams are
+ * independent by construction and need no jump-ahead.  The substream
+ * number only contributes its 32 low bits xor its 32 high bits to the
+ * key.
  */
 class RngStream
 {
 public:
-  RngStream (uint32_t seed, uint64_t stream, uint64_t substream);
+  /**
+   * The generators an RngStream can use.
+   */
+  enum Generator
+  {
+    MRG32K3A,                   //!< L'Ecuyer's MRG32k3a
+    PHILOX                      //!< Philox4x32-10
+  };
+
+  RngStream (uint32_t seed, uint64_t stream, uint64_t substream,
+             enum Generator generator = MRG32K3A);
   RngStream (const RngStream&);
   /**
    * Generate the next random number for this stream.
    * Uniformly distributed between 0 and 1.
    */
   double RandU01 (void);
+  /**
+   * Generate the next random numbers for this stream: this is
+   * equivalent to, but faster than, n calls to RandU01.
+   *
+   * \param values the array to store the numbers into
+   * \param n the number of values to generate
+   */
+  void RandU01 (double *values, uint32_t n);
+
+  /**
+   * Apply the ten rounds of Philox4x32 to a counter.
+   *
+   * \param counter the counter, replaced by the output block
+   * \param key the key
+   */
+  static void Philox (uint32_t counter[4], const uint32_t key[2]);
 
 private:
   void AdvanceNthBy (uint64_t nth, int by, double state[6]);
+  /** Compute the next Philox output block. */
+  void NextBlock (void);
 
+  enum Generator m_generator;
   double m_currentState[6];
+  uint32_t m_counter[4];        //!< Philox block index and stream
+  uint32_t m_key[2];            //!< Philox seed and substream
+  double m_block[4];            //!< current Philox output block
+  uint32_t m_blockIndex;        //!< next value of m_block
 };
 
 } // namespace ns3
@@ -19,6 +19,7 @@
  */
 
 #include "scheduler.h"
+#include "event-impl.h"
 #include "assert.h"
 #include "log.h"
 
@@ -42,4 +43,27 @@ Scheduler::GetTypeId (void)
   return tid;
 }
 
+void
+Scheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Event> live;
+  while (!IsEmpty ())
+    {
+      Event ev = RemoveNext ();
+      if (ev.impl->IsCancelled ())
+        {
+          removed.push_back (ev);
+        }
+      else
+        {
+          live.push_back (ev);
+        }
+    }
+  for (std::vector<Event>::const_iterator i = live.begin (); i != live.end (); ++i)
+    {
+      Insert (*i);
+    }
+}
+
 } // namespace ns3
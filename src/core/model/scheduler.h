@@ -22,6 +22,7 @@
 #define SCHEDULER_H
 
 #include <stdint.h>
+#include <vector>
 #include "object.h"
 
 namespace ns3 {
@@ -101,6 +102,18 @@ public:
    * This methods cannot be invoked if the list is empty.
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * \param removed the events removed from the event list
+   *
+   * Remove all the cancelled events from the event list, and append
+   * them to \pname{removed}: as with Remove, the caller is responsible
+   * for releasing them.
+   *
+   * The default implementation removes every event and inserts back
+   * those which were not cancelled. Subclasses should override it to
+   * compact their own data structure in place.
+   */
+  virtual void RemoveCancelled (std::vector<Event> &removed);
 };
 
 /* Note the invariants which this function must provide:
@@ -14,4 +14,22 @@ SimulatorImpl::GetTypeId (void)
   return tid;
 }
 
+uint32_t
+SimulatorImpl::GetLiveEventCount (void) const
+{
+  return 0;
+}
+
+uint32_t
+SimulatorImpl::GetCancelledEventCount (void) const
+{
+  return 0;
+}
+
+uint32_t
+SimulatorImpl::GetPeakEventCount (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
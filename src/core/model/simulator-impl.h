@@ -182,6 +182,21 @@ public:
    * \return the current simulation context
    */
   virtual uint32_t GetContext (void) const = 0;
+  /**
+   * \return the number of events in the event list which have not been
+   *         cancelled. The default implementation returns zero.
+   */
+  virtual uint32_t GetLiveEventCount (void) const;
+  /**
+   * \return the number of cancelled events still held in the event list.
+   *         The default implementation returns zero.
+   */
+  virtual uint32_t GetCancelledEventCount (void) const;
+  /**
+   * \return the largest number of events ever held in the event list.
+   *         The default implementation returns zero.
+   */
+  virtual uint32_t GetPeakEventCount (void) const;
 };
 
 } // namespace ns3
@@ -28,15 +28,24 @@
 #include "string.h"
 #include "object-factory.h"
 #include "global-value.h"
+#include "config.h"
+#include "random-variable-stream.h"
 #include "assert.h"
 #include "log.h"
 
 #include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <list>
 #include <vector>
 #include <iostream>
 
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 // Note:  Logging in this file is largely avoided due to the
 // number of calls that are made to these functions and the possibility
 // of causing recursions leading to stack overflow
@@ -74,6 +83,18 @@ NodePrinter (std::ostream &os)
     }
 }
 
+static double
+TimeSource (void)
+{
+  return Simulator::Now ().GetSeconds ();
+}
+
+static uint32_t
+NodeSource (void)
+{
+  return Simulator::GetContext ();
+}
+
 static SimulatorImpl **PeekImpl (void)
 {
   static SimulatorImpl *impl = 0;
@@ -113,6 +134,8 @@ static SimulatorImpl * GetImpl (void)
 //
       LogSetTimePrinter (&TimePrinter);
       LogSetNodePrinter (&NodePrinter);
+      LogSetTimeSource (&TimeSource);
+      LogSetNodeSource (&NodeSource);
     }
   return *pimpl;
 }
@@ -134,9 +157,14 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  LogSetTimeSource (0);
+  LogSetNodeSource (0);
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
+  // the objects matched so far were disposed by the destroy events and
+  // must not be kept alive until the next simulation.
+  Config::InvalidateMatchCache ();
 }
 
 void
@@ -161,6 +189,66 @@ Simulator::Run (void)
   GetImpl ()->Run ();
 }
 
+std::vector<int>
+Simulator::ForkVariants (Time const &time, uint32_t nVariants,
+                         Callback<void, uint32_t> configure,
+                         Callback<int, uint32_t> finish)
+{
+  NS_LOG_FUNCTION (time << nVariants);
+  NS_ASSERT_MSG (time >= Now (), "Cannot fork the simulation in the past");
+  std::vector<int> status (nVariants, -1);
+#ifdef HAVE_SYS_WAIT_H
+  Stop (time - Now ());
+  Run ();
+
+  // the children inherit the output buffers: flush them first so that
+  // they are not written more than once.
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+
+  std::vector<pid_t> children (nVariants, -1);
+  for (uint32_t i = 0; i < nVariants; i++)
+    {
+      pid_t pid = fork ();
+      if (pid == 0)
+        {
+          configure (i);
+          RandomVariableStream::ReseedAll ();
+          Run ();
+          int code = finish.IsNull () ? 0 : finish (i);
+          Destroy ();
+          // do not run the exit handlers and static destructors of the
+          // parent process.
+          std::cout.flush ();
+          std::cerr.flush ();
+          std::fflush (0);
+          _exit (code);
+        }
+      else if (pid < 0)
+        {
+          NS_LOG_WARN ("Cannot fork variant " << i);
+        }
+      children[i] = pid;
+    }
+  for (uint32_t i = 0; i < nVariants; i++)
+    {
+      if (children[i] < 0)
+        {
+          continue;
+        }
+      int wstatus;
+      if (waitpid (children[i], &wstatus, 0) == children[i] && WIFEXITED (wstatus))
+        {
+          status[i] = WEXITSTATUS (wstatus);
+        }
+    }
+#else
+  NS_FATAL_ERROR ("Simulator::ForkVariants is not supported on this system");
+#endif
+  return status;
+}
+
 void 
 Simulator::Stop (void)
 {
@@ -302,6 +390,36 @@ Simulator::GetContext (void)
   return GetImpl ()->GetContext ();
 }
 
+uint64_t
+Simulator::GetEventMemoryInUse (void)
+{
+  return EventImpl::GetLiveMemory ();
+}
+
+uint64_t
+Simulator::GetEventMemoryPeak (void)
+{
+  return EventImpl::GetPeakMemory ();
+}
+
+uint32_t
+Simulator::GetLiveEventCount (void)
+{
+  return GetImpl ()->GetLiveEventCount ();
+}
+
+uint32_t
+Simulator::GetCancelledEventCount (void)
+{
+  return GetImpl ()->GetCancelledEventCount ();
+}
+
+uint32_t
+Simulator::GetPeakEventCount (void)
+{
+  return GetImpl ()->GetPeakEventCount ();
+}
+
 uint32_t
 Simulator::GetSystemId (void)
 {
@@ -341,6 +459,8 @@ Simulator::SetImplementation (Ptr<SimulatorImpl> impl)
 //
   LogSetTimePrinter (&TimePrinter);
   LogSetNodePrinter (&NodePrinter);
+  LogSetTimeSource (&TimeSource);
+  LogSetNodeSource (&NodeSource);
 }
 Ptr<SimulatorImpl>
 Simulator::GetImplementation (void)
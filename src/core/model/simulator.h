@@ -28,9 +28,11 @@
 
 #include "deprecated.h"
 #include "object-factory.h"
+#include "callback.h"
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace ns3 {
 
@@ -116,6 +118,46 @@ public:
    */
   static void Run (void);
 
+  /**
+   * \param time the absolute time at which the simulation is forked
+   * \param nVariants the number of variants of the simulation to run
+   * \param configure invoked in each variant with its index, before the
+   *        simulation is resumed
+   * \param finish invoked in each variant with its index once the
+   *        simulation is over, to return the exit status of the variant
+   * \returns the exit status of each variant, or -1 if a variant was
+   *          killed by a signal or could not be started
+   *
+   * Run the simulation until \pname{time}, then run \pname{nVariants}
+   * variants of the rest of the simulation in parallel, each in a child
+   * process forked from this one, so that they share the warm-up phase
+   * of the simulation.
+   *
+   * In each child process, \pname{configure} is expected to select the
+   * run number of the variant with RngSeedManager::SetRun, and to apply
+   * its parameters with Config::Set. Every RandomVariableStream is then
+   * re-seeded with RandomVariableStream::ReseedAll, the simulation is run
+   * to completion, \pname{finish} is invoked, the simulator is destroyed
+   * and the process exits with the value returned by \pname{finish}, or
+   * with zero if \pname{finish} is null. Only the lowest 8 bits of the
+   * exit status reach the parent. The exit handlers and the destructors
+   * of static objects are not run in the child processes: the results of
+   * each variant should be written and their files closed by
+   * \pname{finish}.
+   *
+   * In the parent process, ForkVariants returns once all the variants
+   * have exited; the simulation is left paused at \pname{time}.
+   *
+   * The standard output streams are flushed before forking, but other
+   * buffered output, such as trace files, is shared with the children
+   * and should be flushed by the caller. The legacy RandomVariable
+   * classes are not re-seeded. This is only supported on systems which
+   * provide fork.
+   */
+  static std::vector<int> ForkVariants (Time const &time, uint32_t nVariants,
+                                        Callback<void, uint32_t> configure,
+                                        Callback<int, uint32_t> finish = MakeNullCallback<int, uint32_t> ());
+
   /**
    * If an event invokes this method, it will be the last
    * event scheduled by the Simulator::run method before
@@ -748,6 +790,45 @@ public:
    */
   static uint32_t GetContext (void);
 
+  /**
+   * \returns the number of bytes currently allocated to pending or
+   *          referenced events, including their bound arguments.
+   *
+   * Event memory is recycled by EventImpl so this reflects the size
+   * of the event pools in use rather than calls to the system allocator.
+   */
+  static uint64_t GetEventMemoryInUse (void);
+
+  /**
+   * \returns the largest value ever returned by GetEventMemoryInUse, or
+   *          an upper bound of it if events were allocated or released
+   *          by several threads.
+   */
+  static uint64_t GetEventMemoryPeak (void);
+
+  /**
+   * \returns the number of pending events which have not been cancelled
+   *          with Simulator::Cancel.
+   *
+   * Simulator implementations which do not keep track of their event
+   * list occupancy return zero from GetLiveEventCount,
+   * GetCancelledEventCount and GetPeakEventCount.
+   */
+  static uint32_t GetLiveEventCount (void);
+
+  /**
+   * \returns the number of events cancelled with Simulator::Cancel which
+   *          are still held by the scheduler, waiting to be purged or to
+   *          expire.
+   */
+  static uint32_t GetCancelledEventCount (void);
+
+  /**
+   * \returns the largest number of events, live or cancelled, ever held
+   *          by the scheduler.
+   */
+  static uint32_t GetPeakEventCount (void);
+
   /**
    * \param time delay until the event expires
    * \param event the event to schedule
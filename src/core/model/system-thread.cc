@@ -29,6 +29,9 @@ namespace ns3 {
 
 #ifdef HAVE_PTHREAD_H
 
+// static initializers run in the thread which loads the library
+static pthread_t g_mainThread = pthread_self ();
+
 SystemThread::SystemThread (Callback<void> callback)
   : m_callback (callback)
 {
@@ -93,6 +96,12 @@ SystemThread::Equals (SystemThread::ThreadId id)
   return (pthread_equal (pthread_self (), id) != 0);
 }
 
+bool
+SystemThread::IsMainThread (void)
+{
+  return (pthread_equal (pthread_self (), g_mainThread) != 0);
+}
+
 #endif /* HAVE_PTHREAD_H */
 
 } // namespace ns3
@@ -142,6 +142,18 @@ public:
    */
   static bool Equals(ThreadId id);
 
+  /**
+   * @brief Checks whether the caller runs in the thread which loaded
+   * the ns-3 libraries, i.e., the thread running main ().
+   *
+   * Process-wide caches which are not thread-safe (e.g., the free lists
+   * of the network module) use this to fall back to the system allocator
+   * when invoked by the threads of a parallel simulator.
+   *
+   * @returns true if called from the main thread.
+   */
+  static bool IsMainThread (void);
+
 private:
 #ifdef HAVE_PTHREAD_H
   static void *DoRun (void *arg);
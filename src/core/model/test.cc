@@ -16,17 +16,29 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include "ns3/core-config.h"
 #include "test.h"
 #include "assert.h"
 #include "abort.h"
 #include "system-path.h"
 #include "log.h"
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <cerrno>
+#include <algorithm>
 #include <vector>
 #include <list>
 #include <map>
 
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 
 namespace ns3 {
 
@@ -114,6 +126,9 @@ private:
   std::list<TestCase *> FilterTests (std::string testName,
                                      enum TestSuite::Type testType,
                                      enum TestCase::TestDuration maximumTestDuration);
+  bool RunParallel (const std::list<TestCase *> &tests, std::ostream *os,
+                    bool xml, uint32_t workers);
+  void PrintTimes (const std::list<TestCase *> &tests, std::ostream *os) const;
 
 
   typedef std::vector<TestSuite *> TestSuiteVector;
@@ -642,6 +657,9 @@ TestRunnerImpl::PrintHelp (const char *program_name) const
             << "output" << std::endl
             << "  --append=FILE          : append test result to FILE instead of standard "
             << "output" << std::endl
+            << "  --parallel=N           : run up to N test suites at the same time, each" << std::endl
+            << "                           in its own process, and print the wall-clock" << std::endl
+            << "                           time of the slowest suites" << std::endl
     ;  
 }
 
@@ -737,6 +755,206 @@ TestRunnerImpl::FilterTests (std::string testName,
 }
 
 
+#ifdef HAVE_SYS_WAIT_H
+/**
+ * A test suite running in a child process.
+ */
+struct TestWorker
+{
+  pid_t pid;
+  int fd;                  //!< read end of the pipe of the child
+  uint32_t index;          //!< index of the suite in the list of tests
+  std::string report;      //!< report read so far
+};
+#endif
+
+bool
+TestRunnerImpl::RunParallel (const std::list<TestCase *> &tests, std::ostream *os,
+                             bool xml, uint32_t workers)
+{
+  NS_LOG_FUNCTION (this << os << xml << workers);
+  bool failed = false;
+#ifdef HAVE_SYS_WAIT_H
+  std::vector<TestCase *> suites (tests.begin (), tests.end ());
+  std::vector<std::string> reports (suites.size ());
+  std::vector<bool> done (suites.size (), false);
+  std::vector<TestWorker> running;
+  uint32_t next = 0;
+  uint32_t printed = 0;
+
+  // the children inherit the output buffers: flush them first so that
+  // they are not written more than once.
+  os->flush ();
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+
+  while (!running.empty () || (next < suites.size () && (m_continueOnFailure || !failed)))
+    {
+      while (running.size () < workers && next < suites.size ()
+             && (m_continueOnFailure || !failed))
+        {
+          uint32_t index = next++;
+          TestCase *test = suites[index];
+          // the wall-clock time of the suite is measured here, including
+          // the start of its process.
+          test->m_result = new TestCase::Result ();
+          test->m_result->clock.Start ();
+          int fds[2];
+          if (pipe (fds) != 0)
+            {
+              NS_FATAL_ERROR ("Cannot create the pipe of test suite " << test->GetName ());
+            }
+          pid_t pid = fork ();
+          if (pid < 0)
+            {
+              NS_FATAL_ERROR ("Cannot fork test suite " << test->GetName ());
+            }
+          if (pid == 0)
+            {
+              // each suite runs in its own process, with its own
+              // simulator and random number generator state.
+              close (fds[0]);
+              delete test->m_result;
+              test->Run (this);
+              std::ostringstream oss;
+              PrintReport (test, &oss, xml, 0);
+              std::string report = oss.str ();
+              std::string::size_type written = 0;
+              while (written < report.size ())
+                {
+                  ssize_t n = write (fds[1], report.data () + written, report.size () - written);
+                  if (n < 0 && errno != EINTR)
+                    {
+                      break;
+                    }
+                  written += n > 0 ? n : 0;
+                }
+              // do not run the exit handlers and static destructors of the
+              // parent process.
+              std::cout.flush ();
+              std::cerr.flush ();
+              std::fflush (0);
+              _exit (test->IsFailed () ? 1 : 0);
+            }
+          // only the child writes to the pipe: the read end sees the end
+          // of file as soon as the child exits.
+          close (fds[1]);
+          TestWorker worker;
+          worker.pid = pid;
+          worker.fd = fds[0];
+          worker.index = index;
+          running.push_back (worker);
+        }
+
+      std::vector<struct pollfd> polled (running.size ());
+      for (uint32_t i = 0; i < running.size (); i++)
+        {
+          polled[i].fd = running[i].fd;
+          polled[i].events = POLLIN;
+          polled[i].revents = 0;
+        }
+      if (poll (&polled[0], polled.size (), -1) < 0)
+        {
+          NS_ASSERT_MSG (errno == EINTR, "poll failed with errno " << errno);
+          continue;
+        }
+      for (uint32_t i = running.size (); i-- > 0; )
+        {
+          if (polled[i].revents == 0)
+            {
+              continue;
+            }
+          TestWorker &worker = running[i];
+          char buffer[4096];
+          ssize_t n = read (worker.fd, buffer, sizeof (buffer));
+          if (n > 0)
+            {
+              worker.report.append (buffer, n);
+              continue;
+            }
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+          close (worker.fd);
+          TestCase *test = suites[worker.index];
+          test->m_result->clock.End ();
+          int status = 0;
+          if (waitpid (worker.pid, &status, 0) == worker.pid
+              && WIFEXITED (status) && WEXITSTATUS (status) <= 1)
+            {
+              reports[worker.index] = worker.report;
+              if (WEXITSTATUS (status) == 1)
+                {
+                  test->m_result->childrenFailed = true;
+                }
+            }
+          else
+            {
+              // the suite crashed before it could report its results:
+              // report the crash in its place.
+              std::ostringstream message;
+              message << "test suite process ";
+              if (WIFSIGNALED (status))
+                {
+                  message << "killed by signal " << WTERMSIG (status);
+                }
+              else
+                {
+                  message << "exited with status " << WEXITSTATUS (status);
+                }
+              test->m_result->failure.push_back (TestCaseFailure ("", "", "", message.str (), "", 0));
+              std::ostringstream oss;
+              PrintReport (test, &oss, xml, 0);
+              reports[worker.index] = oss.str ();
+            }
+          failed = failed || test->IsFailed ();
+          done[worker.index] = true;
+          running.erase (running.begin () + i);
+        }
+
+      // print the reports in the order of the suites.
+      while (printed < suites.size () && done[printed])
+        {
+          *os << reports[printed];
+          reports[printed].clear ();
+          printed++;
+        }
+      os->flush ();
+    }
+#endif
+  return failed;
+}
+
+void
+TestRunnerImpl::PrintTimes (const std::list<TestCase *> &tests, std::ostream *os) const
+{
+  NS_LOG_FUNCTION (this << os);
+  std::vector<std::pair<int64_t, std::string> > times;
+  for (std::list<TestCase *>::const_iterator i = tests.begin (); i != tests.end (); ++i)
+    {
+      if ((*i)->m_result != 0)
+        {
+          times.push_back (std::make_pair ((*i)->m_result->clock.GetElapsedReal (),
+                                           (*i)->GetName ()));
+        }
+    }
+  std::sort (times.rbegin (), times.rend ());
+
+  const double MS_PER_SEC = 1000.;
+  const uint32_t SLOWEST = 10;
+  std::streamsize oldPrecision = (*os).precision (3);
+  *os << std::fixed;
+  *os << "Slowest test suites (wall-clock time):" << std::endl;
+  for (uint32_t i = 0; i < times.size () && i < SLOWEST; i++)
+    {
+      *os << Indent (1) << times[i].first / MS_PER_SEC << " s " << times[i].second << std::endl;
+    }
+  (*os).unsetf(std::ios_base::floatfield);
+  (*os).precision (oldPrecision);
+}
+
 int 
 TestRunnerImpl::Run (int argc, char *argv[])
 {
@@ -751,6 +969,7 @@ TestRunnerImpl::Run (int argc, char *argv[])
   bool printTestTypeList = false;
   bool printTestNameList = false;
   bool printTestTypeAndName = false;
+  uint32_t parallel = 1;
   enum TestCase::TestDuration maximumTestDuration = TestCase::QUICK;
   char *progname = argv[0];
 
@@ -826,6 +1045,10 @@ TestRunnerImpl::Run (int argc, char *argv[])
         {
           out = arg + strlen("--out=");
         }
+      else if (strncmp(arg, "--parallel=", strlen("--parallel=")) == 0)
+        {
+          parallel = std::atoi (arg + strlen("--parallel="));
+        }
       else if (strncmp(arg, "--fullness=", strlen("--fullness=")) == 0)
         {
           fullness = arg + strlen("--fullness=");
@@ -932,20 +1155,39 @@ TestRunnerImpl::Run (int argc, char *argv[])
       os = &std::cout;
     }
 
+#ifndef HAVE_SYS_WAIT_H
+  if (parallel > 1)
+    {
+      std::cerr << "Parallel test execution is not supported on this system" << std::endl;
+      parallel = 1;
+    }
+#endif
+
   // let's run our tests now.
   bool failed = false;
-  for (std::list<TestCase *>::const_iterator i = tests.begin (); i != tests.end (); ++i)
+  if (parallel > 1)
     {
-      TestCase *test = *i;
-
-      test->Run (this);
-      PrintReport (test, os, xml, 0);
-      if (test->IsFailed ())
+      failed = RunParallel (tests, os, xml, parallel);
+      if (!xml)
         {
-          failed = true;
-          if (!m_continueOnFailure)
+          PrintTimes (tests, os);
+        }
+    }
+  else
+    {
+      for (std::list<TestCase *>::const_iterator i = tests.begin (); i != tests.end (); ++i)
+        {
+          TestCase *test = *i;
+
+          test->Run (this);
+          PrintReport (test, os, xml, 0);
+          if (test->IsFailed ())
             {
-              return 1;
+              failed = true;
+              if (!m_continueOnFailure)
+                {
+                  return 1;
+                }
             }
         }
     }
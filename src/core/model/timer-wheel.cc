@@ -0,0 +1,423 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "timer-wheel.h"
+#include "simulator.h"
+#include "simulation-singleton.h"
+#include "make-event.h"
+#include "global-value.h"
+#include "assert.h"
+#include "log.h"
+#include <map>
+
+NS_LOG_COMPONENT_DEFINE ("TimerWheel");
+
+namespace ns3 {
+
+static GlobalValue g_timerWheelResolution ("TimerWheelResolution",
+                                           "The duration of a tick of the timer wheel: "
+                                           "timers are scheduled in the simulator during "
+                                           "the tick in which they expire.",
+                                           TimeValue (MilliSeconds (1)),
+                                           MakeTimeChecker ());
+
+typedef std::map<uint16_t, TimerWheel::Statistics> StatisticsMap;
+
+static StatisticsMap *
+GetStatisticsMap (void)
+{
+  static StatisticsMap statistics;
+  return &statistics;
+}
+
+TimerWheel::Entry::Entry (TypeId owner)
+  : m_prev (0),
+    m_next (0),
+    m_wheel (0),
+    m_ts (0),
+    m_context (0),
+    m_state (IDLE),
+    m_level (0),
+    m_slot (0),
+    m_event (0),
+    m_fire (0),
+    m_stats (TimerWheel::LookupStatistics (owner))
+{
+  NS_LOG_FUNCTION (this << owner);
+}
+
+TimerWheel::Entry::~Entry ()
+{
+  NS_LOG_FUNCTION (this);
+  Cancel ();
+}
+
+void
+TimerWheel::Entry::Arm (const Time &delay, const Ptr<EventImpl> &event)
+{
+  NS_LOG_FUNCTION (this << delay << event);
+  NS_ASSERT (delay.IsPositive ());
+  Cancel ();
+  m_stats->armed++;
+  m_ts = Simulator::Now ().GetTimeStep () + delay.GetTimeStep ();
+  m_context = Simulator::GetContext ();
+  m_event = event;
+  SimulationSingleton<TimerWheel>::Get ()->Insert (this);
+}
+
+void
+TimerWheel::Entry::Cancel (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_state == IDLE)
+    {
+      return;
+    }
+  m_stats->cancelled++;
+  m_wheel->Unlink (this);
+  m_event = 0;
+}
+
+bool
+TimerWheel::Entry::IsRunning (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_state != IDLE;
+}
+
+Time
+TimerWheel::Entry::GetDelayLeft (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_state == IDLE)
+    {
+      return TimeStep (0);
+    }
+  return TimeStep (m_ts - Simulator::Now ().GetTimeStep ());
+}
+
+TimerWheel::TimerWheel ()
+  : m_resolution (1),
+    m_tick (0),
+    m_wakeupTick (-1),
+    m_count (0),
+    m_scheduled (0)
+{
+  NS_LOG_FUNCTION (this);
+  TimeValue resolution = TimeValue (MilliSeconds (1));
+  GlobalValue::GetValueByNameFailSafe ("TimerWheelResolution", resolution);
+  m_resolution = std::max (resolution.Get ().GetTimeStep (), (int64_t)1);
+  m_tick = Simulator::Now ().GetTimeStep () / m_resolution;
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      m_occupied[level] = 0;
+      for (uint32_t slot = 0; slot < SLOTS; slot++)
+        {
+          m_slots[level][slot] = 0;
+        }
+    }
+}
+
+TimerWheel::~TimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+  // the entries outlive the simulation: leave them idle
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      for (uint32_t slot = 0; slot < SLOTS; slot++)
+        {
+          while (m_slots[level][slot] != 0)
+            {
+              Unlink (m_slots[level][slot]);
+            }
+        }
+    }
+  while (m_scheduled != 0)
+    {
+      Unlink (m_scheduled);
+    }
+}
+
+void
+TimerWheel::Insert (Entry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  if (m_count == 0 && m_wakeupTick == -1)
+    {
+      // the wheel is idle: catch up with the current time
+      m_tick = std::max (m_tick, Simulator::Now ().GetTimeStep () / m_resolution);
+    }
+  int64_t tick = entry->m_ts / m_resolution;
+  if (tick <= m_tick)
+    {
+      Schedule (entry);
+      return;
+    }
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      uint32_t shift = SLOT_BITS * (level + 1);
+      if ((tick >> shift) != (m_tick >> shift))
+        {
+          continue;
+        }
+      uint32_t slot = (tick >> (SLOT_BITS * level)) & SLOT_MASK;
+      entry->m_wheel = this;
+      entry->m_state = Entry::IN_WHEEL;
+      entry->m_level = level;
+      entry->m_slot = slot;
+      entry->m_prev = 0;
+      entry->m_next = m_slots[level][slot];
+      if (entry->m_next != 0)
+        {
+          entry->m_next->m_prev = entry;
+        }
+      m_slots[level][slot] = entry;
+      m_occupied[level] |= ((uint64_t)1) << slot;
+      m_count++;
+      if (m_wakeupTick == -1 || tick < m_wakeupTick)
+        {
+          ScheduleWakeup ();
+        }
+      return;
+    }
+  // beyond the range of the wheel
+  Schedule (entry);
+}
+
+void
+TimerWheel::Unlink (Entry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  if (entry->m_next != 0)
+    {
+      entry->m_next->m_prev = entry->m_prev;
+    }
+  if (entry->m_state == Entry::IN_WHEEL)
+    {
+      if (entry->m_prev != 0)
+        {
+          entry->m_prev->m_next = entry->m_next;
+        }
+      else
+        {
+          m_slots[entry->m_level][entry->m_slot] = entry->m_next;
+          if (entry->m_next == 0)
+            {
+              m_occupied[entry->m_level] &= ~(((uint64_t)1) << entry->m_slot);
+            }
+        }
+      m_count--;
+    }
+  else
+    {
+      NS_ASSERT (entry->m_state == Entry::SCHEDULED);
+      if (entry->m_prev != 0)
+        {
+          entry->m_prev->m_next = entry->m_next;
+        }
+      else
+        {
+          m_scheduled = entry->m_next;
+        }
+      entry->m_fire->Cancel ();
+      entry->m_fire = 0;
+    }
+  entry->m_prev = 0;
+  entry->m_next = 0;
+  entry->m_wheel = 0;
+  entry->m_state = Entry::IDLE;
+}
+
+void
+TimerWheel::Schedule (Entry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  entry->m_stats->scheduled++;
+  entry->m_wheel = this;
+  entry->m_state = Entry::SCHEDULED;
+  entry->m_prev = 0;
+  entry->m_next = m_scheduled;
+  if (entry->m_next != 0)
+    {
+      entry->m_next->m_prev = entry;
+    }
+  m_scheduled = entry;
+  entry->m_fire = Ptr<EventImpl> (MakeEvent (&TimerWheel::Fire, entry), false);
+  Time delay = TimeStep (entry->m_ts - Simulator::Now ().GetTimeStep ());
+  Simulator::ScheduleWithContext (entry->m_context, delay, GetPointer (entry->m_fire));
+}
+
+void
+TimerWheel::Cascade (uint32_t level, uint32_t slot)
+{
+  NS_LOG_FUNCTION (this << level << slot);
+  while (m_slots[level][slot] != 0)
+    {
+      Entry *entry = m_slots[level][slot];
+      Unlink (entry);
+      Insert (entry);
+    }
+}
+
+int64_t
+TimerWheel::GetNextTick (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // the slots of a level which hold timers all follow the slot of the
+  // current tick, and come before the next slot of the level above.
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      uint32_t shift = SLOT_BITS * level;
+      uint32_t current = (m_tick >> shift) & SLOT_MASK;
+      uint64_t pending = m_occupied[level] & ~((((uint64_t)2) << current) - 1);
+      if (pending == 0)
+        {
+          continue;
+        }
+      uint32_t slot = current + 1;
+      while ((pending & (((uint64_t)1) << slot)) == 0)
+        {
+          slot++;
+        }
+      int64_t block = (m_tick >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+      return block | (((int64_t)slot) << shift);
+    }
+  return -1;
+}
+
+void
+TimerWheel::ScheduleWakeup (void)
+{
+  NS_LOG_FUNCTION (this);
+  int64_t tick = GetNextTick ();
+  if (tick == m_wakeupTick)
+    {
+      return;
+    }
+  m_wakeup.Cancel ();
+  m_wakeupTick = tick;
+  if (tick == -1)
+    {
+      return;
+    }
+  int64_t delay = std::max (tick * m_resolution - Simulator::Now ().GetTimeStep (), (int64_t)0);
+  m_wakeup = Simulator::Schedule (TimeStep (delay), &TimerWheel::Wakeup, this);
+}
+
+void
+TimerWheel::Wakeup (void)
+{
+  NS_LOG_FUNCTION (this);
+  // m_wakeupTick is kept until the end so that the timers inserted
+  // below do not schedule another wakeup each
+  int64_t tick = m_wakeupTick;
+  NS_ASSERT (tick > m_tick);
+  m_tick = tick;
+  // cascade the slots which start at this tick, from the highest level
+  for (uint32_t level = LEVELS - 1; level > 0; level--)
+    {
+      uint32_t shift = SLOT_BITS * level;
+      if ((tick & ((((int64_t)1) << shift) - 1)) == 0)
+        {
+          Cascade (level, (tick >> shift) & SLOT_MASK);
+        }
+    }
+  // and schedule the timers which expire during this tick
+  uint32_t slot = tick & SLOT_MASK;
+  while (m_slots[0][slot] != 0)
+    {
+      Entry *entry = m_slots[0][slot];
+      Unlink (entry);
+      Schedule (entry);
+    }
+  m_wakeupTick = -1;
+  ScheduleWakeup ();
+}
+
+void
+TimerWheel::Fire (Entry *entry)
+{
+  NS_LOG_FUNCTION (entry);
+  NS_ASSERT (entry->m_state == Entry::SCHEDULED);
+  Ptr<EventImpl> event = entry->m_event;
+  entry->m_stats->fired++;
+  entry->m_event = 0;
+  // keep the simulator event alive while unlinking the entry
+  Ptr<EventImpl> fire = entry->m_fire;
+  if (entry->m_next != 0)
+    {
+      entry->m_next->m_prev = entry->m_prev;
+    }
+  if (entry->m_prev != 0)
+    {
+      entry->m_prev->m_next = entry->m_next;
+    }
+  else
+    {
+      entry->m_wheel->m_scheduled = entry->m_next;
+    }
+  entry->m_prev = 0;
+  entry->m_next = 0;
+  entry->m_wheel = 0;
+  entry->m_fire = 0;
+  entry->m_state = Entry::IDLE;
+  event->Invoke ();
+}
+
+TimerWheel::Statistics *
+TimerWheel::LookupStatistics (TypeId owner)
+{
+  NS_LOG_FUNCTION (owner);
+  StatisticsMap *map = GetStatisticsMap ();
+  StatisticsMap::iterator i = map->find (owner.GetUid ());
+  if (i == map->end ())
+    {
+      Statistics stats;
+      stats.armed = 0;
+      stats.cancelled = 0;
+      stats.scheduled = 0;
+      stats.fired = 0;
+      i = map->insert (std::make_pair (owner.GetUid (), stats)).first;
+    }
+  return &i->second;
+}
+
+TimerWheel::Statistics
+TimerWheel::GetStatistics (TypeId owner)
+{
+  NS_LOG_FUNCTION (owner);
+  return *LookupStatistics (owner);
+}
+
+void
+TimerWheel::PrintStatistics (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  StatisticsMap *map = GetStatisticsMap ();
+  for (StatisticsMap::const_iterator i = map->begin (); i != map->end (); ++i)
+    {
+      TypeId tid;
+      tid.SetUid (i->first);
+      os << tid.GetName ()
+         << " armed=" << i->second.armed
+         << " cancelled=" << i->second.cancelled
+         << " scheduled=" << i->second.scheduled
+         << " fired=" << i->second.fired
+         << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "nstime.h"
+#include "event-id.h"
+#include "event-impl.h"
+#include "type-id.h"
+#include "ptr.h"
+#include <stdint.h>
+#include <ostream>
+
+namespace ns3 {
+
+template <typename T>
+class SimulationSingleton;
+
+/**
+ * \ingroup core
+ * \brief a hierarchical timing wheel for protocol timers
+ *
+ * Protocol timers (retransmission, expiry and timeout timers) are
+ * re-armed or cancelled much more often than they expire. Scheduling
+ * each of them in the simulator leaves a dead event in the Scheduler for
+ * every cancellation. The timers held by a TimerWheel::Entry are instead
+ * kept in the wheel, where arming, re-arming and cancelling a timer are
+ * O(1), and only reach the Scheduler when they are about to expire.
+ *
+ * The wheel counts time in ticks of the TimerWheelResolution global
+ * value (1ms by default) and is made of four levels of 64 slots. A timer
+ * which expires in the same block of 64 ticks as the current tick is
+ * stored in the slot of its tick on the first level; otherwise, it is
+ * stored on the lowest level whose block contains both ticks, and is
+ * cascaded to the lower levels when the wheel reaches the start of its
+ * slot. When the wheel reaches the tick of a timer, the timer is
+ * scheduled in the simulator, in the context it was armed from, at its
+ * exact expiration time. Timers which expire later than 2^24 ticks are
+ * scheduled in the simulator directly.
+ *
+ * The wheel itself only schedules a simulator event at the start of the
+ * next slot which holds timers. Cancelled timers are unlinked from their
+ * slot without touching the wheel event: if it finds no timer left to
+ * process, it simply schedules the next one. The wheel event is only
+ * cancelled, and scheduled again, when a timer is inserted in a slot
+ * which starts before it.
+ *
+ * The wheel is deleted by Simulator::Destroy, and is not thread-safe: it
+ * must only be used from the simulation thread.
+ */
+class TimerWheel
+{
+public:
+  /**
+   * Counters of the timers of an owner type.
+   */
+  struct Statistics
+  {
+    uint64_t armed;       //!< number of times a timer was armed
+    uint64_t cancelled;   //!< number of running timers cancelled or re-armed
+    uint64_t scheduled;   //!< number of timers scheduled in the simulator
+    uint64_t fired;       //!< number of timers which expired
+  };
+
+  /**
+   * \brief a timer held by the TimerWheel
+   *
+   * An Entry is owned by the object which uses the timer, typically as
+   * a member in place of an EventId, and can be armed and cancelled any
+   * number of times. Destroying a running Entry cancels it.
+   */
+  class Entry
+  {
+public:
+    /**
+     * \param owner the type of the object which owns this timer, under
+     *        which its arming, cancellation and expiration are counted.
+     */
+    Entry (TypeId owner);
+    ~Entry ();
+
+    /**
+     * \param delay the delay after which this timer expires.
+     * \param event the event to invoke when this timer expires.
+     *
+     * Arm this timer, after cancelling it if it is running. The event
+     * is held until the timer expires, and can be re-used to re-arm
+     * the timer.
+     */
+    void Arm (const Time &delay, const Ptr<EventImpl> &event);
+    /**
+     * Cancel this timer if it is running. Do nothing otherwise.
+     */
+    void Cancel (void);
+    /**
+     * \returns true if this timer is armed and has not yet expired nor
+     *          been cancelled, false otherwise.
+     */
+    bool IsRunning (void) const;
+    /**
+     * \returns the amount of time left until this timer expires, or zero
+     *          if it is not running.
+     */
+    Time GetDelayLeft (void) const;
+
+private:
+    friend class TimerWheel;
+
+    Entry (const Entry &o);
+    Entry &operator = (const Entry &o);
+
+    enum State
+    {
+      IDLE,
+      IN_WHEEL,
+      SCHEDULED
+    };
+
+    // previous and next entries of the slot, or of the scheduled list
+    Entry *m_prev;
+    Entry *m_next;
+    // the wheel which holds this entry when it is not idle
+    TimerWheel *m_wheel;
+    // expiration timestamp
+    int64_t m_ts;
+    uint32_t m_context;
+    enum State m_state;
+    uint8_t m_level;
+    uint8_t m_slot;
+    Ptr<EventImpl> m_event;
+    // the simulator event which invokes m_event when scheduled
+    Ptr<EventImpl> m_fire;
+    Statistics *m_stats;
+  };
+
+  /**
+   * \param owner the type of the objects which own the timers
+   * \returns the counters of the timers of \pname{owner}, accumulated
+   *          since the start of the program.
+   */
+  static Statistics GetStatistics (TypeId owner);
+  /**
+   * \param os the stream to print to
+   *
+   * Print the counters of the timers of every owner type, one per line.
+   */
+  static void PrintStatistics (std::ostream &os);
+
+private:
+  friend class SimulationSingleton<TimerWheel>;
+
+  enum
+  {
+    LEVELS = 4,
+    SLOT_BITS = 6,
+    SLOTS = 1 << SLOT_BITS,
+    SLOT_MASK = SLOTS - 1
+  };
+
+  TimerWheel ();
+  ~TimerWheel ();
+
+  void Insert (Entry *entry);
+  void Unlink (Entry *entry);
+  void Schedule (Entry *entry);
+  void Cascade (uint32_t level, uint32_t slot);
+  int64_t GetNextTick (void) const;
+  void ScheduleWakeup (void);
+  void Wakeup (void);
+  static void Fire (Entry *entry);
+  static Statistics *LookupStatistics (TypeId owner);
+
+  // duration of a tick, in time steps
+  int64_t m_resolution;
+  // last tick processed: timers up to this tick are scheduled
+  int64_t m_tick;
+  // tick of the pending wakeup event, or -1
+  int64_t m_wakeupTick;
+  EventId m_wakeup;
+  uint32_t m_count;
+  // one bit per non-empty slot, for each level
+  uint64_t m_occupied[LEVELS];
+  Entry *m_slots[LEVELS][SLOTS];
+  // entries scheduled in the simulator
+  Entry *m_scheduled;
+};
+
+} // namespace ns3
+
+#endif /* TIMER_WHEEL_H */
@@ -20,6 +20,7 @@
 #include "timer.h"
 #include "simulator.h"
 #include "simulation-singleton.h"
+#include "make-event.h"
 #include "log.h"
 
 NS_LOG_COMPONENT_DEFINE ("Timer");
@@ -30,7 +31,8 @@ Timer::Timer ()
   : m_flags (CHECK_ON_DESTROY),
     m_delay (FemtoSeconds (0)),
     m_event (),
-    m_impl (0)
+    m_impl (0),
+    m_wheel (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -39,7 +41,8 @@ Timer::Timer (enum DestroyPolicy destroyPolicy)
   : m_flags (destroyPolicy),
     m_delay (FemtoSeconds (0)),
     m_event (),
-    m_impl (0)
+    m_impl (0),
+    m_wheel (0)
 {
   NS_LOG_FUNCTION (this << destroyPolicy);
 }
@@ -47,7 +50,15 @@ Timer::Timer (enum DestroyPolicy destroyPolicy)
 Timer::~Timer ()
 {
   NS_LOG_FUNCTION (this);
-  if (m_flags & CHECK_ON_DESTROY)
+  if (m_wheel != 0)
+    {
+      if ((m_flags & CHECK_ON_DESTROY) && m_wheel->IsRunning ())
+        {
+          NS_FATAL_ERROR ("Event is still running while destroying.");
+        }
+      delete m_wheel;
+    }
+  else if (m_flags & CHECK_ON_DESTROY)
     {
       if (m_event.IsRunning ())
         {
@@ -71,6 +82,15 @@ Timer::SetDelay (const Time &time)
   NS_LOG_FUNCTION (this << time);
   m_delay = time;
 }
+void
+Timer::UseWheel (TypeId owner)
+{
+  NS_LOG_FUNCTION (this << owner);
+  NS_ASSERT (!IsRunning () && !IsSuspended ());
+  delete m_wheel;
+  m_wheel = new TimerWheel::Entry (owner);
+  m_wheelEvent = Ptr<EventImpl> (MakeEvent (&Timer::Expire, this), false);
+}
 Time
 Timer::GetDelay (void) const
 {
@@ -84,6 +104,10 @@ Timer::GetDelayLeft (void) const
   switch (GetState ())
     {
     case Timer::RUNNING:
+      if (m_wheel != 0)
+        {
+          return m_wheel->GetDelayLeft ();
+        }
       return Simulator::GetDelayLeft (m_event);
       break;
     case Timer::EXPIRED:
@@ -103,24 +127,42 @@ void
 Timer::Cancel (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      m_wheel->Cancel ();
+      return;
+    }
   Simulator::Cancel (m_event);
 }
 void
 Timer::Remove (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      m_wheel->Cancel ();
+      return;
+    }
   Simulator::Remove (m_event);
 }
 bool
 Timer::IsExpired (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      return !IsSuspended () && !m_wheel->IsRunning ();
+    }
   return !IsSuspended () && m_event.IsExpired ();
 }
 bool
 Timer::IsRunning (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      return !IsSuspended () && m_wheel->IsRunning ();
+    }
   return !IsSuspended () && m_event.IsRunning ();
 }
 bool
@@ -160,11 +202,11 @@ Timer::Schedule (Time delay)
 {
   NS_LOG_FUNCTION (this << delay);
   NS_ASSERT (m_impl != 0);
-  if (m_event.IsRunning ())
+  if (IsRunning ())
     {
       NS_FATAL_ERROR ("Event is still running while re-scheduling.");
     }
-  m_event = m_impl->Schedule (delay);
+  DoSchedule (delay);
 }
 
 void
@@ -172,8 +214,8 @@ Timer::Suspend (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (IsRunning ());
-  m_delayLeft = Simulator::GetDelayLeft (m_event);
-  Simulator::Remove (m_event);
+  m_delayLeft = GetDelayLeft ();
+  Remove ();
   m_flags |= TIMER_SUSPENDED;
 }
 
@@ -182,10 +224,31 @@ Timer::Resume (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_flags & TIMER_SUSPENDED);
-  m_event = m_impl->Schedule (m_delayLeft);
+  DoSchedule (m_delayLeft);
   m_flags &= ~TIMER_SUSPENDED;
 }
 
+void
+Timer::DoSchedule (const Time &delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  if (m_wheel != 0)
+    {
+      m_wheel->Arm (delay, m_wheelEvent);
+    }
+  else
+    {
+      m_event = m_impl->Schedule (delay);
+    }
+}
+
+void
+Timer::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_impl->Invoke ();
+}
+
 
 } // namespace ns3
 
@@ -24,6 +24,7 @@
 #include "nstime.h"
 #include "event-id.h"
 #include "int-to-type.h"
+#include "timer-wheel.h"
 
 namespace ns3 {
 
@@ -41,6 +42,10 @@ class TimerImpl;
  * A timer can also be used to enforce a set of predefined event lifetime
  * management policies. These policies are specified at construction time
  * and cannot be changed after.
+ *
+ * Timers which are cancelled or re-scheduled much more often than they
+ * expire can hold their events in the TimerWheel rather than in the
+ * simulator event list, see Timer::UseWheel.
  */
 class Timer
 {
@@ -166,6 +171,14 @@ public:
    * The next call to Schedule will schedule the timer with this delay.
    */
   void SetDelay (const Time &delay);
+  /**
+   * \param owner the type of the object which owns this timer
+   *
+   * Hold the events of this timer in the TimerWheel rather than in the
+   * simulator event list, and count them in the TimerWheel::Statistics
+   * of \pname{owner}. This must be called while the timer is not running.
+   */
+  void UseWheel (TypeId owner);
   /**
    * \returns the currently-configured delay for the next Schedule.
    */
@@ -235,11 +248,25 @@ private:
     TIMER_SUSPENDED = (1 << 7)
   };
 
+  /**
+   * Invoke the function of this timer when it expires from the wheel.
+   */
+  void Expire (void);
+  /**
+   * \param delay the delay to use
+   *
+   * Schedule the event of this timer in the simulator or in the wheel.
+   */
+  void DoSchedule (const Time &delay);
+
   int m_flags;
   Time m_delay;
   EventId m_event;
   TimerImpl *m_impl;
   Time m_delayLeft;
+  // the wheel entry of this timer, if it uses the wheel
+  TimerWheel::Entry *m_wheel;
+  Ptr<EventImpl> m_wheelEvent;
 };
 
 } // namespace ns3
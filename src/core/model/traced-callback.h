@@ -21,8 +21,12 @@
 #ifndef TRACED_CALLBACK_H
 #define TRACED_CALLBACK_H
 
-#include <list>
+#include <vector>
+#include "ns3/core-config.h"
 #include "callback.h"
+#ifdef NS3_OPTIONAL_TRACES_DISABLE
+#include "fatal-error.h"
+#endif /* NS3_OPTIONAL_TRACES_DISABLE */
 
 namespace ns3 {
 
@@ -35,6 +39,9 @@ namespace ns3 {
  * it forwards calls to a chain of ns3::Callback. TracedCallback::Connect adds a ns3::Callback
  * at the end of the chain of callbacks. TracedCallback::Disconnect removes a ns3::Callback from
  * the chain of callbacks.
+ *
+ * The chain is stored in a contiguous array, so invoking a TracedCallback
+ * which has no sink connected costs a single test.
  */
 template<typename T1 = empty, typename T2 = empty, 
          typename T3 = empty, typename T4 = empty,
@@ -89,7 +96,7 @@ public:
   void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const;
 
 private:
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+  typedef std::vector<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
   CallbackList m_callbackList;
 };
 
@@ -116,6 +123,8 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::ConnectWithoutContext (const CallbackBa
 {
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> cb;
   cb.Assign (callback);
+  // the sinks are copied whenever they are invoked
+  cb.MoveImplToHeap ();
   m_callbackList.push_back (cb);
 }
 template<typename T1, typename T2,
@@ -128,6 +137,7 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Connect (const CallbackBase & callback,
   Callback<void,std::string,T1,T2,T3,T4,T5,T6,T7,T8> cb;
   cb.Assign (callback);
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
+  realCb.MoveImplToHeap ();
   m_callbackList.push_back (realCb);
 }
 template<typename T1, typename T2, 
@@ -137,18 +147,16 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DisconnectWithoutContext (const CallbackBase & callback)
 {
-  for (typename CallbackList::iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); /* empty */)
+  typename CallbackList::size_type j = 0;
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      if ((*i).IsEqual (callback))
-        {
-          i = m_callbackList.erase (i);
-        }
-      else
+      if (!m_callbackList[i].IsEqual (callback))
         {
-          i++;
+          m_callbackList[j] = m_callbackList[i];
+          j++;
         }
     }
+  m_callbackList.resize (j);
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -169,10 +177,13 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // sinks may connect or disconnect sinks, which reallocates or
+  // compacts the array: do not keep an iterator across their invocation,
+  // and invoke a copy of each sink, which keeps its heap pimpl alive.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)();
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink ();
     }
 }
 template<typename T1, typename T2, 
@@ -182,10 +193,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1);
     }
 }
 template<typename T1, typename T2, 
@@ -195,10 +206,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1, a2);
     }
 }
 template<typename T1, typename T2, 
@@ -208,10 +219,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1, a2, a3);
     }
 }
 template<typename T1, typename T2, 
@@ -221,10 +232,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1, a2, a3, a4);
     }
 }
 template<typename T1, typename T2, 
@@ -234,10 +245,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1, a2, a3, a4, a5);
     }
 }
 template<typename T1, typename T2, 
@@ -247,10 +258,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1, a2, a3, a4, a5, a6);
     }
 }
 template<typename T1, typename T2, 
@@ -260,10 +271,10 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1, a2, a3, a4, a5, a6, a7);
     }
 }
 template<typename T1, typename T2, 
@@ -273,13 +284,63 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      typename CallbackList::value_type sink = m_callbackList[i];
+      sink (a1, a2, a3, a4, a5, a6, a7, a8);
     }
 }
 
+/**
+ * \brief a TracedCallback which can be compiled out
+ * \ingroup tracing
+ *
+ * An ns3::OptionalTracedCallback is an ns3::TracedCallback, except in the
+ * builds configured with --disable-optional-traces: there, invoking it
+ * costs nothing and connecting a sink to it is a fatal error, so that
+ * no sink silently misses its events. It is meant for the trace sources
+ * which sit on per-packet paths and are seldom connected in long
+ * simulations; trace sources used by helpers or other models, such as
+ * the drop traces, must remain TracedCallbacks.
+ */
+#ifndef NS3_OPTIONAL_TRACES_DISABLE
+template<typename T1 = empty, typename T2 = empty, 
+         typename T3 = empty, typename T4 = empty,
+         typename T5 = empty, typename T6 = empty,
+         typename T7 = empty, typename T8 = empty>
+class OptionalTracedCallback : public TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>
+{
+};
+#else /* NS3_OPTIONAL_TRACES_DISABLE */
+template<typename T1 = empty, typename T2 = empty, 
+         typename T3 = empty, typename T4 = empty,
+         typename T5 = empty, typename T6 = empty,
+         typename T7 = empty, typename T8 = empty>
+class OptionalTracedCallback
+{
+public:
+  void ConnectWithoutContext (const CallbackBase & callback)
+  {
+    NS_FATAL_ERROR ("Optional trace source disabled by --disable-optional-traces");
+  }
+  void Connect (const CallbackBase & callback, std::string path)
+  {
+    NS_FATAL_ERROR ("Optional trace source " << path << " disabled by --disable-optional-traces");
+  }
+  void DisconnectWithoutContext (const CallbackBase & callback) {}
+  void Disconnect (const CallbackBase & callback, std::string path) {}
+  void operator() (void) const {}
+  void operator() (T1 a1) const {}
+  void operator() (T1 a1, T2 a2) const {}
+  void operator() (T1 a1, T2 a2, T3 a3) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const {}
+};
+#endif /* NS3_OPTIONAL_TRACES_DISABLE */
+
 } // namespace ns3
 
 #endif /* TRACED_CALLBACK_H */
@@ -27,6 +27,7 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 /*********************************************************************
  *         Helper code
@@ -39,11 +40,146 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
 // IidManager needs to be in ns3 namespace for NS_ASSERT and NS_LOG
 // to find g_log
 
+namespace {
+
+/**
+ * \brief An open-addressing hash table from names to integers.
+ *
+ * The slots store a copy of each name together with its hash, and
+ * collisions are resolved by linear probing.  The table is doubled
+ * whenever it becomes half full, so probe sequences stay short.
+ * Names are never removed.
+ */
+class NameIndex
+{
+public:
+  NameIndex ();
+  /**
+   * \param name the name to insert
+   * \param value the value associated to the name
+   *
+   * If the name is already in the table, the table is not modified:
+   * the first value inserted for a name wins.
+   */
+  void Insert (const std::string &name, uint32_t value);
+  /**
+   * \param name the name to look up
+   * \param value where the value associated to the name is stored
+   * \returns true if the name is in the table, false otherwise.
+   */
+  bool Find (const std::string &name, uint32_t *value) const;
+private:
+  struct Slot {
+    std::string name;
+    uint32_t hash;
+    uint32_t value;
+    bool used;
+  };
+  static uint32_t Hash (const std::string &name);
+  void DoInsert (const std::string &name, uint32_t hash, uint32_t value);
+  std::vector<struct Slot> m_slots;
+  uint32_t m_n;
+};
+
+NameIndex::NameIndex ()
+  : m_n (0)
+{
+}
+
+uint32_t
+NameIndex::Hash (const std::string &name)
+{
+  // 32-bit FNV-1a: much cheaper than the Hasher for short names.
+  uint32_t hash = 2166136261U;
+  for (std::string::size_type i = 0; i < name.size (); i++)
+    {
+      hash ^= static_cast<uint8_t> (name[i]);
+      hash *= 16777619U;
+    }
+  return hash;
+}
+
+void
+NameIndex::DoInsert (const std::string &name, uint32_t hash, uint32_t value)
+{
+  uint32_t mask = m_slots.size () - 1;
+  for (uint32_t i = hash & mask; ; i = (i + 1) & mask)
+    {
+      struct Slot &slot = m_slots[i];
+      if (!slot.used)
+        {
+          slot.name = name;
+          slot.hash = hash;
+          slot.value = value;
+          slot.used = true;
+          m_n++;
+          return;
+        }
+      if (slot.hash == hash && slot.name == name)
+        {
+          return;
+        }
+    }
+}
+
+void
+NameIndex::Insert (const std::string &name, uint32_t value)
+{
+  if (2 * (m_n + 1) > m_slots.size ())
+    {
+      struct Slot empty;
+      empty.hash = 0;
+      empty.value = 0;
+      empty.used = false;
+      std::vector<struct Slot> slots (std::max<std::size_t> (16, 2 * m_slots.size ()), empty);
+      slots.swap (m_slots);
+      m_n = 0;
+      for (std::vector<struct Slot>::const_iterator i = slots.begin (); i != slots.end (); ++i)
+        {
+          if (i->used)
+            {
+              DoInsert (i->name, i->hash, i->value);
+            }
+        }
+    }
+  DoInsert (name, Hash (name), value);
+}
+
+bool
+NameIndex::Find (const std::string &name, uint32_t *value) const
+{
+  if (m_n == 0)
+    {
+      return false;
+    }
+  uint32_t hash = Hash (name);
+  uint32_t mask = m_slots.size () - 1;
+  for (uint32_t i = hash & mask; m_slots[i].used; i = (i + 1) & mask)
+    {
+      const struct Slot &slot = m_slots[i];
+      if (slot.hash == hash && slot.name == name)
+        {
+          *value = slot.value;
+          return true;
+        }
+    }
+  return false;
+}
+
+} // anonymous namespace
+
 /**
  * \brief TypeId information manager
  *
- * Information records are stored in a vector.  Name and hash lookup
- * are performed by maps to the vector index.
+ * Information records are stored in a vector.  Name lookup is performed
+ * by a NameIndex, and hash lookup by a map, to the vector index.
+ *
+ * Each record also holds the flattened attributes and trace sources of
+ * its type, that is, its own followed by those of its parent and so on
+ * up to the root of the inheritance tree, together with a NameIndex for
+ * each of them.  These tables are built on first use and rebuilt after
+ * any change to the inheritance tree, so that looking up an inherited
+ * attribute or trace source does not walk the parents.
  *
  * \internal
  * <b>Hash Chaining</b>
@@ -105,6 +241,11 @@ public:
   uint32_t GetTraceSourceN (uint16_t uid) const;
   struct TypeId::TraceSourceInformation GetTraceSource(uint16_t uid, uint32_t i) const;
   bool MustHideFromDocumentation (uint16_t uid) const;
+  uint32_t GetFlatAttributeN (uint16_t uid) const;
+  const struct TypeId::AttributeInformation *GetFlatAttribute (uint16_t uid, uint32_t i,
+                                                               uint16_t *owner) const;
+  const struct TypeId::AttributeInformation *LookupAttribute (uint16_t uid, std::string name) const;
+  const struct TypeId::TraceSourceInformation *LookupTraceSource (uint16_t uid, std::string name) const;
 
 private:
   bool HasTraceSource (uint16_t uid, std::string name);
@@ -121,15 +262,24 @@ private:
     bool mustHideFromDocumentation;
     std::vector<struct TypeId::AttributeInformation> attributes;
     std::vector<struct TypeId::TraceSourceInformation> traceSources;
+    // the flattened tables, valid if tablesGeneration == m_generation.
+    // Each entry is the (uid, index) of an attribute or trace source.
+    uint32_t tablesGeneration;
+    std::vector<std::pair<uint16_t, uint32_t> > flatAttributes;
+    std::vector<std::pair<uint16_t, uint32_t> > flatTraceSources;
+    NameIndex attributeIndex;
+    NameIndex traceSourceIndex;
   };
   typedef std::vector<struct IidInformation>::const_iterator Iterator;
 
   struct IidManager::IidInformation *LookupInformation (uint16_t uid) const;
+  struct IidManager::IidInformation *LookupTables (uint16_t uid) const;
 
   std::vector<struct IidInformation> m_information;
 
-  typedef std::map<std::string, uint16_t> namemap_t;
-  namemap_t m_namemap;
+  NameIndex m_namemap;
+  // incremented whenever an attribute, a trace source or a parent is added.
+  uint32_t m_generation;
 
   typedef std::map<TypeId::hash_t, uint16_t> hashmap_t;
   hashmap_t m_hashmap;
@@ -141,6 +291,7 @@ private:
 };
 
 IidManager::IidManager ()
+  : m_generation (1)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -158,7 +309,7 @@ IidManager::AllocateUid (std::string name)
 {
   NS_LOG_FUNCTION (this << name);
   // Type names are definitive: equal names are equal types
-  NS_ASSERT_MSG (m_namemap.count (name) == 0,
+  NS_ASSERT_MSG (GetUid (name) == 0,
                  "Trying to allocate twice the same uid: " << name);
   
   TypeId::hash_t hash = Hasher (name) & (~HashChainFlag);
@@ -213,12 +364,13 @@ IidManager::AllocateUid (std::string name)
   information.groupName = "";
   information.hasConstructor = false;
   information.mustHideFromDocumentation = false;
+  information.tablesGeneration = 0;
   m_information.push_back (information);
   uint32_t uid = m_information.size ();
   NS_ASSERT (uid <= 0xffff);
 
   // Add to both maps:
-  m_namemap.insert (std::make_pair (name, uid));
+  m_namemap.Insert (name, uid);
   m_hashmap.insert (std::make_pair (hash, uid));
   return uid;
 }
@@ -231,6 +383,44 @@ IidManager::LookupInformation (uint16_t uid) const
   return const_cast<struct IidInformation *> (&m_information[uid-1]);
 }
 
+struct IidManager::IidInformation *
+IidManager::LookupTables (uint16_t uid) const
+{
+  NS_LOG_FUNCTION (this << uid);
+  struct IidInformation *information = LookupInformation (uid);
+  if (information->tablesGeneration == m_generation)
+    {
+      return information;
+    }
+  information->flatAttributes.clear ();
+  information->flatTraceSources.clear ();
+  information->attributeIndex = NameIndex ();
+  information->traceSourceIndex = NameIndex ();
+  uint16_t current = uid;
+  while (true)
+    {
+      struct IidInformation *tmp = LookupInformation (current);
+      for (uint32_t i = 0; i < tmp->attributes.size (); i++)
+        {
+          information->attributeIndex.Insert (tmp->attributes[i].name, information->flatAttributes.size ());
+          information->flatAttributes.push_back (std::make_pair (current, i));
+        }
+      for (uint32_t i = 0; i < tmp->traceSources.size (); i++)
+        {
+          information->traceSourceIndex.Insert (tmp->traceSources[i].name, information->flatTraceSources.size ());
+          information->flatTraceSources.push_back (std::make_pair (current, i));
+        }
+      if (tmp->parent == current || tmp->parent == 0)
+        {
+          // top of inheritance tree, or no parent set yet
+          break;
+        }
+      current = tmp->parent;
+    }
+  information->tablesGeneration = m_generation;
+  return information;
+}
+
 void 
 IidManager::SetParent (uint16_t uid, uint16_t parent)
 {
@@ -238,6 +428,7 @@ IidManager::SetParent (uint16_t uid, uint16_t parent)
   NS_ASSERT (parent <= m_information.size ());
   struct IidInformation *information = LookupInformation (uid);
   information->parent = parent;
+  m_generation++;
 }
 void 
 IidManager::SetGroupName (uint16_t uid, std::string groupName)
@@ -271,10 +462,10 @@ uint16_t
 IidManager::GetUid (std::string name) const
 {
   NS_LOG_FUNCTION (this << name);
-  namemap_t::const_iterator it = m_namemap.find (name);
-  if (it != m_namemap.end ())
+  uint32_t uid;
+  if (m_namemap.Find (name, &uid))
     {
-      return it->second;
+      return uid;
     }
   else
     {
@@ -409,6 +600,7 @@ IidManager::AddAttribute (uint16_t uid,
   info.accessor = accessor;
   info.checker = checker;
   information->attributes.push_back (info);
+  m_generation++;
 }
 void 
 IidManager::SetAttributeInitialValue(uint16_t uid,
@@ -485,6 +677,7 @@ IidManager::AddTraceSource (uint16_t uid,
   source.help = help;
   source.accessor = accessor;
   information->traceSources.push_back (source);
+  m_generation++;
 }
 uint32_t 
 IidManager::GetTraceSourceN (uint16_t uid) const
@@ -509,6 +702,53 @@ IidManager::MustHideFromDocumentation (uint16_t uid) const
   return information->mustHideFromDocumentation;
 }
 
+uint32_t
+IidManager::GetFlatAttributeN (uint16_t uid) const
+{
+  NS_LOG_FUNCTION (this << uid);
+  struct IidInformation *information = LookupTables (uid);
+  return information->flatAttributes.size ();
+}
+const struct TypeId::AttributeInformation *
+IidManager::GetFlatAttribute (uint16_t uid, uint32_t i, uint16_t *owner) const
+{
+  NS_LOG_FUNCTION (this << uid << i << owner);
+  struct IidInformation *information = LookupTables (uid);
+  NS_ASSERT (i < information->flatAttributes.size ());
+  std::pair<uint16_t, uint32_t> entry = information->flatAttributes[i];
+  if (owner != 0)
+    {
+      *owner = entry.first;
+    }
+  return &LookupInformation (entry.first)->attributes[entry.second];
+}
+const struct TypeId::AttributeInformation *
+IidManager::LookupAttribute (uint16_t uid, std::string name) const
+{
+  NS_LOG_FUNCTION (this << uid << name);
+  struct IidInformation *information = LookupTables (uid);
+  uint32_t i;
+  if (!information->attributeIndex.Find (name, &i))
+    {
+      return 0;
+    }
+  std::pair<uint16_t, uint32_t> entry = information->flatAttributes[i];
+  return &LookupInformation (entry.first)->attributes[entry.second];
+}
+const struct TypeId::TraceSourceInformation *
+IidManager::LookupTraceSource (uint16_t uid, std::string name) const
+{
+  NS_LOG_FUNCTION (this << uid << name);
+  struct IidInformation *information = LookupTables (uid);
+  uint32_t i;
+  if (!information->traceSourceIndex.Find (name, &i))
+    {
+      return 0;
+    }
+  std::pair<uint16_t, uint32_t> entry = information->flatTraceSources[i];
+  return &LookupInformation (entry.first)->traceSources[entry.second];
+}
+
 } // namespace ns3
 
 namespace ns3 {
@@ -588,22 +828,41 @@ bool
 TypeId::LookupAttributeByName (std::string name, struct TypeId::AttributeInformation *info) const
 {
   NS_LOG_FUNCTION (this << name << info);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
-        {
-          struct TypeId::AttributeInformation tmp = tid.GetAttribute(i);
-          if (tmp.name == name)
-            {
-              *info = tmp;
-              return true;
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return false;
+  const struct TypeId::AttributeInformation *tmp = FindAttribute (name);
+  if (tmp == 0)
+    {
+      return false;
+    }
+  *info = *tmp;
+  return true;
+}
+
+const struct TypeId::AttributeInformation *
+TypeId::FindAttribute (std::string name) const
+{
+  NS_LOG_FUNCTION (this << name);
+  return Singleton<IidManager>::Get ()->LookupAttribute (m_tid, name);
+}
+
+uint32_t
+TypeId::GetFlatAttributeN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return Singleton<IidManager>::Get ()->GetFlatAttributeN (m_tid);
+}
+
+const struct TypeId::AttributeInformation &
+TypeId::GetFlatAttribute (uint32_t i, TypeId *owner) const
+{
+  NS_LOG_FUNCTION (this << i << owner);
+  uint16_t uid;
+  const struct TypeId::AttributeInformation *info =
+    Singleton<IidManager>::Get ()->GetFlatAttribute (m_tid, i, &uid);
+  if (owner != 0)
+    {
+      *owner = TypeId (uid);
+    }
+  return *info;
 }
 
 TypeId 
@@ -791,21 +1050,13 @@ Ptr<const TraceSourceAccessor>
 TypeId::LookupTraceSourceByName (std::string name) const
 {
   NS_LOG_FUNCTION (this << name);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetTraceSourceN (); i++)
-        {
-          struct TypeId::TraceSourceInformation info = tid.GetTraceSource (i);
-          if (info.name == name)
-            {
-              return info.accessor;
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return 0;
+  const struct TypeId::TraceSourceInformation *info =
+    Singleton<IidManager>::Get ()->LookupTraceSource (m_tid, name);
+  if (info == 0)
+    {
+      return 0;
+    }
+  return info->accessor;
 }
 
 uint16_t 
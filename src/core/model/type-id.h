@@ -188,6 +188,24 @@ public:
    *          index is i.
    */
   std::string GetAttributeFullName (uint32_t i) const;
+  /**
+   * \returns the number of attributes defined in this TypeId and in
+   *          all its parents.
+   */
+  uint32_t GetFlatAttributeN (void) const;
+  /**
+   * \param i index into the attributes of this TypeId and of all its
+   *        parents: the attributes of this TypeId come first, followed
+   *        by those of its parent, and so on.
+   * \param owner if not zero, where the TypeId which defines the
+   *        attribute is stored.
+   * \returns the information associated to the attribute whose
+   *          index is i.
+   *
+   * The returned reference points into the TypeId database: it is
+   * only valid until the next attribute is registered.
+   */
+  const struct TypeId::AttributeInformation &GetFlatAttribute (uint32_t i, TypeId *owner = 0) const;
 
   /**
    * \returns a callback which can be used to instanciate an object
@@ -313,6 +331,16 @@ public:
    * \returns true if the requested attribute could be found, false otherwise.
    */
   bool LookupAttributeByName (std::string name, struct AttributeInformation *info) const;
+  /**
+   * \param name the name of the requested attribute
+   * \returns the information associated to the attribute of this TypeId
+   *          or of one of its parents, or zero if it could not be found.
+   *
+   * Unlike LookupAttributeByName, this method does not copy the
+   * information: the returned pointer is only valid until the next
+   * attribute is registered.
+   */
+  const struct AttributeInformation *FindAttribute (std::string name) const;
   /**
    * \param name the name of the requested trace source
    * \returns the trace source accessor which can be used to connect and disconnect
@@ -18,6 +18,10 @@
 
 #include "ns3/test.h"
 #include "ns3/callback.h"
+#include "ns3/simple-ref-count.h"
+#include <iostream>
+#include <string>
+#include <ctime>
 #include <stdint.h>
 
 using namespace ns3;
@@ -688,6 +692,94 @@ MakeCallbackTemplatesTestCase::DoRun (void)
   that.CheckParentalRights ();
 }
 
+// ===========================================================================
+// Test the callbacks whose CallbackImpl is stored inside the Callback
+// ===========================================================================
+class CallbackTestCounter : public SimpleRefCount<CallbackTestCounter>
+{
+public:
+  CallbackTestCounter () : m_count (0) {}
+  void Add (int i) { m_count += i; }
+  int m_count;
+};
+
+static void
+CallbackTestCount (Ptr<CallbackTestCounter> counter, int i)
+{
+  counter->Add (i);
+}
+
+static void
+CallbackTestAppend (std::string prefix, std::string suffix, Ptr<CallbackTestCounter> counter, int i)
+{
+  counter->Add (prefix.size () + suffix.size () + i);
+}
+
+class InlineCallbackTestCase : public TestCase
+{
+public:
+  InlineCallbackTestCase ();
+  virtual ~InlineCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+InlineCallbackTestCase::InlineCallbackTestCase ()
+  : TestCase ("Check copies of inline and heap Callback implementations")
+{
+}
+
+void
+InlineCallbackTestCase::DoRun (void)
+{
+  Ptr<CallbackTestCounter> counter = Create<CallbackTestCounter> ();
+  {
+    Callback<void, int> member = MakeCallback (&CallbackTestCounter::Add, counter);
+    Callback<void, int> bound = MakeBoundCallback (&CallbackTestCount, counter);
+    Callback<void, int> heap = MakeBoundCallback (&CallbackTestAppend, std::string (100, 'a'),
+                                                  std::string (100, 'b'), counter);
+    NS_TEST_ASSERT_MSG_EQ (counter->GetReferenceCount (), 4, "Wrong reference count");
+
+    Callback<void, int> copy = member;
+    copy (1);
+    member (2);
+    NS_TEST_ASSERT_MSG_EQ (counter->m_count, 3, "Copy did not fire");
+    NS_TEST_ASSERT_MSG_EQ (copy.IsEqual (member), true, "Copy differs from original");
+    NS_TEST_ASSERT_MSG_EQ (copy.IsEqual (bound), false, "Distinct callbacks are equal");
+    NS_TEST_ASSERT_MSG_EQ (counter->GetReferenceCount (), 5, "Wrong reference count");
+
+    copy = bound;
+    copy (10);
+    NS_TEST_ASSERT_MSG_EQ (counter->m_count, 13, "Assigned copy did not fire");
+    NS_TEST_ASSERT_MSG_EQ (copy.IsEqual (bound), true, "Assigned copy differs from original");
+    copy = heap;
+    copy (0);
+    NS_TEST_ASSERT_MSG_EQ (counter->m_count, 213, "Heap copy did not fire");
+    NS_TEST_ASSERT_MSG_EQ (copy.IsEqual (heap), true, "Heap copy differs from original");
+    NS_TEST_ASSERT_MSG_EQ (counter->GetReferenceCount (), 4, "Wrong reference count");
+
+    CallbackBase base = bound;
+    NS_TEST_ASSERT_MSG_EQ (copy.CheckType (base), true, "Wrong type");
+    copy.Assign (base);
+    copy (100);
+    NS_TEST_ASSERT_MSG_EQ (counter->m_count, 313, "Assigned callback did not fire");
+    NS_TEST_ASSERT_MSG_EQ (base.GetImpl ()->IsEqual (bound.GetImpl ()), true, "Wrong GetImpl");
+    NS_TEST_ASSERT_MSG_EQ (Callback<void> ().CheckType (base), false, "Wrong type");
+
+    base = CallbackBase ();
+    copy.Nullify ();
+    NS_TEST_ASSERT_MSG_EQ (copy.IsNull (), true, "Nullified callback is not null");
+    NS_TEST_ASSERT_MSG_EQ (counter->GetReferenceCount (), 4, "Wrong reference count");
+    copy = copy;
+    copy = member;
+    copy = copy;
+    copy (1);
+    NS_TEST_ASSERT_MSG_EQ (counter->m_count, 314, "Self-assigned callback did not fire");
+  }
+  NS_TEST_ASSERT_MSG_EQ (counter->GetReferenceCount (), 1, "Callbacks leaked a reference");
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -705,6 +797,117 @@ CallbackTestSuite::CallbackTestSuite ()
   AddTestCase (new MakeBoundCallbackTestCase, TestCase::QUICK);
   AddTestCase (new NullifyCallbackTestCase, TestCase::QUICK);
   AddTestCase (new MakeCallbackTemplatesTestCase, TestCase::QUICK);
+  AddTestCase (new InlineCallbackTestCase, TestCase::QUICK);
 }
 
 static CallbackTestSuite CallbackTestSuite;
+
+// ===========================================================================
+// Measure the cost of constructing and invoking callbacks, with the
+// CallbackImpl stored inline or on the heap.
+// ===========================================================================
+class CallbackTimeTestCase : public TestCase
+{
+public:
+  CallbackTimeTestCase ();
+  virtual ~CallbackTimeTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  void Report (std::string name, clock_t start, clock_t stop) const;
+
+  enum { REPETITIONS = 1000000 };
+};
+
+CallbackTimeTestCase::CallbackTimeTestCase ()
+  : TestCase ("Measure average Callback construction and invocation time")
+{
+}
+
+void
+CallbackTimeTestCase::Report (std::string name, clock_t start, clock_t stop) const
+{
+  std::cout << name << 1e9 * (stop - start) / CLOCKS_PER_SEC / REPETITIONS << " ns/callback" << std::endl;
+}
+
+void
+CallbackTimeTestCase::DoRun (void)
+{
+  typedef MemPtrCallbackImpl<Ptr<CallbackTestCounter>, void (CallbackTestCounter::*)(int),
+                             void, int, empty, empty, empty, empty, empty, empty, empty, empty> MemPtrImpl;
+  typedef BoundFunctorCallbackImpl<void (*)(Ptr<CallbackTestCounter>, int), void, Ptr<CallbackTestCounter>,
+                                   int, empty, empty, empty, empty, empty, empty, empty> BoundImpl;
+  typedef CallbackImpl<void, int, empty, empty, empty, empty, empty, empty, empty, empty> Impl;
+  Ptr<CallbackTestCounter> counter = Create<CallbackTestCounter> ();
+
+  std::cout << GetName () << std::endl;
+  clock_t start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      Callback<void, int> cb (Ptr<Impl> (Create<MemPtrImpl> (counter, &CallbackTestCounter::Add)));
+      cb (1);
+    }
+  clock_t stop = clock ();
+  Report ("heap member:     ", start, stop);
+
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      Callback<void, int> cb = MakeCallback (&CallbackTestCounter::Add, counter);
+      cb (1);
+    }
+  stop = clock ();
+  Report ("inline member:   ", start, stop);
+
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      Callback<void, int> cb (Ptr<Impl> (Create<BoundImpl> (&CallbackTestCount, counter)));
+      cb (1);
+    }
+  stop = clock ();
+  Report ("heap bound:      ", start, stop);
+
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      Callback<void, int> cb = MakeBoundCallback (&CallbackTestCount, counter);
+      cb (1);
+    }
+  stop = clock ();
+  Report ("inline bound:    ", start, stop);
+
+  Callback<void, int> heap (Ptr<Impl> (Create<MemPtrImpl> (counter, &CallbackTestCounter::Add)));
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      heap (1);
+    }
+  stop = clock ();
+  Report ("heap invoke:     ", start, stop);
+
+  Callback<void, int> member = MakeCallback (&CallbackTestCounter::Add, counter);
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      member (1);
+    }
+  stop = clock ();
+  Report ("inline invoke:   ", start, stop);
+
+  NS_TEST_EXPECT_MSG_EQ (counter->m_count, 6 * REPETITIONS, "Callbacks did not fire");
+}
+
+class CallbackPerformanceSuite : public TestSuite
+{
+public:
+  CallbackPerformanceSuite ();
+};
+
+CallbackPerformanceSuite::CallbackPerformanceSuite ()
+  : TestSuite ("callback-perf", PERFORMANCE)
+{
+  AddTestCase (new CallbackTimeTestCase, TestCase::QUICK);
+}
+
+static CallbackPerformanceSuite callbackPerformanceSuite;
@@ -29,7 +29,9 @@
 #include "ns3/object-vector.h"
 #include "ns3/names.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 
 
 #include <sstream>
@@ -606,6 +608,90 @@ ObjectVectorTraceConfigTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeA/NodeB/NodesB/1/Source", "Trace 1 did not provide expected context");
 }
 
+// ===========================================================================
+// Test for the cache of the objects matched by a path.
+// ===========================================================================
+class MatchCacheConfigTestCase : public TestCase
+{
+public:
+  MatchCacheConfigTestCase ();
+  virtual ~MatchCacheConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+MatchCacheConfigTestCase::MatchCacheConfigTestCase ()
+  : TestCase ("Check that the cached matches are discarded when the object graph changes")
+{
+}
+
+void
+MatchCacheConfigTestCase::DoRun (void)
+{
+  Config::SetGlobal ("ConfigMatchCache", BooleanValue (true));
+
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  root->SetNodeA (a);
+  Ptr<ConfigTestObject> obj0 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> obj1 = CreateObject<ConfigTestObject> ();
+  a->AddNodeB (obj0);
+  a->AddNodeB (obj1);
+
+  std::string path = "/NodeA/NodesB/[0-1]|5";
+  Config::MatchContainer matches = Config::LookupMatches (path);
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 2, "Wrong number of matches");
+  NS_TEST_EXPECT_MSG_EQ (matches.GetMatchedPath (1), "/NodeA/NodesB/1/", "Wrong matched path");
+
+  //
+  // The objects added behind the back of the Config functions are not seen
+  // until the cache is discarded.
+  //
+  for (uint32_t i = 2; i < 6; i++)
+    {
+      a->AddNodeB (CreateObject<ConfigTestObject> ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches (path).GetN (), 2, "Matches not cached");
+  Config::InvalidateMatchCache ();
+  matches = Config::LookupMatches (path);
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 3, "Cache not discarded");
+  NS_TEST_EXPECT_MSG_EQ (matches.GetMatchedPath (2), "/NodeA/NodesB/5/", "Wrong matched path");
+
+  //
+  // Setting a pointer through the Config functions discards the cache.
+  // The roots registered by the other tests may match too.
+  //
+  Ptr<ConfigTestObject> b = CreateObject<ConfigTestObject> ();
+  uint32_t n = Config::LookupMatches ("/NodeA/NodeB").GetN ();
+  Config::Set ("/NodeA/NodeB", PointerValue (b));
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodeA/NodeB").GetN (), n + 1, "Cache not discarded by Set");
+
+  //
+  // Naming an object discards the cache.
+  //
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/Names/MatchCacheObject").GetN (), 0, "Unexpected match");
+  Names::Add ("MatchCacheObject", obj0);
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/Names/MatchCacheObject").GetN (), 1, "Cache not discarded by Names");
+
+  //
+  // The objects matched during a simulation are released when it is
+  // destroyed.
+  //
+  matches = Config::LookupMatches (path);
+  uint32_t references = obj1->GetReferenceCount ();
+  matches = Config::MatchContainer ();
+  NS_TEST_EXPECT_MSG_EQ (obj1->GetReferenceCount (), references - 1, "Matches not cached");
+  Simulator::Now ();
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (obj1->GetReferenceCount (), references - 2, "Cache not discarded by Simulator::Destroy");
+
+  Config::UnregisterRootNamespaceObject (root);
+  Config::SetGlobal ("ConfigMatchCache", BooleanValue (false));
+  Names::Clear ();
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -621,6 +707,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new RootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
+  AddTestCase (new MatchCacheConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
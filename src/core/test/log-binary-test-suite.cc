@@ -0,0 +1,504 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+#include "ns3/fatal-error.h"
+#include "ns3/core-config.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+#include <vector>
+#include <ctime>
+#include <cstdio>
+
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/callback.h"
+#endif /* HAVE_PTHREAD_H */
+
+static bool g_logContext = false;
+static int GetLogContext (void);
+
+#undef NS_LOG_APPEND_CONTEXT
+#define NS_LOG_APPEND_CONTEXT if (g_logContext) { std::clog << "[context=" << GetLogContext () << "] "; }
+
+NS_LOG_COMPONENT_DEFINE ("LogBinaryTest");
+
+using namespace ns3;
+
+#ifdef HAVE_PTHREAD_H
+// whether another thread writes to std::clog while the context is logged
+static bool g_logOtherThread = false;
+
+static void
+WriteOtherThread (void)
+{
+  std::clog << "other thread" << std::endl;
+}
+#endif /* HAVE_PTHREAD_H */
+
+static int
+GetLogContext (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (g_logOtherThread)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&WriteOtherThread));
+      thread->Start ();
+      thread->Join ();
+    }
+#endif /* HAVE_PTHREAD_H */
+  return 7;
+}
+
+// arguments with inserters which take them by non-const reference.
+enum LogBinaryPlainEnum { PLAIN_A, PLAIN_B = 7 };
+enum LogBinaryNamedEnum { NAMED_A, NAMED_B };
+struct LogBinaryArgument
+{
+  int value;
+};
+
+static std::ostream &
+operator<< (std::ostream &os, LogBinaryNamedEnum &v)
+{
+  return os << (v == NAMED_A ? "named-a" : "named-b");
+}
+
+static std::ostream &
+operator<< (std::ostream &os, LogBinaryArgument &v)
+{
+  return os << "argument " << v.value;
+}
+
+static void
+LogArguments (int i)
+{
+  LogBinaryPlainEnum plain = PLAIN_B;
+  LogBinaryNamedEnum named = NAMED_B;
+  LogBinaryArgument argument;
+  argument.value = i;
+  TracedValue<uint32_t> traced = 42;
+  NS_LOG_DEBUG ("plain " << plain << " " << PLAIN_A << " named " << named << " " << argument << " traced " << traced);
+  NS_LOG_FUNCTION (named << argument << traced << plain);
+}
+
+static void
+LogMessages (int i)
+{
+  NS_LOG_FUNCTION (i << "text" << 2.5 << &g_logContext);
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_DEBUG ("int " << i << " unsigned " << 3u << " double " << 1.0 / 3 << " char " << 'c' << " bool " << true);
+  NS_LOG_INFO ("string " << std::string ("abc") << " time " << Seconds (1.5) << " hex " << std::hex << 255 << " " << i << std::dec);
+  NS_LOG_LOGIC ("width " << std::setw (6) << i << " after " << i);
+  NS_LOG_WARN ("uint8 " << static_cast<uint8_t> (65) << " int64 " << static_cast<int64_t> (-12345678901LL) << " float " << 0.1f);
+  NS_LOG_ERROR ("line" << std::endl << "next");
+  g_logContext = true;
+  NS_LOG_INFO ("with context " << i);
+  NS_LOG_FUNCTION (i);
+  g_logContext = false;
+  LogArguments (i);
+}
+
+static void
+LogScenario (void)
+{
+  LogComponentEnable ("LogBinaryTest", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+  Simulator::Schedule (Seconds (1.0), &LogMessages, 1);
+  Simulator::ScheduleWithContext (3, Seconds (2.5), &LogMessages, 2);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  LogComponentDisable ("LogBinaryTest", LogLevel (LOG_PREFIX_TIME | LOG_PREFIX_NODE));
+  LogMessages (3);
+  LogComponentDisable ("LogBinaryTest", LOG_ALL);
+  LogComponentDisable ("LogBinaryTest", LOG_PREFIX_ALL);
+}
+
+class LogBinaryTestCase : public TestCase
+{
+public:
+  LogBinaryTestCase ();
+  virtual void DoRun (void);
+};
+
+LogBinaryTestCase::LogBinaryTestCase ()
+  : TestCase ("Check that decoded binary logs match the text logs")
+{
+}
+
+void
+LogBinaryTestCase::DoRun (void)
+{
+  std::ostringstream text;
+  std::streambuf *clog = std::clog.rdbuf (text.rdbuf ());
+  LogScenario ();
+
+  std::ostringstream unformatted;
+  std::clog.rdbuf (unformatted.rdbuf ());
+  std::string filename = CreateTempDirFilename ("log-binary.bin");
+  LogEnableBinary (filename);
+  LogScenario ();
+  LogDisableBinary ();
+  std::clog.rdbuf (clog);
+  NS_TEST_EXPECT_MSG_EQ (unformatted.str (), "", "Binary log messages were formatted");
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (is, decoded), true, "Could not decode the binary log");
+  NS_TEST_EXPECT_MSG_EQ (decoded.str (), text.str (), "Decoded binary log differs from the text log");
+  is.close ();
+
+  // a truncated log decodes up to its last complete message.
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  std::string data ((std::istreambuf_iterator<char> (file)), std::istreambuf_iterator<char> ());
+  std::istringstream truncated (data.substr (0, data.size () - 3));
+  decoded.str ("");
+  NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (truncated, decoded), false, "Truncated binary log was decoded");
+  std::string expected = text.str ();
+  expected = expected.substr (0, expected.rfind ('\n', expected.size () - 2) + 1);
+  NS_TEST_EXPECT_MSG_EQ (decoded.str (), expected, "Wrong messages decoded from a truncated binary log");
+}
+
+class LogBinaryRingTestCase : public TestCase
+{
+public:
+  LogBinaryRingTestCase ();
+  virtual void DoRun (void);
+};
+
+LogBinaryRingTestCase::LogBinaryRingTestCase ()
+  : TestCase ("Check that a binary log ring buffer keeps the last messages")
+{
+}
+
+void
+LogBinaryRingTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("log-binary-ring.bin");
+  LogEnableBinary (filename, 1000);
+  LogComponentEnable ("LogBinaryTest", LOG_DEBUG);
+  for (int i = 0; i < 1000; i++)
+    {
+      NS_LOG_DEBUG ("message " << i << " of " << 1000);
+    }
+  LogComponentDisable ("LogBinaryTest", LOG_DEBUG);
+  LogDisableBinary ();
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (is, decoded), true, "Could not decode the binary log");
+  std::istringstream lines (decoded.str ());
+  std::string line;
+  std::vector<std::string> messages;
+  while (std::getline (lines, line))
+    {
+      messages.push_back (line);
+    }
+  NS_TEST_ASSERT_MSG_GT (messages.size (), 10, "Too few messages in the ring buffer");
+  NS_TEST_ASSERT_MSG_LT (messages.size (), 1000, "Too many messages in the ring buffer");
+  for (uint32_t i = 0; i < messages.size (); i++)
+    {
+      std::ostringstream expected;
+      expected << "message " << 1000 - messages.size () + i << " of 1000";
+      NS_TEST_EXPECT_MSG_EQ (messages[i], expected.str (), "Wrong message " << i);
+    }
+}
+
+#ifdef HAVE_SYS_WAIT_H
+class LogBinaryFatalTestCase : public TestCase
+{
+public:
+  LogBinaryFatalTestCase ();
+  virtual void DoRun (void);
+};
+
+LogBinaryFatalTestCase::LogBinaryFatalTestCase ()
+  : TestCase ("Check that a binary log ring buffer is written on a fatal error")
+{
+}
+
+void
+LogBinaryFatalTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("log-binary-fatal.bin");
+  pid_t pid = fork ();
+  NS_TEST_ASSERT_MSG_NE (pid, -1, "Cannot fork");
+  if (pid == 0)
+    {
+      // the messages of the fatal error are expected.
+      std::freopen ("/dev/null", "w", stderr);
+      LogEnableBinary (filename, 1000);
+      LogComponentEnable ("LogBinaryTest", LOG_DEBUG);
+      for (int i = 0; i < 10; i++)
+        {
+          NS_LOG_DEBUG ("message " << i << " before the fatal error");
+        }
+      NS_FATAL_ERROR ("fatal error");
+    }
+  int status;
+  waitpid (pid, &status, 0);
+  bool exited = WIFEXITED (status);
+  NS_TEST_EXPECT_MSG_EQ (exited, false, "The fatal error did not terminate the process");
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (is, decoded), true, "Could not decode the binary log");
+  std::ostringstream expected;
+  for (int i = 0; i < 10; i++)
+    {
+      expected << "message " << i << " before the fatal error" << std::endl;
+    }
+  NS_TEST_EXPECT_MSG_EQ (decoded.str (), expected.str (), "Ring buffer lost on a fatal error");
+}
+#endif /* HAVE_SYS_WAIT_H */
+
+#ifdef HAVE_PTHREAD_H
+class LogBinaryThreadsTestCase : public TestCase
+{
+public:
+  LogBinaryThreadsTestCase ();
+  virtual void DoRun (void);
+private:
+  static void Log (uint32_t thread);
+};
+
+static const uint32_t THREADS = 4;
+static const uint32_t THREAD_MESSAGES = 2000;
+
+LogBinaryThreadsTestCase::LogBinaryThreadsTestCase ()
+  : TestCase ("Check that threads can record binary log messages concurrently")
+{
+}
+
+void
+LogBinaryThreadsTestCase::Log (uint32_t thread)
+{
+  for (uint32_t i = 0; i < THREAD_MESSAGES; i++)
+    {
+      NS_LOG_DEBUG ("thread " << thread << " message " << i);
+      // each statement is a site registered by the first thread to use it.
+      NS_LOG_INFO ("thread " << thread << " info " << i);
+    }
+}
+
+void
+LogBinaryThreadsTestCase::DoRun (void)
+{
+  LogComponentEnable ("LogBinaryTest", LogLevel (LOG_DEBUG | LOG_INFO));
+  for (uint32_t ring = 0; ring < 2; ring++)
+    {
+      std::string filename = CreateTempDirFilename ("log-binary-threads.bin");
+      LogEnableBinary (filename, ring == 0 ? 0 : 1 << 22);
+      std::vector<Ptr<SystemThread> > threads;
+      for (uint32_t i = 0; i < THREADS; i++)
+        {
+          threads.push_back (Create<SystemThread> (MakeBoundCallback (&LogBinaryThreadsTestCase::Log, i)));
+          threads.back ()->Start ();
+        }
+      for (uint32_t i = 0; i < THREADS; i++)
+        {
+          threads[i]->Join ();
+        }
+      LogDisableBinary ();
+
+      std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+      std::ostringstream decoded;
+      NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (is, decoded), true, "Could not decode the binary log");
+      // the messages of each thread are in order.
+      std::vector<uint32_t> next (THREADS, 0);
+      std::istringstream lines (decoded.str ());
+      std::string line;
+      while (std::getline (lines, line))
+        {
+          std::istringstream words (line);
+          std::string thread, message;
+          uint32_t t = THREADS, i = 0;
+          words >> thread >> t >> message >> i;
+          NS_TEST_ASSERT_MSG_LT (t, THREADS, "Corrupted message \"" << line << "\"");
+          std::ostringstream expected;
+          expected << "thread " << t << (next[t] % 2 == 0 ? " message " : " info ") << next[t] / 2;
+          NS_TEST_ASSERT_MSG_EQ (line, expected.str (), "Wrong message of thread " << t);
+          next[t]++;
+        }
+      for (uint32_t i = 0; i < THREADS; i++)
+        {
+          uint32_t messages = next[i];
+          NS_TEST_EXPECT_MSG_EQ (messages, 2 * THREAD_MESSAGES, "Messages of thread " << i << " lost");
+        }
+    }
+  LogComponentDisable ("LogBinaryTest", LOG_ALL);
+}
+
+class LogBinaryContextTestCase : public TestCase
+{
+public:
+  LogBinaryContextTestCase ();
+  virtual void DoRun (void);
+};
+
+LogBinaryContextTestCase::LogBinaryContextTestCase ()
+  : TestCase ("Check that the context of a message does not capture the output of other threads")
+{
+}
+
+void
+LogBinaryContextTestCase::DoRun (void)
+{
+  LogComponentEnable ("LogBinaryTest", LOG_DEBUG);
+  std::ostringstream other;
+  std::streambuf *clog = std::clog.rdbuf (other.rdbuf ());
+  std::string filename = CreateTempDirFilename ("log-binary-context.bin");
+  LogEnableBinary (filename);
+  g_logContext = true;
+  g_logOtherThread = true;
+  NS_LOG_DEBUG ("message");
+  g_logOtherThread = false;
+  g_logContext = false;
+  LogDisableBinary ();
+  std::clog.rdbuf (clog);
+  LogComponentDisable ("LogBinaryTest", LOG_ALL);
+  NS_TEST_EXPECT_MSG_EQ (other.str (), "other thread\n", "Output of another thread was captured");
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (is, decoded), true, "Could not decode the binary log");
+  NS_TEST_EXPECT_MSG_EQ (decoded.str (), "[context=7] message\n", "Wrong context recorded");
+}
+#endif /* HAVE_PTHREAD_H */
+
+class LogBinaryTestSuite : public TestSuite
+{
+public:
+  LogBinaryTestSuite ()
+    : TestSuite ("log-binary")
+  {
+    AddTestCase (new LogBinaryTestCase (), TestCase::QUICK);
+    AddTestCase (new LogBinaryRingTestCase (), TestCase::QUICK);
+#ifdef HAVE_SYS_WAIT_H
+    AddTestCase (new LogBinaryFatalTestCase (), TestCase::QUICK);
+#endif /* HAVE_SYS_WAIT_H */
+#ifdef HAVE_PTHREAD_H
+    AddTestCase (new LogBinaryThreadsTestCase (), TestCase::QUICK);
+    AddTestCase (new LogBinaryContextTestCase (), TestCase::QUICK);
+#endif /* HAVE_PTHREAD_H */
+  }
+} g_logBinaryTestSuite;
+
+// a buffer which discards its output, to time the formatting alone.
+class NullStreambuf : public std::streambuf
+{
+protected:
+  virtual int overflow (int c)
+  {
+    return c;
+  }
+  virtual std::streamsize xsputn (const char *s, std::streamsize n)
+  {
+    return n;
+  }
+};
+
+class LogBinaryTimeTestCase : public TestCase
+{
+public:
+  LogBinaryTimeTestCase ();
+  virtual void DoRun (void);
+private:
+  static void Log (void);
+  static void Report (const char *name, clock_t start, clock_t stop);
+};
+
+static const uint32_t MESSAGES = 1000000;
+
+LogBinaryTimeTestCase::LogBinaryTimeTestCase ()
+  : TestCase ("Time text and binary logging")
+{
+}
+
+void
+LogBinaryTimeTestCase::Log (void)
+{
+  for (uint32_t i = 0; i < MESSAGES; i++)
+    {
+      NS_LOG_DEBUG ("packet " << i << " size " << 1500 << " delay " << 1.25e-3 << " from " << &g_logContext);
+    }
+}
+
+void
+LogBinaryTimeTestCase::Report (const char *name, clock_t start, clock_t stop)
+{
+  std::cout << name << 1e9 * (stop - start) / CLOCKS_PER_SEC / MESSAGES << " ns/message" << std::endl;
+}
+
+void
+LogBinaryTimeTestCase::DoRun (void)
+{
+  std::cout << GetName () << std::endl;
+  LogComponentEnable ("LogBinaryTest", LogLevel (LOG_DEBUG | LOG_PREFIX_FUNC | LOG_PREFIX_LEVEL));
+
+  NullStreambuf null;
+  std::streambuf *clog = std::clog.rdbuf (&null);
+  clock_t start = clock ();
+  Log ();
+  clock_t stop = clock ();
+  std::clog.rdbuf (clog);
+  Report ("text (discarded):  ", start, stop);
+
+  LogEnableBinary (CreateTempDirFilename ("log-binary-ring.bin"), 1 << 20);
+  start = clock ();
+  Log ();
+  stop = clock ();
+  Report ("binary ring:       ", start, stop);
+
+  std::string filename = CreateTempDirFilename ("log-binary-file.bin");
+  LogEnableBinary (filename);
+  start = clock ();
+  Log ();
+  LogDisableBinary ();
+  stop = clock ();
+  Report ("binary file:       ", start, stop);
+
+  LogComponentDisable ("LogBinaryTest", LOG_ALL);
+  LogComponentDisable ("LogBinaryTest", LOG_PREFIX_ALL);
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ofstream os ("/dev/null");
+  start = clock ();
+  NS_TEST_EXPECT_MSG_EQ (LogDecodeBinary (is, os), true, "Could not decode the binary log");
+  stop = clock ();
+  Report ("decoding:          ", start, stop);
+}
+
+class LogBinaryPerformanceSuite : public TestSuite
+{
+public:
+  LogBinaryPerformanceSuite ()
+    : TestSuite ("log-binary-perf", PERFORMANCE)
+  {
+    AddTestCase (new LogBinaryTimeTestCase (), TestCase::QUICK);
+  }
+} g_logBinaryPerformanceSuite;
@@ -22,6 +22,10 @@
 #include "ns3/object.h"
 #include "ns3/object-factory.h"
 #include "ns3/assert.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <ctime>
 
 namespace {
 
@@ -89,6 +93,43 @@ public:
   }
 };
 
+// A family of distinct types to aggregate together.
+template <int N>
+class Aggregate : public ns3::Object
+{
+public:
+  static ns3::TypeId GetTypeId (void) {
+    static std::string name = MakeName ();
+    static ns3::TypeId tid = ns3::TypeId (name.c_str ())
+      .SetParent (Object::GetTypeId ())
+      .HideFromDocumentation ()
+      .AddConstructor<Aggregate<N> > ();
+    return tid;
+  }
+private:
+  static std::string MakeName (void) {
+    std::ostringstream oss;
+    oss << "ObjectTest:Aggregate" << N;
+    return oss.str ();
+  }
+};
+
+// Aggregate N objects of distinct types to an object.
+template <int N>
+void
+AggregateMany (ns3::Ptr<ns3::Object> object, std::vector<ns3::Ptr<ns3::Object> > *aggregates)
+{
+  ns3::Ptr<ns3::Object> aggregate = ns3::CreateObject<Aggregate<N> > ();
+  object->AggregateObject (aggregate);
+  aggregates->push_back (aggregate);
+  AggregateMany<N-1> (object, aggregates);
+}
+template <>
+void
+AggregateMany<0> (ns3::Ptr<ns3::Object> object, std::vector<ns3::Ptr<ns3::Object> > *aggregates)
+{
+}
+
 NS_OBJECT_ENSURE_REGISTERED (BaseA);
 NS_OBJECT_ENSURE_REGISTERED (DerivedA);
 NS_OBJECT_ENSURE_REGISTERED (BaseB);
@@ -335,6 +376,70 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that the lookup cache of aggregates returns the
+// right objects.
+// ===========================================================================
+class AggregateCacheTestCase : public TestCase
+{
+public:
+  AggregateCacheTestCase ();
+  virtual ~AggregateCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AggregateCacheTestCase::AggregateCacheTestCase ()
+  : TestCase ("Check the lookup cache of aggregated Objects")
+{
+}
+
+AggregateCacheTestCase::~AggregateCacheTestCase ()
+{
+}
+
+void
+AggregateCacheTestCase::DoRun (void)
+{
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  std::vector<Ptr<Object> > aggregates;
+  AggregateMany<12> (derivedA, &aggregates);
+
+  //
+  // Every lookup is performed twice, so the second one hits the cache,
+  // through the GetObject template and through the TypeId.
+  //
+  for (uint32_t j = 0; j < 2; j++)
+    {
+      for (uint32_t i = 0; i < aggregates.size (); i++)
+        {
+          TypeId tid = aggregates[i]->GetInstanceTypeId ();
+          NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<Object> (tid), aggregates[i],
+                                 "Wrong object found for " << tid.GetName ());
+        }
+      NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<Aggregate<3> > (), aggregates[12 - 3],
+                             "Wrong object found for Aggregate<3>");
+      NS_TEST_ASSERT_MSG_EQ (aggregates[0]->GetObject<BaseA> (), derivedA,
+                             "Wrong object found for BaseA");
+      NS_TEST_ASSERT_MSG_EQ (aggregates[0]->GetObject<BaseB> (), 0,
+                             "Unexpectedly found a BaseB");
+    }
+
+  //
+  // Aggregating a new object must make it visible to the lookups which
+  // previously failed, without breaking the lookups which succeeded.
+  //
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+  aggregates[0]->AggregateObject (derivedB);
+  NS_TEST_ASSERT_MSG_EQ (aggregates[0]->GetObject<BaseB> (), derivedB,
+                         "Cannot GetObject for BaseB after aggregation");
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), derivedA,
+                         "Cannot GetObject for BaseA after aggregation");
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<Aggregate<3> > (), aggregates[12 - 3],
+                         "Cannot GetObject for Aggregate<3> after aggregation");
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -422,8 +527,113 @@ ObjectTestSuite::ObjectTestSuite ()
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
+  AddTestCase (new AggregateCacheTestCase, TestCase::QUICK);
 }
 
 static ObjectTestSuite objectTestSuite;
 
+// ===========================================================================
+// Measure the time spent in GetObject on a large aggregate, compared to a
+// search of the aggregates such as performed before a lookup is cached.
+// ===========================================================================
+class GetObjectTimeTestCase : public TestCase
+{
+public:
+  GetObjectTimeTestCase ();
+  virtual ~GetObjectTimeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  static Ptr<Object> Search (Ptr<Object> object, TypeId tid);
+
+  enum { REPETITIONS = 1000000 };
+};
+
+GetObjectTimeTestCase::GetObjectTimeTestCase ()
+  : TestCase ("Measure average GetObject time on 16 aggregated objects")
+{
+}
+
+GetObjectTimeTestCase::~GetObjectTimeTestCase ()
+{
+}
+
+Ptr<Object>
+GetObjectTimeTestCase::Search (Ptr<Object> object, TypeId tid)
+{
+  Object::AggregateIterator i = object->GetAggregateIterator ();
+  while (i.HasNext ())
+    {
+      Ptr<const Object> current = i.Next ();
+      TypeId cur = current->GetInstanceTypeId ();
+      while (cur != tid && cur != Object::GetTypeId ())
+        {
+          cur = cur.GetParent ();
+        }
+      if (cur == tid)
+        {
+          return ConstCast<Object> (current);
+        }
+    }
+  return 0;
+}
+
+void
+GetObjectTimeTestCase::DoRun (void)
+{
+  Ptr<Object> object = CreateObject<BaseA> ();
+  std::vector<Ptr<Object> > aggregates;
+  AggregateMany<16> (object, &aggregates);
+  TypeId first = aggregates.front ()->GetInstanceTypeId ();
+  TypeId last = aggregates.back ()->GetInstanceTypeId ();
+
+  std::cout << GetName () << std::endl;
+  uint32_t found = 0;
+  clock_t start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      found += (Search (object, first) != 0);
+      found += (Search (object, last) != 0);
+    }
+  clock_t stop = clock ();
+  std::cout << "search:           "
+            << 1e9 * (stop - start) / CLOCKS_PER_SEC / (2 * REPETITIONS) << " ns/lookup" << std::endl;
+
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      found += (object->GetObject<Object> (first) != 0);
+      found += (object->GetObject<Object> (last) != 0);
+    }
+  stop = clock ();
+  std::cout << "GetObject (tid):  "
+            << 1e9 * (stop - start) / CLOCKS_PER_SEC / (2 * REPETITIONS) << " ns/lookup" << std::endl;
+
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      found += (object->GetObject<Aggregate<16> > () != 0);
+      found += (object->GetObject<Aggregate<1> > () != 0);
+    }
+  stop = clock ();
+  std::cout << "GetObject<T> ():  "
+            << 1e9 * (stop - start) / CLOCKS_PER_SEC / (2 * REPETITIONS) << " ns/lookup" << std::endl;
+
+  NS_TEST_EXPECT_MSG_EQ (found, 6 * REPETITIONS, "Missing aggregates");
+}
+
+class ObjectPerformanceSuite : public TestSuite
+{
+public:
+  ObjectPerformanceSuite ();
+};
+
+ObjectPerformanceSuite::ObjectPerformanceSuite ()
+  : TestSuite ("object-perf", PERFORMANCE)
+{
+  AddTestCase (new GetObjectTimeTestCase, TestCase::QUICK);
+}
+
+static ObjectPerformanceSuite objectPerformanceSuite;
+
 } // namespace ns3
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/profiling-simulator-impl.h"
+#include "ns3/simulator.h"
+#include "ns3/object-factory.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include <sstream>
+
+using namespace ns3;
+
+class ProfilingSimulatorImplTestCase : public TestCase
+{
+public:
+  ProfilingSimulatorImplTestCase ();
+  virtual void DoRun (void);
+  void Member (uint32_t a);
+  void OtherMember (uint32_t a);
+  uint32_t m_invoked;
+};
+
+static void
+ProfilingFunction (void)
+{
+}
+
+ProfilingSimulatorImplTestCase::ProfilingSimulatorImplTestCase ()
+  : TestCase ("Check that events are counted by handler and context")
+{
+}
+void
+ProfilingSimulatorImplTestCase::Member (uint32_t a)
+{
+  m_invoked++;
+}
+void
+ProfilingSimulatorImplTestCase::OtherMember (uint32_t a)
+{
+  m_invoked++;
+}
+void
+ProfilingSimulatorImplTestCase::DoRun (void)
+{
+  m_invoked = 0;
+  ObjectFactory factory;
+  factory.SetTypeId (ProfilingSimulatorImpl::GetTypeId ());
+  factory.Set ("ReportFile", StringValue (""));
+  factory.Set ("FoldedFile", StringValue (""));
+  Ptr<ProfilingSimulatorImpl> impl = factory.Create<ProfilingSimulatorImpl> ();
+  Simulator::SetImplementation (impl);
+
+  Simulator::ScheduleWithContext (1, Seconds (1.0), &ProfilingSimulatorImplTestCase::Member, this, 0);
+  Simulator::ScheduleWithContext (1, Seconds (2.0), &ProfilingSimulatorImplTestCase::Member, this, 0);
+  Simulator::ScheduleWithContext (2, Seconds (3.0), &ProfilingSimulatorImplTestCase::Member, this, 0);
+  Simulator::ScheduleWithContext (1, Seconds (3.0), &ProfilingSimulatorImplTestCase::OtherMember, this, 0);
+  EventId cancelled = Simulator::Schedule (Seconds (4.0), &ProfilingSimulatorImplTestCase::Member, this, 0);
+  Simulator::Schedule (Seconds (5.0), &ProfilingFunction);
+  Simulator::Cancel (cancelled);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsExpired (cancelled), true, "Cancelled event is not expired");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_invoked, 4, "Wrapped events were not invoked");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (5.0), "Wrong simulation time");
+
+  std::ostringstream report;
+  impl->PrintReport (report);
+  NS_TEST_EXPECT_MSG_EQ ((report.str ().find ("Event profile: 5 events") != std::string::npos), true,
+                         "Wrong number of events: " << report.str ());
+
+  std::ostringstream folded;
+  impl->PrintFolded (folded);
+  std::string member = "void (ProfilingSimulatorImplTestCase::*)(unsigned int) at 0x";
+  std::string::size_type first = folded.str ().find ("node 1;" + member);
+  NS_TEST_EXPECT_MSG_NE (first, std::string::npos, "Missing context 1: " << folded.str ());
+  // the two methods share their signature but not their handler.
+  std::string::size_type second = folded.str ().find ("node 1;" + member, first + 1);
+  NS_TEST_EXPECT_MSG_NE (second, std::string::npos, "Handlers merged: " << folded.str ());
+  NS_TEST_EXPECT_MSG_EQ ((folded.str ().find ("node 2;" + member) != std::string::npos), true,
+                         "Missing context 2: " << folded.str ());
+  NS_TEST_EXPECT_MSG_EQ ((folded.str ().find ("no context;void (*)() at 0x") != std::string::npos), true,
+                         "Missing function: " << folded.str ());
+  Simulator::Destroy ();
+}
+
+class ProfilingSimulatorImplTestSuite : public TestSuite
+{
+public:
+  ProfilingSimulatorImplTestSuite ()
+    : TestSuite ("profiling-simulator-impl")
+  {
+    AddTestCase (new ProfilingSimulatorImplTestCase (), TestCase::QUICK);
+  }
+} g_profilingSimulatorImplTestSuite;
@@ -0,0 +1,540 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/rng-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/integer.h"
+#include <cmath>
+#include <iostream>
+#include <ctime>
+#include <vector>
+
+using namespace ns3;
+
+// ===========================================================================
+// Check the Philox rounds against the known-answer vectors of Random123
+// ===========================================================================
+
+class PhiloxKnownAnswerTestCase : public TestCase
+{
+public:
+  PhiloxKnownAnswerTestCase ();
+  virtual void DoRun (void);
+};
+
+PhiloxKnownAnswerTestCase::PhiloxKnownAnswerTestCase ()
+  : TestCase ("Check Philox4x32-10 against its known-answer vectors")
+{
+}
+
+void
+PhiloxKnownAnswerTestCase::DoRun (void)
+{
+  static const uint32_t vectors[3][10] = {
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000,
+      0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+    { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+      0xffffffff, 0xffffffff,
+      0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+    { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344,
+      0xa4093822, 0x299f31d0,
+      0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+  };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      uint32_t counter[4] = { vectors[i][0], vectors[i][1], vectors[i][2], vectors[i][3] };
+      uint32_t key[2] = { vectors[i][4], vectors[i][5] };
+      RngStream::Philox (counter, key);
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (counter[j], vectors[i][6 + j], "Wrong word " << j << " of vector " << i);
+        }
+    }
+}
+
+// ===========================================================================
+// Check that batches of numbers are those of successive calls
+// ===========================================================================
+
+class RngStreamBatchTestCase : public TestCase
+{
+public:
+  RngStreamBatchTestCase ();
+  virtual void DoRun (void);
+private:
+  void Check (enum RngStream::Generator generator, std::string name);
+};
+
+RngStreamBatchTestCase::RngStreamBatchTestCase ()
+  : TestCase ("Check that RandU01 batches match successive RandU01 calls")
+{
+}
+
+void
+RngStreamBatchTestCase::Check (enum RngStream::Generator generator, std::string name)
+{
+  RngStream sequential (12, 3, 7, generator);
+  RngStream batch (12, 3, 7, generator);
+  // batches of odd sizes, to cross the Philox blocks in the middle.
+  double values[13];
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      uint32_t n = 1 + (i * 5) % 13;
+      batch.RandU01 (values, n);
+      for (uint32_t j = 0; j < n; j++)
+        {
+          double expected = sequential.RandU01 ();
+          NS_TEST_EXPECT_MSG_EQ (values[j], expected, name << ": wrong value " << j << " in batch " << i);
+          NS_TEST_EXPECT_MSG_GT (values[j], 0.0, name << ": value out of range");
+          NS_TEST_EXPECT_MSG_LT (values[j], 1.0, name << ": value out of range");
+        }
+    }
+  RngStream copy (sequential);
+  NS_TEST_EXPECT_MSG_EQ (copy.RandU01 (), sequential.RandU01 (), name << ": copy diverged");
+}
+
+void
+RngStreamBatchTestCase::DoRun (void)
+{
+  Check (RngStream::MRG32K3A, "MRG32k3a");
+  Check (RngStream::PHILOX, "Philox");
+
+  // different streams and substreams produce different numbers.
+  RngStream a (1, 0, 1, RngStream::PHILOX);
+  RngStream b (1, 1, 1, RngStream::PHILOX);
+  RngStream c (1, 0, 2, RngStream::PHILOX);
+  double va = a.RandU01 ();
+  NS_TEST_EXPECT_MSG_NE (va, b.RandU01 (), "Philox streams are identical");
+  NS_TEST_EXPECT_MSG_NE (va, c.RandU01 (), "Philox substreams are identical");
+}
+
+// ===========================================================================
+// Check GetValues against GetValue, with both generators
+// ===========================================================================
+
+class RandomVariableGetValuesTestCase : public TestCase
+{
+public:
+  RandomVariableGetValuesTestCase ();
+  virtual void DoRun (void);
+private:
+  void Check (Ptr<RandomVariableStream> sequential, Ptr<RandomVariableStream> batch, std::string name);
+};
+
+RandomVariableGetValuesTestCase::RandomVariableGetValuesTestCase ()
+  : TestCase ("Check that GetValues matches successive GetValue calls")
+{
+}
+
+void
+RandomVariableGetValuesTestCase::Check (Ptr<RandomVariableStream> sequential,
+                                        Ptr<RandomVariableStream> batch,
+                                        std::string name)
+{
+  sequential->SetStream (5);
+  batch->SetStream (5);
+  std::vector<double> values (100);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      batch->GetValues (&values[0], values.size ());
+      for (uint32_t j = 0; j < values.size (); j++)
+        {
+          double expected = sequential->GetValue ();
+          NS_TEST_EXPECT_MSG_EQ_TOL (values[j], expected, 1e-12,
+                                     name << ": wrong value " << j << " in batch " << i);
+        }
+    }
+}
+
+void
+RandomVariableGetValuesTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      enum RngStream::Generator generator = i == 0 ? RngStream::MRG32K3A : RngStream::PHILOX;
+      RngSeedManager::SetGenerator (generator);
+      NS_TEST_EXPECT_MSG_EQ (RngSeedManager::GetGenerator (), generator, "Generator not set");
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          bool antithetic = j == 1;
+          Ptr<UniformRandomVariable> u1 = CreateObject<UniformRandomVariable> ();
+          Ptr<UniformRandomVariable> u2 = CreateObject<UniformRandomVariable> ();
+          u1->SetAttribute ("Min", DoubleValue (2.0));
+          u1->SetAttribute ("Max", DoubleValue (5.0));
+          u2->SetAttribute ("Min", DoubleValue (2.0));
+          u2->SetAttribute ("Max", DoubleValue (5.0));
+          u1->SetAttribute ("Antithetic", BooleanValue (antithetic));
+          u2->SetAttribute ("Antithetic", BooleanValue (antithetic));
+          Check (u1, u2, "uniform");
+
+          // a low bound, so that values are often drawn again.
+          Ptr<ExponentialRandomVariable> e1 = CreateObject<ExponentialRandomVariable> ();
+          Ptr<ExponentialRandomVariable> e2 = CreateObject<ExponentialRandomVariable> ();
+          e1->SetAttribute ("Bound", DoubleValue (1.0));
+          e2->SetAttribute ("Bound", DoubleValue (1.0));
+          e1->SetAttribute ("Antithetic", BooleanValue (antithetic));
+          e2->SetAttribute ("Antithetic", BooleanValue (antithetic));
+          Check (e1, e2, "exponential");
+
+          // the default implementation.
+          Ptr<NormalRandomVariable> n1 = CreateObject<NormalRandomVariable> ();
+          Ptr<NormalRandomVariable> n2 = CreateObject<NormalRandomVariable> ();
+          n1->SetAttribute ("Antithetic", BooleanValue (antithetic));
+          n2->SetAttribute ("Antithetic", BooleanValue (antithetic));
+          Check (n1, n2, "normal");
+        }
+    }
+  RngSeedManager::SetGenerator (RngStream::MRG32K3A);
+}
+
+// ===========================================================================
+// Check the frequencies of the values drawn from the Zipf alias tables
+// ===========================================================================
+
+class ZipfAliasTableTestCase : public TestCase
+{
+public:
+  ZipfAliasTableTestCase ();
+  virtual void DoRun (void);
+private:
+  void Check (Ptr<ZipfRandomVariable> x, uint32_t n, double alpha, bool attributes);
+};
+
+static const uint32_t N_DRAWS = 200000;
+
+ZipfAliasTableTestCase::ZipfAliasTableTestCase ()
+  : TestCase ("Check that Zipf values are drawn with frequencies proportional to k^-alpha")
+{
+}
+
+void
+ZipfAliasTableTestCase::Check (Ptr<ZipfRandomVariable> x, uint32_t n, double alpha, bool attributes)
+{
+  std::vector<uint32_t> counts (n + 1, 0);
+  for (uint32_t i = 0; i < N_DRAWS; i++)
+    {
+      uint32_t value = attributes ? x->GetInteger () : x->GetInteger (n, alpha);
+      NS_TEST_ASSERT_MSG_EQ ((value >= 1 && value <= n), true,
+                             "Zipf value " << value << " outside of [1, " << n << "]");
+      counts[value]++;
+    }
+  double h = 0;
+  for (uint32_t k = 1; k <= n; k++)
+    {
+      h += std::pow (k, -alpha);
+    }
+  for (uint32_t k = 1; k <= n; k++)
+    {
+      double frequency = static_cast<double> (counts[k]) / N_DRAWS;
+      double expected = std::pow (k, -alpha) / h;
+      NS_TEST_EXPECT_MSG_EQ_TOL (frequency, expected, 5e-3,
+                                 "Wrong frequency of rank " << k << " for N=" << n << " alpha=" << alpha);
+    }
+}
+
+void
+ZipfAliasTableTestCase::DoRun (void)
+{
+  Ptr<ZipfRandomVariable> x = CreateObject<ZipfRandomVariable> ();
+  x->SetStream (7);
+  x->SetAttribute ("N", IntegerValue (10));
+  x->SetAttribute ("Alpha", DoubleValue (1.0));
+  Check (x, 10, 1.0, true);
+  // the table is rebuilt from the arguments, not the attributes.
+  Check (x, 5, 2.0, false);
+  // and again from the attributes.
+  x->SetAttribute ("N", IntegerValue (20));
+  x->SetAttribute ("Alpha", DoubleValue (0.5));
+  Check (x, 20, 0.5, true);
+}
+
+// ===========================================================================
+// Check the mean of Empirical values drawn through the guide table
+// ===========================================================================
+
+class EmpiricalGuideTableTestCase : public TestCase
+{
+public:
+  EmpiricalGuideTableTestCase ();
+  virtual void DoRun (void);
+};
+
+EmpiricalGuideTableTestCase::EmpiricalGuideTableTestCase ()
+  : TestCase ("Check the mean of interpolated Empirical values with many points")
+{
+}
+
+void
+EmpiricalGuideTableTestCase::DoRun (void)
+{
+  // points of irregular probabilities, several of which fall into the
+  // same interval of the guide table, and some steps of the CDF.
+  Ptr<EmpiricalRandomVariable> x = CreateObject<EmpiricalRandomVariable> ();
+  x->SetStream (7);
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  double cdf = 0.1;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      values.push_back (i * i);
+      cdfs.push_back (cdf);
+      x->CDF (i * i, cdf);
+      if (i % 10 == 0)
+        {
+          x->CDF (i * i, cdf + 0.02);
+          values.push_back (i * i);
+          cdfs.push_back (cdf + 0.02);
+          cdf += 0.02;
+        }
+      cdf += (i % 3) * 0.7 / 100;
+    }
+
+  // the mean of each segment weighted by its probability, plus the
+  // first and last points weighted by the probability outside of them.
+  double expectedMean = cdfs.front () * values.front () + (1 - cdfs.back ()) * values.back ();
+  for (uint32_t i = 1; i < values.size (); i++)
+    {
+      expectedMean += (cdfs[i] - cdfs[i - 1]) * (values[i - 1] + values[i]) / 2;
+    }
+
+  double sum = 0;
+  for (uint32_t i = 0; i < N_DRAWS; i++)
+    {
+      double value = x->GetValue ();
+      NS_TEST_ASSERT_MSG_EQ ((value >= values.front () && value <= values.back ()), true,
+                             "Value " << value << " outside of the points");
+      sum += value;
+    }
+  double mean = sum / N_DRAWS;
+  NS_TEST_EXPECT_MSG_EQ_TOL (mean, expectedMean, expectedMean * 1e-2, "Wrong mean value");
+}
+
+// ===========================================================================
+// Check the frequencies of discrete Empirical values drawn from the alias
+// table
+// ===========================================================================
+
+class EmpiricalAliasTableTestCase : public TestCase
+{
+public:
+  EmpiricalAliasTableTestCase ();
+  virtual void DoRun (void);
+};
+
+EmpiricalAliasTableTestCase::EmpiricalAliasTableTestCase ()
+  : TestCase ("Check the frequencies of Empirical values without interpolation")
+{
+}
+
+void
+EmpiricalAliasTableTestCase::DoRun (void)
+{
+  // 1, 2, 4 and 8 with the probabilities 0.2, 0.3, 0 and 0.5.
+  Ptr<EmpiricalRandomVariable> x = CreateObject<EmpiricalRandomVariable> ();
+  x->SetStream (7);
+  x->SetAttribute ("Interpolate", BooleanValue (false));
+  x->CDF (1.0, 0.2);
+  x->CDF (2.0, 0.5);
+  x->CDF (4.0, 0.5);
+  x->CDF (8.0, 1.0);
+
+  uint32_t counts[9] = { 0 };
+  for (uint32_t i = 0; i < N_DRAWS; i++)
+    {
+      double value = x->GetValue ();
+      NS_TEST_ASSERT_MSG_EQ ((value == 1.0 || value == 2.0 || value == 8.0), true,
+                             "Unexpected value " << value);
+      counts[static_cast<uint32_t> (value)]++;
+    }
+  double f1 = static_cast<double> (counts[1]) / N_DRAWS;
+  double f2 = static_cast<double> (counts[2]) / N_DRAWS;
+  double f8 = static_cast<double> (counts[8]) / N_DRAWS;
+  NS_TEST_EXPECT_MSG_EQ_TOL (f1, 0.2, 5e-3, "Wrong frequency of 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (f2, 0.3, 5e-3, "Wrong frequency of 2");
+  NS_TEST_EXPECT_MSG_EQ_TOL (f8, 0.5, 5e-3, "Wrong frequency of 8");
+
+  // interpolating again returns values between the points.
+  x->SetAttribute ("Interpolate", BooleanValue (true));
+  bool interpolated = false;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      double value = x->GetValue ();
+      interpolated |= (value != 1.0 && value != 2.0 && value != 8.0);
+    }
+  NS_TEST_EXPECT_MSG_EQ (interpolated, true, "Values are not interpolated");
+}
+
+class RngStreamTestSuite : public TestSuite
+{
+public:
+  RngStreamTestSuite ()
+    : TestSuite ("rng-stream")
+  {
+    AddTestCase (new PhiloxKnownAnswerTestCase (), TestCase::QUICK);
+    AddTestCase (new RngStreamBatchTestCase (), TestCase::QUICK);
+    AddTestCase (new RandomVariableGetValuesTestCase (), TestCase::QUICK);
+    AddTestCase (new ZipfAliasTableTestCase (), TestCase::QUICK);
+    AddTestCase (new EmpiricalGuideTableTestCase (), TestCase::QUICK);
+    AddTestCase (new EmpiricalAliasTableTestCase (), TestCase::QUICK);
+  }
+} g_rngStreamTestSuite;
+
+// ===========================================================================
+// Time the generation of uniform values
+// ===========================================================================
+
+class RngStreamTimeTestCase : public TestCase
+{
+public:
+  RngStreamTimeTestCase ();
+  virtual void DoRun (void);
+private:
+  static void Report (const char *name, clock_t start, clock_t stop);
+};
+
+static const uint32_t BATCH = 1000;
+static const uint32_t BATCHES = 20000;
+
+RngStreamTimeTestCase::RngStreamTimeTestCase ()
+  : TestCase ("Time the generation of uniform values")
+{
+}
+
+void
+RngStreamTimeTestCase::Report (const char *name, clock_t start, clock_t stop)
+{
+  std::cout << name << 1e9 * (stop - start) / CLOCKS_PER_SEC / BATCH / BATCHES << " ns/value" << std::endl;
+}
+
+void
+RngStreamTimeTestCase::DoRun (void)
+{
+  std::vector<double> values (BATCH);
+  double sum = 0;
+
+  std::cout << GetName () << std::endl;
+  for (uint32_t g = 0; g < 2; g++)
+    {
+      enum RngStream::Generator generator = g == 0 ? RngStream::MRG32K3A : RngStream::PHILOX;
+      std::cout << (g == 0 ? "MRG32k3a" : "Philox") << std::endl;
+      RngSeedManager::SetGenerator (generator);
+      Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+
+      clock_t start = clock ();
+      for (uint32_t i = 0; i < BATCHES; i++)
+        {
+          for (uint32_t j = 0; j < BATCH; j++)
+            {
+              values[j] = uniform->GetValue ();
+            }
+          sum += values[BATCH - 1];
+        }
+      clock_t stop = clock ();
+      Report ("  GetValue:      ", start, stop);
+
+      start = clock ();
+      for (uint32_t i = 0; i < BATCHES; i++)
+        {
+          uniform->GetValues (&values[0], BATCH);
+          sum += values[BATCH - 1];
+        }
+      stop = clock ();
+      Report ("  GetValues:     ", start, stop);
+
+      RngStream stream (1, 0, 1, generator);
+      start = clock ();
+      for (uint32_t i = 0; i < BATCHES; i++)
+        {
+          stream.RandU01 (&values[0], BATCH);
+          sum += values[BATCH - 1];
+        }
+      stop = clock ();
+      Report ("  RandU01 batch: ", start, stop);
+    }
+  RngSeedManager::SetGenerator (RngStream::MRG32K3A);
+  NS_TEST_EXPECT_MSG_GT (sum, 0.0, "No value generated");
+}
+
+// ===========================================================================
+// Time the generation of values drawn from the Zipf and Empirical tables
+// ===========================================================================
+
+class RandomVariableTableTimeTestCase : public TestCase
+{
+public:
+  RandomVariableTableTimeTestCase ();
+  virtual void DoRun (void);
+private:
+  static double TimeValues (const char *name, Ptr<RandomVariableStream> x);
+};
+
+RandomVariableTableTimeTestCase::RandomVariableTableTimeTestCase ()
+  : TestCase ("Time the generation of Zipf and Empirical values")
+{
+}
+
+double
+RandomVariableTableTimeTestCase::TimeValues (const char *name, Ptr<RandomVariableStream> x)
+{
+  // the first value builds the table.
+  double sum = x->GetValue ();
+  clock_t start = clock ();
+  for (uint32_t i = 0; i < BATCHES * BATCH / 2; i++)
+    {
+      sum += x->GetValue ();
+    }
+  clock_t stop = clock ();
+  std::cout << name << 1e9 * (stop - start) / CLOCKS_PER_SEC / (BATCHES * BATCH / 2) << " ns/value" << std::endl;
+  return sum;
+}
+
+void
+RandomVariableTableTimeTestCase::DoRun (void)
+{
+  std::cout << GetName () << std::endl;
+
+  Ptr<ZipfRandomVariable> zipf = CreateObject<ZipfRandomVariable> ();
+  zipf->SetAttribute ("N", IntegerValue (1000));
+  zipf->SetAttribute ("Alpha", DoubleValue (1.0));
+  double sum = TimeValues ("  zipf:                   ", zipf);
+
+  Ptr<EmpiricalRandomVariable> empirical = CreateObject<EmpiricalRandomVariable> ();
+  for (uint32_t i = 1; i <= 1000; i++)
+    {
+      empirical->CDF (i, std::pow (i / 1000.0, 3));
+    }
+  sum += TimeValues ("  empirical interpolated: ", empirical);
+  empirical->SetAttribute ("Interpolate", BooleanValue (false));
+  sum += TimeValues ("  empirical discrete:     ", empirical);
+
+  NS_TEST_EXPECT_MSG_GT (sum, 0.0, "No value generated");
+}
+
+class RngStreamPerformanceSuite : public TestSuite
+{
+public:
+  RngStreamPerformanceSuite ()
+    : TestSuite ("rng-stream-perf", PERFORMANCE)
+  {
+    AddTestCase (new RngStreamTimeTestCase (), TestCase::QUICK);
+    AddTestCase (new RandomVariableTableTimeTestCase (), TestCase::QUICK);
+  }
+} g_rngStreamPerformanceSuite;
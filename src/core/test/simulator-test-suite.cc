@@ -19,10 +19,19 @@
  */
 #include "ns3/test.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/event-impl.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include <map>
+#include <vector>
 
 using namespace ns3;
 
@@ -459,6 +468,276 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  uint64_t NextDelay (void);
+  uint32_t m_seed;
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that many events are dequeued in order with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_seed (1),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+uint64_t
+SchedulerOrderTestCase::NextDelay (void)
+{
+  // a simple deterministic LCG with a mix of short and long delays.
+  m_seed = m_seed * 1103515245 + 12345;
+  uint32_t v = (m_seed >> 8) & 0xffff;
+  if (v & 1)
+    {
+      return v % 8;
+    }
+  return v * 1000;
+}
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::map<uint32_t, Scheduler::Event> pending;
+  uint32_t uid = 0;
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Scheduler::Event ev = { 0, { NextDelay (), uid++, 0}};
+      scheduler->Insert (ev);
+      pending[ev.key.m_uid] = ev;
+    }
+  Scheduler::EventKey last = { 0, 0, 0};
+  bool ordered = true;
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      Scheduler::Event next = scheduler->PeekNext ();
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, ev.key.m_uid, "PeekNext and RemoveNext disagree");
+      ordered = ordered && !(ev.key < last);
+      last = ev.key;
+      pending.erase (ev.key.m_uid);
+      Scheduler::Event n1 = { 0, { ev.key.m_ts + NextDelay (), uid++, 0}};
+      scheduler->Insert (n1);
+      pending[n1.key.m_uid] = n1;
+      if (i % 7 == 0)
+        {
+          Scheduler::Event n2 = { 0, { ev.key.m_ts + NextDelay (), uid++, 0}};
+          scheduler->Insert (n2);
+          pending[n2.key.m_uid] = n2;
+        }
+      if (i % 5 == 0)
+        {
+          std::map<uint32_t, Scheduler::Event>::iterator victim = pending.lower_bound (m_seed % uid);
+          if (victim != pending.end ())
+            {
+              scheduler->Remove (victim->second);
+              pending.erase (victim);
+            }
+        }
+    }
+  while (!scheduler->IsEmpty ())
+    {
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      ordered = ordered && !(ev.key < last);
+      last = ev.key;
+      NS_TEST_ASSERT_MSG_EQ (pending.erase (ev.key.m_uid), 1, "Unknown event dequeued");
+    }
+  NS_TEST_EXPECT_MSG_EQ (ordered, true, "Events were not dequeued in order");
+  NS_TEST_EXPECT_MSG_EQ (pending.size (), 0, "Events were lost");
+}
+
+class SimulatorEventMemoryTestCase : public TestCase
+{
+public:
+  SimulatorEventMemoryTestCase ();
+  virtual void DoRun (void);
+  void Event (uint64_t a, uint64_t b, uint64_t c);
+};
+
+SimulatorEventMemoryTestCase::SimulatorEventMemoryTestCase ()
+  : TestCase ("Check the accounting of event memory")
+{
+}
+void
+SimulatorEventMemoryTestCase::Event (uint64_t a, uint64_t b, uint64_t c)
+{
+}
+void
+SimulatorEventMemoryTestCase::DoRun (void)
+{
+  uint64_t before = Simulator::GetEventMemoryInUse ();
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorEventMemoryTestCase::Event, this, i, i, i);
+    }
+  uint64_t during = Simulator::GetEventMemoryInUse ();
+  NS_TEST_EXPECT_MSG_EQ ((during >= before + 1000 * (sizeof (EventImpl) + 3 * sizeof (uint64_t))), true,
+                         "Bound arguments are not accounted for");
+  NS_TEST_EXPECT_MSG_EQ ((Simulator::GetEventMemoryPeak () >= during), true, "Peak below current usage");
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventMemoryInUse (), before, "Event memory was not released");
+}
+
+class SimulatorPurgeTestCase : public TestCase
+{
+public:
+  SimulatorPurgeTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Event (uint32_t i);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_invoked;
+  bool m_ordered;
+  Time m_last;
+};
+
+SimulatorPurgeTestCase::SimulatorPurgeTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that cancelled events are purged with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+void
+SimulatorPurgeTestCase::Event (uint32_t i)
+{
+  m_ordered = m_ordered && i % 4 == 0 && Simulator::Now () >= m_last;
+  m_last = Simulator::Now ();
+  m_invoked++;
+}
+void
+SimulatorPurgeTestCase::DoRun (void)
+{
+  m_invoked = 0;
+  m_ordered = true;
+  m_last = Seconds (0);
+  Simulator::SetScheduler (m_schedulerFactory);
+  Simulator::GetImplementation ()->SetAttribute ("CancelledPurgeRatio", DoubleValue (1.0));
+  Simulator::GetImplementation ()->SetAttribute ("CancelledPurgeMinimum", UintegerValue (100));
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds ((i * 7919) % 5000), &SimulatorPurgeTestCase::Event, this, i));
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 2000, "Scheduled events were not counted");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetPeakEventCount (), 2000, "Peak below current occupancy");
+  uint64_t memory = Simulator::GetEventMemoryInUse ();
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      if (i % 4 != 0)
+        {
+          Simulator::Cancel (ids[i]);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 500, "Cancelled events were counted as live");
+  NS_TEST_EXPECT_MSG_EQ ((Simulator::GetCancelledEventCount () < 1000), true, "Cancelled events were not purged");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetPeakEventCount (), 2000, "Peak decreased");
+  ids.clear ();
+  NS_TEST_EXPECT_MSG_EQ ((Simulator::GetEventMemoryInUse () < memory), true, "Purged events were not released");
+
+  // events cancelled without Simulator::Cancel are not counted, neither
+  // when they are cancelled nor when they expire.
+  Simulator::GetImplementation ()->SetAttribute ("CancelledPurgeRatio", DoubleValue (0.0));
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorPurgeTestCase::Event, this, 1).PeekEventImpl ()->Cancel ();
+    }
+  Simulator::Cancel (Simulator::Schedule (Seconds (1.0), &SimulatorPurgeTestCase::Event, this, 1));
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 600, "Events cancelled directly were not counted as live");
+  Simulator::Stop (MilliSeconds (5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetCancelledEventCount (), 1, "Expired events cancelled directly were uncounted");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 0, "Live events left after Run");
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_invoked, 500, "Live events were lost");
+  NS_TEST_EXPECT_MSG_EQ (m_ordered, true, "Events were not invoked in order");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 0, "Events left after Run");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetCancelledEventCount (), 0, "Cancelled events left after Run");
+  Simulator::Destroy ();
+}
+
+class SimulatorForkTestCase : public TestCase
+{
+public:
+  SimulatorForkTestCase ();
+  virtual void DoRun (void);
+  void Tick (void);
+  void Configure (uint32_t variant);
+  int Finish (uint32_t variant);
+  uint32_t m_ticks;
+  uint32_t m_variant;
+  uint64_t m_run;
+  Ptr<UniformRandomVariable> m_rng;
+};
+
+SimulatorForkTestCase::SimulatorForkTestCase ()
+  : TestCase ("Check that simulation variants can be forked after a warm-up")
+{
+}
+void
+SimulatorForkTestCase::Tick (void)
+{
+  m_ticks++;
+  m_rng->GetValue ();
+  if (m_ticks < 10)
+    {
+      Simulator::Schedule (Seconds (1.0), &SimulatorForkTestCase::Tick, this);
+    }
+}
+void
+SimulatorForkTestCase::Configure (uint32_t variant)
+{
+  m_variant = variant;
+  RngSeedManager::SetRun (100 + variant);
+}
+int
+SimulatorForkTestCase::Finish (uint32_t variant)
+{
+  // the stream of each variant restarts from the beginning of the
+  // substream of its run, and was used once per tick after the fork.
+  uint32_t value = m_rng->GetInteger (0, 1000000);
+  Ptr<UniformRandomVariable> fresh = CreateObject<UniformRandomVariable> ();
+  fresh->SetStream (3);
+  for (uint32_t i = 5; i < m_ticks; i++)
+    {
+      fresh->GetValue ();
+    }
+  bool reseeded = value == fresh->GetInteger (0, 1000000);
+  bool complete = m_ticks == 10 && Simulator::Now () == Seconds (9.0);
+  return (variant == m_variant && reseeded && complete) ? 10 + variant : 1;
+}
+void
+SimulatorForkTestCase::DoRun (void)
+{
+  m_ticks = 0;
+  m_variant = 0xffffffff;
+  m_run = RngSeedManager::GetRun ();
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_rng->SetStream (3);
+  Simulator::Schedule (Seconds (0.0), &SimulatorForkTestCase::Tick, this);
+
+  std::vector<int> status = Simulator::ForkVariants (Seconds (4.5), 3,
+                                                     MakeCallback (&SimulatorForkTestCase::Configure, this),
+                                                     MakeCallback (&SimulatorForkTestCase::Finish, this));
+  NS_TEST_ASSERT_MSG_EQ (status.size (), 3, "Wrong number of variants");
+  for (uint32_t i = 0; i < status.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (status[i], 10 + (int)i, "Variant " << i << " failed");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_ticks, 5, "Warm-up was not run in the parent");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (4.5), "Parent was not paused");
+  NS_TEST_EXPECT_MSG_EQ (m_variant, 0xffffffff, "Variant configured in the parent");
+  NS_TEST_EXPECT_MSG_EQ (RngSeedManager::GetRun (), m_run, "Run number changed in the parent");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_ticks, 10, "Parent cannot be resumed");
+  Simulator::Destroy ();
+  m_rng = 0;
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +754,32 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new SimulatorEventMemoryTestCase (), TestCase::QUICK);
+    AddTestCase (new SimulatorForkTestCase (), TestCase::QUICK);
+
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SimulatorPurgeTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorPurgeTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorPurgeTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorPurgeTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorPurgeTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -26,10 +26,13 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/make-event.h"
 
 #include <ctime>
 #include <list>
+#include <set>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -225,6 +228,129 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+class ThreadedEventMemoryTestCase : public TestCase
+{
+public:
+  ThreadedEventMemoryTestCase ();
+  static void Nothing (uint32_t i);
+  void Allocate (void);
+  std::vector<EventImpl *> m_events;
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedEventMemoryTestCase::ThreadedEventMemoryTestCase ()
+  : TestCase ("Check the accounting of event memory across threads")
+{
+}
+void
+ThreadedEventMemoryTestCase::Nothing (uint32_t i)
+{
+}
+void
+ThreadedEventMemoryTestCase::Allocate (void)
+{
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      EventImpl *event = MakeEvent (&ThreadedEventMemoryTestCase::Nothing, i);
+      if (i % 2 == 0)
+        {
+          m_events.push_back (event);
+        }
+      else
+        {
+          event->Unref ();
+        }
+    }
+}
+void
+ThreadedEventMemoryTestCase::DoRun (void)
+{
+  uint64_t before = Simulator::GetEventMemoryInUse ();
+  // the events are released by the main thread, after the thread which
+  // allocated them exits.
+  for (uint32_t i = 0; i < 20; ++i)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeCallback (&ThreadedEventMemoryTestCase::Allocate, this));
+      thread->Start ();
+      thread->Join ();
+      uint64_t during = Simulator::GetEventMemoryInUse ();
+      NS_TEST_EXPECT_MSG_EQ ((during > before), true, "Memory of live events is not accounted for");
+      uint64_t peak = Simulator::GetEventMemoryPeak ();
+      NS_TEST_EXPECT_MSG_EQ ((peak >= during), true, "Peak below current usage");
+      for (std::vector<EventImpl *>::iterator j = m_events.begin (); j != m_events.end (); ++j)
+        {
+          (*j)->Unref ();
+        }
+      m_events.clear ();
+      uint64_t after = Simulator::GetEventMemoryInUse ();
+      NS_TEST_EXPECT_MSG_EQ (after, before, "Event memory was not released");
+    }
+}
+
+class ThreadedEventOwnerTestCase : public TestCase
+{
+public:
+  ThreadedEventOwnerTestCase ();
+  static void Nothing (uint32_t i);
+  void Allocate (void);
+  std::vector<EventImpl *> m_events;
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedEventOwnerTestCase::ThreadedEventOwnerTestCase ()
+  : TestCase ("Check that events released by another thread return to their owner")
+{
+}
+void
+ThreadedEventOwnerTestCase::Nothing (uint32_t i)
+{
+}
+void
+ThreadedEventOwnerTestCase::Allocate (void)
+{
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      m_events.push_back (MakeEvent (&ThreadedEventOwnerTestCase::Nothing, i));
+    }
+}
+void
+ThreadedEventOwnerTestCase::DoRun (void)
+{
+  Ptr<SystemThread> thread =
+    Create<SystemThread> (MakeCallback (&ThreadedEventOwnerTestCase::Allocate, this));
+  thread->Start ();
+  thread->Join ();
+  std::set<EventImpl *> remote (m_events.begin (), m_events.end ());
+  for (std::vector<EventImpl *>::const_iterator i = m_events.begin (); i != m_events.end (); ++i)
+    {
+      (*i)->Unref ();
+    }
+  m_events.clear ();
+  // the blocks released above belong to the thread which allocated them,
+  // and must not be reused by this thread.
+  uint32_t reused = 0;
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      EventImpl *event = MakeEvent (&ThreadedEventOwnerTestCase::Nothing, i);
+      if (remote.find (event) != remote.end ())
+        {
+          reused++;
+        }
+      m_events.push_back (event);
+    }
+  for (std::vector<EventImpl *>::const_iterator i = m_events.begin (); i != m_events.end (); ++i)
+    {
+      (*i)->Unref ();
+    }
+  m_events.clear ();
+  NS_TEST_EXPECT_MSG_EQ (reused, 0, "Blocks of another thread were reused");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -241,7 +367,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +389,7 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedEventMemoryTestCase (), TestCase::QUICK);
+    AddTestCase (new ThreadedEventOwnerTestCase (), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
@@ -134,6 +134,37 @@ TimesWithSignsTestCase::DoTeardown (void)
 {
 }
 
+class TimeFromDoubleTestCase : public TestCase
+{
+public:
+  TimeFromDoubleTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TimeFromDoubleTestCase::TimeFromDoubleTestCase ()
+  : TestCase ("Checks that whole and fractional doubles convert as int64x64_t values")
+{
+}
+
+void
+TimeFromDoubleTestCase::DoRun (void)
+{
+  double values[] = { 0.0, 1.0, -1.0, 2.0, 5.0, 1000.0, -86400.0, 1000000.0,
+                      0.5, 1.25, -0.001, 1e-9 };
+  Time::Unit units[] = { Time::S, Time::MS, Time::US, Time::NS, Time::PS, Time::FS };
+  for (uint32_t i = 0; i < sizeof (values) / sizeof (values[0]); i++)
+    {
+      for (uint32_t j = 0; j < sizeof (units) / sizeof (units[0]); j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (Time::FromDouble (values[i], units[j]).GetTimeStep (),
+                                 Time::From (int64x64_t (values[i]), units[j]).GetTimeStep (),
+                                 "Wrong conversion of " << values[i] << " in unit " << j);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (Seconds (2.0), NanoSeconds (2000000000), "Wrong seconds");
+}
+
 static class TimeTestSuite : public TestSuite
 {
 public:
@@ -142,5 +173,6 @@ public:
   {
     AddTestCase (new TimeSimpleTestCase (), TestCase::QUICK);
     AddTestCase (new TimesWithSignsTestCase (), TestCase::QUICK);
+    AddTestCase (new TimeFromDoubleTestCase (), TestCase::QUICK);
   }
 } g_timeTestSuite;
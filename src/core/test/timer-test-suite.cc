@@ -18,9 +18,12 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "ns3/timer.h"
+#include "ns3/timer-wheel.h"
+#include "ns3/make-event.h"
 #include "ns3/test.h"
 #include "ns3/simulator.h"
 #include "ns3/nstime.h"
+#include <vector>
 
 namespace {
 void bari (int)
@@ -208,6 +211,101 @@ TimerTemplateTestCase::DoTeardown (void)
   Simulator::Destroy ();
 }
 
+class TimerWheelTestCase : public TestCase
+{
+public:
+  TimerWheelTestCase ();
+  virtual void DoRun (void);
+  void Expire (Time expected);
+  static TypeId GetOwnerTypeId (void);
+  uint32_t m_fired;
+};
+
+TimerWheelTestCase::TimerWheelTestCase ()
+  : TestCase ("Check that timers held in the timer wheel expire on time")
+{
+}
+
+TypeId
+TimerWheelTestCase::GetOwnerTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TimerWheelTestOwner")
+    .HideFromDocumentation ()
+  ;
+  return tid;
+}
+
+void
+TimerWheelTestCase::Expire (Time expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), expected, "timer expired at the wrong time");
+  m_fired++;
+}
+
+void
+TimerWheelTestCase::DoRun (void)
+{
+  TypeId owner = GetOwnerTypeId ();
+  TimerWheel::Statistics before = TimerWheel::GetStatistics (owner);
+  m_fired = 0;
+
+  // within a tick, on each level of the wheel, and beyond it
+  Time delays[] = { NanoSeconds (10), MicroSeconds (1500), MilliSeconds (63),
+                    MilliSeconds (64), MilliSeconds (4097), Seconds (100),
+                    Seconds (36000) };
+  const uint32_t n = sizeof (delays) / sizeof (delays[0]);
+  std::vector<TimerWheel::Entry *> entries;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      TimerWheel::Entry *entry = new TimerWheel::Entry (owner);
+      entry->Arm (delays[i], Ptr<EventImpl> (MakeEvent (&TimerWheelTestCase::Expire, this, delays[i]), false));
+      NS_TEST_EXPECT_MSG_EQ (entry->IsRunning (), true, "armed timer is running");
+      NS_TEST_EXPECT_MSG_EQ (entry->GetDelayLeft (), delays[i], "delay left");
+      entries.push_back (entry);
+    }
+
+  // a timer re-armed many times before it expires
+  TimerWheel::Entry rearmed (owner);
+  for (uint32_t i = 1; i <= 100; i++)
+    {
+      Time delay = MilliSeconds (10 * i);
+      rearmed.Arm (delay, Ptr<EventImpl> (MakeEvent (&TimerWheelTestCase::Expire, this, delay), false));
+    }
+  // and a timer cancelled before it expires
+  TimerWheel::Entry cancelled (owner);
+  cancelled.Arm (Seconds (2), Ptr<EventImpl> (MakeEvent (&TimerWheelTestCase::Expire, this, Seconds (2)), false));
+  cancelled.Cancel ();
+  NS_TEST_EXPECT_MSG_EQ (cancelled.IsRunning (), false, "cancelled timer is not running");
+
+  // a Timer which uses the wheel
+  Timer timer (Timer::CANCEL_ON_DESTROY);
+  timer.UseWheel (owner);
+  timer.SetFunction (&TimerWheelTestCase::Expire, this);
+  timer.SetArguments (Seconds (7));
+  timer.Schedule (Seconds (3));
+  NS_TEST_EXPECT_MSG_EQ (timer.GetState (), Timer::RUNNING, "");
+  timer.Suspend ();
+  NS_TEST_EXPECT_MSG_EQ (timer.GetState (), Timer::SUSPENDED, "");
+  Simulator::Schedule (Seconds (4), &Timer::Resume, &timer);
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_fired, n + 2, "all timers expired");
+  NS_TEST_EXPECT_MSG_EQ (timer.GetState (), Timer::EXPIRED, "");
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (entries[i]->IsRunning (), false, "expired timer is not running");
+      delete entries[i];
+    }
+  TimerWheel::Statistics after = TimerWheel::GetStatistics (owner);
+  NS_TEST_EXPECT_MSG_EQ (after.armed - before.armed, n + 100 + 1 + 2, "armed timers");
+  NS_TEST_EXPECT_MSG_EQ (after.cancelled - before.cancelled, 99 + 1 + 1, "cancelled timers");
+  NS_TEST_EXPECT_MSG_EQ (after.fired - before.fired, n + 2, "expired timers");
+  NS_TEST_EXPECT_MSG_EQ (after.scheduled - before.scheduled, n + 2, "only expiring timers are scheduled");
+
+  Simulator::Destroy ();
+}
+
 static class TimerTestSuite : public TestSuite
 {
 public:
@@ -216,5 +314,6 @@ public:
   {
     AddTestCase (new TimerStateTestCase (), TestCase::QUICK);
     AddTestCase (new TimerTemplateTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerWheelTestCase (), TestCase::QUICK);
   }
 } g_timerTestSuite;
@@ -108,6 +108,100 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+class ReentrantTracedCallbackTestCase : public TestCase
+{
+public:
+  ReentrantTracedCallbackTestCase ();
+  virtual ~ReentrantTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void CbConnect (uint32_t a);
+  void CbCount (uint32_t a);
+  static void CbBound (ReentrantTracedCallbackTestCase *test, uint64_t const &tag, uint32_t a);
+
+  TracedCallback<uint32_t> m_trace;
+  uint32_t m_count;
+  uint64_t m_tag;
+};
+
+ReentrantTracedCallbackTestCase::ReentrantTracedCallbackTestCase ()
+  : TestCase ("Check TracedCallback sinks which connect other sinks")
+{
+}
+
+void
+ReentrantTracedCallbackTestCase::CbConnect (uint32_t a)
+{
+  // enough sinks to force the chain to grow while it is invoked.
+  for (uint32_t i = 0; i < a; i++)
+    {
+      m_trace.ConnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::CbCount, this));
+    }
+}
+
+void
+ReentrantTracedCallbackTestCase::CbCount (uint32_t a)
+{
+  m_count++;
+}
+
+void
+ReentrantTracedCallbackTestCase::CbBound (ReentrantTracedCallbackTestCase *test, uint64_t const &tag, uint32_t a)
+{
+  // the bound argument is referenced in the sink while the chain grows
+  test->CbConnect (a);
+  test->m_tag = tag;
+}
+
+void
+ReentrantTracedCallbackTestCase::DoRun (void)
+{
+  //
+  // The sinks connected while the trace is invoked are called by the
+  // same invocation, as they are appended to the chain.
+  //
+  m_count = 0;
+  m_trace.ConnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::CbConnect, this));
+  m_trace (100);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 100, "New sinks not called");
+
+  //
+  // Disconnecting a sink removes all its connections.
+  //
+  m_trace.DisconnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::CbConnect, this));
+  m_count = 0;
+  m_trace (100);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 100, "Wrong number of sinks called");
+  m_trace.DisconnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::CbCount, this));
+  m_count = 0;
+  m_trace (100);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 0, "Disconnected sinks called");
+
+  //
+  // The bound arguments of a sink remain valid while it connects sinks.
+  //
+  TracedCallback<uint32_t> trace;
+  m_trace = trace;
+  m_tag = 0;
+  m_trace.ConnectWithoutContext (MakeBoundCallback (&ReentrantTracedCallbackTestCase::CbBound, this, 0x123456789aULL));
+  m_trace (100);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 100, "New sinks not called");
+  NS_TEST_ASSERT_MSG_EQ (m_tag, 0x123456789aULL, "Bound argument of the sink destroyed");
+  m_count = 0;
+
+#ifndef NS3_OPTIONAL_TRACES_DISABLE
+  //
+  // Unless they are compiled out, optional trace sources work the same.
+  //
+  OptionalTracedCallback<uint32_t> optional;
+  optional.ConnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::CbCount, this));
+  optional (1);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Optional trace source not called");
+#endif /* NS3_OPTIONAL_TRACES_DISABLE */
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -118,6 +212,7 @@ TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new ReentrantTracedCallbackTestCase, TestCase::QUICK);
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
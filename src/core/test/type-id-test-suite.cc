@@ -25,6 +25,8 @@
 #include "ns3/type-id.h"
 #include "ns3/test.h"
 #include "ns3/log.h"
+#include "ns3/object-base.h"
+#include "ns3/uinteger.h"
 
 using namespace std;
 
@@ -110,6 +112,88 @@ UniqueTypeIdTestCase::DoRun (void)
 }
 
 
+//----------------------------
+//
+// Inherited attribute and trace source lookup
+
+class InheritedLookupTestCase : public TestCase
+{
+public:
+  InheritedLookupTestCase ();
+  virtual ~InheritedLookupTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+InheritedLookupTestCase::InheritedLookupTestCase ()
+  : TestCase ("Check the lookup of inherited attributes and trace sources")
+{
+}
+
+InheritedLookupTestCase::~InheritedLookupTestCase ()
+{
+}
+
+void
+InheritedLookupTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < TypeId::GetRegisteredN (); i++)
+    {
+      TypeId tid = TypeId::GetRegistered (i);
+      uint32_t n = 0;
+      TypeId tmp = tid;
+      while (true)
+        {
+          for (uint32_t j = 0; j < tmp.GetAttributeN (); j++)
+            {
+              std::string name = tmp.GetAttribute (j).name;
+              NS_TEST_ASSERT_MSG_LT (n, tid.GetFlatAttributeN (),
+                                     "Missing attributes in " << tid.GetName ());
+              TypeId owner;
+              const struct TypeId::AttributeInformation &info = tid.GetFlatAttribute (n, &owner);
+              NS_TEST_ASSERT_MSG_EQ (owner, tmp, "Wrong owner of " << name << " in " << tid.GetName ());
+              NS_TEST_ASSERT_MSG_EQ (info.name, name, "Wrong attribute in " << tid.GetName ());
+              NS_TEST_ASSERT_MSG_EQ (tid.FindAttribute (name), &info,
+                                     "Could not find " << name << " in " << tid.GetName ());
+              n++;
+            }
+          for (uint32_t j = 0; j < tmp.GetTraceSourceN (); j++)
+            {
+              struct TypeId::TraceSourceInformation source = tmp.GetTraceSource (j);
+              NS_TEST_ASSERT_MSG_EQ (tid.LookupTraceSourceByName (source.name), source.accessor,
+                                     "Could not find " << source.name << " in " << tid.GetName ());
+            }
+          if (!tmp.HasParent ())
+            {
+              break;
+            }
+          tmp = tmp.GetParent ();
+        }
+      NS_TEST_ASSERT_MSG_EQ (n, tid.GetFlatAttributeN (), "Extra attributes in " << tid.GetName ());
+      NS_TEST_ASSERT_MSG_EQ (tid.FindAttribute ("NoSuchAttribute"), 0, "Found a missing attribute");
+      NS_TEST_ASSERT_MSG_EQ (tid.LookupTraceSourceByName ("NoSuchTraceSource"), 0, "Found a missing trace source");
+    }
+
+  // an attribute added to a parent after a lookup in a child is visible.
+  TypeId parent;
+  if (TypeId::LookupByNameFailSafe ("ns3::InheritedLookupTestParent", &parent))
+    {
+      return;
+    }
+  parent = TypeId ("ns3::InheritedLookupTestParent")
+    .SetParent<ObjectBase> ();
+  TypeId child = TypeId ("ns3::InheritedLookupTestChild")
+    .SetParent (parent);
+  NS_TEST_ASSERT_MSG_EQ (child.FindAttribute ("Late"), 0, "Found a missing attribute");
+  parent.AddAttribute ("Late", "An attribute added after a lookup.",
+                       UintegerValue (1),
+                       Ptr<const AttributeAccessor> (0),
+                       MakeUintegerChecker<uint32_t> ());
+  NS_TEST_ASSERT_MSG_NE (child.FindAttribute ("Late"), 0, "Could not find a late attribute");
+  NS_TEST_ASSERT_MSG_EQ (child.GetFlatAttributeN (), 1, "Wrong number of attributes");
+}
+
+
 //----------------------------
 //
 // Collision test
@@ -295,8 +379,10 @@ TypeIdTestSuite::TypeIdTestSuite ()
   // If the CollisionTestCase is performed before the
   // UniqueIdTestCase, the artificial collisions added by
   // CollisionTestCase will show up in the list of TypeIds
-  // as chained.
+  // as chained.  The InheritedLookupTestCase also expects every TypeId
+  // to have a parent, which these do not.
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
+  AddTestCase (new InheritedLookupTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
 }
 
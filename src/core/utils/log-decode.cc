@@ -0,0 +1,59 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Print the messages of a binary log, recorded with NS_LOG_BINARY or
+// ns3::LogEnableBinary, in the text format of the logging macros.
+//
+//   ./waf --run "log-decode --file=trace.bin"
+
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string filename;
+
+  CommandLine cmd;
+  cmd.AddValue ("file", "The binary log to decode, or the standard input if empty", filename);
+  cmd.Parse (argc, argv);
+
+  bool complete;
+  if (filename.empty ())
+    {
+      complete = LogDecodeBinary (std::cin, std::cout);
+    }
+  else
+    {
+      std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+      if (!is)
+        {
+          std::cerr << "Could not open " << filename << std::endl;
+          return 1;
+        }
+      complete = LogDecodeBinary (is, std::cout);
+    }
+  if (!complete)
+    {
+      std::cerr << "The binary log is truncated or corrupted" << std::endl;
+      return 1;
+    }
+  return 0;
+}
@@ -29,10 +29,14 @@
 #include "ns3/node-container.h"
 #include "ns3/ptr.h"
 #include "ns3/pointer.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #ifdef NS3_MPI
 #include <mpi.h>
@@ -85,6 +89,18 @@ DistributedSimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::DistributedSimulatorImpl")
     .SetParent<Object> ()
     .AddConstructor<DistributedSimulatorImpl> ()
+    .AddAttribute ("SynchronizationMode",
+                   "The algorithm used to synchronize the ranks.",
+                   EnumValue (LBTS),
+                   MakeEnumAccessor (&DistributedSimulatorImpl::m_syncMode),
+                   MakeEnumChecker (LBTS, "Lbts",
+                                    NULL_MESSAGE, "NullMessage"))
+    .AddAttribute ("MaxBatchSize",
+                   "The size, in bytes, above which the messages batched for a rank "
+                   "are sent before the next synchronization.",
+                   UintegerValue (DEFAULT_MPI_BATCH_SIZE),
+                   MakeUintegerAccessor (&DistributedSimulatorImpl::m_maxBatchSize),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -114,6 +130,9 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
   m_events = 0;
+  m_syncMode = LBTS;
+  m_maxBatchSize = DEFAULT_MPI_BATCH_SIZE;
+  m_stopScheduled = false;
 }
 
 DistributedSimulatorImpl::~DistributedSimulatorImpl ()
@@ -155,6 +174,8 @@ void
 DistributedSimulatorImpl::CalculateLookAhead (void)
 {
 #ifdef NS3_MPI
+  m_neighborLookAhead.clear ();
+  m_pathLookAhead.assign (MpiInterface::GetSize (), GetMaximumSimulationTime ());
   if (MpiInterface::GetSize () <= 1)
     {
       DistributedSimulatorImpl::m_lookAhead = Seconds (0);
@@ -210,6 +231,13 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
               TimeValue delay;
               channel->GetAttribute ("Delay", delay);
 
+              uint32_t rank = remoteNode->GetSystemId ();
+              if (m_neighborLookAhead.find (rank) == m_neighborLookAhead.end ()
+                  || delay.Get () < m_neighborLookAhead[rank])
+                {
+                  m_neighborLookAhead[rank] = delay.Get ();
+                }
+
               if (delay.Get ().GetSeconds () < DistributedSimulatorImpl::m_lookAhead.GetSeconds ())
                 {
                   DistributedSimulatorImpl::m_lookAhead = delay.Get ();
@@ -261,6 +289,95 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
       m_grantedTime = m_lookAhead;
     }
 
+  if (MpiInterface::GetSize () > 1)
+    {
+      CalculatePathLookAhead ();
+    }
+
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+DistributedSimulatorImpl::CalculatePathLookAhead (void)
+{
+#ifdef NS3_MPI
+  /*
+   * Gather the lookahead of the links between every pair of ranks. An
+   * event of rank j at time t cannot cause a packet to be received by
+   * this rank before t plus the smallest sum of lookaheads along a path
+   * from j to this rank, so slow links do not limit the ranks which are
+   * not directly connected to them.
+   */
+  uint32_t n = m_systemCount;
+  std::vector<long> sendbuf (n, -1);
+  for (std::map<uint32_t, Time>::const_iterator i = m_neighborLookAhead.begin ();
+       i != m_neighborLookAhead.end (); ++i)
+    {
+      sendbuf[i->first] = i->second.GetTimeStep ();
+    }
+  std::vector<long> matrix (n * n);
+  MPI_Allgather (&sendbuf[0], n, MPI_LONG, &matrix[0], n, MPI_LONG, MPI_COMM_WORLD);
+
+  // Dijkstra on the reversed graph, from this rank
+  const uint64_t infinity = GetMaximumSimulationTime ().GetTimeStep ();
+  std::vector<uint64_t> distance (n, infinity);
+  std::vector<bool> done (n, false);
+  distance[m_myId] = 0;
+  for (uint32_t iteration = 0; iteration < n; ++iteration)
+    {
+      uint32_t k = n;
+      for (uint32_t j = 0; j < n; ++j)
+        {
+          if (!done[j] && (k == n || distance[j] < distance[k]))
+            {
+              k = j;
+            }
+        }
+      if (distance[k] == infinity)
+        {
+          break;
+        }
+      done[k] = true;
+      for (uint32_t j = 0; j < n; ++j)
+        {
+          long delay = matrix[j * n + k];
+          if (delay >= 0 && distance[k] + delay < distance[j])
+            {
+              distance[j] = distance[k] + delay;
+            }
+        }
+    }
+  // Events of this rank may come back through a neighbor
+  uint64_t cycle = infinity;
+  for (uint32_t j = 0; j < n; ++j)
+    {
+      long delay = matrix[m_myId * n + j];
+      if (j != m_myId && delay >= 0 && distance[j] != infinity)
+        {
+          cycle = std::min (cycle, delay + distance[j]);
+        }
+    }
+  distance[m_myId] = cycle;
+
+  bool connected = false;
+  for (uint32_t j = 0; j < n; ++j)
+    {
+      m_pathLookAhead[j] = TimeStep (distance[j]);
+      connected |= distance[j] != infinity;
+    }
+  if (connected)
+    {
+      // everything starts at time zero
+      m_grantedTime = *std::min_element (m_pathLookAhead.begin (), m_pathLookAhead.end ());
+    }
+  else
+    {
+      // Tasks with no inter-task links keep using the global lookahead
+      // computed above so that they don't run too far ahead.
+      m_pathLookAhead.clear ();
+    }
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -333,6 +450,12 @@ void
 DistributedSimulatorImpl::Run (void)
 {
 #ifdef NS3_MPI
+  MpiInterface::SetMaxBatchSize (m_maxBatchSize);
+  if (m_syncMode == NULL_MESSAGE)
+    {
+      RunNullMessage ();
+      return;
+    }
   CalculateLookAhead ();
   m_stop = false;
   while (!m_globalFinished)
@@ -348,7 +471,9 @@ DistributedSimulatorImpl::Run (void)
         { 
 
           // Can't process next event, calculate a new LBTS
-          // First receive any pending messages
+          // First send the batched packets and receive any pending
+          // messages
+          MpiInterface::Flush ();
           MpiInterface::ReceiveMessages ();
           // reset next time
           nextTime = Next ();
@@ -377,7 +502,22 @@ DistributedSimulatorImpl::Run (void)
               totTx += m_pLBTS[i].GetTxCount ();
               m_globalFinished &= m_pLBTS[i].IsFinished ();
             }
-          if (totRx == totTx)
+          if (totRx == totTx && !m_pathLookAhead.empty ())
+            {
+              // Each rank limits the window by the time its next event
+              // needs to reach this rank.
+              m_grantedTime = GetMaximumSimulationTime ();
+              for (uint32_t i = 0; i < m_systemCount; ++i)
+                {
+                  Time smallest = m_pLBTS[i].GetSmallestTime ();
+                  Time lookAhead = m_pathLookAhead[i];
+                  if (smallest < GetMaximumSimulationTime () - lookAhead)
+                    {
+                      m_grantedTime = Min (m_grantedTime, smallest + lookAhead);
+                    }
+                }
+            }
+          else if (totRx == totTx)
             {
               // If lookahead is infinite then granted time should be as well.
               // Covers the edge case if all the tasks have no inter tasks 
@@ -410,6 +550,96 @@ DistributedSimulatorImpl::Run (void)
 #endif
 }
 
+void
+DistributedSimulatorImpl::SendNullMessages (Time bound)
+{
+  for (std::map<uint32_t, Time>::const_iterator i = m_neighborLookAhead.begin ();
+       i != m_neighborLookAhead.end (); ++i)
+    {
+      Time guarantee = GetMaximumSimulationTime ();
+      if (bound < GetMaximumSimulationTime () - i->second)
+        {
+          guarantee = bound + i->second;
+        }
+      // guarantees only ever increase; don't repeat them
+      std::map<uint32_t, Time>::iterator sent = m_nullMessageSent.find (i->first);
+      if (sent == m_nullMessageSent.end () || guarantee > sent->second)
+        {
+          NS_LOG_LOGIC ("null message to " << i->first << " guarantee " << guarantee);
+          MpiInterface::SendNullMessage (i->first, guarantee);
+          m_nullMessageSent[i->first] = guarantee;
+        }
+    }
+}
+
+void
+DistributedSimulatorImpl::RunNullMessage (void)
+{
+#ifdef NS3_MPI
+  CalculateLookAhead ();
+  if (!m_stopScheduled)
+    {
+      NS_FATAL_ERROR ("The NullMessage synchronization mode requires Simulator::Stop (time)");
+    }
+  for (std::map<uint32_t, Time>::const_iterator i = m_neighborLookAhead.begin ();
+       i != m_neighborLookAhead.end (); ++i)
+    {
+      if (i->second.IsZero ())
+        {
+          NS_FATAL_ERROR ("Links to rank " << i->first << " have no delay");
+        }
+    }
+  m_nullMessageSent.clear ();
+  m_stop = false;
+  while (true)
+    {
+      // No packet earlier than the smallest guarantee of the neighbors
+      // can be received anymore.
+      Time safeTime = GetMaximumSimulationTime ();
+      for (std::map<uint32_t, Time>::const_iterator i = m_neighborLookAhead.begin ();
+           i != m_neighborLookAhead.end (); ++i)
+        {
+          safeTime = Min (safeTime, MpiInterface::GetGuarantee (i->first));
+        }
+      while (!IsLocalFinished () && Next () < safeTime)
+        {
+          ProcessOneEvent ();
+        }
+      if (m_stop || (m_events->IsEmpty () && safeTime == GetMaximumSimulationTime ()))
+        {
+          break;
+        }
+
+      // Blocked: events processed from now on, including those of the
+      // packets yet to be received, cannot be earlier than bound.
+      SendNullMessages (Min (Next (), safeTime));
+      MpiInterface::Flush ();
+      MpiInterface::ReceiveMessages ();
+      MpiInterface::TestSendComplete ();
+    }
+
+  // This rank won't send anything anymore. Keep receiving until all the
+  // messages in transit have been matched, since the neighbors may still
+  // send packets and null messages to it.
+  SendNullMessages (GetMaximumSimulationTime ());
+  MpiInterface::Flush ();
+  uint32_t sendbuf[2];
+  uint32_t recvbuf[2];
+  do
+    {
+      MpiInterface::ReceiveMessages ();
+      MpiInterface::TestSendComplete ();
+      sendbuf[0] = MpiInterface::GetTxCount ();
+      sendbuf[1] = MpiInterface::GetRxCount ();
+      MPI_Allreduce (sendbuf, recvbuf, 2, MPI_UNSIGNED, MPI_SUM, MPI_COMM_WORLD);
+    }
+  while (recvbuf[0] != recvbuf[1]);
+  m_globalFinished = true;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
 uint32_t DistributedSimulatorImpl::GetSystemId () const
 {
   return m_myId;
@@ -424,6 +654,7 @@ DistributedSimulatorImpl::Stop (void)
 void
 DistributedSimulatorImpl::Stop (Time const &time)
 {
+  m_stopScheduled = true;
   Simulator::Schedule (time, &Simulator::Stop);
 }
 
@@ -28,6 +28,8 @@
 #include "ns3/ptr.h"
 
 #include <list>
+#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -96,10 +98,34 @@ private:
  * \ingroup mpi
  *
  * \brief distributed simulator implementation using lookahead
+ *
+ * Two conservative synchronization algorithms are available through
+ * the SynchronizationMode attribute:
+ *  - LBTS: whenever a rank reaches the end of its time window, all the
+ *    ranks exchange their next event time with MPI_Allgather. The next
+ *    window extends up to the earliest time at which the next event of
+ *    any rank could affect this rank, i.e., the smallest sum of its next
+ *    event time and the lookahead of the shortest path of remote links
+ *    from that rank to this one.
+ *  - NullMessage: the Chandy-Misra-Bryant algorithm. A blocked rank
+ *    sends to each neighbor rank (i.e., each rank it shares a remote
+ *    point-to-point link with) a null message guaranteeing that it will
+ *    not send any packet earlier than its next event time plus the
+ *    lookahead of their links, and only waits for the guarantees of its
+ *    neighbors. This mode requires a stop time (Simulator::Stop (time)).
  */
 class DistributedSimulatorImpl : public SimulatorImpl
 {
 public:
+  /**
+   * Algorithm used to synchronize the ranks
+   */
+  enum SynchronizationMode
+  {
+    LBTS,
+    NULL_MESSAGE
+  };
+
   static TypeId GetTypeId (void);
 
   DistributedSimulatorImpl ();
@@ -128,7 +154,10 @@ public:
 private:
   virtual void DoDispose (void);
   void CalculateLookAhead (void);
+  void CalculatePathLookAhead (void);
   bool IsLocalFinished (void) const;
+  void RunNullMessage (void);
+  void SendNullMessages (Time bound);
 
   void ProcessOneEvent (void);
   uint64_t NextTs (void) const;
@@ -153,6 +182,17 @@ private:
   Time         m_grantedTime; // Last LBTS
   static Time  m_lookAhead;   // Lookahead value
 
+  SynchronizationMode m_syncMode;
+  uint32_t m_maxBatchSize;
+  bool m_stopScheduled;
+  // lookahead of the links to each neighbor rank
+  std::map<uint32_t, Time> m_neighborLookAhead;
+  // smallest lookahead along any path from each rank to this one
+  // (or back to this one), empty if this rank has no remote link
+  std::vector<Time> m_pathLookAhead;
+  // last guarantee sent to each neighbor rank
+  std::map<uint32_t, Time> m_nullMessageSent;
+
 };
 
 } // namespace ns3
@@ -22,6 +22,8 @@
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <algorithm>
+#include <cstring>
 
 #include "mpi-interface.h"
 #include "mpi-receiver.h"
@@ -70,6 +72,16 @@ SentBuffer::GetRequest ()
 }
 #endif
 
+MpiInterface::PeerStatistics::PeerStatistics ()
+  : txBytes (0),
+    rxBytes (0),
+    txMessages (0),
+    rxMessages (0),
+    txBatches (0),
+    rxBatches (0)
+{
+}
+
 uint32_t              MpiInterface::m_sid = 0;
 uint32_t              MpiInterface::m_size = 1;
 bool                  MpiInterface::m_initialized = false;
@@ -77,24 +89,41 @@ bool                  MpiInterface::m_enabled = false;
 uint32_t              MpiInterface::m_rxCount = 0;
 uint32_t              MpiInterface::m_txCount = 0;
 std::list<SentBuffer> MpiInterface::m_pendingTx;
-
-#ifdef NS3_MPI
-MPI_Request* MpiInterface::m_requests;
-char**       MpiInterface::m_pRxBuffers;
-#endif
+std::vector<MpiInterface::Batch> MpiInterface::m_batches;
+uint32_t              MpiInterface::m_maxBatchSize = DEFAULT_MPI_BATCH_SIZE;
+std::vector<uint8_t>  MpiInterface::m_rxBuffer;
+std::vector<MpiInterface::PeerStatistics> MpiInterface::m_statistics;
+std::vector<uint32_t> MpiInterface::m_txCounts;
+std::vector<uint32_t> MpiInterface::m_rxCounts;
+std::vector<std::list<MpiInterface::NullMessage> > MpiInterface::m_pendingGuarantees;
+std::vector<Time>     MpiInterface::m_guarantees;
+
+// destination node of the messages which carry a guarantee rather than
+// a packet
+static const uint32_t NULL_MESSAGE_NODE = 0xffffffff;
+// guarantee of a rank which will not send anything anymore
+static const uint64_t NULL_MESSAGE_FOREVER = ~static_cast<uint64_t> (0);
+// each message of a batch starts with its length (not counting the
+// length itself), the receive time, the node and the device
+static const uint32_t MESSAGE_HEADER_SIZE = 4 + 8 + 4 + 4;
 
 void
 MpiInterface::Destroy ()
 {
 #ifdef NS3_MPI
-  for (uint32_t i = 0; i < GetSize (); ++i)
+  for (uint32_t i = 0; i < m_batches.size (); ++i)
     {
-      delete [] m_pRxBuffers[i];
+      delete [] m_batches[i].buffer;
     }
-  delete [] m_pRxBuffers;
-  delete [] m_requests;
+  m_batches.clear ();
+  m_rxBuffer.clear ();
+  m_statistics.clear ();
 
   m_pendingTx.clear ();
+  m_txCounts.clear ();
+  m_rxCounts.clear ();
+  m_pendingGuarantees.clear ();
+  m_guarantees.clear ();
 #endif
 }
 
@@ -154,108 +183,247 @@ MpiInterface::Enable (int* pargc, char*** pargv)
   MPI_Comm_size (MPI_COMM_WORLD, reinterpret_cast <int *> (&m_size));
   m_enabled = true;
   m_initialized = true;
-  // Post a non-blocking receive for all peers
-  m_pRxBuffers = new char*[m_size];
-  m_requests = new MPI_Request[m_size];
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
-      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[i]);
-    }
+  Batch empty = { 0, 0, 0, 0 };
+  m_batches.assign (m_size, empty);
+  m_rxBuffer.resize (MAX_MPI_MSG_SIZE);
+  m_statistics.assign (m_size, PeerStatistics ());
+  m_txCounts.assign (m_size, 0);
+  m_rxCounts.assign (m_size, 0);
+  m_pendingGuarantees.assign (m_size, std::list<NullMessage> ());
+  m_guarantees.assign (m_size, Seconds (0));
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
 }
 
+uint8_t*
+MpiInterface::AppendMessage (uint32_t rank, uint64_t t, uint32_t node, uint32_t dev, uint32_t size)
+{
+  Batch &batch = m_batches[rank];
+  uint32_t needed = batch.size + MESSAGE_HEADER_SIZE + size;
+  if (needed > batch.capacity)
+    {
+      uint32_t capacity = std::max (needed, std::max (2 * batch.capacity, m_maxBatchSize));
+      uint8_t* buffer = new uint8_t[capacity];
+      if (batch.size > 0)
+        {
+          std::memcpy (buffer, batch.buffer, batch.size);
+        }
+      delete [] batch.buffer;
+      batch.buffer = buffer;
+      batch.capacity = capacity;
+    }
+  // Add the length, time, dest node and dest device. Messages have
+  // any size, so the fields are not aligned.
+  uint8_t* p = batch.buffer + batch.size;
+  uint32_t length = MESSAGE_HEADER_SIZE - 4 + size;
+  std::memcpy (p, &length, 4);
+  std::memcpy (p + 4, &t, 8);
+  std::memcpy (p + 12, &node, 4);
+  std::memcpy (p + 16, &dev, 4);
+  batch.size = needed;
+  batch.count++;
+  m_txCount++;
+  return p + MESSAGE_HEADER_SIZE;
+}
+
 void
-MpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
+MpiInterface::FlushBatch (uint32_t rank)
 {
 #ifdef NS3_MPI
+  Batch &batch = m_batches[rank];
   SentBuffer sendBuf;
   m_pendingTx.push_back (sendBuf);
   std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
 
-  uint32_t serializedSize = p->GetSerializedSize ();
-  uint8_t* buffer =  new uint8_t[serializedSize + 16];
-  i->SetBuffer (buffer);
-  // Add the time, dest node and dest device
-  uint64_t t = rxTime.GetNanoSeconds ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = t;
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = node;
-  *pData++ = dev;
-  // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
+  // The sent buffer takes over the batch, which is reallocated by the
+  // next message.
+  i->SetBuffer (batch.buffer);
+  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), batch.size, MPI_CHAR, rank,
+             0, MPI_COMM_WORLD, (i->GetRequest ()));
+  m_statistics[rank].txBytes += batch.size;
+  m_statistics[rank].txMessages += batch.count;
+  m_statistics[rank].txBatches++;
+  batch.buffer = 0;
+  batch.size = 0;
+  batch.capacity = 0;
+  batch.count = 0;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+MpiInterface::Flush ()
+{
+  for (uint32_t rank = 0; rank < m_batches.size (); ++rank)
+    {
+      if (m_batches[rank].count > 0)
+        {
+          FlushBatch (rank);
+        }
+    }
+}
+
+void
+MpiInterface::SetMaxBatchSize (uint32_t size)
+{
+  m_maxBatchSize = size;
+}
 
+MpiInterface::PeerStatistics
+MpiInterface::GetStatistics (uint32_t rank)
+{
+  NS_ASSERT (rank < m_statistics.size ());
+  return m_statistics[rank];
+}
+
+void
+MpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
+{
+#ifdef NS3_MPI
   // Find the system id for the destination node
   Ptr<Node> destNode = NodeList::GetNode (node);
   uint32_t nodeSysId = destNode->GetSystemId ();
 
-  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (i->GetRequest ()));
-  m_txCount++;
+  // Serialize the packet in place, after its header
+  uint32_t serializedSize = p->GetSerializedSize ();
+  uint8_t* buffer = AppendMessage (nodeSysId, rxTime.GetNanoSeconds (), node, dev, serializedSize);
+  p->Serialize (buffer, serializedSize);
+  m_txCounts[nodeSysId]++;
+
+  if (m_batches[nodeSysId].size >= m_maxBatchSize)
+    {
+      FlushBatch (nodeSysId);
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+MpiInterface::SendNullMessage (uint32_t rank, const Time &guarantee)
+{
+#ifdef NS3_MPI
+  // Same header as a packet, with the packets sent so far as device.
+  // Null messages share the batches of the packets so that they are
+  // received in order.
+  uint64_t t = guarantee.GetNanoSeconds ();
+  if (guarantee == Simulator::GetMaximumSimulationTime ())
+    {
+      t = NULL_MESSAGE_FOREVER;
+    }
+  AppendMessage (rank, t, NULL_MESSAGE_NODE, m_txCounts[rank], 0);
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
 }
 
+Time
+MpiInterface::GetGuarantee (uint32_t rank)
+{
+  // guarantees wait for the packets sent before them to be received.
+  std::list<NullMessage> &pending = m_pendingGuarantees[rank];
+  std::list<NullMessage>::iterator i = pending.begin ();
+  while (i != pending.end ())
+    {
+      if (i->count > m_rxCounts[rank])
+        {
+          ++i;
+          continue;
+        }
+      if (i->guarantee == NULL_MESSAGE_FOREVER)
+        {
+          m_guarantees[rank] = Simulator::GetMaximumSimulationTime ();
+        }
+      else
+        {
+          m_guarantees[rank] = std::max (m_guarantees[rank], NanoSeconds (i->guarantee));
+        }
+      i = pending.erase (i);
+    }
+  return m_guarantees[rank];
+}
+
 void
 MpiInterface::ReceiveMessages ()
-{ // Poll the non-block reads to see if data arrived
+{ // Poll for batches which arrived
 #ifdef NS3_MPI
   while (true)
     {
       int flag = 0;
-      int index = 0;
       MPI_Status status;
 
-      MPI_Testany (GetSize (), m_requests, &index, &flag, &status);
+      MPI_Iprobe (MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &flag, &status);
       if (!flag)
         {
           break;        // No more messages
         }
       int count;
       MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
-
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t nanoSeconds = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
+      uint32_t source = status.MPI_SOURCE;
+      if (m_rxBuffer.size () < static_cast<uint32_t> (count))
+        {
+          m_rxBuffer.resize (count);
+        }
+      MPI_Recv (&m_rxBuffer[0], count, MPI_CHAR, source, 0, MPI_COMM_WORLD, &status);
+      m_statistics[source].rxBytes += count;
+      m_statistics[source].rxBatches++;
 
-      Time rxTime = NanoSeconds (nanoSeconds);
+      const uint8_t* pData = &m_rxBuffer[0];
+      const uint8_t* pEnd = pData + count;
+      while (pData < pEnd)
+        {
+          // Get the meta data first
+          uint32_t length;
+          uint64_t nanoSeconds;
+          uint32_t node;
+          uint32_t dev;
+          std::memcpy (&length, pData, 4);
+          std::memcpy (&nanoSeconds, pData + 4, 8);
+          std::memcpy (&node, pData + 12, 4);
+          std::memcpy (&dev, pData + 16, 4);
+          const uint8_t* payload = pData + MESSAGE_HEADER_SIZE;
+          uint32_t size = length - (MESSAGE_HEADER_SIZE - 4);
+          pData += 4 + length;
+          NS_ASSERT (pData <= pEnd);
+          m_rxCount++; // Count this receive
+          m_statistics[source].rxMessages++;
+
+          if (node == NULL_MESSAGE_NODE)
+            {
+              NullMessage msg;
+              msg.count = dev;
+              msg.guarantee = nanoSeconds;
+              m_pendingGuarantees[source].push_back (msg);
+              continue;
+            }
+          m_rxCounts[source]++;
 
-      count -= sizeof (nanoSeconds) + sizeof (node) + sizeof (dev);
+          Time rxTime = NanoSeconds (nanoSeconds);
 
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+          Ptr<Packet> p = Create<Packet> (payload, size, true);
 
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      Ptr<MpiReceiver> pMpiRec = 0;
-      uint32_t nDevices = pNode->GetNDevices ();
-      for (uint32_t i = 0; i < nDevices; ++i)
-        {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
+          // Find the correct node/device to schedule receive event
+          Ptr<Node> pNode = NodeList::GetNode (node);
+          Ptr<MpiReceiver> pMpiRec = 0;
+          uint32_t nDevices = pNode->GetNDevices ();
+          for (uint32_t i = 0; i < nDevices; ++i)
             {
-              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-              break;
+              Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+              if (pThisDev->GetIfIndex () == dev)
+                {
+                  pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+                  break;
+                }
             }
-        }
 
-      NS_ASSERT (pNode && pMpiRec);
+          NS_ASSERT (pNode && pMpiRec);
 
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &MpiReceiver::Receive, pMpiRec, p);
-
-      // Re-queue the next read
-      MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[index]);
+          // Schedule the rx event
+          Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                          &MpiReceiver::Receive, pMpiRec, p);
+        }
     }
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
@@ -24,6 +24,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 
 #include "ns3/nstime.h"
 #include "ns3/buffer.h"
@@ -50,6 +51,12 @@ namespace ns3 {
  */
 const uint32_t MAX_MPI_MSG_SIZE = 2000;
 
+/**
+ * default size, in bytes, above which a batch of messages is sent
+ * without waiting for the next synchronization
+ */
+const uint32_t DEFAULT_MPI_BATCH_SIZE = 65536;
+
 /**
  * \ingroup mpi
  *
@@ -85,10 +92,30 @@ class Packet;
  * \ingroup mpi
  *
  * Interface between ns-3 and MPI
+ *
+ * The packets and null messages sent to a rank are serialized back to
+ * back in a batch which is only handed to MPI, as a single message,
+ * when Flush is called or when its size reaches the maximum batch size.
  */
 class MpiInterface
 {
 public:
+  /**
+   * \ingroup mpi
+   *
+   * Traffic exchanged with another rank
+   */
+  struct PeerStatistics
+  {
+    PeerStatistics ();
+    uint64_t txBytes;    //!< bytes sent, including the message headers
+    uint64_t rxBytes;    //!< bytes received, including the message headers
+    uint32_t txMessages; //!< packets and null messages sent
+    uint32_t rxMessages; //!< packets and null messages received
+    uint32_t txBatches;  //!< MPI messages sent
+    uint32_t rxBatches;  //!< MPI messages received
+  };
+
   /**
    * Delete all buffers
    */
@@ -124,9 +151,24 @@ public:
    * \param node destination node
    * \param dev destination device
    *
-   * Serialize and send a packet to the specified node and net device
+   * Serialize a packet for the specified node and net device in the
+   * batch of the rank of the node
    */
   static void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+  /**
+   * Send the pending batches, one MPI message per destination rank
+   */
+  static void Flush ();
+  /**
+   * \param size size, in bytes, above which a batch is sent
+   * immediately
+   */
+  static void SetMaxBatchSize (uint32_t size);
+  /**
+   * \param rank peer rank
+   * \return the traffic exchanged with rank so far
+   */
+  static PeerStatistics GetStatistics (uint32_t rank);
   /**
    * Check for received messages complete
    */
@@ -136,13 +178,28 @@ public:
    */
   static void TestSendComplete ();
   /**
-   * \return received count in packets
+   * \return received count in packets and null messages
    */
   static uint32_t GetRxCount ();
   /**
-   * \return transmitted count in packets
+   * \return transmitted count in packets and null messages
    */
   static uint32_t GetTxCount ();
+  /**
+   * \param rank destination rank
+   * \param guarantee no packet with an earlier receive time will be
+   * sent to rank anymore
+   *
+   * Queue a null message of the Chandy-Misra-Bryant algorithm in the
+   * batch of rank. Null messages are included in the transmitted count.
+   */
+  static void SendNullMessage (uint32_t rank, const Time &guarantee);
+  /**
+   * \param rank source rank
+   * \return the time before which no packet will be received from
+   * rank anymore, according to the null messages received so far
+   */
+  static Time GetGuarantee (uint32_t rank);
 
 private:
   static uint32_t m_sid;
@@ -156,14 +213,42 @@ private:
   static bool     m_initialized;
   static bool     m_enabled;
 
-  // Pending non-blocking receives
-  static MPI_Request* m_requests;
+  // Messages not sent yet to a rank, serialized back to back
+  struct Batch
+  {
+    uint8_t* buffer;
+    uint32_t size;
+    uint32_t capacity;
+    uint32_t count;
+  };
+
+  static uint8_t* AppendMessage (uint32_t rank, uint64_t t, uint32_t node,
+                                 uint32_t dev, uint32_t size);
+  static void FlushBatch (uint32_t rank);
+
+  static std::vector<Batch> m_batches;
+  static uint32_t m_maxBatchSize;
 
-  // Data buffers for non-blocking reads
-  static char**   m_pRxBuffers;
+  // Data buffer for the receives, grown to the largest batch
+  static std::vector<uint8_t> m_rxBuffer;
 
   // List of pending non-blocking sends
   static std::list<SentBuffer> m_pendingTx;
+
+  static std::vector<PeerStatistics> m_statistics;
+
+  // Packets sent to and received from each rank. Null messages carry
+  // the number of packets sent before them, so that a guarantee is only
+  // applied once the packets which precede it have been received.
+  struct NullMessage
+  {
+    uint32_t count;
+    uint64_t guarantee;
+  };
+  static std::vector<uint32_t> m_txCounts;
+  static std::vector<uint32_t> m_rxCounts;
+  static std::vector<std::list<NullMessage> > m_pendingGuarantees;
+  static std::vector<Time> m_guarantees;
 };
 
 } // namespace ns3
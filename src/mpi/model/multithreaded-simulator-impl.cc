@@ -0,0 +1,803 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+#include "mpi-receiver.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/make-event.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+#include "ns3/system-thread.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <sched.h>
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+// no event pending
+static const uint64_t NO_EVENT = ~static_cast<uint64_t> (0);
+
+// partition run by the calling thread
+static __thread uint32_t g_currentPartition = 0;
+
+MultithreadedSimulatorImpl *MultithreadedSimulatorImpl::m_instance = 0;
+
+MultithreadedSimulatorImpl::Partition::Partition ()
+  : events (0),
+    systemId (0),
+    // uids are allocated from 4.
+    // uid 0 is "invalid" events
+    // uid 1 is "now" events
+    // uid 2 is "destroy" events
+    uid (4),
+    // before ::Run is entered, the currentUid will be zero
+    currentUid (0),
+    currentTs (0),
+    currentContext (0xffffffff),
+    unscheduledEvents (0),
+    mailbox (0),
+    sent (0),
+    stopRequested (false),
+    stopRequestTs (NO_EVENT),
+    nextTs (NO_EVENT),
+    stop (false),
+    stopTs (NO_EVENT),
+    granted (0)
+{
+}
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_uid (4),
+    m_lookAhead (NO_EVENT),
+    m_stop (false),
+    m_running (false),
+    m_nextWorker (1),
+    m_barrierCount (0),
+    m_barrierGeneration (0)
+{
+  NS_LOG_FUNCTION (this);
+  // the partition of system id 0 is always run by the main thread
+  m_partitions.push_back (new Partition ());
+  m_systemIdToPartition[0] = 0;
+  m_instance = this;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_instance == this)
+    {
+      m_instance = 0;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      while (partition->events != 0 && !partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      Message *message = partition->mailbox;
+      while (message != 0)
+        {
+          Message *next = message->next;
+          if (message->event != 0)
+            {
+              message->event->Unref ();
+            }
+          delete [] message->data;
+          delete message;
+          message = next;
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  m_systemIdToPartition.clear ();
+  m_contextToPartition.clear ();
+  m_peers.clear ();
+  if (m_instance == this)
+    {
+      m_instance = 0;
+    }
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT (!m_running);
+  m_schedulerFactory = schedulerFactory;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->events != 0)
+        {
+          while (!(*i)->events->IsEmpty ())
+            {
+              Scheduler::Event next = (*i)->events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      (*i)->events = scheduler;
+    }
+}
+
+// System ID for shared-memory simulation is always zero
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t systemId)
+{
+  std::map<uint32_t, uint32_t>::const_iterator i = m_systemIdToPartition.find (systemId);
+  if (i != m_systemIdToPartition.end ())
+    {
+      return i->second;
+    }
+  NS_ASSERT (!m_running);
+  uint32_t index = m_partitions.size ();
+  NS_LOG_LOGIC ("partition " << index << " for system id " << systemId);
+  Partition *partition = new Partition ();
+  partition->systemId = systemId;
+  partition->events = m_schedulerFactory.Create<Scheduler> ();
+  m_partitions.push_back (partition);
+  m_systemIdToPartition[systemId] = index;
+  return index;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::FindPartition (uint32_t context) const
+{
+  // outside of Run, the events are kept in the partitions of the last
+  // Run, or in the first partition before the first Run, and they are
+  // moved by Run if the system id of their node changed.
+  return context < m_contextToPartition.size () ? m_contextToPartition[context] : 0;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  return m_partitions[g_currentPartition];
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lookAhead = NO_EVENT;
+  m_peers.clear ();
+  for (NodeList::Iterator node = NodeList::Begin (); node != NodeList::End (); ++node)
+    {
+      uint32_t partition = m_contextToPartition[(*node)->GetId ()];
+      for (uint32_t i = 0; i < (*node)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> localNetDevice = (*node)->GetDevice (i);
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < channel->GetNDevices (); ++j)
+            {
+              Ptr<NetDevice> remoteNetDevice = channel->GetDevice (j);
+              uint32_t remotePartition = m_contextToPartition[remoteNetDevice->GetNode ()->GetId ()];
+              if (remotePartition == partition)
+                {
+                  continue;
+                }
+              // only works for p2p links currently
+              Ptr<MpiReceiver> receiver = remoteNetDevice->GetObject<MpiReceiver> ();
+              if (!localNetDevice->IsPointToPoint () || receiver == 0)
+                {
+                  NS_FATAL_ERROR ("Channel " << channel->GetId () << " of type " <<
+                                  channel->GetInstanceTypeId ().GetName () <<
+                                  " connects nodes of different partitions; only"
+                                  " point-to-point links may do so and they must be"
+                                  " created after selecting the MultithreadedSimulatorImpl");
+                }
+              uint64_t key = static_cast<uint64_t> ((*node)->GetId ()) << 32 | localNetDevice->GetIfIndex ();
+              Peer peer;
+              peer.partition = remotePartition;
+              peer.context = remoteNetDevice->GetNode ()->GetId ();
+              peer.receiver = PeekPointer (receiver);
+              m_peers[key] = peer;
+
+              // compare delay on the channel with current value of
+              // m_lookAhead.  if delay on channel is smaller, make
+              // it the new lookAhead.
+              TimeValue delay;
+              channel->GetAttribute ("Delay", delay);
+              m_lookAhead = std::min (m_lookAhead, static_cast<uint64_t> (delay.Get ().GetTimeStep ()));
+            }
+        }
+    }
+  if (m_lookAhead == 0)
+    {
+      NS_FATAL_ERROR ("Links between partitions must have a non-zero delay");
+    }
+  NS_LOG_LOGIC ("lookahead " << m_lookAhead);
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  if (m_running)
+    {
+      ev.key.m_uid = partition->uid;
+      partition->uid++;
+    }
+  else
+    {
+      // the events inserted outside of Run may move to another
+      // partition, so their uids must be unique across partitions.
+      ev.key.m_uid = m_uid;
+      m_uid++;
+    }
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::Post (Partition *partition, Message *message)
+{
+  Partition *current = GetCurrent ();
+  if (message->ts < current->granted)
+    {
+      NS_FATAL_ERROR ("Event for context " << message->context << " at " <<
+                      message->ts << " is within the current window of its partition;"
+                      " delays between partitions must not be smaller than the lookahead");
+    }
+  message->source = g_currentPartition;
+  message->sequence = current->sent;
+  current->sent++;
+  Message *head;
+  do
+    {
+      head = partition->mailbox;
+      message->next = head;
+    }
+  while (!__sync_bool_compare_and_swap (&partition->mailbox, head, message));
+}
+
+bool
+MultithreadedSimulatorImpl::IsEarlier (const Message *a, const Message *b)
+{
+  if (a->ts != b->ts)
+    {
+      return a->ts < b->ts;
+    }
+  if (a->source != b->source)
+    {
+      return a->source < b->source;
+    }
+  return a->sequence < b->sequence;
+}
+
+void
+MultithreadedSimulatorImpl::ReceiveMessages (Partition *partition)
+{
+  Message *message = __sync_lock_test_and_set (&partition->mailbox, static_cast<Message *> (0));
+  if (message == 0)
+    {
+      return;
+    }
+  std::vector<Message *> &inbox = partition->inbox;
+  while (message != 0)
+    {
+      inbox.push_back (message);
+      message = message->next;
+    }
+  // the order of the mailbox depends on thread interleaving
+  std::sort (inbox.begin (), inbox.end (), &MultithreadedSimulatorImpl::IsEarlier);
+  for (std::vector<Message *>::const_iterator i = inbox.begin (); i != inbox.end (); ++i)
+    {
+      message = *i;
+      EventImpl *event = message->event;
+      if (event == 0)
+        {
+          Ptr<Packet> p = Create<Packet> (message->data, message->size, true);
+          event = MakeEvent (&MpiReceiver::Receive, message->receiver, p);
+          delete [] message->data;
+        }
+      Insert (partition, message->ts, message->context, event);
+      delete message;
+    }
+  inbox.clear ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  // SystemCondition cannot be used here because a waiter resets the
+  // condition for all the other waiters.
+  uint32_t generation = m_barrierGeneration;
+  __sync_synchronize ();
+  if (__sync_add_and_fetch (&m_barrierCount, 1) == m_partitions.size ())
+    {
+      m_barrierCount = 0;
+      __sync_fetch_and_add (&m_barrierGeneration, 1);
+    }
+  else
+    {
+      while (m_barrierGeneration == generation)
+        {
+          sched_yield ();
+        }
+    }
+  __sync_synchronize ();
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  g_currentPartition = index;
+  Partition *partition = m_partitions[index];
+  while (true)
+    {
+      // wait for the messages of the previous window
+      Barrier ();
+      ReceiveMessages (partition);
+      partition->nextTs = partition->events->IsEmpty () ? NO_EVENT : partition->events->PeekNext ().key.m_ts;
+      // the stop requests are only modified while events are processed,
+      // each by the thread of its partition, so every thread latches
+      // the same stop state here.
+      partition->stop = false;
+      partition->stopTs = NO_EVENT;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          partition->stop = partition->stop || (*i)->stopRequested;
+          partition->stopTs = std::min (partition->stopTs, (*i)->stopRequestTs);
+        }
+      Barrier ();
+
+      // every thread computes the same window from the same values
+      uint64_t lbts = NO_EVENT;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          lbts = std::min (lbts, (*i)->nextTs);
+        }
+      if (lbts == NO_EVENT || partition->stop || lbts >= partition->stopTs)
+        {
+          break;
+        }
+      uint64_t granted = (m_lookAhead >= NO_EVENT - lbts) ? NO_EVENT : lbts + m_lookAhead;
+      partition->granted = granted;
+      granted = std::min (granted, partition->stopTs);
+      // the stop requests of this partition apply at once to its events
+      while (!partition->events->IsEmpty () && !partition->stopRequested
+             && partition->events->PeekNext ().key.m_ts < std::min (granted, partition->stopRequestTs))
+        {
+          ProcessOneEvent (partition);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Redistribute (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Scheduler::Event> events;
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      Partition *partition = m_partitions[i];
+      while (!partition->events->IsEmpty ())
+        {
+          events.push_back (partition->events->RemoveNext ());
+        }
+      for (std::vector<Scheduler::Event>::const_iterator j = events.begin (); j != events.end (); ++j)
+        {
+          // the events which are not run by a node stay where they are
+          uint32_t target = j->key.m_context < m_contextToPartition.size () ?
+            m_contextToPartition[j->key.m_context] : i;
+          if (target != i)
+            {
+              NS_LOG_LOGIC ("move event of context " << j->key.m_context << " to partition " << target);
+              partition->unscheduledEvents--;
+              m_partitions[target]->unscheduledEvents++;
+            }
+          m_partitions[target]->events->Insert (*j);
+        }
+      events.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunWorker (void)
+{
+  RunPartition (__sync_fetch_and_add (&m_nextWorker, 1));
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (g_currentPartition == 0);
+
+  // freeze the assignment of nodes to partitions
+  m_contextToPartition.clear ();
+  for (NodeList::Iterator node = NodeList::Begin (); node != NodeList::End (); ++node)
+    {
+      m_contextToPartition.push_back (GetPartition ((*node)->GetSystemId ()));
+    }
+  // the events scheduled before the nodes were assigned to their
+  // partitions, e.g., by Node::Construct, join their partition.
+  Redistribute ();
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->uid = std::max ((*i)->uid, m_uid);
+    }
+  CalculateLookAhead ();
+  NS_LOG_LOGIC (m_partitions.size () << " partitions");
+
+  m_stop = false;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->stopRequested = false;
+    }
+  m_running = true;
+  m_nextWorker = 1;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_partitions.size (); ++i)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::RunWorker, this));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  RunPartition (0);
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  g_currentPartition = 0;
+  m_running = false;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      m_uid = std::max (m_uid, (*i)->uid);
+      m_stop = m_stop || (*i)->stopRequested;
+      (*i)->stopRequestTs = NO_EVENT;
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      NS_ASSERT (!(*i)->events->IsEmpty () || (*i)->unscheduledEvents == 0);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  GetCurrent ()->stopRequested = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+  Partition *partition = GetCurrent ();
+  partition->stopRequestTs = std::min (partition->stopRequestTs, partition->currentTs + time.GetTimeStep ());
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep () << event);
+
+  Partition *current = GetCurrent ();
+  Time tAbsolute = time + TimeStep (current->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (current->currentTs));
+  return Insert (current, tAbsolute.GetTimeStep (), current->currentContext, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+
+  Partition *current = GetCurrent ();
+  uint64_t ts = current->currentTs + time.GetTimeStep ();
+  uint32_t index = FindPartition (context);
+  if (!m_running || index == g_currentPartition)
+    {
+      Insert (m_partitions[index], ts, context, event);
+    }
+  else
+    {
+      Message *message = new Message ();
+      message->ts = ts;
+      message->context = context;
+      message->event = event;
+      message->receiver = 0;
+      message->data = 0;
+      message->size = 0;
+      Post (m_partitions[index], message);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  Partition *current = GetCurrent ();
+  return Insert (current, current->currentTs, current->currentContext, event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+void
+MultithreadedSimulatorImpl::SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev)
+{
+  NS_ASSERT_MSG (m_instance != 0 && m_instance->m_running,
+                 "MultithreadedSimulatorImpl::SendPacket invoked outside of Run");
+  m_instance->DoSendPacket (p, rxTime.GetTimeStep (), node, dev);
+}
+
+void
+MultithreadedSimulatorImpl::DoSendPacket (Ptr<Packet> p, uint64_t ts, uint32_t node, uint32_t dev)
+{
+  NS_LOG_FUNCTION (this << p << ts << node << dev);
+  std::map<uint64_t, Peer>::const_iterator i =
+    m_peers.find (static_cast<uint64_t> (node) << 32 | dev);
+  NS_ASSERT_MSG (i != m_peers.end (), "Device " << dev << " of node " << node <<
+                 " is not connected to another partition");
+  // the packet is serialized because reference counts are not thread-safe
+  Message *message = new Message ();
+  message->ts = ts;
+  message->context = i->second.context;
+  message->event = 0;
+  message->receiver = i->second.receiver;
+  message->size = p->GetSerializedSize ();
+  message->data = new uint8_t[message->size];
+  p->Serialize (message->data, message->size);
+  Post (m_partitions[i->second.partition], message);
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrent ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  uint32_t index = FindPartition (id.GetContext ());
+  if (m_running && index != g_currentPartition)
+    {
+      // the scheduler of another partition cannot be modified
+      Cancel (id);
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = m_partitions[index];
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0 ||
+          ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  const Partition *partition = m_partitions[FindPartition (ev.GetContext ())];
+  if (ev.PeekEventImpl () == 0 ||
+      ev.GetTs () < partition->currentTs ||
+      (ev.GetTs () == partition->currentTs &&
+       ev.GetUid () <= partition->currentUid) ||
+      ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->currentContext;
+}
+
+bool
+MultithreadedSimulatorImpl::IsEnabled (void)
+{
+  if (m_instance != 0)
+    {
+      return true;
+    }
+  StringValue type;
+  GlobalValue::GetValueByName ("SimulatorImplementationType", type);
+  return type.Get () == GetTypeId ().GetName ();
+}
+
+} // namespace ns3
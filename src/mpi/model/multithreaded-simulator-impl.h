@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-mutex.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class MpiReceiver;
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief shared-memory parallel simulator implementation using lookahead
+ *
+ * This implementation executes the partitions of a simulation in
+ * parallel within a single process, using one thread per partition.
+ * Nodes are assigned to partitions through their system id, exactly as
+ * for the DistributedSimulatorImpl, so the same topology scripts can be
+ * used without MPI: the partition of system id 0 runs in the thread
+ * which invokes Simulator::Run and the other partitions run in
+ * additional threads.
+ *
+ * Each partition owns its own event scheduler. The partitions advance
+ * in lock step through conservative time windows: at the start of each
+ * window the threads synchronize on a barrier, compute the lower bound
+ * on the timestamp of the next event of any partition (LBTS) and then
+ * process, without any further synchronization, all their events
+ * earlier than LBTS plus the lookahead. The lookahead is the smallest
+ * delay of the point-to-point links which connect two partitions.
+ *
+ * Packets crossing partitions are serialized by the
+ * PointToPointRemoteChannel and posted to a lock-free mailbox of the
+ * receiving partition, which deserializes them in its own thread.
+ * Incoming messages are sorted by timestamp and sender before being
+ * scheduled, so that a simulation gives the same results regardless of
+ * thread interleaving.
+ *
+ * Limitations:
+ *  - only point-to-point links may connect nodes of different
+ *    partitions, and this implementation must be selected before the
+ *    links are created so that the PointToPointHelper creates remote
+ *    channels for them;
+ *  - objects must not be shared by nodes of different partitions;
+ *  - the stop requests are combined by all the partitions at the start
+ *    of each window: Simulator::Stop () stops the caller's partition
+ *    after the current event, but the other partitions only at the end
+ *    of the current window; Simulator::Stop (time) stops all partitions
+ *    before the events of the stop time if it is called before
+ *    Simulator::Run or with a delay of at least the lookahead,
+ *    otherwise the other partitions may run the events of the current
+ *    window which follow the stop time.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns true if the MultithreadedSimulatorImpl is, or will be,
+   * the simulator implementation.
+   */
+  static bool IsEnabled (void);
+  /**
+   * \brief Deliver a packet to the peer of a device in another partition
+   *
+   * \param p packet to send
+   * \param rxTime absolute time at which the packet must be received
+   * \param node id of the node which sends the packet
+   * \param dev interface index of the device which sends the packet
+   */
+  static void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+
+private:
+  struct Message
+  {
+    Message *next;
+    uint64_t ts;
+    uint32_t context;
+    // index of the sending partition and sequence number within it,
+    // used to order messages deterministically
+    uint32_t source;
+    uint64_t sequence;
+    // event to schedule or, if zero, serialized packet for the receiver
+    EventImpl *event;
+    MpiReceiver *receiver;
+    uint8_t *data;
+    uint32_t size;
+  };
+  struct Partition
+  {
+    Partition ();
+    Ptr<Scheduler> events;
+    uint32_t systemId;
+    uint32_t uid;
+    uint32_t currentUid;
+    uint64_t currentTs;
+    uint32_t currentContext;
+    // number of events that have been inserted but not yet scheduled,
+    // not counting the "destroy" events; this is used for validation
+    int unscheduledEvents;
+    // messages posted by other partitions, pushed by their threads
+    Message * volatile mailbox;
+    uint64_t sent;
+    // stop requests of the events of this partition, only written by
+    // its thread while the events are processed
+    bool stopRequested;
+    uint64_t stopRequestTs;
+    // window state, only written between the two barriers of a window
+    uint64_t nextTs;
+    bool stop;
+    uint64_t stopTs;
+    uint64_t granted;
+    std::vector<Message *> inbox;
+  };
+  struct Peer
+  {
+    uint32_t partition;
+    uint32_t context;
+    MpiReceiver *receiver;
+  };
+  typedef std::list<EventId> DestroyEvents;
+
+  virtual void DoDispose (void);
+  static bool IsEarlier (const Message *a, const Message *b);
+
+  uint32_t GetPartition (uint32_t systemId);
+  uint32_t FindPartition (uint32_t context) const;
+  Partition *GetCurrent (void) const;
+  void CalculateLookAhead (void);
+  EventId Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  void Redistribute (void);
+  void Post (Partition *partition, Message *message);
+  void DoSendPacket (Ptr<Packet> p, uint64_t ts, uint32_t node, uint32_t dev);
+  void ReceiveMessages (Partition *partition);
+  void ProcessOneEvent (Partition *partition);
+  void Barrier (void);
+  void RunPartition (uint32_t index);
+  void RunWorker (void);
+
+  std::vector<Partition *> m_partitions;
+  std::map<uint32_t, uint32_t> m_systemIdToPartition;
+  // frozen when Run is entered, indexed by node id
+  std::vector<uint32_t> m_contextToPartition;
+  // remote peer of each (node id, interface index) crossing partitions
+  std::map<uint64_t, Peer> m_peers;
+  ObjectFactory m_schedulerFactory;
+  // uid of the next event inserted outside of Run
+  uint32_t m_uid;
+  DestroyEvents m_destroyEvents;
+  SystemMutex m_destroyEventsMutex;
+  uint64_t m_lookAhead;
+  // whether the last Run was stopped, for IsFinished
+  bool m_stop;
+  bool m_running;
+  volatile uint32_t m_nextWorker;
+  volatile uint32_t m_barrierCount;
+  volatile uint32_t m_barrierGeneration;
+
+  static MultithreadedSimulatorImpl *m_instance;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,374 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/mac48-address.h"
+#include "ns3/system-thread.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+// the MultithreadedSimulatorImpl only accepts point-to-point links with
+// a delay between partitions.
+class DelayChannel : public SimpleChannel
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::MultithreadedTestDelayChannel")
+      .SetParent<SimpleChannel> ()
+      .AddConstructor<DelayChannel> ()
+      .AddAttribute ("Delay", "Transmission delay through the channel",
+                     TimeValue (MilliSeconds (10)),
+                     MakeTimeAccessor (&DelayChannel::m_delay),
+                     MakeTimeChecker ())
+    ;
+    return tid;
+  }
+private:
+  Time m_delay;
+};
+
+class PointToPointDevice : public SimpleNetDevice
+{
+public:
+  virtual bool IsPointToPoint (void) const
+  {
+    return true;
+  }
+};
+
+// connect two nodes of different partitions
+void
+Connect (Ptr<Node> a, Ptr<Node> b)
+{
+  Ptr<DelayChannel> channel = CreateObject<DelayChannel> ();
+  Ptr<Node> nodes[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<PointToPointDevice> device = CreateObject<PointToPointDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      device->AggregateObject (CreateObject<MpiReceiver> ());
+      nodes[i]->AddDevice (device);
+    }
+}
+
+Ptr<Node>
+CreateNode (uint32_t systemId)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  node->SetAttribute ("SystemId", UintegerValue (systemId));
+  return node;
+}
+
+} // anonymous namespace
+
+class MultithreadedStopTestCase : public TestCase
+{
+public:
+  MultithreadedStopTestCase ();
+  virtual void DoRun (void);
+private:
+  void Tick (uint32_t node);
+  std::vector<uint32_t> m_ticks;
+  std::vector<Time> m_last;
+};
+
+MultithreadedStopTestCase::MultithreadedStopTestCase ()
+  : TestCase ("Check that Simulator::Stop stops all the partitions")
+{
+}
+
+void
+MultithreadedStopTestCase::Tick (uint32_t node)
+{
+  m_ticks[node]++;
+  m_last[node] = Simulator::Now ();
+  Simulator::Schedule (Seconds (1.0), &MultithreadedStopTestCase::Tick, this, node);
+}
+
+void
+MultithreadedStopTestCase::DoRun (void)
+{
+  Simulator::SetImplementation (CreateObject<MultithreadedSimulatorImpl> ());
+  const uint32_t n = 4;
+  m_ticks.assign (n, 0);
+  m_last.assign (n, Seconds (0.0));
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      nodes.push_back (CreateNode (i));
+      Simulator::ScheduleWithContext (i, Seconds (1.0), &MultithreadedStopTestCase::Tick, this, i);
+    }
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Connect (nodes[0], nodes[i]);
+    }
+  Simulator::Stop (Seconds (5.5));
+  Simulator::Run ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t ticks = m_ticks[i];
+      Time last = m_last[i];
+      NS_TEST_EXPECT_MSG_EQ (ticks, 5, "Wrong number of events run by node " << i);
+      NS_TEST_EXPECT_MSG_EQ (last, Seconds (5.0), "Wrong time of the last event of node " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsFinished (), false, "Events were lost when the simulation stopped");
+  Simulator::Destroy ();
+}
+
+class MultithreadedStopRequestTestCase : public TestCase
+{
+public:
+  MultithreadedStopRequestTestCase ();
+  virtual void DoRun (void);
+private:
+  void Tick (uint32_t node);
+  void Stop (bool now);
+  void Run (bool now);
+  std::vector<Time> m_last;
+};
+
+MultithreadedStopRequestTestCase::MultithreadedStopRequestTestCase ()
+  : TestCase ("Check that Simulator::Stop called by a partition stops all the partitions")
+{
+}
+
+void
+MultithreadedStopRequestTestCase::Tick (uint32_t node)
+{
+  m_last[node] = Simulator::Now ();
+  Simulator::Schedule (MilliSeconds (1), &MultithreadedStopRequestTestCase::Tick, this, node);
+}
+
+void
+MultithreadedStopRequestTestCase::Stop (bool now)
+{
+  if (now)
+    {
+      Simulator::Stop ();
+    }
+  else
+    {
+      Simulator::Stop (MilliSeconds (20));
+    }
+}
+
+void
+MultithreadedStopRequestTestCase::Run (bool now)
+{
+  Simulator::SetImplementation (CreateObject<MultithreadedSimulatorImpl> ());
+  const uint32_t n = 4;
+  m_last.assign (n, Seconds (0.0));
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      nodes.push_back (CreateNode (i));
+      Simulator::ScheduleWithContext (i, MilliSeconds (1), &MultithreadedStopRequestTestCase::Tick, this, i);
+    }
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Connect (nodes[0], nodes[i]);
+    }
+  // requested by the partition of node 2, the lookahead is 10ms.
+  Simulator::ScheduleWithContext (2, MilliSeconds (100), &MultithreadedStopRequestTestCase::Stop, this, now);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+MultithreadedStopRequestTestCase::DoRun (void)
+{
+  Run (false);
+  for (uint32_t i = 0; i < m_last.size (); i++)
+    {
+      Time last = m_last[i];
+      NS_TEST_EXPECT_MSG_EQ (last, MilliSeconds (119), "Node " << i << " not stopped at the stop time");
+    }
+
+  // the stop event of node 2 runs before its tick of the same time.
+  Run (true);
+  Time last = m_last[2];
+  NS_TEST_EXPECT_MSG_EQ (last, MilliSeconds (99), "The partition of node 2 not stopped at once");
+  for (uint32_t i = 0; i < m_last.size (); i++)
+    {
+      last = m_last[i];
+      NS_TEST_EXPECT_MSG_GT (last, MilliSeconds (98), "Node " << i << " stopped before the request");
+      NS_TEST_EXPECT_MSG_LT (last, MilliSeconds (110), "Node " << i << " not stopped at the end of the window");
+    }
+}
+
+class MultithreadedContextTestCase : public TestCase
+{
+public:
+  MultithreadedContextTestCase ();
+  virtual void DoRun (void);
+private:
+  void Send (uint32_t to, Time delay, uint32_t hops);
+  void Receive (uint32_t to, uint32_t hops);
+  struct Reception
+  {
+    Time time;
+    uint32_t context;
+    bool mainThread;
+  };
+  std::vector<Reception> m_receptions;
+  std::vector<Ptr<Node> > m_nodes;
+};
+
+MultithreadedContextTestCase::MultithreadedContextTestCase ()
+  : TestCase ("Check that ScheduleWithContext delivers events to other partitions")
+{
+}
+
+void
+MultithreadedContextTestCase::Send (uint32_t to, Time delay, uint32_t hops)
+{
+  Simulator::ScheduleWithContext (to, delay, &MultithreadedContextTestCase::Receive, this, to, hops);
+}
+
+void
+MultithreadedContextTestCase::Receive (uint32_t to, uint32_t hops)
+{
+  // each reception happens after the previous one, whatever thread it runs in
+  Reception reception;
+  reception.time = Simulator::Now ();
+  reception.context = Simulator::GetContext ();
+  reception.mainThread = SystemThread::IsMainThread ();
+  m_receptions.push_back (reception);
+  if (hops > 1)
+    {
+      Send (1 - to, MilliSeconds (20), hops - 1);
+    }
+}
+
+void
+MultithreadedContextTestCase::DoRun (void)
+{
+  Simulator::SetImplementation (CreateObject<MultithreadedSimulatorImpl> ());
+  m_nodes.push_back (CreateNode (0));
+  m_nodes.push_back (CreateNode (1));
+  Connect (m_nodes[0], m_nodes[1]);
+  Simulator::ScheduleWithContext (0, Seconds (1.0), &MultithreadedContextTestCase::Send, this, 1, MilliSeconds (10), 4);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_receptions.size (), 4, "Wrong number of events received");
+  Time expected = MilliSeconds (1010);
+  for (uint32_t i = 0; i < m_receptions.size (); i++)
+    {
+      Reception reception = m_receptions[i];
+      uint32_t node = 1 - i % 2;
+      bool mainThread = (node == 0);
+      NS_TEST_EXPECT_MSG_EQ (reception.time, expected, "Wrong time of reception " << i);
+      NS_TEST_EXPECT_MSG_EQ (reception.context, node, "Wrong context of reception " << i);
+      NS_TEST_EXPECT_MSG_EQ (reception.mainThread, mainThread, "Reception " << i << " run by the wrong partition");
+      expected += MilliSeconds (20);
+    }
+  Simulator::Destroy ();
+  m_nodes.clear ();
+}
+
+class MultithreadedEarlyEventsTestCase : public TestCase
+{
+public:
+  MultithreadedEarlyEventsTestCase ();
+  virtual void DoRun (void);
+private:
+  void Check (uint32_t node);
+  // not vector<bool>: the partitions write to their elements concurrently
+  std::vector<uint8_t> m_checked;
+  std::vector<uint32_t> m_contexts;
+  std::vector<uint8_t> m_mainThread;
+};
+
+MultithreadedEarlyEventsTestCase::MultithreadedEarlyEventsTestCase ()
+  : TestCase ("Check that events scheduled before the nodes are partitioned run in their partition")
+{
+}
+
+void
+MultithreadedEarlyEventsTestCase::Check (uint32_t node)
+{
+  m_checked[node] = true;
+  m_contexts[node] = Simulator::GetContext ();
+  m_mainThread[node] = SystemThread::IsMainThread ();
+}
+
+void
+MultithreadedEarlyEventsTestCase::DoRun (void)
+{
+  Simulator::SetImplementation (CreateObject<MultithreadedSimulatorImpl> ());
+  const uint32_t n = 4;
+  m_checked.assign (n, false);
+  m_contexts.assign (n, 0);
+  m_mainThread.assign (n, false);
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      nodes.push_back (CreateObject<Node> ());
+    }
+  // the devices schedule their initialization, and the events below
+  // are scheduled, while all the nodes still have the system id 0.
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Connect (nodes[0], nodes[i]);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Simulator::ScheduleWithContext (i, Seconds (i), &MultithreadedEarlyEventsTestCase::Check, this, i);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      nodes[i]->SetAttribute ("SystemId", UintegerValue (i));
+    }
+  Simulator::Run ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      bool checked = m_checked[i];
+      uint32_t context = m_contexts[i];
+      bool mainThread = m_mainThread[i];
+      bool expected = (i == 0);
+      NS_TEST_EXPECT_MSG_EQ (checked, true, "Event of node " << i << " was not run");
+      NS_TEST_EXPECT_MSG_EQ (context, i, "Wrong context of the event of node " << i);
+      NS_TEST_EXPECT_MSG_EQ (mainThread, expected, "Event of node " << i << " run by the wrong partition");
+    }
+  Simulator::Destroy ();
+}
+
+class MultithreadedSimulatorImplTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorImplTestSuite ()
+    : TestSuite ("mpi-multithreaded", UNIT)
+  {
+    AddTestCase (new MultithreadedStopTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedStopRequestTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedContextTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedEarlyEventsTestCase (), TestCase::QUICK);
+  }
+} g_multithreadedSimulatorImplTestSuite;
@@ -20,6 +20,13 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/core-config.h"
+#include <algorithm>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
 
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
@@ -48,46 +55,229 @@ namespace ns3 {
 
 uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+// capacity of the data of the smallest size class
+static const uint32_t BUFFER_SLAB_MIN_SIZE = 64;
+
+static GlobalValue g_bufferSlabMaxSize ("BufferSlabMaxSize",
+                                        "The largest size, in bytes, of the buffer data cached "
+                                        "for reuse; larger data are always released to the system.",
+                                        UintegerValue (16384),
+                                        MakeUintegerChecker<uint32_t> (BUFFER_SLAB_MIN_SIZE));
+static GlobalValue g_bufferSlabCapacity ("BufferSlabCapacity",
+                                         "The number of buffer data of each size class cached "
+                                         "for reuse by each thread.",
+                                         UintegerValue (1024),
+                                         MakeUintegerChecker<uint32_t> ());
+
+/* Each thread owns a slab, which it finds through a thread-specific
+ * key. The key of a thread which has released its slab is set to
+ * DESTROYED_SLAB so that the slab is not re-created by the static
+ * destructors which run afterwards: those buffers are allocated and
+ * released directly.
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
+#define DESTROYED_SLAB ((struct Buffer::Slab *)(~(long) 0))
+std::vector<struct Buffer::Slab *> *Buffer::g_slabs = 0;
+struct Buffer::SlabStatistics Buffer::g_retiredStats = { 0, 0, 0, 0 };
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+#ifdef HAVE_PTHREAD_H
+static pthread_key_t g_slabKey;
+static pthread_once_t g_slabKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_slabsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+#else
+static void *g_slab = 0;
+#endif /* HAVE_PTHREAD_H */
+#ifdef HAVE_TLS
+// a copy of the thread-specific key, which is only needed to destroy
+// the slab when the thread exits
+static __thread void *g_threadSlab = 0;
+#endif /* HAVE_TLS */
+// the global values, read once by the first slab created after they
+// are registered; these are protected by g_slabsMutex
+static bool g_slabConfigured = false;
+static uint32_t g_slabMaxSize = 16384;
+static uint32_t g_slabCapacity = 1024;
+
+static void
+LockSlabs (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock (&g_slabsMutex);
+#endif
+}
+
+static void
+UnlockSlabs (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock (&g_slabsMutex);
+#endif
+}
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  // the thread-specific destructor is not invoked for the main thread
+  Buffer::DestroySlab (Buffer::GetSlab ());
+}
+
+void
+Buffer::CreateSlabKey (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_key_create (&g_slabKey, &Buffer::DestroySlab);
+#endif
+}
+
+uint32_t
+Buffer::GetSizeClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  while ((BUFFER_SLAB_MIN_SIZE << sizeClass) < size)
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+void
+Buffer::SetThreadSlab (struct Buffer::Slab *slab)
+{
+#ifdef HAVE_TLS
+  g_threadSlab = slab;
+#endif /* HAVE_TLS */
+#ifdef HAVE_PTHREAD_H
+  pthread_setspecific (g_slabKey, slab);
+#else
+  g_slab = slab;
+#endif /* HAVE_PTHREAD_H */
+}
+
+struct Buffer::Slab *
+Buffer::GetSlab (void)
+{
+#ifdef HAVE_TLS
+  struct Buffer::Slab *slab = static_cast<struct Buffer::Slab *> (g_threadSlab);
+#elif defined (HAVE_PTHREAD_H)
+  pthread_once (&g_slabKeyOnce, &CreateSlabKey);
+  struct Buffer::Slab *slab = static_cast<struct Buffer::Slab *> (pthread_getspecific (g_slabKey));
+#else
+  struct Buffer::Slab *slab = static_cast<struct Buffer::Slab *> (g_slab);
+#endif
+  if (slab == DESTROYED_SLAB)
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
+      return 0;
+    }
+  if (slab != 0)
+    {
+      return slab;
+    }
+  return CreateSlab ();
+}
+
+struct Buffer::Slab *
+Buffer::CreateSlab (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_slabKeyOnce, &CreateSlabKey);
+#endif /* HAVE_PTHREAD_H */
+  struct Buffer::Slab *slab = new struct Buffer::Slab ();
+  slab->m_stats.hits = 0;
+  slab->m_stats.misses = 0;
+  slab->m_stats.recycled = 0;
+  slab->m_stats.released = 0;
+  LockSlabs ();
+  if (!g_slabConfigured)
+    {
+      // The global values may not be registered yet if the first buffer
+      // is created by a static constructor: the defaults are used until
+      // they are.
+      UintegerValue maxSize;
+      UintegerValue capacity;
+      if (GlobalValue::GetValueByNameFailSafe ("BufferSlabMaxSize", maxSize)
+          && GlobalValue::GetValueByNameFailSafe ("BufferSlabCapacity", capacity))
         {
-          Buffer::Deallocate (*i);
+          g_slabMaxSize = maxSize.Get ();
+          g_slabCapacity = capacity.Get ();
+          g_slabConfigured = true;
         }
-      delete g_freeList;
-      g_freeList = DESTROYED;
     }
+  slab->m_maxSize = g_slabMaxSize;
+  slab->m_capacity = g_slabCapacity;
+  if (g_slabs == 0)
+    {
+      g_slabs = new std::vector<struct Buffer::Slab *> ();
+    }
+  g_slabs->push_back (slab);
+  UnlockSlabs ();
+  slab->m_classes.resize (GetSizeClass (slab->m_maxSize) + 1);
+  slab->m_maxSize = BUFFER_SLAB_MIN_SIZE << (slab->m_classes.size () - 1);
+  SetThreadSlab (slab);
+  return slab;
+}
+
+void
+Buffer::DestroySlab (void *p)
+{
+  struct Buffer::Slab *slab = static_cast<struct Buffer::Slab *> (p);
+  if (slab == 0 || slab == DESTROYED_SLAB)
+    {
+      return;
+    }
+  LockSlabs ();
+  g_retiredStats.hits += slab->m_stats.hits;
+  g_retiredStats.misses += slab->m_stats.misses;
+  g_retiredStats.recycled += slab->m_stats.recycled;
+  g_retiredStats.released += slab->m_stats.released;
+  g_slabs->erase (std::find (g_slabs->begin (), g_slabs->end (), slab));
+  UnlockSlabs ();
+  for (std::vector<FreeList>::iterator i = slab->m_classes.begin ();
+       i != slab->m_classes.end (); ++i)
+    {
+      for (FreeList::iterator j = i->begin (); j != i->end (); ++j)
+        {
+          Buffer::Deallocate (*j);
+        }
+    }
+  delete slab;
+  SetThreadSlab (DESTROYED_SLAB);
+}
+
+struct Buffer::SlabStatistics
+Buffer::GetSlabStatistics (void)
+{
+  LockSlabs ();
+  struct Buffer::SlabStatistics stats = g_retiredStats;
+  if (g_slabs != 0)
+    {
+      for (std::vector<struct Buffer::Slab *>::const_iterator i = g_slabs->begin ();
+           i != g_slabs->end (); ++i)
+        {
+          stats.hits += (*i)->m_stats.hits;
+          stats.misses += (*i)->m_stats.misses;
+          stats.recycled += (*i)->m_stats.recycled;
+          stats.released += (*i)->m_stats.released;
+        }
+    }
+  UnlockSlabs ();
+  return stats;
+}
+
+void
+Buffer::ResetSlabStatistics (void)
+{
+  struct Buffer::SlabStatistics zero = { 0, 0, 0, 0 };
+  LockSlabs ();
+  g_retiredStats = zero;
+  if (g_slabs != 0)
+    {
+      for (std::vector<struct Buffer::Slab *>::const_iterator i = g_slabs->begin ();
+           i != g_slabs->end (); ++i)
+        {
+          (*i)->m_stats = zero;
+        }
+    }
+  UnlockSlabs ();
 }
 
 void
@@ -95,46 +285,56 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  struct Buffer::Slab *slab = GetSlab ();
+  if (slab == 0)
     {
       Buffer::Deallocate (data);
+      return;
     }
-  else
+  if (data->m_size <= slab->m_maxSize)
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      // only the data allocated with the size of their class are
+      // cached, so that any data of a class fits any request
+      uint32_t sizeClass = GetSizeClass (data->m_size);
+      FreeList &freeList = slab->m_classes[sizeClass];
+      if (data->m_size == (BUFFER_SLAB_MIN_SIZE << sizeClass)
+          && freeList.size () < slab->m_capacity)
+        {
+          freeList.push_back (data);
+          slab->m_stats.recycled++;
+          return;
+        }
     }
+  slab->m_stats.released++;
+  Buffer::Deallocate (data);
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  struct Buffer::Slab *slab = GetSlab ();
+  if (slab == 0)
     {
-      g_freeList = new Buffer::FreeList ();
+      return Buffer::Allocate (dataSize);
     }
-  else if (IS_INITIALIZED (g_freeList))
+  if (dataSize > slab->m_maxSize)
     {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
+      slab->m_stats.misses++;
+      return Buffer::Allocate (dataSize);
+    }
+  uint32_t sizeClass = GetSizeClass (dataSize);
+  FreeList &freeList = slab->m_classes[sizeClass];
+  if (!freeList.empty ())
+    {
+      struct Buffer::Data *data = freeList.back ();
+      freeList.pop_back ();
+      data->m_count = 1;
+      slab->m_stats.hits++;
+      return data;
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
+  slab->m_stats.misses++;
+  struct Buffer::Data *data = Buffer::Allocate (BUFFER_SLAB_MIN_SIZE << sizeClass);
   NS_ASSERT (data->m_count == 1);
   return data;
 }
@@ -153,6 +353,18 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+struct Buffer::SlabStatistics
+Buffer::GetSlabStatistics (void)
+{
+  struct Buffer::SlabStatistics stats = { 0, 0, 0, 0 };
+  return stats;
+}
+
+void
+Buffer::ResetSlabStatistics (void)
+{
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -25,7 +25,7 @@
 #include <ostream>
 #include "ns3/assert.h"
 
-#define noBUFFER_FREE_LIST 1
+#define BUFFER_FREE_LIST 1
 
 namespace ns3 {
 
@@ -529,6 +529,33 @@ private:
   Buffer (uint32_t dataSize);
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \brief statistics of the allocator of the buffer data
+   *
+   * The data of released buffers are cached by each thread in a slab
+   * of power-of-two size classes, from which the new buffers are
+   * allocated. The size of the largest class is set by the
+   * "BufferSlabMaxSize" global value and the number of data cached per
+   * class by "BufferSlabCapacity"; both are read once, when the first
+   * buffer is created after they are registered, and apply to all the
+   * threads.
+   */
+  struct SlabStatistics
+  {
+    uint64_t hits;     //!< data allocated from a slab
+    uint64_t misses;   //!< data allocated from the system
+    uint64_t recycled; //!< data released to a slab
+    uint64_t released; //!< data released to the system
+  };
+  /**
+   * \returns the statistics of the allocator, summed over all threads
+   */
+  static SlabStatistics GetSlabStatistics (void);
+  /**
+   * Reset the statistics of the allocator.
+   */
+  static void ResetSlabStatistics (void);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -615,12 +642,27 @@ private:
 
 #ifdef BUFFER_FREE_LIST
   typedef std::vector<struct Buffer::Data*> FreeList;
+  /* The released data of each size class, owned by a thread.
+   */
+  struct Slab
+  {
+    std::vector<FreeList> m_classes;
+    uint32_t m_maxSize;
+    uint32_t m_capacity;
+    struct SlabStatistics m_stats;
+  };
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize;
-  static FreeList *g_freeList;
+  static void CreateSlabKey (void);
+  static struct Slab *GetSlab (void);
+  static struct Slab *CreateSlab (void);
+  static void SetThreadSlab (struct Slab *slab);
+  static void DestroySlab (void *slab);
+  static uint32_t GetSizeClass (uint32_t size);
+  static std::vector<struct Slab *> *g_slabs;
+  static struct SlabStatistics g_retiredStats;
   static struct LocalStaticDestructor g_localStaticDestructor;
 #endif
 };
@@ -19,6 +19,10 @@
  */
 #include "byte-tag-list.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
 #include <vector>
 #include <cstring>
 
@@ -137,6 +141,10 @@ ByteTagList::ByteTagList (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
+    }
 }
 ByteTagList &
 ByteTagList::operator = (const ByteTagList &o)
@@ -153,6 +161,10 @@ ByteTagList::operator = (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
+    }
   return *this;
 }
 ByteTagList::~ByteTagList ()
@@ -169,10 +181,21 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
   NS_LOG_FUNCTION (this << tid << bufferSize << start << end);
   uint32_t spaceNeeded = m_used + bufferSize + 4 + 4 + 4 + 4;
   NS_ASSERT (m_used <= spaceNeeded);
+  if (m_data == 0 && spaceNeeded <= INLINE_SIZE)
+    {
+      TagBuffer tag = TagBuffer (&m_inline[m_used], &m_inline[spaceNeeded]);
+      tag.WriteU32 (tid.GetUid ());
+      tag.WriteU32 (bufferSize);
+      tag.WriteU32 (start);
+      tag.WriteU32 (end);
+      m_used = spaceNeeded;
+      return tag;
+    }
   if (m_data == 0)
     {
+      // spill the inline tags to the heap
       m_data = Allocate (spaceNeeded);
-      m_used = 0;
+      std::memcpy (&m_data->data, m_inline, m_used);
     } 
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
@@ -206,6 +229,13 @@ ByteTagList::Add (const ByteTagList &o)
     }
 }
 
+bool
+ByteTagList::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_used == 0;
+}
+
 void 
 ByteTagList::RemoveAll (void)
 {
@@ -228,10 +258,15 @@ ByteTagList::Iterator
 ByteTagList::Begin (int32_t offsetStart, int32_t offsetEnd) const
 {
   NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
-  if (m_data == 0)
+  if (m_used == 0)
     {
       return Iterator (0, 0, offsetStart, offsetEnd);
     }
+  else if (m_data == 0)
+    {
+      uint8_t *start = const_cast<uint8_t *> (m_inline);
+      return Iterator (start, start + m_used, offsetStart, offsetEnd);
+    }
   else
     {
       return Iterator (m_data->data, &m_data->data[m_used], offsetStart, offsetEnd);
@@ -340,11 +375,23 @@ ByteTagList::AddAtStart (int32_t adjustment, int32_t prependOffset)
 
 #ifdef USE_FREE_LIST
 
+// the free list is not thread-safe: it is only used by the main thread,
+// and the threads of a parallel simulator allocate from the heap.
+static bool
+IsFreeListUsable (void)
+{
+#ifdef HAVE_PTHREAD_H
+  return SystemThread::IsMainThread ();
+#else
+  return true;
+#endif /* HAVE_PTHREAD_H */
+}
+
 struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  while (IsFreeListUsable () && !g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
       g_freeList.pop_back ();
@@ -379,7 +426,8 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   if (data->count == 0)
     {
       if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
+          data->size < g_maxSize ||
+          !IsFreeListUsable ())
         {
           uint8_t *buffer = (uint8_t *)data;
           delete [] buffer;
@@ -44,9 +44,13 @@ struct ByteTagListData;
  *     as 4 32bit integers (TypeId, tag data size, start, end) followed 
  *     by the tag data as generated by Tag::Serialize.
  *
- *   - The struct ByteTagListData structure which contains the tag byte buffer
- *     is shared and, thus, reference-counted. This data structure is unshared
- *     as-needed to emulate COW semantics.
+ *   - As long as the serialized tags fit in INLINE_SIZE bytes, they are
+ *     stored inline in the ByteTagList itself and copied along with it:
+ *     adding one or two small tags to a packet thus does not allocate memory.
+ *
+ *   - Larger lists are spilled to a struct ByteTagListData structure which
+ *     contains the tag byte buffer and is shared and, thus, reference-counted.
+ *     This data structure is unshared as-needed to emulate COW semantics.
  *
  *   - Each tag tags a unique set of bytes identified by the pair of offsets
  *     (start,end). These offsets are provided by Buffer::GetCurrentStartOffset
@@ -127,6 +131,11 @@ private:
 
   void RemoveAll (void);
 
+  /**
+   * \returns true if this list contains no tags, false otherwise.
+   */
+  bool IsEmpty (void) const;
+
   /**
    * \param offsetStart the offset which uniquely identifies the first data byte 
    *        present in the byte buffer associated to this ByteTagList.
@@ -154,6 +163,16 @@ private:
   void AddAtStart (int32_t adjustment, int32_t prependOffset);
 
 private:
+  /**
+   * The number of bytes of serialized tags which are stored inline
+   * before the list is spilled to a heap-allocated ByteTagListData:
+   * room for two tags of up to 8 bytes each.
+   */
+  enum InlineSize_e
+  {
+    INLINE_SIZE = 48
+  };
+
   bool IsDirtyAtEnd (int32_t appendOffset);
   bool IsDirtyAtStart (int32_t prependOffset);
   ByteTagList::Iterator BeginAll (void) const;
@@ -163,6 +182,7 @@ private:
 
   uint16_t m_used;
   struct ByteTagListData *m_data;
+  uint8_t m_inline[INLINE_SIZE];
 };
 
 } // namespace ns3
@@ -111,6 +111,7 @@ void
 NodeListPriv::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  Config::InvalidateMatchCache ();
   for (std::vector<Ptr<Node> >::iterator i = m_nodes.begin ();
        i != m_nodes.end (); i++)
     {
@@ -130,6 +131,7 @@ NodeListPriv::Add (Ptr<Node> node)
   uint32_t index = m_nodes.size ();
   m_nodes.push_back (node);
   Simulator::ScheduleWithContext (index, TimeStep (0), &Node::Initialize, node);
+  Config::InvalidateMatchCache ();
   return index;
 
 }
@@ -22,6 +22,10 @@
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
 #include "packet-metadata.h"
 #include "buffer.h"
 #include "header.h"
@@ -36,6 +40,18 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
+
+uint16_t
+PacketMetadata::AllocateChunkUid (void)
+{
+  // headers and trailers may be added concurrently by the
+  // MultithreadedSimulatorImpl.
+#if defined (__GNUC__)
+  return __sync_fetch_and_add (&m_chunkUid, 1);
+#else
+  return m_chunkUid++;
+#endif
+}
 PacketMetadata::DataFreeList PacketMetadata::m_freeList;
 
 PacketMetadata::DataFreeList::~DataFreeList ()
@@ -512,6 +528,7 @@ PacketMetadata::ReplaceTail (PacketMetadata::SmallItem *item,
 
   // create a copy of the packet without its tail.
   PacketMetadata h (m_packetUid, 0);
+  h.DoMaterialize ();
   uint16_t current = m_head;
   while (current != 0xffff && current != m_tail)
     {
@@ -578,6 +595,18 @@ PacketMetadata::ReadItems (uint16_t current,
   return buffer - &m_data->m_data[current];
 }
 
+// the free list is not thread-safe: it is only used by the main thread,
+// and the threads of a parallel simulator allocate from the heap.
+static bool
+IsFreeListUsable (void)
+{
+#ifdef HAVE_PTHREAD_H
+  return SystemThread::IsMainThread ();
+#else
+  return true;
+#endif /* HAVE_PTHREAD_H */
+}
+
 struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
@@ -587,7 +616,7 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  while (IsFreeListUsable () && !m_freeList.empty ()) 
     {
       struct PacketMetadata::Data *data = m_freeList.back ();
       m_freeList.pop_back ();
@@ -616,7 +645,8 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
   NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
   if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
+      data->m_size < m_maxSize ||
+      !IsFreeListUsable ()) 
     {
       PacketMetadata::Deallocate (data);
     } 
@@ -662,46 +692,268 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
   return fragment;
 }
 
+void
+PacketMetadata::Log (uint16_t operation, uint32_t typeUid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << operation << typeUid << size << chunkUid);
+  const uint32_t n = sizeof (struct PacketMetadata::LogEntry);
+  if (m_logUsed + n > 0xffff)
+    {
+      DoMaterialize ();
+    }
+  if (m_log == 0)
+    {
+      m_log = PacketMetadata::Create (8 * n);
+      m_log->m_dirtyEnd = 0;
+    }
+  else if (m_logUsed + n > m_log->m_size
+           || (m_log->m_count != 1 && m_log->m_dirtyEnd != m_logUsed))
+    {
+      // The log is full, or another copy of this packet has already
+      // appended to it: copy the entries which belong to this packet.
+      struct PacketMetadata::Data *log =
+        PacketMetadata::Create (std::min<uint32_t> (2 * (m_logUsed + n), 0xffff));
+      memcpy (log->m_data, m_log->m_data, m_logUsed);
+      Release (m_log);
+      m_log = log;
+    }
+  struct PacketMetadata::LogEntry entry;
+  entry.operation = operation;
+  entry.chunkUid = chunkUid;
+  entry.typeUid = typeUid;
+  entry.size = size;
+  memcpy (&m_log->m_data[m_logUsed], &entry, n);
+  m_logUsed += n;
+  m_log->m_dirtyEnd = m_logUsed;
+}
+
+bool
+PacketMetadata::CancelLast (uint16_t operation, uint32_t typeUid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << operation << typeUid << size);
+  const uint32_t n = sizeof (struct PacketMetadata::LogEntry);
+  if (m_logUsed < n)
+    {
+      return false;
+    }
+  struct PacketMetadata::LogEntry entry;
+  memcpy (&entry, &m_log->m_data[m_logUsed - n], n);
+  if (entry.operation != operation || entry.typeUid != typeUid || entry.size != size)
+    {
+      return false;
+    }
+  // the entry is left in place for the other copies which share the log
+  m_logUsed -= n;
+  if (m_logUsed == 0)
+    {
+      Release (m_log);
+      m_log = 0;
+    }
+  return true;
+}
+
+void
+PacketMetadata::DoMaterialize (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      m_data = PacketMetadata::Create (10);
+      memset (m_data->m_data, 0xff, 4);
+    }
+  if (m_log == 0)
+    {
+      return;
+    }
+  // detach the log first so that the replayed operations are not logged
+  struct PacketMetadata::Data *log = m_log;
+  uint16_t used = m_logUsed;
+  m_log = 0;
+  m_logUsed = 0;
+  for (uint32_t offset = 0; offset < used; offset += sizeof (struct PacketMetadata::LogEntry))
+    {
+      struct PacketMetadata::LogEntry entry;
+      memcpy (&entry, &log->m_data[offset], sizeof (entry));
+      switch (entry.operation)
+        {
+        case LOG_ADD_HEADER:
+          DoAddHeader (entry.typeUid, entry.size, entry.chunkUid);
+          break;
+        case LOG_ADD_TRAILER:
+          DoAddTrailer (entry.typeUid, entry.size, entry.chunkUid);
+          break;
+        case LOG_REMOVE_HEADER:
+          DoRemoveHeader (entry.typeUid, entry.size);
+          break;
+        case LOG_REMOVE_TRAILER:
+          DoRemoveTrailer (entry.typeUid, entry.size);
+          break;
+        case LOG_REMOVE_AT_START:
+          DoRemoveAtStart (entry.size);
+          break;
+        case LOG_REMOVE_AT_END:
+          DoRemoveAtEnd (entry.size);
+          break;
+        default:
+          NS_ASSERT (false);
+          break;
+        }
+    }
+  Release (log);
+}
+
 void 
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &header << size);
-  NS_ASSERT (IsStateOk ());
+  if (!m_enable)
+    {
+      m_metadataSkipped = true;
+      return;
+    }
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
-  DoAddHeader (uid, size);
-  NS_ASSERT (IsStateOk ());
+  if (!m_enableChecking)
+    {
+      Log (LOG_ADD_HEADER, uid, size, AllocateChunkUid ());
+      return;
+    }
+  DoMaterialize ();
+  DoAddHeader (uid, size, AllocateChunkUid ());
 }
-void
-PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
+void 
+PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
-  NS_LOG_FUNCTION (this << uid << size);
+  NS_LOG_FUNCTION (this << &header << size);
+  if (!m_enable) 
+    {
+      m_metadataSkipped = true;
+      return;
+    }
+  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
+  if (!m_enableChecking)
+    {
+      if (!CancelLast (LOG_ADD_HEADER, uid, size))
+        {
+          Log (LOG_REMOVE_HEADER, uid, size, 0);
+        }
+      return;
+    }
+  DoMaterialize ();
+  DoRemoveHeader (uid, size);
+}
+void 
+PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &trailer << size);
   if (!m_enable)
     {
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  if (!m_enableChecking)
+    {
+      Log (LOG_ADD_TRAILER, uid, size, AllocateChunkUid ());
+      return;
+    }
+  DoMaterialize ();
+  DoAddTrailer (uid, size, AllocateChunkUid ());
+}
+void 
+PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &trailer << size);
+  if (!m_enable) 
+    {
+      m_metadataSkipped = true;
+      return;
+    }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  if (!m_enableChecking)
+    {
+      if (!CancelLast (LOG_ADD_TRAILER, uid, size))
+        {
+          Log (LOG_REMOVE_TRAILER, uid, size, 0);
+        }
+      return;
+    }
+  DoMaterialize ();
+  DoRemoveTrailer (uid, size);
+}
+void
+PacketMetadata::AddAtEnd (PacketMetadata const&o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  if (!m_enable) 
+    {
+      m_metadataSkipped = true;
+      return;
+    }
+  DoMaterialize ();
+  o.Materialize ();
+  DoAddAtEnd (o);
+}
+void 
+PacketMetadata::RemoveAtStart (uint32_t start)
+{
+  NS_LOG_FUNCTION (this << start);
+  if (!m_enable) 
+    {
+      m_metadataSkipped = true;
+      return;
+    }
+  if (!m_enableChecking)
+    {
+      if (start != 0)
+        {
+          Log (LOG_REMOVE_AT_START, 0, start, 0);
+        }
+      return;
+    }
+  DoMaterialize ();
+  DoRemoveAtStart (start);
+}
+void 
+PacketMetadata::RemoveAtEnd (uint32_t end)
+{
+  NS_LOG_FUNCTION (this << end);
+  if (!m_enable) 
+    {
+      m_metadataSkipped = true;
+      return;
+    }
+  if (!m_enableChecking)
+    {
+      if (end != 0)
+        {
+          Log (LOG_REMOVE_AT_END, 0, end, 0);
+        }
+      return;
+    }
+  DoMaterialize ();
+  DoRemoveAtEnd (end);
+}
 
+void
+PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
+  NS_ASSERT (IsStateOk ());
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
+  NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
+PacketMetadata::DoRemoveHeader (uint32_t uid, uint32_t size)
 {
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << &header << size);
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -740,38 +992,25 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << &trailer << size);
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
+PacketMetadata::DoRemoveTrailer (uint32_t uid, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << &trailer << size);
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -810,15 +1049,10 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
 }
 void
-PacketMetadata::AddAtEnd (PacketMetadata const&o)
+PacketMetadata::DoAddAtEnd (PacketMetadata const&o)
 {
   NS_LOG_FUNCTION (this << &o);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -898,15 +1132,10 @@ PacketMetadata::AddPaddingAtEnd (uint32_t end)
     }
 }
 void 
-PacketMetadata::RemoveAtStart (uint32_t start)
+PacketMetadata::DoRemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
@@ -934,6 +1163,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.DoMaterialize ();
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -961,15 +1191,10 @@ PacketMetadata::RemoveAtStart (uint32_t start)
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveAtEnd (uint32_t end)
+PacketMetadata::DoRemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
@@ -998,6 +1223,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.DoMaterialize ();
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1058,6 +1284,7 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  Materialize ();
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1161,6 +1388,7 @@ PacketMetadata::GetSerializedSize (void) const
     {
       return totalSize;
     }
+  Materialize ();
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
@@ -1195,6 +1423,7 @@ PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
   uint8_t* start = buffer;
+  Materialize ();
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
   if (buffer == 0) 
@@ -1297,6 +1526,7 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
   NS_LOG_FUNCTION (this << &buffer << size);
   const uint8_t* start = buffer;
   uint32_t desSize = size - 4;
+  DoMaterialize ();
 
   buffer = ReadFromRawU64 (m_packetUid, start, buffer, size);
   desSize -= 8;
@@ -75,6 +75,17 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Maintaining this linked list as headers and trailers are added
+ * and removed is costly, and the list is rarely read, so it is built
+ * lazily: the operations are first recorded in a log of fixed-size
+ * entries, shared by the copies of a packet, and the linked list is
+ * only updated from the log when it is read (e.g., by BeginItem or
+ * Serialize) or when packets are concatenated. Removing the header
+ * or trailer most recently added simply drops its entry from the
+ * log. The operations are applied immediately when checking is
+ * enabled, so that unexpected removals are still reported where they
+ * happen.
  */
 class PacketMetadata 
 {
@@ -273,6 +284,26 @@ private:
      */
     uint16_t chunkUid;
   };
+  /* operations recorded in the log
+   */
+  enum LogOperation {
+    LOG_ADD_HEADER,
+    LOG_ADD_TRAILER,
+    LOG_REMOVE_HEADER,
+    LOG_REMOVE_TRAILER,
+    LOG_REMOVE_AT_START,
+    LOG_REMOVE_AT_END
+  };
+  struct LogEntry {
+    /* a LogOperation */
+    uint16_t operation;
+    /* the chunk uid of an added header or trailer */
+    uint16_t chunkUid;
+    /* the type uid of a header or trailer, shifted as in SmallItem */
+    uint32_t typeUid;
+    /* the size of a header or trailer, or the number of bytes removed */
+    uint32_t size;
+  };
   struct ExtraItem {
     /* offset (in bytes) from start of original header to 
        the start of the fragment still present.
@@ -303,6 +334,19 @@ public:
 
   PacketMetadata ();
 
+  void Log (uint16_t operation, uint32_t typeUid, uint32_t size, uint16_t chunkUid);
+  bool CancelLast (uint16_t operation, uint32_t typeUid, uint32_t size);
+  inline void Materialize (void) const;
+  void DoMaterialize (void);
+  void DoAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  void DoRemoveHeader (uint32_t uid, uint32_t size);
+  void DoAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  void DoRemoveTrailer (uint32_t uid, uint32_t size);
+  void DoAddAtEnd (PacketMetadata const&o);
+  void DoRemoveAtStart (uint32_t start);
+  void DoRemoveAtEnd (uint32_t end);
+  static inline void Release (struct PacketMetadata::Data *data);
+
   inline uint16_t AddSmall (const PacketMetadata::SmallItem *item);
   uint16_t AddBig (uint32_t head, uint32_t tail,
                    const PacketMetadata::SmallItem *item, 
@@ -324,7 +368,6 @@ public:
   uint32_t ReadItems (uint16_t current, 
                       struct PacketMetadata::SmallItem *item,
                       struct PacketMetadata::ExtraItem *extraItem) const;
-  void DoAddHeader (uint32_t uid, uint32_t size);
   bool IsStateOk (void) const;
   bool IsPointerOk (uint16_t pointer) const;
   bool IsSharedPointerOk (uint16_t pointer) const;
@@ -334,6 +377,7 @@ public:
   static void Recycle (struct PacketMetadata::Data *data);
   static struct PacketMetadata::Data *Allocate (uint32_t n);
   static void Deallocate (struct PacketMetadata::Data *data);
+  static uint16_t AllocateChunkUid (void);
 
   static DataFreeList m_freeList;
   static bool m_enable;
@@ -347,6 +391,7 @@ public:
   static uint32_t m_maxSize;
   static uint16_t m_chunkUid;
 
+  /* the linked list, zero until an item is added to it */
   struct Data *m_data;
   /**
      head -(next)-> tail
@@ -357,6 +402,9 @@ public:
   uint16_t m_tail;
   uint16_t m_used;
   uint64_t m_packetUid;
+  /* the operations not yet applied to the linked list, zero if none */
+  struct Data *m_log;
+  uint16_t m_logUsed;
 };
 
 } // namespace ns3
@@ -364,16 +412,23 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
-    m_packetUid (uid)
+    m_packetUid (uid),
+    m_log (0),
+    m_logUsed (0)
 {
-  memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
-      DoAddHeader (0, size);
+      if (!m_enable)
+        {
+          m_metadataSkipped = true;
+          return;
+        }
+      // the payload is an item of type uid zero
+      Log (LOG_ADD_HEADER, 0, size, AllocateChunkUid ());
     }
 }
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
@@ -381,11 +436,20 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
-    m_packetUid (o.m_packetUid)
+    m_packetUid (o.m_packetUid),
+    m_log (o.m_log),
+    m_logUsed (o.m_logUsed)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
+  if (m_log != 0)
+    {
+      NS_ASSERT (m_log->m_count < std::numeric_limits<uint32_t>::max());
+      m_log->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -393,29 +457,53 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      Release (m_data);
+      m_data = o.m_data;
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count++;
+        }
+    }
+  if (m_log != o.m_log) 
+    {
+      Release (m_log);
+      m_log = o.m_log;
+      if (m_log != 0)
+        {
+          m_log->m_count++;
         }
-      m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
   m_used = o.m_used;
   m_packetUid = o.m_packetUid;
+  m_logUsed = o.m_logUsed;
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  Release (m_data);
+  Release (m_log);
+}
+void
+PacketMetadata::Release (struct PacketMetadata::Data *data)
+{
+  if (data != 0)
+    {
+      data->m_count--;
+      if (data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (data);
+        }
+    }
+}
+void
+PacketMetadata::Materialize (void) const
+{
+  if (m_log != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      // the log and the linked list are one logical state
+      const_cast<PacketMetadata *> (this)->DoMaterialize ();
     }
 }
 
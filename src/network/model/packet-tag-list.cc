@@ -157,7 +157,27 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  for (uint32_t i = 0; i < m_inlineCount; ++i)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          NS_LOG_INFO ("found tid in inline tags");
+          tag.Deserialize (TagBuffer (m_inline[i].data,
+                                      m_inline[i].data + TagData::MAX_SIZE));
+          for (uint32_t j = i + 1; j < m_inlineCount; ++j)
+            {
+              m_inline[j - 1] = m_inline[j];
+            }
+          m_inlineCount--;
+          Relink ();
+          return true;
+        }
+    }
+  bool found = COWTraverse (tag, &PacketTagList::RemoveWriter);
+  Relink ();
+  return found;
 }
 
 // COWWriter implementing Remove
@@ -196,7 +216,20 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  for (uint32_t i = 0; i < m_inlineCount; ++i)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          NS_LOG_INFO ("found tid in inline tags, rewriting");
+          tag.Serialize (TagBuffer (m_inline[i].data,
+                                    m_inline[i].data + tag.GetSerializedSize ()));
+          return true;
+        }
+    }
   bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
+  Relink ();
   if (!found)
     {
       Add (tag);
@@ -245,19 +278,39 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (const struct TagData *cur = Head (); cur != 0; cur = cur->next) 
     {
       NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
     }
-  struct TagData * head = new struct TagData ();
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  if (m_inlineCount == INLINE_TAGS)
+    {
+      self->Spill ();
+    }
+  struct TagData * head = &self->m_inline[m_inlineCount];
   head->count = 1;
-  head->next = 0;
   head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
+  head->next = m_inlineCount == 0 ? m_next : &self->m_inline[m_inlineCount - 1];
   NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_inlineCount++;
+}
+
+void
+PacketTagList::Spill (void)
+{
+  NS_LOG_FUNCTION (this << m_inlineCount);
+  for (uint32_t i = 0; i < m_inlineCount; ++i)
+    {
+      struct TagData * copy = new struct TagData ();
+      copy->tid = m_inline[i].tid;
+      copy->count = 1;
+      memcpy (copy->data, m_inline[i].data, TagData::MAX_SIZE);
+      copy->next = m_next;
+      m_next = copy;
+    }
+  m_inlineCount = 0;
 }
 
 bool
@@ -265,12 +318,13 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (const struct TagData *cur = Head (); cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
         {
           /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
+          uint8_t *data = const_cast<uint8_t *> (cur->data);
+          tag.Deserialize (TagBuffer (data, data + TagData::MAX_SIZE));
           return true;
         }
     }
@@ -281,6 +335,10 @@ PacketTagList::Peek (Tag &tag) const
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
+  if (m_inlineCount != 0)
+    {
+      return &m_inline[m_inlineCount - 1];
+    }
   return m_next;
 }
 
@@ -120,6 +120,22 @@ class Tag;
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
  *
+ * \par <b> Inline storage </b> of the most recent tags:
+ *
+ *   - The last #INLINE_TAGS tags added to a PacketTagList are not
+ *     allocated in the tree: they are stored in the PacketTagList itself,
+ *     and are copied along with it.  The inline TagData are linked in
+ *     front of the tree, so that #Head still returns a singly-linked list.
+ *
+ *   - When #Add finds the inline storage full, the inline tags are moved
+ *     to a new branch of the tree, and the inline storage is reused.
+ *     Packets which carry up to #INLINE_TAGS tags thus never allocate
+ *     TagData.
+ *
+ *   - #Remove and #Replace operate in place on the inline tags, since
+ *     they are never shared, and use the copy-on-write traversal described
+ *     above for the tags stored in the tree.
+ *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
@@ -176,8 +192,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same #struct TagData as \pname{o}.
+   * This makes a light-weight copy by pointing to the same
+   * #struct TagData as \pname{o}, and copying its inline tags.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -186,7 +202,8 @@ public:
    * \param [in] o The PacketTagList to copy.
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same #struct TagData as \pname{o}.
+   * pointing to the same #struct TagData as \pname{o}, and
+   * copying its inline tags.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
@@ -238,6 +255,29 @@ public:
   const struct PacketTagList::TagData *Head (void) const;
 
 private:
+  /**
+   * \brief Number of tags stored inline
+   *
+   * Most packets carry no more than two packet tags, which are stored
+   * in #m_inline without allocating TagData.
+   */
+  enum InlineTags_e
+  {
+    INLINE_TAGS = 2           /**< Size of #m_inline */
+  };
+
+  /**
+   * Link the inline tags in front of #m_next, from the most recent one.
+   *
+   * This must be called whenever #m_inline, #m_inlineCount or
+   * #m_next change.
+   */
+  inline void Relink (void);
+  /**
+   * Move the inline tags to a new branch of the tree, in front of #m_next.
+   */
+  void Spill (void);
+
   /**
    * Typedef of method function pointer for copy-on-write operations
    *
@@ -287,9 +327,17 @@ private:
   bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
 
   /**
-   * Pointer to first #struct TagData on the list
+   * Pointer to first #struct TagData of the tree, after the inline tags
    */
   struct TagData *m_next;
+  /**
+   * Number of tags stored in #m_inline
+   */
+  uint32_t m_inlineCount;
+  /**
+   * The most recent tags, in the order they were added
+   */
+  struct TagData m_inline[INLINE_TAGS];
 };
 
 } // namespace ns3
@@ -301,24 +349,31 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_inlineCount (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_next (o.m_next),
+    m_inlineCount (o.m_inlineCount)
 {
   if (m_next != 0)
     {
       m_next->count++;
     }
+  for (uint32_t i = 0; i < m_inlineCount; ++i)
+    {
+      m_inline[i] = o.m_inline[i];
+    }
+  Relink ();
 }
 
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
@@ -328,6 +383,12 @@ PacketTagList::operator = (PacketTagList const &o)
     {
       m_next->count++;
     }
+  m_inlineCount = o.m_inlineCount;
+  for (uint32_t i = 0; i < m_inlineCount; ++i)
+    {
+      m_inline[i] = o.m_inline[i];
+    }
+  Relink ();
   return *this;
 }
 
@@ -358,6 +419,18 @@ PacketTagList::RemoveAll (void)
       delete prev;
     }
   m_next = 0;
+  m_inlineCount = 0;
+}
+
+void
+PacketTagList::Relink (void)
+{
+  struct TagData *next = m_next;
+  for (uint32_t i = 0; i < m_inlineCount; ++i)
+    {
+      m_inline[i].next = next;
+      next = &m_inline[i];
+    }
 }
 
 } // namespace ns3
@@ -30,6 +30,16 @@ namespace ns3 {
 
 uint32_t Packet::m_globalUid = 0;
 
+uint32_t
+Packet::AllocateUid (void)
+{
+#if defined (__GNUC__)
+  return __sync_fetch_and_add (&m_globalUid, 1);
+#else
+  return m_globalUid++;
+#endif
+}
+
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
 {
@@ -137,10 +147,9 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -179,10 +188,9 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -205,10 +213,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -323,10 +330,21 @@ Packet::AddAtEnd (Ptr<const Packet> packet)
   uint32_t appendPrependOffset = m_buffer.GetCurrentEndOffset () - packet->m_buffer.GetSize ();
   m_byteTagList.AddAtEnd (m_buffer.GetCurrentStartOffset () - aStart, 
                           appendPrependOffset);
-  ByteTagList copy = packet->m_byteTagList;
-  copy.AddAtStart (m_buffer.GetCurrentEndOffset () - bEnd,
-                   appendPrependOffset);
-  m_byteTagList.Add (copy);
+  if (!packet->m_byteTagList.IsEmpty ())
+    {
+      ByteTagList copy = packet->m_byteTagList;
+      copy.AddAtStart (m_buffer.GetCurrentEndOffset () - bEnd,
+                       appendPrependOffset);
+      if (m_byteTagList.IsEmpty ())
+        {
+          // share the tags of the other packet rather than copying them
+          m_byteTagList = copy;
+        }
+      else
+        {
+          m_byteTagList.Add (copy);
+        }
+    }
   m_metadata.AddAtEnd (packet->m_metadata);
 }
 void
@@ -583,6 +583,11 @@ private:
           const PacketTagList &packetTagList, const PacketMetadata &metadata);
 
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
+  /**
+   * \returns a new packet uid. Packets may be created concurrently by
+   * the MultithreadedSimulatorImpl so the counter is updated atomically.
+   */
+  static uint32_t AllocateUid (void);
 
   Buffer m_buffer;
   ByteTagList m_byteTagList;
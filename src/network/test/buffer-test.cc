@@ -2,6 +2,11 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
 #include "ns3/test.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+#include <vector>
 
 using namespace ns3;
 
@@ -323,6 +328,150 @@ BufferTest::DoRun (void)
   free (cBuf);
 }
 //-----------------------------------------------------------------------------
+class BufferSlabTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferSlabTest ();
+};
+
+BufferSlabTest::BufferSlabTest ()
+  : TestCase ("Check that the data of released buffers are reused") {
+}
+
+void
+BufferSlabTest::DoRun (void)
+{
+  // warm up the slab with a few buffers of each size
+  for (uint32_t size = 1; size < 4000; size += 100)
+    {
+      Buffer buffer;
+      buffer.AddAtStart (size);
+      buffer.Begin ().WriteU8 (0xff, size);
+    }
+  Buffer::ResetSlabStatistics ();
+  for (uint32_t size = 1; size < 4000; size += 100)
+    {
+      Buffer buffer;
+      buffer.AddAtStart (size);
+      Buffer copy = buffer.CreateFullCopy ();
+      copy.AddAtEnd (10);
+    }
+  Buffer::SlabStatistics stats = Buffer::GetSlabStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.misses, 0, "Buffer data allocated in steady state");
+  NS_TEST_EXPECT_MSG_GT (stats.hits, 0, "No buffer data allocated");
+  NS_TEST_EXPECT_MSG_EQ (stats.recycled, stats.hits, "Buffer data not released to the slab");
+  NS_TEST_EXPECT_MSG_EQ (stats.released, 0, "Buffer data released to the system");
+}
+//-----------------------------------------------------------------------------
+#ifdef HAVE_PTHREAD_H
+class BufferThreadsTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferThreadsTest ();
+private:
+  struct Worker
+  {
+    uint32_t seed;
+    bool corrupted;
+    // buffers left for the main thread to release
+    std::vector<Buffer> buffers;
+  };
+  static void Fill (Buffer buffer, uint8_t value);
+  static bool Check (Buffer buffer, uint8_t value);
+  static void Work (struct Worker *worker);
+};
+
+BufferThreadsTest::BufferThreadsTest ()
+  : TestCase ("Check that buffers are used concurrently by several threads") {
+}
+
+void
+BufferThreadsTest::Fill (Buffer buffer, uint8_t value)
+{
+  buffer.Begin ().WriteU8 (value, buffer.GetSize ());
+}
+
+bool
+BufferThreadsTest::Check (Buffer buffer, uint8_t value)
+{
+  Buffer::Iterator i = buffer.Begin ();
+  for (uint32_t j = 0; j < buffer.GetSize (); j++)
+    {
+      if (i.ReadU8 () != value)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+BufferThreadsTest::Work (struct Worker *worker)
+{
+  std::vector<Buffer> buffers (64);
+  std::vector<uint8_t> values (buffers.size (), 0);
+  uint32_t random = worker->seed;
+  for (uint32_t n = 0; n < 100000; n++)
+    {
+      random = random * 1103515245 + 12345;
+      uint32_t j = (random >> 8) % buffers.size ();
+      if (!Check (buffers[j], values[j]))
+        {
+          worker->corrupted = true;
+        }
+      uint32_t size = (random >> 16) % 300;
+      if (random & 1)
+        {
+          buffers[j] = Buffer ();
+          buffers[j].AddAtStart (size);
+        }
+      else
+        {
+          // copies and fragments share and then duplicate the data
+          Buffer copy = buffers[(j + 1) % buffers.size ()];
+          buffers[j] = copy.CreateFragment (0, copy.GetSize () / 2);
+          buffers[j].AddAtEnd (size);
+        }
+      values[j] = static_cast<uint8_t> (random >> 24);
+      Fill (buffers[j], values[j]);
+    }
+  for (uint32_t j = 0; j < buffers.size (); j++)
+    {
+      if (!Check (buffers[j], values[j]))
+        {
+          worker->corrupted = true;
+        }
+    }
+  worker->buffers = buffers;
+}
+
+void
+BufferThreadsTest::DoRun (void)
+{
+  const uint32_t n = 4;
+  std::vector<struct Worker> workers (n);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      workers[i].seed = i + 1;
+      workers[i].corrupted = false;
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&BufferThreadsTest::Work, &workers[i])));
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      threads[i]->Start ();
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      threads[i]->Join ();
+      bool corrupted = workers[i].corrupted;
+      NS_TEST_EXPECT_MSG_EQ (corrupted, false, "Buffer of thread " << i << " corrupted");
+    }
+  // the data of the buffers of the exited threads go to this thread's slab
+  workers.clear ();
+}
+#endif /* HAVE_PTHREAD_H */
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -333,6 +482,10 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferSlabTest, TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new BufferThreadsTest, TestCase::QUICK);
+#endif /* HAVE_PTHREAD_H */
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include <iostream>
+#include <ctime>
+
+using namespace ns3;
+
+static const uint64_t g_rates[] = { 32768, 56000, 448000, 1000000, 1500000, 5000000,
+                                    10000000, 54000000, 100000000, 1000000000 };
+
+class DataRateTxTimeTestCase : public TestCase
+{
+public:
+  DataRateTxTimeTestCase ();
+  virtual void DoRun (void);
+};
+
+DataRateTxTimeTestCase::DataRateTxTimeTestCase ()
+  : TestCase ("Check integer transmission times against exact and double results")
+{
+}
+void
+DataRateTxTimeTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < sizeof (g_rates) / sizeof (g_rates[0]); i++)
+    {
+      DataRate rate (g_rates[i]);
+      for (uint32_t bytes = 0; bytes <= 9000; bytes++)
+        {
+          // in nanoseconds, bytes * 8 * 1e9 does not overflow 64 bits.
+          int64_t exact = bytes * 8000000000ULL / g_rates[i];
+          int64_t txTime = rate.CalculateBytesTxTime (bytes).GetNanoSeconds ();
+          NS_TEST_ASSERT_MSG_EQ (txTime, exact, "Wrong time for " << bytes << " bytes at " << rate);
+          // the double computation truncates values slightly below the
+          // exact result down to the previous time step.
+          int64_t seconds = Seconds (rate.CalculateTxTime (bytes)).GetNanoSeconds ();
+          NS_TEST_ASSERT_MSG_EQ ((seconds == txTime || seconds == txTime - 1), true,
+                                 "Wrong time for " << bytes << " bytes at " << rate << ": " << seconds);
+        }
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (DataRate ("5Mbps").CalculateBytesTxTime (1500), MicroSeconds (2400), "Wrong time");
+  NS_TEST_EXPECT_MSG_EQ (DataRate ("10Mbps").CalculateBitsTxTime (96), NanoSeconds (9600), "Wrong time");
+  NS_TEST_EXPECT_MSG_EQ (DataRate ("1bps").CalculateBitsTxTime (3600), Seconds (3600.0), "Wrong time");
+  NS_TEST_EXPECT_MSG_EQ (DataRate ("100Gbps").CalculateBitsTxTime (100000000001ULL), NanoSeconds (1000000000),
+                         "Wrong time");
+  // a remainder too large to scale in 64 bits.
+  NS_TEST_EXPECT_MSG_EQ_TOL (DataRate ("100Gbps").CalculateBitsTxTime (199999999999ULL).GetSeconds (),
+                             2.0, 1e-8, "Wrong time");
+}
+
+class DataRateTestSuite : public TestSuite
+{
+public:
+  DataRateTestSuite ()
+    : TestSuite ("data-rate", UNIT)
+  {
+    AddTestCase (new DataRateTxTimeTestCase (), TestCase::QUICK);
+  }
+} g_dataRateTestSuite;
+
+class DataRateTxTimeBenchmarkTestCase : public TestCase
+{
+public:
+  DataRateTxTimeBenchmarkTestCase ();
+  virtual void DoRun (void);
+
+  enum { REPETITIONS = 1000000 };
+};
+
+DataRateTxTimeBenchmarkTestCase::DataRateTxTimeBenchmarkTestCase ()
+  : TestCase ("Measure average transmission time computation time")
+{
+}
+void
+DataRateTxTimeBenchmarkTestCase::DoRun (void)
+{
+  // stop recording Time objects for resolution changes, as a running
+  // simulation does.
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  DataRate rate ("5Mbps");
+  int64_t doubleSum = 0;
+  int64_t integerSum = 0;
+  int64_t secondsSum = 0;
+
+  std::cout << GetName () << std::endl;
+  clock_t start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      doubleSum += Seconds (rate.CalculateTxTime (40 + i % 1460)).GetTimeStep ();
+    }
+  clock_t stop = clock ();
+  std::cout << "Seconds (CalculateTxTime ()): "
+            << 1e9 * (stop - start) / CLOCKS_PER_SEC / REPETITIONS << " ns/packet" << std::endl;
+
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      integerSum += rate.CalculateBytesTxTime (40 + i % 1460).GetTimeStep ();
+    }
+  stop = clock ();
+  std::cout << "CalculateBytesTxTime ():      "
+            << 1e9 * (stop - start) / CLOCKS_PER_SEC / REPETITIONS << " ns/packet" << std::endl;
+
+  start = clock ();
+  for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+      secondsSum += Seconds (i % 1000).GetTimeStep ();
+    }
+  stop = clock ();
+  std::cout << "Seconds (whole double):       "
+            << 1e9 * (stop - start) / CLOCKS_PER_SEC / REPETITIONS << " ns/time" << std::endl;
+
+  NS_TEST_EXPECT_MSG_EQ ((integerSum >= doubleSum && integerSum - doubleSum <= REPETITIONS), true,
+                         "Integer and double times differ by more than one step");
+  NS_TEST_EXPECT_MSG_EQ (secondsSum, Seconds (499500.0).GetTimeStep () * (REPETITIONS / 1000), "Wrong seconds");
+}
+
+class DataRatePerformanceTestSuite : public TestSuite
+{
+public:
+  DataRatePerformanceTestSuite ()
+    : TestSuite ("data-rate-perf", PERFORMANCE)
+  {
+    AddTestCase (new DataRateTxTimeBenchmarkTestCase (), TestCase::QUICK);
+  }
+} g_dataRatePerformanceTestSuite;
@@ -821,6 +821,29 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // copies which share operations not yet applied to their metadata
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_HEADER (p, 6);
+  p1 = p->Copy ();
+  REM_HEADER (p1, 6);
+  ADD_HEADER (p, 2);
+  ADD_TRAILER (p1, 3);
+  ADD_HEADER (p1, 4);
+  REM_HEADER (p1, 4);
+  p2 = p1->Copy ();
+  p2->RemoveAtStart (1);
+  p2->RemoveAtEnd (2);
+  CHECK_HISTORY (p, 4, 2, 6, 1, 10);
+  CHECK_HISTORY (p1, 3, 1, 10, 3);
+  CHECK_HISTORY (p2, 2, 10, 1);
+  ADD_HEADER (p, 5);
+  p3 = p->Copy ();
+  REM_HEADER (p3, 5);
+  REM_HEADER (p3, 2);
+  CHECK_HISTORY (p3, 3, 6, 1, 10);
+  CHECK_HISTORY (p, 5, 5, 2, 6, 1, 10);
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
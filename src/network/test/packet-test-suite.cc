@@ -716,6 +716,125 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+class PacketTagLifecycleTest : public TestCase
+{
+public:
+  PacketTagLifecycleTest ();
+  virtual ~PacketTagLifecycleTest ();
+private:
+  void DoRun (void);
+  int LifecycleTime (const int nTags, const bool verbose = false);
+};
+
+PacketTagLifecycleTest::PacketTagLifecycleTest ()
+  : TestCase ("PacketTagLifecycleTest: ")
+{
+}
+
+PacketTagLifecycleTest::~PacketTagLifecycleTest ()
+{
+}
+
+int
+PacketTagLifecycleTest::LifecycleTime (const int nTags,
+                                       const bool verbose /* = false */)
+{
+  const int reps = 10000;
+  ATestTag<1> t1 (1);
+  ATestTag<2> t2 (2);
+  ATestTag<3> t3 (3);
+  ATestTag<4> t4 (4);
+  ATestHeader<8> h;
+  int start = clock ();
+  for (int i = 0; i < reps; ++i) {
+    // a packet tagged by the application and the lower layers
+    Ptr<Packet> p = Create<Packet> (100);
+    p->AddByteTag (t1);
+    p->AddPacketTag (t2);
+    if (nTags > 2) p->AddPacketTag (t3);
+    if (nTags > 3) p->AddPacketTag (t4);
+    p->AddHeader (h);
+    // forwarded as a copy, and aggregated with another tagged packet
+    Ptr<Packet> copy = p->Copy ();
+    Ptr<Packet> other = Create<Packet> (50);
+    other->AddByteTag (t1);
+    copy->AddAtEnd (other);
+    copy->ReplacePacketTag (t2);
+    // received
+    copy->RemoveHeader (h);
+    copy->PeekPacketTag (t2);
+    copy->RemovePacketTag (t2);
+    copy->RemoveAllByteTags ();
+  }
+  int stop = clock ();
+  int delta = stop - start;
+  if (verbose) {
+    std::cout << GetName () << "lifecycle time: " << nTags << " tags: "
+              << std::setw (8) << delta << " ticks for "
+              << reps           << " packets"
+              << std::endl;
+  }
+  return delta;
+}
+
+void
+PacketTagLifecycleTest::DoRun (void)
+{
+  std::cout << GetName () << "begin" << std::endl;
+
+  { // Correctness of the tags along the lifecycle
+    ATestTag<1> t1 (1);
+    ATestTag<2> t2 (2);
+    ATestTag<3> t3 (3);
+    Ptr<Packet> a = Create<Packet> (10);
+    a->AddPacketTag (t2);
+    a->AddPacketTag (t3);
+    Ptr<Packet> b = Create<Packet> (20);
+    b->AddByteTag (t1);
+    a->AddAtEnd (b);
+
+    ATestTag<1> r1;
+    NS_TEST_EXPECT_MSG_EQ (a->FindFirstMatchingByteTag (r1), true,
+                           "byte tag merged in AddAtEnd");
+    NS_TEST_EXPECT_MSG_EQ (r1.GetData (), 1, "byte tag value");
+    ByteTagIterator i = a->GetByteTagIterator ();
+    NS_TEST_EXPECT_MSG_EQ (i.HasNext (), true, "byte tag present");
+    ByteTagIterator::Item item = i.Next ();
+    NS_TEST_EXPECT_MSG_EQ (item.GetStart (), 10, "byte tag start");
+    NS_TEST_EXPECT_MSG_EQ (item.GetEnd (), 30, "byte tag end");
+    NS_TEST_EXPECT_MSG_EQ (i.HasNext (), false, "single byte tag");
+
+    Ptr<Packet> c = a->Copy ();
+    ATestTag<2> n2 (4);
+    c->ReplacePacketTag (n2);
+    ATestTag<2> r2;
+    NS_TEST_EXPECT_MSG_EQ (a->PeekPacketTag (r2), true, "original tag");
+    NS_TEST_EXPECT_MSG_EQ (r2.GetData (), 2, "original tag value");
+    NS_TEST_EXPECT_MSG_EQ (c->PeekPacketTag (r2), true, "replaced tag");
+    NS_TEST_EXPECT_MSG_EQ (r2.GetData (), 4, "replaced tag value");
+    ATestTag<3> r3;
+    NS_TEST_EXPECT_MSG_EQ (c->RemovePacketTag (r3), true, "removed tag");
+    NS_TEST_EXPECT_MSG_EQ (c->PeekPacketTag (r3), false, "tag removed");
+    NS_TEST_EXPECT_MSG_EQ (a->PeekPacketTag (r3), true, "tag kept in original");
+  }
+
+  { // Timing
+    std::cout << GetName () << "lifecycle timing" << std::endl;
+    const int nIterations = 10;
+    for (int nTags = 2; nTags <= 4; ++nTags) {
+      int flm = std::numeric_limits<int>::max ();
+      for (int i = 0; i < nIterations; ++i) {
+        int now = LifecycleTime (nTags);
+        if (now < flm) flm = now;
+      }
+      std::cout << GetName () << "min lifecycle time: " << nTags << " tags: "
+                << std::setw (8) << flm << " ticks"
+                << std::endl;
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -728,6 +847,7 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketTagLifecycleTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
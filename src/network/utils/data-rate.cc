@@ -22,6 +22,8 @@
 #include "ns3/nstime.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/assert.h"
+#include <limits>
 
 NS_LOG_COMPONENT_DEFINE ("DataRate");
 
@@ -232,6 +234,33 @@ double DataRate::CalculateTxTime (uint32_t bytes) const
   return static_cast<double>(bytes)*8/m_bps;
 }
 
+Time DataRate::CalculateBytesTxTime (uint32_t bytes) const
+{
+  NS_LOG_FUNCTION (this << bytes);
+  return CalculateBitsTxTime (static_cast<uint64_t> (bytes) * 8);
+}
+
+Time DataRate::CalculateBitsTxTime (uint64_t bits) const
+{
+  NS_LOG_FUNCTION (this << bits);
+  NS_ASSERT_MSG (m_bps != 0, "Null data rate");
+  // the second is the coarsest time unit: it is always a whole number
+  // of time steps.
+  uint64_t stepsPerSecond = Time::FromInteger (1, Time::S).GetTimeStep ();
+  if (bits <= 0xffffffffULL && stepsPerSecond <= 0xffffffffULL)
+    {
+      return TimeStep (bits * stepsPerSecond / m_bps);
+    }
+  uint64_t seconds = bits / m_bps;
+  uint64_t remainder = bits % m_bps;
+  if (remainder <= std::numeric_limits<uint64_t>::max () / stepsPerSecond)
+    {
+      return TimeStep (seconds * stepsPerSecond + remainder * stepsPerSecond / m_bps);
+    }
+  // a rate too high to scale the remainder in 64 bits.
+  return Seconds (static_cast<double> (bits) / m_bps);
+}
+
 uint64_t DataRate::GetBitRate () const
 {
   NS_LOG_FUNCTION (this);
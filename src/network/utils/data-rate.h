@@ -99,6 +99,29 @@ public:
    */
   double CalculateTxTime (uint32_t bytes) const;
 
+  /**
+   * \brief Calculate transmission time
+   *
+   * Calculates the transmission time at this data rate in integer
+   * arithmetic: the result is the exact transmission time, rounded down
+   * to the current Time resolution.  This is cheaper than converting
+   * the result of CalculateTxTime with Seconds, which can also be one
+   * time step short of the exact value.
+   * \param bytes The number of bytes (not bits) for which to calculate
+   * \return The transmission time for the number of bytes specified
+   */
+  Time CalculateBytesTxTime (uint32_t bytes) const;
+
+  /**
+   * \brief Calculate transmission time
+   *
+   * \param bits The number of bits (not bytes) for which to calculate
+   * \return The transmission time for the number of bits specified,
+   * rounded down to the current Time resolution
+   * \sa CalculateBytesTxTime
+   */
+  Time CalculateBitsTxTime (uint64_t bits) const;
+
   /**
    * Get the underlying bitrate
    * \return The underlying bitrate in bits per second
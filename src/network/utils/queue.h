@@ -160,8 +160,9 @@ protected:
   void Drop (Ptr<Packet> packet);
 
 private:
-  TracedCallback<Ptr<const Packet> > m_traceEnqueue;
-  TracedCallback<Ptr<const Packet> > m_traceDequeue;
+  OptionalTracedCallback<Ptr<const Packet> > m_traceEnqueue;
+  OptionalTracedCallback<Ptr<const Packet> > m_traceDequeue;
+  // connected by the flow monitor and the trace helpers
   TracedCallback<Ptr<const Packet> > m_traceDrop;
 
   uint32_t m_nBytes;
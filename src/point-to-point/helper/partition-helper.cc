@@ -0,0 +1,467 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "partition-helper.h"
+#include "point-to-point-helper.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("PartitionHelper");
+
+namespace ns3 {
+
+// number of passes over all the nodes to reduce the cut
+static const uint32_t MAX_REFINE_PASSES = 16;
+
+PartitionHelper::PartitionHelper ()
+  : m_imbalance (0.05)
+{
+}
+
+uint32_t
+PartitionHelper::GetIndex (Ptr<Node> node)
+{
+  std::map<uint32_t, uint32_t>::const_iterator i = m_indexes.find (node->GetId ());
+  if (i != m_indexes.end ())
+    {
+      return i->second;
+    }
+  uint32_t index = m_nodes.GetN ();
+  m_indexes[node->GetId ()] = index;
+  m_nodes.Add (node);
+  m_weights.push_back (1.0);
+  return index;
+}
+
+void
+PartitionHelper::Add (NodeContainer c)
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      GetIndex (*i);
+    }
+}
+
+void
+PartitionHelper::Add (Ptr<Node> node, double weight)
+{
+  NS_ASSERT (weight >= 0);
+  m_weights[GetIndex (node)] = weight;
+}
+
+void
+PartitionHelper::AddLink (Ptr<Node> a, Ptr<Node> b, Time delay, DataRate rate)
+{
+  Link link;
+  link.a = GetIndex (a);
+  link.b = GetIndex (b);
+  link.delay = delay;
+  link.rate = rate;
+  m_links.push_back (link);
+}
+
+void
+PartitionHelper::SetImbalance (double imbalance)
+{
+  NS_ASSERT (imbalance >= 0);
+  m_imbalance = imbalance;
+}
+
+static uint32_t
+FindRoot (std::vector<uint32_t> &parent, uint32_t i)
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+std::vector<uint32_t>
+PartitionHelper::Contract (Time delay) const
+{
+  // merge the nodes connected by the links shorter than delay, and
+  // number the groups in the order of their first node.
+  uint32_t nNodes = m_nodes.GetN ();
+  std::vector<uint32_t> parent (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      parent[i] = i;
+    }
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (i->delay < delay)
+        {
+          parent[FindRoot (parent, i->a)] = FindRoot (parent, i->b);
+        }
+    }
+  std::vector<uint32_t> group (nNodes);
+  std::map<uint32_t, uint32_t> groupOfRoot;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      uint32_t root = FindRoot (parent, i);
+      std::map<uint32_t, uint32_t>::const_iterator j = groupOfRoot.find (root);
+      if (j == groupOfRoot.end ())
+        {
+          uint32_t index = groupOfRoot.size ();
+          groupOfRoot[root] = index;
+          group[i] = index;
+        }
+      else
+        {
+          group[i] = j->second;
+        }
+    }
+  return group;
+}
+
+static uint32_t
+CountGroups (const std::vector<uint32_t> &group)
+{
+  if (group.empty ())
+    {
+      return 0;
+    }
+  return *std::max_element (group.begin (), group.end ()) + 1;
+}
+
+static std::vector<double>
+GetGroupWeights (const std::vector<uint32_t> &group, uint32_t nGroups,
+                 const std::vector<double> &weights)
+{
+  std::vector<double> groupWeights (nGroups, 0.0);
+  for (uint32_t i = 0; i < group.size (); ++i)
+    {
+      groupWeights[group[i]] += weights[i];
+    }
+  return groupWeights;
+}
+
+std::vector<std::map<uint32_t, double> >
+PartitionHelper::GetNeighbors (const std::vector<uint32_t> &group, uint32_t nGroups) const
+{
+  // sum of the data rates of the links between two groups
+  std::vector<std::map<uint32_t, double> > neighbors (nGroups);
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      uint32_t a = group[i->a];
+      uint32_t b = group[i->b];
+      if (a != b)
+        {
+          double rate = static_cast<double> (i->rate.GetBitRate ());
+          neighbors[a][b] += rate;
+          neighbors[b][a] += rate;
+        }
+    }
+  return neighbors;
+}
+
+bool
+PartitionHelper::Balance (const std::vector<uint32_t> &group, uint32_t nGroups,
+                          uint32_t n, std::vector<uint32_t> &partition) const
+{
+  // Assign the heaviest groups first, each to the lightest partition,
+  // and report whether the load of every partition is acceptable.
+  std::vector<double> groupWeights = GetGroupWeights (group, nGroups, m_weights);
+  double total = 0;
+  std::vector<std::pair<double, uint32_t> > order;
+  for (uint32_t i = 0; i < nGroups; ++i)
+    {
+      total += groupWeights[i];
+      order.push_back (std::make_pair (-groupWeights[i], i));
+    }
+  std::sort (order.begin (), order.end ());
+  double maxLoad = (1 + m_imbalance) * total / n;
+  std::vector<double> load (n, 0.0);
+  partition.assign (nGroups, 0);
+  bool balanced = true;
+  for (uint32_t i = 0; i < nGroups; ++i)
+    {
+      uint32_t g = order[i].second;
+      uint32_t p = std::min_element (load.begin (), load.end ()) - load.begin ();
+      load[p] += groupWeights[g];
+      partition[g] = p;
+      balanced &= load[p] <= maxLoad;
+    }
+  return balanced;
+}
+
+bool
+PartitionHelper::Grow (const std::vector<uint32_t> &group, uint32_t nGroups,
+                       uint32_t n, std::vector<uint32_t> &partition) const
+{
+  // Grow the partitions one after the other from a seed group, adding
+  // the group the most connected to the partition until it reaches
+  // its share of the total weight. This keeps neighbors together, which
+  // Balance does not.
+  std::vector<double> groupWeights = GetGroupWeights (group, nGroups, m_weights);
+  std::vector<std::map<uint32_t, double> > neighbors = GetNeighbors (group, nGroups);
+  double total = 0;
+  for (uint32_t g = 0; g < nGroups; ++g)
+    {
+      total += groupWeights[g];
+    }
+  double target = total / n;
+  const uint32_t unassigned = n;
+  partition.assign (nGroups, unassigned);
+  uint32_t nextSeed = 0;
+  bool balanced = true;
+  for (uint32_t p = 0; p < n; ++p)
+    {
+      double load = 0;
+      std::map<uint32_t, double> frontier;
+      while (true)
+        {
+          // the last partition takes all the remaining groups
+          uint32_t g = nGroups;
+          if (!frontier.empty ())
+            {
+              double bestConnection = -1;
+              for (std::map<uint32_t, double>::const_iterator i = frontier.begin ();
+                   i != frontier.end (); ++i)
+                {
+                  if (i->second > bestConnection)
+                    {
+                      g = i->first;
+                      bestConnection = i->second;
+                    }
+                }
+            }
+          else
+            {
+              while (nextSeed < nGroups && partition[nextSeed] != unassigned)
+                {
+                  nextSeed++;
+                }
+              g = nextSeed;
+            }
+          if (g == nGroups)
+            {
+              break;
+            }
+          if (p < n - 1 && load > 0
+              && load + groupWeights[g] - target > target - load)
+            {
+              // closer to the target without this group
+              break;
+            }
+          partition[g] = p;
+          load += groupWeights[g];
+          frontier.erase (g);
+          for (std::map<uint32_t, double>::const_iterator i = neighbors[g].begin ();
+               i != neighbors[g].end (); ++i)
+            {
+              if (partition[i->first] == unassigned)
+                {
+                  frontier[i->first] += i->second;
+                }
+            }
+          if (p < n - 1 && load >= target)
+            {
+              break;
+            }
+        }
+      balanced &= load <= (1 + m_imbalance) * target;
+    }
+  return balanced;
+}
+
+void
+PartitionHelper::Refine (const std::vector<uint32_t> &group, uint32_t nGroups,
+                         uint32_t n, std::vector<uint32_t> &partition) const
+{
+  // Move single groups to the partition they are the most connected
+  // to, as long as the balance allows it, until no move reduces the
+  // cut anymore.
+  std::vector<double> groupWeights = GetGroupWeights (group, nGroups, m_weights);
+  std::vector<std::map<uint32_t, double> > neighbors = GetNeighbors (group, nGroups);
+  double total = 0;
+  std::vector<double> load (n, 0.0);
+  for (uint32_t g = 0; g < nGroups; ++g)
+    {
+      total += groupWeights[g];
+      load[partition[g]] += groupWeights[g];
+    }
+  double maxLoad = (1 + m_imbalance) * total / n;
+
+  for (uint32_t pass = 0; pass < MAX_REFINE_PASSES; ++pass)
+    {
+      bool moved = false;
+      for (uint32_t g = 0; g < nGroups; ++g)
+        {
+          uint32_t from = partition[g];
+          std::vector<double> connection (n, 0.0);
+          for (std::map<uint32_t, double>::const_iterator i = neighbors[g].begin ();
+               i != neighbors[g].end (); ++i)
+            {
+              connection[partition[i->first]] += i->second;
+            }
+          bool overloaded = load[from] > maxLoad;
+          uint32_t best = from;
+          double bestGain = 0;
+          for (uint32_t p = 0; p < n; ++p)
+            {
+              if (p == from || load[p] + groupWeights[g] > maxLoad)
+                {
+                  continue;
+                }
+              double gain = connection[p] - connection[from];
+              // without gain, only move to improve the balance, which
+              // prevents the groups from moving back and forth.
+              bool better = gain > bestGain
+                || (gain == bestGain && load[p] + groupWeights[g] < load[from]
+                    && (best == from || load[p] < load[best]));
+              if (overloaded && best == from)
+                {
+                  better = true;
+                }
+              if (better)
+                {
+                  best = p;
+                  bestGain = gain;
+                }
+            }
+          if (best != from)
+            {
+              partition[g] = best;
+              load[from] -= groupWeights[g];
+              load[best] += groupWeights[g];
+              moved = true;
+            }
+        }
+      if (!moved)
+        {
+          break;
+        }
+    }
+}
+
+void
+PartitionHelper::Partition (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT (n > 0);
+
+  // The lookahead is the smallest delay of the links which are cut, so
+  // find the largest delay below which all the links can be kept
+  // within the partitions. The loads only get harder to balance as
+  // the delay increases.
+  std::vector<Time> delays;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      delays.push_back (i->delay);
+    }
+  std::sort (delays.begin (), delays.end ());
+  delays.erase (std::unique (delays.begin (), delays.end ()), delays.end ());
+  delays.push_back (Simulator::GetMaximumSimulationTime ());
+
+  std::vector<uint32_t> group = Contract (delays[0]);
+  std::vector<uint32_t> partition;
+  for (uint32_t i = 1; i < delays.size (); ++i)
+    {
+      std::vector<uint32_t> candidate = Contract (delays[i]);
+      if (!Balance (candidate, CountGroups (candidate), n, partition))
+        {
+          break;
+        }
+      group = candidate;
+    }
+  uint32_t nGroups = CountGroups (group);
+
+  // Start from the grown partitions if they are balanced, and reduce
+  // the traffic between them.
+  if (!Grow (group, nGroups, n, partition))
+    {
+      Balance (group, nGroups, n, partition);
+    }
+  Refine (group, nGroups, n, partition);
+
+  m_partition.resize (m_nodes.GetN ());
+  for (uint32_t i = 0; i < m_nodes.GetN (); ++i)
+    {
+      m_partition[i] = partition[group[i]];
+      m_nodes.Get (i)->SetAttribute ("SystemId", UintegerValue (m_partition[i]));
+    }
+  NS_LOG_LOGIC ("lookahead " << GetLookAhead () << " cut " << GetCutRate ());
+}
+
+NetDeviceContainer
+PartitionHelper::Install (PointToPointHelper helper)
+{
+  NS_ASSERT_MSG (m_partition.size () == m_nodes.GetN (),
+                 "PartitionHelper::Partition must be called before Install");
+  NetDeviceContainer devices;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      helper.SetDeviceAttribute ("DataRate", DataRateValue (i->rate));
+      helper.SetChannelAttribute ("Delay", TimeValue (i->delay));
+      devices.Add (helper.Install (m_nodes.Get (i->a), m_nodes.Get (i->b)));
+    }
+  return devices;
+}
+
+Time
+PartitionHelper::GetLookAhead (void) const
+{
+  NS_ASSERT (m_partition.size () == m_nodes.GetN ());
+  Time lookAhead = Simulator::GetMaximumSimulationTime ();
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (m_partition[i->a] != m_partition[i->b])
+        {
+          lookAhead = Min (lookAhead, i->delay);
+        }
+    }
+  return lookAhead;
+}
+
+DataRate
+PartitionHelper::GetCutRate (void) const
+{
+  NS_ASSERT (m_partition.size () == m_nodes.GetN ());
+  uint64_t rate = 0;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (m_partition[i->a] != m_partition[i->b])
+        {
+          rate += i->rate.GetBitRate ();
+        }
+    }
+  return DataRate (rate);
+}
+
+double
+PartitionHelper::GetWeight (uint32_t partition) const
+{
+  NS_ASSERT (m_partition.size () == m_nodes.GetN ());
+  double weight = 0;
+  for (uint32_t i = 0; i < m_nodes.GetN (); ++i)
+    {
+      if (m_partition[i] == partition)
+        {
+          weight += m_weights[i];
+        }
+    }
+  return weight;
+}
+
+} // namespace ns3
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PARTITION_HELPER_H
+#define PARTITION_HELPER_H
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+
+namespace ns3 {
+
+class PointToPointHelper;
+
+/**
+ * \brief Assign the system ids of the nodes of a point-to-point topology
+ *
+ * This helper splits a topology in partitions for a distributed (or
+ * multithreaded) simulation, instead of assigning the system id of each
+ * node by hand. The nodes and the point-to-point links between them are
+ * described to the helper, typically from the links of a
+ * TopologyReader, and Partition then:
+ *  - keeps together the nodes connected by the links with the smallest
+ *    delays, so that the lookahead, i.e., the smallest delay of the
+ *    links between partitions, is as large as possible while the load
+ *    of each partition stays within the allowed imbalance;
+ *  - balances the weights of the nodes between the partitions while
+ *    minimizing the data rate of the links between partitions, which
+ *    approximates the traffic which must be exchanged.
+ *
+ * The system ids must be assigned before the links are installed, so
+ * that the PointToPointHelper creates remote channels for the links
+ * between partitions. Install does it for all the links described to
+ * the helper.
+ */
+class PartitionHelper
+{
+public:
+  PartitionHelper ();
+
+  /**
+   * \param c nodes to partition, with a weight of 1
+   */
+  void Add (NodeContainer c);
+  /**
+   * \param node a node to partition
+   * \param weight the relative load of the node
+   */
+  void Add (Ptr<Node> node, double weight);
+  /**
+   * \param a one end of the link
+   * \param b the other end of the link
+   * \param delay propagation delay of the link
+   * \param rate data rate of the devices of the link
+   *
+   * Describe a point-to-point link. The nodes are added with a weight of
+   * 1 if they were not added yet.
+   */
+  void AddLink (Ptr<Node> a, Ptr<Node> b, Time delay, DataRate rate);
+  /**
+   * \param imbalance allowed excess of the weight of a partition over
+   * the average, e.g., 0.1 for 10%
+   */
+  void SetImbalance (double imbalance);
+
+  /**
+   * \param n number of partitions, usually MpiInterface::GetSize ()
+   *
+   * Compute the partitions and set the SystemId attribute of the nodes.
+   */
+  void Partition (uint32_t n);
+  /**
+   * \param helper helper used to create the links
+   * \returns the devices of all the links, two per link
+   *
+   * Install all the links with their delay and data rate. Must be
+   * called after Partition.
+   */
+  NetDeviceContainer Install (PointToPointHelper helper);
+
+  /**
+   * \returns the smallest delay of the links between partitions, or
+   * Simulator::GetMaximumSimulationTime if there is none
+   */
+  Time GetLookAhead (void) const;
+  /**
+   * \returns the sum of the data rates of the links between partitions
+   */
+  DataRate GetCutRate (void) const;
+  /**
+   * \param partition a partition
+   * \returns the sum of the weights of its nodes
+   */
+  double GetWeight (uint32_t partition) const;
+
+private:
+  struct Link
+  {
+    uint32_t a;
+    uint32_t b;
+    Time delay;
+    DataRate rate;
+  };
+
+  uint32_t GetIndex (Ptr<Node> node);
+  std::vector<uint32_t> Contract (Time delay) const;
+  std::vector<std::map<uint32_t, double> > GetNeighbors (const std::vector<uint32_t> &group,
+                                                        uint32_t nGroups) const;
+  bool Balance (const std::vector<uint32_t> &group, uint32_t nGroups,
+                uint32_t n, std::vector<uint32_t> &partition) const;
+  bool Grow (const std::vector<uint32_t> &group, uint32_t nGroups,
+             uint32_t n, std::vector<uint32_t> &partition) const;
+  void Refine (const std::vector<uint32_t> &group, uint32_t nGroups,
+               uint32_t n, std::vector<uint32_t> &partition) const;
+
+  NodeContainer m_nodes;
+  std::vector<double> m_weights;
+  std::map<uint32_t, uint32_t> m_indexes;
+  std::vector<Link> m_links;
+  double m_imbalance;
+  // partition of each node, empty until Partition is called
+  std::vector<uint32_t> m_partition;
+};
+
+} // namespace ns3
+
+#endif /* PARTITION_HELPER_H */
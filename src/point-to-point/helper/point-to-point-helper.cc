@@ -30,6 +30,10 @@
 #include "ns3/names.h"
 #include "ns3/mpi-interface.h"
 #include "ns3/mpi-receiver.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/multithreaded-simulator-impl.h"
+#endif /* HAVE_PTHREAD_H */
 
 #include "ns3/trace-helper.h"
 #include "point-to-point-helper.h"
@@ -251,6 +255,16 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
           useNormalChannel = false;
         }
     }
+#ifdef HAVE_PTHREAD_H
+  else if (MultithreadedSimulatorImpl::IsEnabled ())
+    {
+      // nodes with different system ids are run by different threads
+      if (a->GetSystemId () != b->GetSystemId ())
+        {
+          useNormalChannel = false;
+        }
+    }
+#endif /* HAVE_PTHREAD_H */
   if (useNormalChannel)
     {
       channel = m_channelFactory.Create<PointToPointChannel> ();
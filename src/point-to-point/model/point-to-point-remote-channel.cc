@@ -26,6 +26,10 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/multithreaded-simulator-impl.h"
+#endif /* HAVE_PTHREAD_H */
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointRemoteChannel");
 
@@ -62,17 +66,28 @@ PointToPointRemoteChannel::TransmitStart (
 
   IsInitialized ();
 
-  uint32_t wire = src == GetSource (0) ? 0 : 1;
-  Ptr<PointToPointNetDevice> dst = GetDestination (wire);
-
-#ifdef NS3_MPI
   // Calculate the rxTime (absolute)
   Time rxTime = Simulator::Now () + txTime + GetDelay ();
-  MpiInterface::SendPacket (p, rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
-#else
-  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#ifdef NS3_MPI
+  if (MpiInterface::IsEnabled ())
+    {
+      uint32_t wire = src == GetSource (0) ? 0 : 1;
+      Ptr<PointToPointNetDevice> dst = GetDestination (wire);
+      MpiInterface::SendPacket (p, rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
+      return true;
+    }
 #endif
-  return true;
+#ifdef HAVE_PTHREAD_H
+  if (MultithreadedSimulatorImpl::IsEnabled ())
+    {
+      // The destination device is run by another thread and must not
+      // be referenced here: the peer is looked up from the source device.
+      MultithreadedSimulatorImpl::SendPacket (p, rxTime, src->GetNode ()->GetId (), src->GetIfIndex ());
+      return true;
+    }
+#endif /* HAVE_PTHREAD_H */
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+  return false;
 }
 
 } // namespace ns3
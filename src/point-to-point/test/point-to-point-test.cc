@@ -3,6 +3,17 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/partition-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/multithreaded-simulator-impl.h"
+#endif /* HAVE_PTHREAD_H */
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -56,6 +67,171 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 //-----------------------------------------------------------------------------
+class PartitionHelperTest : public TestCase
+{
+public:
+  PartitionHelperTest ();
+
+  virtual void DoRun (void);
+};
+
+PartitionHelperTest::PartitionHelperTest ()
+  : TestCase ("Check that the PartitionHelper keeps the shortest links within partitions")
+{
+}
+
+void
+PartitionHelperTest::DoRun (void)
+{
+  // Two cliques of four nodes with 1ms links, connected by two 10ms
+  // links: the nodes are split along the long links.
+  NodeContainer nodes;
+  nodes.Create (8);
+  PartitionHelper partition;
+  partition.Add (nodes);
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      for (uint32_t j = i + 1; j < 8; j++)
+        {
+          if (i / 4 == j / 4)
+            {
+              partition.AddLink (nodes.Get (i), nodes.Get (j), MilliSeconds (1), DataRate ("10Mbps"));
+            }
+        }
+    }
+  partition.AddLink (nodes.Get (3), nodes.Get (4), MilliSeconds (10), DataRate ("1Mbps"));
+  partition.AddLink (nodes.Get (0), nodes.Get (7), MilliSeconds (10), DataRate ("1Mbps"));
+  partition.Partition (2);
+
+  NS_TEST_EXPECT_MSG_EQ (partition.GetLookAhead (), MilliSeconds (10), "Wrong lookahead");
+  NS_TEST_EXPECT_MSG_EQ (partition.GetCutRate ().GetBitRate (), 2000000, "Wrong cut");
+  NS_TEST_EXPECT_MSG_EQ (partition.GetWeight (0), 4, "Unbalanced partitions");
+  NS_TEST_EXPECT_MSG_EQ (partition.GetWeight (1), 4, "Unbalanced partitions");
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (nodes.Get (i)->GetSystemId (), nodes.Get (i / 4 * 4)->GetSystemId (),
+                             "Node " << i << " not in the partition of its clique");
+    }
+
+  PointToPointHelper p2p;
+  NetDeviceContainer devices = partition.Install (p2p);
+  NS_TEST_EXPECT_MSG_EQ (devices.GetN (), 2 * (6 + 6 + 2), "Wrong number of devices");
+
+  // A chain of equal links can't keep any link within the partitions,
+  // so only the cut is minimized: each partition is a segment.
+  NodeContainer chain;
+  chain.Create (9);
+  PartitionHelper chainPartition;
+  for (uint32_t i = 0; i + 1 < 9; i++)
+    {
+      chainPartition.AddLink (chain.Get (i), chain.Get (i + 1), MilliSeconds (1), DataRate ("1Mbps"));
+    }
+  chainPartition.SetImbalance (0);
+  chainPartition.Partition (3);
+  NS_TEST_EXPECT_MSG_EQ (chainPartition.GetLookAhead (), MilliSeconds (1), "Wrong lookahead");
+  NS_TEST_EXPECT_MSG_EQ (chainPartition.GetCutRate ().GetBitRate (), 2000000, "Wrong cut");
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (chainPartition.GetWeight (i), 3, "Unbalanced partitions");
+    }
+
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
+class PartitionedDeliveryTest : public TestCase
+{
+public:
+  PartitionedDeliveryTest ();
+
+  virtual void DoRun (void);
+
+private:
+  void RunSimulation (void);
+  void SendPackets (Ptr<NetDevice> device, uint32_t n);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  // packets received by each node, in order
+  std::vector<std::ostringstream *> m_received;
+};
+
+PartitionedDeliveryTest::PartitionedDeliveryTest ()
+  : TestCase ("Check that partitions run by threads deliver the same packets as a sequential run")
+{
+}
+
+void
+PartitionedDeliveryTest::SendPackets (Ptr<NetDevice> device, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100 + 10 * i + device->GetNode ()->GetId ());
+      device->Send (p, device->GetBroadcast (), 0x800);
+    }
+}
+
+bool
+PartitionedDeliveryTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  *m_received[device->GetNode ()->GetId ()] << Simulator::Now ().GetTimeStep () << " "
+                                             << device->GetIfIndex () << " " << p->GetSize () << "\n";
+  return true;
+}
+
+void
+PartitionedDeliveryTest::RunSimulation (void)
+{
+  // a chain of four nodes, split in two partitions in its middle
+  NodeContainer nodes;
+  nodes.Create (4);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      nodes.Get (i)->SetAttribute ("SystemId", UintegerValue (i / 2));
+      m_received.push_back (new std::ostringstream ());
+    }
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("1Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  for (uint32_t i = 0; i + 1 < 4; i++)
+    {
+      NetDeviceContainer devices = p2p.Install (nodes.Get (i), nodes.Get (i + 1));
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Ptr<NetDevice> device = devices.Get (j);
+          device->SetReceiveCallback (MakeCallback (&PartitionedDeliveryTest::Receive, this));
+          Simulator::ScheduleWithContext (device->GetNode ()->GetId (), Seconds (1.0 + 0.001 * i),
+                                          &PartitionedDeliveryTest::SendPackets, this, device, 5);
+        }
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+PartitionedDeliveryTest::DoRun (void)
+{
+  RunSimulation ();
+  std::vector<std::string> expected;
+  for (uint32_t i = 0; i < m_received.size (); i++)
+    {
+      expected.push_back (m_received[i]->str ());
+      delete m_received[i];
+    }
+  m_received.clear ();
+  NS_TEST_ASSERT_MSG_NE (expected[1], "", "No packets received");
+
+#ifdef HAVE_PTHREAD_H
+  Simulator::SetImplementation (CreateObject<MultithreadedSimulatorImpl> ());
+  RunSimulation ();
+  for (uint32_t i = 0; i < m_received.size (); i++)
+    {
+      std::string received = m_received[i]->str ();
+      NS_TEST_EXPECT_MSG_EQ (received, expected[i], "Node " << i << " received different packets");
+      delete m_received[i];
+    }
+  m_received.clear ();
+#endif /* HAVE_PTHREAD_H */
+}
+//-----------------------------------------------------------------------------
 class PointToPointTestSuite : public TestSuite
 {
 public:
@@ -66,6 +242,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PartitionHelperTest, TestCase::QUICK);
+  AddTestCase (new PartitionedDeliveryTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite;
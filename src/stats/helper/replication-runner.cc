@@ -0,0 +1,503 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "replication-runner.h"
+#include "ns3/data-calculator.h"
+#include "ns3/data-output-interface.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <iostream>
+#include <sstream>
+#include <limits>
+
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReplicationRunner");
+
+namespace {
+
+/**
+ * Writes the numeric outputs of the calculators of a replication as
+ * "key<tab>variable<tab>value" lines.
+ */
+class ReplicationOutputCallback : public DataOutputCallback
+{
+public:
+  ReplicationOutputCallback (std::ostream &os)
+    : m_os (os)
+  {
+    m_os.precision (17);
+  }
+  void OutputStatistic (std::string key, std::string variable,
+                        const StatisticalSummary *statSum)
+  {
+    OutputValue (key, variable + "-count", statSum->getCount ());
+    if (statSum->getCount () == 0)
+      {
+        return;
+      }
+    OutputValue (key, variable + "-sum", statSum->getSum ());
+    OutputValue (key, variable + "-mean", statSum->getMean ());
+    OutputValue (key, variable + "-min", statSum->getMin ());
+    OutputValue (key, variable + "-max", statSum->getMax ());
+  }
+  void OutputSingleton (std::string key, std::string variable, int val)
+  {
+    OutputValue (key, variable, val);
+  }
+  void OutputSingleton (std::string key, std::string variable, uint32_t val)
+  {
+    OutputValue (key, variable, val);
+  }
+  void OutputSingleton (std::string key, std::string variable, double val)
+  {
+    OutputValue (key, variable, val);
+  }
+  void OutputSingleton (std::string key, std::string variable, std::string val)
+  {
+    // not a number: cannot be summarized.
+  }
+  void OutputSingleton (std::string key, std::string variable, Time val)
+  {
+    OutputValue (key, variable, val.GetSeconds ());
+  }
+
+private:
+  void OutputValue (std::string key, std::string variable, double val)
+  {
+    // the statistics of some calculators are not a number when they
+    // have not been computed.
+    if (val != val)
+      {
+        return;
+      }
+    m_os << Escape (key) << '\t' << Escape (variable) << '\t' << val << '\n';
+  }
+  static std::string Escape (std::string s)
+  {
+    for (std::string::iterator i = s.begin (); i != s.end (); ++i)
+      {
+        if (*i == '\t' || *i == '\n')
+          {
+            *i = ' ';
+          }
+      }
+    return s;
+  }
+  std::ostream &m_os;
+};
+
+/**
+ * \returns the quantile of order p of the standard normal distribution,
+ * computed with the rational approximation of Peter J. Acklam
+ * (relative error below 1.2e-9).
+ */
+double
+GetNormalQuantile (double p)
+{
+  static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02,
+                              -2.759285104469687e+02, 1.383577518672690e+02,
+                              -3.066479806614716e+01, 2.506628277459239e+00 };
+  static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02,
+                              -1.556989798598866e+02, 6.680131188771972e+01,
+                              -1.328068155288572e+01 };
+  static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01,
+                              -2.400758277161838e+00, -2.549732539343734e+00,
+                              4.374664141464968e+00, 2.938163982698783e+00 };
+  static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01,
+                              2.445134137142996e+00, 3.754408661907416e+00 };
+  static const double low = 0.02425;
+
+  if (p < low || p > 1 - low)
+    {
+      // tails
+      double q = std::sqrt (-2 * std::log (p < low ? p : 1 - p));
+      double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+        ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+      return p < low ? x : -x;
+    }
+  double q = p - 0.5;
+  double r = q * q;
+  return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+         (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+#ifdef HAVE_SYS_WAIT_H
+/**
+ * A replication running in a child process.
+ */
+struct Worker
+{
+  pid_t pid;
+  int fd;                  //!< read end of the pipe of the child
+  uint32_t replication;
+  std::string output;      //!< output read so far
+};
+#endif
+
+} // anonymous namespace
+
+ReplicationRunner::ReplicationRunner ()
+  : m_replications (10),
+    m_workers (0),
+    m_firstRun (RngSeedManager::GetRun ()),
+    m_level (0.95),
+    m_failures (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ReplicationRunner::SetReplications (uint32_t replications)
+{
+  NS_LOG_FUNCTION (this << replications);
+  m_replications = replications;
+}
+
+void
+ReplicationRunner::SetWorkers (uint32_t workers)
+{
+  NS_LOG_FUNCTION (this << workers);
+  m_workers = workers;
+}
+
+void
+ReplicationRunner::SetFirstRun (uint64_t run)
+{
+  NS_LOG_FUNCTION (this << run);
+  m_firstRun = run;
+}
+
+void
+ReplicationRunner::SetConfidenceLevel (double level)
+{
+  NS_LOG_FUNCTION (this << level);
+  NS_ASSERT_MSG (level > 0 && level < 1, "Invalid confidence level " << level);
+  m_level = level;
+}
+
+void
+ReplicationRunner::Run (Scenario scenario)
+{
+  NS_LOG_FUNCTION (this);
+  m_values.clear ();
+  m_failures = 0;
+#ifdef HAVE_SYS_WAIT_H
+  uint32_t workers = m_workers;
+  if (workers == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      workers = processors > 0 ? processors : 1;
+    }
+
+  // the children inherit the output buffers: flush them first so that
+  // they are not written more than once.
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+
+  std::vector<Worker> running;
+  uint32_t next = 0;
+  while (next < m_replications || !running.empty ())
+    {
+      while (next < m_replications && running.size () < workers)
+        {
+          uint32_t replication = next++;
+          int fds[2];
+          if (pipe (fds) != 0)
+            {
+              NS_LOG_WARN ("Cannot create the pipe of replication " << replication);
+              m_failures++;
+              continue;
+            }
+          pid_t pid = fork ();
+          if (pid == 0)
+            {
+              close (fds[0]);
+              int code = RunReplication (replication, scenario, fds[1]);
+              // do not run the exit handlers and static destructors of the
+              // parent process.
+              std::cout.flush ();
+              std::cerr.flush ();
+              std::fflush (0);
+              _exit (code);
+            }
+          // only the child writes to the pipe: the read end sees the end
+          // of file as soon as the child exits.
+          close (fds[1]);
+          if (pid < 0)
+            {
+              NS_LOG_WARN ("Cannot fork replication " << replication);
+              close (fds[0]);
+              m_failures++;
+              continue;
+            }
+          NS_LOG_LOGIC ("replication " << replication << " started as process " << pid);
+          Worker worker;
+          worker.pid = pid;
+          worker.fd = fds[0];
+          worker.replication = replication;
+          running.push_back (worker);
+        }
+      if (running.empty ())
+        {
+          continue;
+        }
+
+      std::vector<struct pollfd> polled (running.size ());
+      for (uint32_t i = 0; i < running.size (); i++)
+        {
+          polled[i].fd = running[i].fd;
+          polled[i].events = POLLIN;
+          polled[i].revents = 0;
+        }
+      if (poll (&polled[0], polled.size (), -1) < 0)
+        {
+          NS_ASSERT_MSG (errno == EINTR, "poll failed with errno " << errno);
+          continue;
+        }
+      for (uint32_t i = running.size (); i-- > 0; )
+        {
+          if (polled[i].revents == 0)
+            {
+              continue;
+            }
+          Worker &worker = running[i];
+          char buffer[4096];
+          ssize_t n = read (worker.fd, buffer, sizeof (buffer));
+          if (n > 0)
+            {
+              worker.output.append (buffer, n);
+              continue;
+            }
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+          close (worker.fd);
+          int status;
+          if (waitpid (worker.pid, &status, 0) == worker.pid
+              && WIFEXITED (status) && WEXITSTATUS (status) == 0)
+            {
+              NS_LOG_LOGIC ("replication " << worker.replication << " completed");
+              Parse (worker.replication, worker.output);
+            }
+          else
+            {
+              NS_LOG_WARN ("Replication " << worker.replication << " failed");
+              m_failures++;
+            }
+          running.erase (running.begin () + i);
+        }
+    }
+#else
+  NS_FATAL_ERROR ("ReplicationRunner is not supported on this system");
+#endif
+}
+
+int
+ReplicationRunner::RunReplication (uint32_t replication, Scenario scenario, int fd) const
+{
+  NS_LOG_FUNCTION (this << replication << fd);
+#ifdef HAVE_SYS_WAIT_H
+  RngSeedManager::SetRun (m_firstRun + replication);
+  // the streams created before the fork must not replay the same numbers
+  // in all the replications.
+  RandomVariableStream::ReseedAll ();
+
+  Ptr<DataCollector> collector = CreateObject<DataCollector> ();
+  scenario (replication, collector);
+
+  std::ostringstream os;
+  ReplicationOutputCallback callback (os);
+  for (DataCalculatorList::iterator i = collector->DataCalculatorBegin ();
+       i != collector->DataCalculatorEnd (); ++i)
+    {
+      (*i)->Output (callback);
+    }
+  collector->Dispose ();
+  Simulator::Destroy ();
+
+  std::string output = os.str ();
+  std::string::size_type written = 0;
+  while (written < output.size ())
+    {
+      ssize_t n = write (fd, output.data () + written, output.size () - written);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          return 1;
+        }
+      written += n;
+    }
+  close (fd);
+#endif
+  return 0;
+}
+
+void
+ReplicationRunner::Parse (uint32_t replication, const std::string &output)
+{
+  NS_LOG_FUNCTION (this << replication);
+  std::istringstream is (output);
+  std::string line;
+  while (std::getline (is, line))
+    {
+      std::string::size_type first = line.find ('\t');
+      std::string::size_type second = line.find ('\t', first + 1);
+      if (first == std::string::npos || second == std::string::npos)
+        {
+          continue;
+        }
+      Variable variable (line.substr (0, first), line.substr (first + 1, second - first - 1));
+      double value = std::strtod (line.c_str () + second + 1, 0);
+      m_values[variable].push_back (std::make_pair (replication, value));
+    }
+}
+
+uint32_t
+ReplicationRunner::GetFailures (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_failures;
+}
+
+std::vector<double>
+ReplicationRunner::GetValues (std::string key, std::string variable) const
+{
+  NS_LOG_FUNCTION (this << key << variable);
+  std::vector<double> values;
+  Values::const_iterator i = m_values.find (Variable (key, variable));
+  if (i == m_values.end ())
+    {
+      return values;
+    }
+  // the replications complete out of order.
+  std::vector<std::pair<uint32_t, double> > sorted = i->second;
+  std::sort (sorted.begin (), sorted.end ());
+  for (uint32_t j = 0; j < sorted.size (); j++)
+    {
+      values.push_back (sorted[j].second);
+    }
+  return values;
+}
+
+std::vector<ReplicationRunner::Summary>
+ReplicationRunner::GetSummaries (void) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Summary> summaries;
+  for (Values::const_iterator i = m_values.begin (); i != m_values.end (); ++i)
+    {
+      Summary summary;
+      summary.key = i->first.first;
+      summary.variable = i->first.second;
+      summary.count = i->second.size ();
+      double sum = 0;
+      for (uint32_t j = 0; j < summary.count; j++)
+        {
+          sum += i->second[j].second;
+        }
+      summary.mean = sum / summary.count;
+      if (summary.count < 2)
+        {
+          summary.stddev = 0;
+          summary.halfWidth = std::numeric_limits<double>::quiet_NaN ();
+        }
+      else
+        {
+          double squares = 0;
+          for (uint32_t j = 0; j < summary.count; j++)
+            {
+              double delta = i->second[j].second - summary.mean;
+              squares += delta * delta;
+            }
+          summary.stddev = std::sqrt (squares / (summary.count - 1));
+          summary.halfWidth = GetStudentQuantile ((1 + m_level) / 2, summary.count - 1)
+            * summary.stddev / std::sqrt (static_cast<double> (summary.count));
+        }
+      summaries.push_back (summary);
+    }
+  return summaries;
+}
+
+void
+ReplicationRunner::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  std::vector<Summary> summaries = GetSummaries ();
+  os << "Replications: " << m_replications << ", failed: " << m_failures
+     << ", confidence level: " << m_level * 100 << "%" << std::endl;
+  for (uint32_t i = 0; i < summaries.size (); i++)
+    {
+      const Summary &summary = summaries[i];
+      os << summary.key << " " << summary.variable
+         << " n=" << summary.count
+         << " mean=" << summary.mean
+         << " stddev=" << summary.stddev
+         << " ci=+/-" << summary.halfWidth << std::endl;
+    }
+}
+
+double
+ReplicationRunner::GetStudentQuantile (double p, uint32_t degrees)
+{
+  NS_LOG_FUNCTION (p << degrees);
+  NS_ASSERT (degrees > 0);
+  if (degrees == 1)
+    {
+      return std::tan (M_PI * (p - 0.5));
+    }
+  if (degrees == 2)
+    {
+      return (2 * p - 1) / std::sqrt (2 * p * (1 - p));
+    }
+  // Cornish-Fisher expansion of the quantile around the normal one
+  // (Abramowitz and Stegun 26.7.5): within 0.2% of the exact value for
+  // three degrees of freedom at the usual confidence levels, and closer
+  // with more.
+  double z = GetNormalQuantile (p);
+  double z2 = z * z;
+  double v = degrees;
+  double g1 = (z2 + 1) * z / 4;
+  double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+  double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+  double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z / 92160;
+  return z + (g1 + (g2 + (g3 + g4 / v) / v) / v) / v;
+}
+
+} // namespace ns3
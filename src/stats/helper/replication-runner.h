@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REPLICATION_RUNNER_H
+#define REPLICATION_RUNNER_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+#include "ns3/callback.h"
+#include "ns3/ptr.h"
+#include "ns3/data-collector.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup stats
+ *
+ * \brief Run independent replications of a scenario in parallel and
+ * summarize their results.
+ *
+ * Each replication runs in a child process forked from the calling
+ * process, with its own run number: replication i uses run number
+ * FirstRun + i. Up to SetWorkers replications run at the same time.
+ *
+ * The scenario is a function which, given the index of the replication
+ * and an empty DataCollector, builds the simulation, adds its
+ * DataCalculator objects to the DataCollector and runs the simulation
+ * with Simulator::Run. The runner then collects the output of every
+ * calculator, destroys the simulator and sends the numeric values to the
+ * calling process: singletons are collected as they are, statistics as
+ * their count, sum, mean, min and max fields, and times in seconds.
+ *
+ * Once all the replications are over, each (key, variable) pair is
+ * summarized by the mean, standard deviation and confidence interval of
+ * its values across the replications. A replication whose process
+ * fails contributes no value, and is counted by GetFailures.
+ *
+ * \code
+ * ReplicationRunner runner;
+ * runner.SetReplications (100);
+ * runner.Run (MakeCallback (&Scenario));
+ * runner.Print (std::cout);
+ * \endcode
+ *
+ * This is only supported on systems which provide fork.
+ */
+class ReplicationRunner
+{
+public:
+  /**
+   * The summary of the values of a variable across the replications.
+   */
+  struct Summary
+  {
+    std::string key;
+    std::string variable;
+    uint32_t count;     //!< number of replications which produced a value
+    double mean;
+    double stddev;      //!< sample standard deviation
+    double halfWidth;   //!< half-width of the confidence interval of the mean
+  };
+
+  /**
+   * The scenario of a replication: invoked with the index of the
+   * replication and the DataCollector its calculators are added to.
+   */
+  typedef Callback<void, uint32_t, Ptr<DataCollector> > Scenario;
+
+  /**
+   * Constructs a runner of 10 replications starting at the current run
+   * number, using as many workers as there are online processors, with
+   * 95% confidence intervals.
+   */
+  ReplicationRunner ();
+
+  /**
+   * \param replications the number of replications to run
+   */
+  void SetReplications (uint32_t replications);
+  /**
+   * \param workers the maximum number of replications run at the same
+   *        time, or zero to use the number of online processors
+   */
+  void SetWorkers (uint32_t workers);
+  /**
+   * \param run the run number of the first replication
+   */
+  void SetFirstRun (uint64_t run);
+  /**
+   * \param level the confidence level of the intervals, between 0 and 1
+   */
+  void SetConfidenceLevel (double level);
+
+  /**
+   * \param scenario the scenario to replicate
+   *
+   * Run all the replications of \pname{scenario} and wait for them to
+   * complete. The results of previous calls are discarded.
+   */
+  void Run (Scenario scenario);
+
+  /**
+   * \returns the number of replications whose process failed
+   */
+  uint32_t GetFailures (void) const;
+  /**
+   * \param key the key of a calculator
+   * \param variable the name of the variable
+   * \returns the values of the variable, in the order of the replications
+   *          which produced them
+   */
+  std::vector<double> GetValues (std::string key, std::string variable) const;
+  /**
+   * \returns the summaries of all the variables, sorted by key and
+   *          variable
+   */
+  std::vector<Summary> GetSummaries (void) const;
+  /**
+   * \param os the stream to print to
+   *
+   * Print the summary of each variable, one per line.
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  typedef std::pair<std::string, std::string> Variable;
+  typedef std::map<Variable, std::vector<std::pair<uint32_t, double> > > Values;
+
+  int RunReplication (uint32_t replication, Scenario scenario, int fd) const;
+  void Parse (uint32_t replication, const std::string &output);
+  static double GetStudentQuantile (double p, uint32_t degrees);
+
+  uint32_t m_replications;
+  uint32_t m_workers;
+  uint64_t m_firstRun;
+  double m_level;
+  uint32_t m_failures;
+  Values m_values;
+};
+
+} // namespace ns3
+
+#endif /* REPLICATION_RUNNER_H */
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/test.h"
+#include "ns3/replication-runner.h"
+#include "ns3/basic-data-calculators.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+
+#include <cmath>
+
+#ifdef HAVE_SYS_WAIT_H
+#include <unistd.h>
+#endif
+
+using namespace ns3;
+
+#ifdef HAVE_SYS_WAIT_H
+
+// the replication which exits without reporting its results.
+static const uint32_t FAILED_REPLICATION = 5;
+
+static void
+Sample (Ptr<UniformRandomVariable> uniform,
+        Ptr<MinMaxAvgTotalCalculator<double> > values,
+        Ptr<CounterCalculator<> > events)
+{
+  values->Update (uniform->GetValue ());
+  events->Update ();
+}
+
+static void
+Scenario (uint32_t replication, Ptr<DataCollector> collector)
+{
+  if (replication == FAILED_REPLICATION)
+    {
+      _exit (1);
+    }
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  Ptr<MinMaxAvgTotalCalculator<double> > values = CreateObject<MinMaxAvgTotalCalculator<double> > ();
+  values->SetContext ("uniform");
+  values->SetKey ("value");
+  collector->AddDataCalculator (values);
+  Ptr<CounterCalculator<> > events = CreateObject<CounterCalculator<> > ();
+  events->SetContext ("uniform");
+  events->SetKey ("events");
+  collector->AddDataCalculator (events);
+
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (Seconds (i), &Sample, uniform, values, events);
+    }
+  Simulator::Run ();
+}
+
+class ReplicationRunnerTestCase : public TestCase
+{
+public:
+  ReplicationRunnerTestCase ();
+  virtual void DoRun (void);
+};
+
+ReplicationRunnerTestCase::ReplicationRunnerTestCase ()
+  : TestCase ("Check that replications run with distinct run numbers and are summarized")
+{
+}
+
+void
+ReplicationRunnerTestCase::DoRun (void)
+{
+  uint64_t run = RngSeedManager::GetRun ();
+  ReplicationRunner runner;
+  runner.SetReplications (8);
+  runner.SetWorkers (4);
+  runner.SetFirstRun (10);
+  runner.Run (MakeCallback (&Scenario));
+
+  NS_TEST_EXPECT_MSG_EQ (runner.GetFailures (), 1, "Wrong number of failed replications");
+  std::vector<double> events = runner.GetValues ("uniform", "events");
+  NS_TEST_ASSERT_MSG_EQ (events.size (), 7, "Wrong number of replications");
+  for (uint32_t i = 0; i < events.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (events[i], 100, "Wrong number of events in replication " << i);
+    }
+  std::vector<double> means = runner.GetValues ("uniform", "value-mean");
+  NS_TEST_ASSERT_MSG_EQ (means.size (), 7, "Wrong number of means");
+  for (uint32_t i = 1; i < means.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_NE (means[i], means[0], "Replications " << i << " and 0 are identical");
+    }
+
+  // the third replication runs again in this process with the same run number.
+  RngSeedManager::SetRun (12);
+  Ptr<DataCollector> collector = CreateObject<DataCollector> ();
+  Scenario (2, collector);
+  Ptr<MinMaxAvgTotalCalculator<double> > values =
+    DynamicCast<MinMaxAvgTotalCalculator<double> > (*collector->DataCalculatorBegin ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (means[2], values->getMean (), 1e-12, "Replication 2 is not reproducible");
+  Simulator::Destroy ();
+  RngSeedManager::SetRun (run);
+
+  std::vector<ReplicationRunner::Summary> summaries = runner.GetSummaries ();
+  bool found = false;
+  for (uint32_t i = 0; i < summaries.size (); i++)
+    {
+      const ReplicationRunner::Summary &summary = summaries[i];
+      if (summary.key != "uniform" || summary.variable != "value-mean")
+        {
+          continue;
+        }
+      found = true;
+      NS_TEST_EXPECT_MSG_EQ (summary.count, 7, "Wrong count");
+      NS_TEST_EXPECT_MSG_EQ_TOL (summary.mean, 0.5, 0.1, "Wrong mean");
+      NS_TEST_EXPECT_MSG_GT (summary.stddev, 0, "Null standard deviation");
+      // t(0.975, 6) = 2.4469
+      NS_TEST_EXPECT_MSG_EQ_TOL (summary.halfWidth, 2.4469 * summary.stddev / std::sqrt (7.0),
+                                 1e-3 * summary.stddev, "Wrong confidence interval");
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "Missing summary");
+}
+
+class ReplicationRunnerTestSuite : public TestSuite
+{
+public:
+  ReplicationRunnerTestSuite ()
+    : TestSuite ("replication-runner")
+  {
+    AddTestCase (new ReplicationRunnerTestCase (), TestCase::QUICK);
+  }
+} g_replicationRunnerTestSuite;
+
+#endif /* HAVE_SYS_WAIT_H */
@@ -216,6 +216,24 @@ VisualSimulatorImpl::GetContext (void) const
   return m_simulator->GetContext ();
 }
 
+uint32_t
+VisualSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_simulator->GetLiveEventCount ();
+}
+
+uint32_t
+VisualSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_simulator->GetCancelledEventCount ();
+}
+
+uint32_t
+VisualSimulatorImpl::GetPeakEventCount (void) const
+{
+  return m_simulator->GetPeakEventCount ();
+}
+
 void
 VisualSimulatorImpl::RunRealSimulator (void)
 {
@@ -68,6 +68,9 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
+  virtual uint32_t GetPeakEventCount (void) const;
 
   /// calls Run() in the wrapped simulator
   void RunRealSimulator (void);